@@ -0,0 +1,104 @@
+#include "bvh_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <containers/bvh.h>
+#include <defines.h>
+#include <math/kmath.h>
+
+#define BVH_TEST_BOX_COUNT 500
+
+typedef struct bvh_frustum_test_context {
+	b8 hits[BVH_TEST_BOX_COUNT];
+	u32 hit_count;
+} bvh_frustum_test_context;
+
+static u32 on_frustum_hit(bvh_userdata user, bvh_id id, void* usr) {
+	bvh_frustum_test_context* context = usr;
+	context->hits[user] = true;
+	context->hit_count++;
+	return 1;
+}
+
+static u8 bvh_query_frustum_should_find_boxes_in_view(void) {
+	bvh tree;
+	expect_to_be_true(bvh_create(0, 0, &tree));
+
+	// Camera at the origin looking down -z.
+	mat4 view = mat4_look_at(vec3_zero(), (vec3){0, 0, -1}, vec3_up());
+	mat4 projection = mat4_perspective(deg_to_rad(60.0f), 1.0f, 0.1f, 100.0f);
+	kfrustum f = kfrustum_from_view_projection(mat4_mul(view, projection));
+
+	// In front of the camera.
+	bvh_insert(&tree, (aabb){{-1, -1, -11}, {1, 1, -9}}, 0);
+	// Behind the camera.
+	bvh_insert(&tree, (aabb){{-1, -1, 9}, {1, 1, 11}}, 1);
+	// Beyond the far clip.
+	bvh_insert(&tree, (aabb){{-1, -1, -131}, {1, 1, -129}}, 2);
+	// Far off to the side.
+	bvh_insert(&tree, (aabb){{49, -1, -11}, {51, 1, -9}}, 3);
+	// Straddling the edge of the view.
+	f32 edge = 10.0f * ktan(deg_to_rad(30.0f));
+	bvh_insert(&tree, (aabb){{edge - 1, -1, -11}, {edge + 1, 1, -9}}, 4);
+
+	bvh_frustum_test_context context = {0};
+	expect_should_be(2, bvh_query_frustum(&tree, &f, on_frustum_hit, &context));
+	expect_to_be_true(context.hits[0]);
+	expect_to_be_false(context.hits[1]);
+	expect_to_be_false(context.hits[2]);
+	expect_to_be_false(context.hits[3]);
+	expect_to_be_true(context.hits[4]);
+
+	bvh_destroy(&tree);
+
+	return true;
+}
+
+static u8 bvh_query_frustum_should_match_brute_force(void) {
+	bvh tree;
+	bvh_create(0, 0, &tree);
+
+	// An orthographic view, as used by shadow cascades.
+	mat4 view = mat4_look_at((vec3){5, 20, 5}, (vec3){0, 0, 0}, vec3_up());
+	mat4 projection = mat4_orthographic(-15.0f, 15.0f, -10.0f, 10.0f, 0.0f, 60.0f);
+	kfrustum f = kfrustum_from_view_projection(mat4_mul(view, projection));
+
+	aabb boxes[BVH_TEST_BOX_COUNT];
+	u32 seed = 12345;
+	for (u32 i = 0; i < BVH_TEST_BOX_COUNT; ++i) {
+		vec3 center;
+		for (u32 j = 0; j < 3; ++j) {
+			seed = seed * 1664525u + 1013904223u;
+			center.elements[j] = ((f32)(seed >> 8) / (f32)(1 << 24)) * 100.0f - 50.0f;
+		}
+		f32 r = 0.5f + (f32)(i % 4);
+		boxes[i] = (aabb){vec3_sub(center, vec3_create(r, r, r)), vec3_add(center, vec3_create(r, r, r))};
+		bvh_insert(&tree, boxes[i], i);
+	}
+
+	bvh_frustum_test_context context = {0};
+	bvh_query_frustum(&tree, &f, on_frustum_hit, &context);
+
+	// Leaves are slightly padded, so the query may find extra boxes right at the edges, but must never miss one.
+	u32 expected_count = 0;
+	for (u32 i = 0; i < BVH_TEST_BOX_COUNT; ++i) {
+		vec3 center = extents_3d_center(boxes[i]);
+		vec3 half_extents = extents_3d_half(boxes[i]);
+		if (kfrustum_intersects_aabb(&f, &center, &half_extents)) {
+			expected_count++;
+			expect_to_be_true(context.hits[i]);
+		}
+	}
+	expect_to_be_true(expected_count > 0);
+	expect_to_be_true(context.hit_count >= expected_count);
+	expect_to_be_true(context.hit_count < BVH_TEST_BOX_COUNT);
+
+	bvh_destroy(&tree);
+
+	return true;
+}
+
+void bvh_register_tests(void) {
+	test_manager_register_test(bvh_query_frustum_should_find_boxes_in_view, "BVH frustum query should find boxes in view");
+	test_manager_register_test(bvh_query_frustum_should_match_brute_force, "BVH frustum query should match brute force");
+}
@@ -0,0 +1,225 @@
+#include "freelist_benchmark_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <containers/freelist.h>
+#include <defines.h>
+#include <memory/kmemory.h>
+#include <time/kclock.h>
+
+/*
+ * Compares the freelist against a plain offset-ordered, first-fit list walk (which is
+ * how the freelist used to work) under the same fragmenting workload of mixed-size
+ * allocations and frees. Reports the time taken and how fragmented each ends up.
+ * Correctness of the same workload is covered by freelist_tests.c.
+ */
+
+#define BENCH_TOTAL_SIZE MEBIBYTES(64)
+#define BENCH_SLOT_COUNT 8192
+#define BENCH_OP_COUNT 60000
+
+typedef struct list_walk_node {
+	u64 offset;
+	u64 size;
+	struct list_walk_node* next;
+} list_walk_node;
+
+typedef struct list_walk {
+	list_walk_node* head;
+	list_walk_node* unused;
+	list_walk_node* nodes;
+	u32 node_count;
+} list_walk;
+
+static list_walk_node* list_walk_node_get(list_walk* list, u64 offset, u64 size, list_walk_node* next) {
+	list_walk_node* node = list->unused;
+	list->unused = node->next;
+	node->offset = offset;
+	node->size = size;
+	node->next = next;
+	return node;
+}
+
+static void list_walk_node_return(list_walk* list, list_walk_node* node) {
+	node->next = list->unused;
+	list->unused = node;
+}
+
+static void list_walk_create(list_walk* list, u64 total_size) {
+	list->node_count = BENCH_SLOT_COUNT * 2;
+	list->nodes = kallocate(sizeof(list_walk_node) * list->node_count, MEMORY_TAG_ENGINE);
+	list->unused = 0;
+	for (u32 i = 0; i < list->node_count; ++i) {
+		list_walk_node_return(list, &list->nodes[i]);
+	}
+	list->head = list_walk_node_get(list, 0, total_size, 0);
+}
+
+static void list_walk_destroy(list_walk* list) {
+	kfree(list->nodes, sizeof(list_walk_node) * list->node_count, MEMORY_TAG_ENGINE);
+	kzero_memory(list, sizeof(list_walk));
+}
+
+static b8 list_walk_allocate(list_walk* list, u64 size, u64* out_offset) {
+	list_walk_node* previous = 0;
+	for (list_walk_node* node = list->head; node; previous = node, node = node->next) {
+		if (node->size >= size) {
+			*out_offset = node->offset;
+			node->offset += size;
+			node->size -= size;
+			if (!node->size) {
+				if (previous) {
+					previous->next = node->next;
+				} else {
+					list->head = node->next;
+				}
+				list_walk_node_return(list, node);
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+static void list_walk_free(list_walk* list, u64 size, u64 offset) {
+	list_walk_node* previous = 0;
+	list_walk_node* node = list->head;
+	while (node && node->offset < offset) {
+		previous = node;
+		node = node->next;
+	}
+
+	// Insert between previous and node, merging with either side where adjacent.
+	if (previous && previous->offset + previous->size == offset) {
+		previous->size += size;
+		if (node && previous->offset + previous->size == node->offset) {
+			previous->size += node->size;
+			previous->next = node->next;
+			list_walk_node_return(list, node);
+		}
+	} else if (node && offset + size == node->offset) {
+		node->offset = offset;
+		node->size += size;
+	} else {
+		list_walk_node* new_node = list_walk_node_get(list, offset, size, node);
+		if (previous) {
+			previous->next = new_node;
+		} else {
+			list->head = new_node;
+		}
+	}
+}
+
+static void list_walk_stats(list_walk* list, u64* out_free, u64* out_largest, u32* out_ranges) {
+	*out_free = 0;
+	*out_largest = 0;
+	*out_ranges = 0;
+	for (list_walk_node* node = list->head; node; node = node->next) {
+		*out_free += node->size;
+		*out_largest = KMAX(*out_largest, node->size);
+		(*out_ranges)++;
+	}
+}
+
+// A small deterministic generator, so both lists see exactly the same workload.
+static u32 bench_random(u32* state) {
+	*state = (*state * 1664525U) + 1013904223U;
+	return *state >> 8;
+}
+
+static u64 bench_size(u32* state) {
+	u32 roll = bench_random(state) % 100;
+	if (roll < 70) {
+		return 16 + (bench_random(state) % 240);
+	} else if (roll < 95) {
+		return 256 + (bench_random(state) % 3840);
+	}
+	return KIBIBYTES(4) + (bench_random(state) % KIBIBYTES(60));
+}
+
+typedef struct bench_slot {
+	u64 offset;
+	u64 size;
+} bench_slot;
+
+static u8 freelist_fragmentation_benchmark(void) {
+	bench_slot* slots = kallocate(sizeof(bench_slot) * BENCH_SLOT_COUNT, MEMORY_TAG_ENGINE);
+
+	// The freelist.
+	u64 memory_requirement = 0;
+	freelist_create(BENCH_TOTAL_SIZE, &memory_requirement, 0, 0);
+	void* block = kallocate(memory_requirement, MEMORY_TAG_ENGINE);
+	freelist list;
+	freelist_create(BENCH_TOTAL_SIZE, &memory_requirement, block, &list);
+
+	kset_memory(slots, 0xFF, sizeof(bench_slot) * BENCH_SLOT_COUNT);
+	u32 rng = 1234;
+	u32 failures = 0;
+	kclock clock;
+	kclock_start(&clock);
+	for (u32 i = 0; i < BENCH_OP_COUNT; ++i) {
+		bench_slot* slot = &slots[bench_random(&rng) % BENCH_SLOT_COUNT];
+		if (slot->offset == INVALID_ID_U64) {
+			slot->size = bench_size(&rng);
+			if (!freelist_allocate_block(&list, slot->size, &slot->offset)) {
+				slot->offset = INVALID_ID_U64;
+				failures++;
+			}
+		} else {
+			freelist_free_block(&list, slot->size, slot->offset);
+			slot->offset = INVALID_ID_U64;
+		}
+	}
+	kclock_update(&clock);
+	f64 freelist_time = clock.elapsed;
+	u64 freelist_free = freelist_free_space(&list);
+	u64 freelist_largest = freelist_largest_free_block(&list);
+	u32 freelist_failures = failures;
+
+	freelist_destroy(&list);
+	kfree(block, memory_requirement, MEMORY_TAG_ENGINE);
+
+	// The list walk, with the same workload.
+	list_walk walk;
+	list_walk_create(&walk, BENCH_TOTAL_SIZE);
+
+	kset_memory(slots, 0xFF, sizeof(bench_slot) * BENCH_SLOT_COUNT);
+	rng = 1234;
+	failures = 0;
+	kclock_start(&clock);
+	for (u32 i = 0; i < BENCH_OP_COUNT; ++i) {
+		bench_slot* slot = &slots[bench_random(&rng) % BENCH_SLOT_COUNT];
+		if (slot->offset == INVALID_ID_U64) {
+			slot->size = bench_size(&rng);
+			if (!list_walk_allocate(&walk, slot->size, &slot->offset)) {
+				slot->offset = INVALID_ID_U64;
+				failures++;
+			}
+		} else {
+			list_walk_free(&walk, slot->size, slot->offset);
+			slot->offset = INVALID_ID_U64;
+		}
+	}
+	kclock_update(&clock);
+	f64 walk_time = clock.elapsed;
+	u64 walk_free = 0;
+	u64 walk_largest = 0;
+	u32 walk_ranges = 0;
+	list_walk_stats(&walk, &walk_free, &walk_largest, &walk_ranges);
+	list_walk_destroy(&walk);
+
+	KINFO("Freelist fragmentation benchmark (%u ops, %u slots, %lluMiB):", BENCH_OP_COUNT, BENCH_SLOT_COUNT, BENCH_TOTAL_SIZE / MEBIBYTES(1));
+	KINFO("  segregated fit: %.6f sec, %u failed, free %llu, largest free block %llu (%.2f%% fragmented)",
+		  freelist_time, freelist_failures, freelist_free, freelist_largest, 100.0 * (1.0 - ((f64)freelist_largest / (f64)freelist_free)));
+	KINFO("  list walk:      %.6f sec, %u failed, free %llu, largest free block %llu (%.2f%% fragmented, %u ranges)",
+		  walk_time, failures, walk_free, walk_largest, 100.0 * (1.0 - ((f64)walk_largest / (f64)walk_free)), walk_ranges);
+
+	kfree(slots, sizeof(bench_slot) * BENCH_SLOT_COUNT, MEMORY_TAG_ENGINE);
+
+	return true;
+}
+
+void freelist_benchmark_register_tests(void) {
+	test_manager_register_test(freelist_fragmentation_benchmark, "Freelist fragmentation benchmark against a list walk");
+}
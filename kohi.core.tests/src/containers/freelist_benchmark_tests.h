@@ -0,0 +1,3 @@
+#pragma once
+
+void freelist_benchmark_register_tests(void);
@@ -1,5 +1,6 @@
 #include "../expect.h"
 #include "../test_manager.h"
+#include "../test_random.h"
 
 #include <containers/freelist.h>
 #include <defines.h>
@@ -409,6 +410,53 @@ u8 freelist_multiple_alloc_and_free_random(void) {
 	return true;
 }
 
+u8 freelist_should_coalesce_after_fragmenting(void) {
+	// Mixed-size allocations and frees in a random order, to fragment the list.
+	const u64 total_size = MEBIBYTES(8);
+	const u32 slot_count = 1024;
+	const u32 op_count = 10000;
+
+	u64 memory_requirement = 0;
+	freelist_create(total_size, &memory_requirement, 0, 0);
+	void* block = kallocate(memory_requirement, MEMORY_TAG_ENGINE);
+	freelist list;
+	freelist_create(total_size, &memory_requirement, block, &list);
+
+	alloc_data* slots = kallocate(sizeof(alloc_data) * slot_count, MEMORY_TAG_ENGINE);
+	for (u32 i = 0; i < slot_count; ++i) {
+		slots[i].offset = INVALID_ID;
+	}
+
+	u32 rng = 1234;
+	for (u32 i = 0; i < op_count; ++i) {
+		alloc_data* slot = &slots[test_random(&rng) % slot_count];
+		if (slot->offset == INVALID_ID) {
+			u32 roll = test_random(&rng) % 100;
+			slot->size = roll < 70 ? 16 + (test_random(&rng) % 240) : (roll < 95 ? 256 + (test_random(&rng) % 3840) : KIBIBYTES(4) + (test_random(&rng) % KIBIBYTES(60)));
+			if (!freelist_allocate_block(&list, slot->size, &slot->offset)) {
+				slot->offset = INVALID_ID;
+			}
+		} else {
+			expect_to_be_true(freelist_free_block(&list, slot->size, slot->offset));
+			slot->offset = INVALID_ID;
+		}
+	}
+
+	// Release everything, which should leave a single range covering the whole list.
+	for (u32 i = 0; i < slot_count; ++i) {
+		if (slots[i].offset != INVALID_ID) {
+			expect_to_be_true(freelist_free_block(&list, slots[i].size, slots[i].offset));
+		}
+	}
+	expect_should_be(total_size, freelist_free_space(&list));
+	expect_should_be(total_size, freelist_largest_free_block(&list));
+
+	kfree(slots, sizeof(alloc_data) * slot_count, MEMORY_TAG_ENGINE);
+	freelist_destroy(&list);
+	kfree(block, memory_requirement, MEMORY_TAG_ENGINE);
+	return true;
+}
+
 void freelist_register_tests(void) {
 	test_manager_register_test(freelist_should_create_and_destroy, "Freelist should create and destroy");
 	test_manager_register_test(freelist_should_allocate_one_and_free_one, "Freelist allocate and free one entry.");
@@ -416,4 +464,5 @@ void freelist_register_tests(void) {
 	test_manager_register_test(freelist_should_allocate_one_and_free_multi_varying_sizes, "Freelist allocate and free multiple entries of varying sizes.");
 	test_manager_register_test(freelist_should_allocate_to_full_and_fail_to_allocate_more, "Freelist allocate to full and fail when trying to allocate more.");
 	test_manager_register_test(freelist_multiple_alloc_and_free_random, "Freelist should randomly allocate and free.");
+	test_manager_register_test(freelist_should_coalesce_after_fragmenting, "Freelist should coalesce back to one range after fragmenting.");
 }
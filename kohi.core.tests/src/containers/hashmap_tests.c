@@ -0,0 +1,197 @@
+#include "hashmap_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <containers/hashmap.h>
+#include <defines.h>
+#include <strings/kname.h>
+
+typedef struct hashmap_test_value {
+	u64 id;
+	f32 weight;
+	u8 tag;
+} hashmap_test_value;
+
+static u8 hashmap_should_create_and_destroy(void) {
+	hashmap map;
+	expect_to_be_true(hashmap_create(sizeof(hashmap_test_value), 100, &map));
+	expect_should_not_be(0, map.controls);
+	expect_should_be(sizeof(hashmap_test_value), map.value_stride);
+	expect_should_be(0, map.count);
+	// Enough room for 100 entries without passing the load factor.
+	expect_to_be_true(map.capacity >= 100);
+	expect_should_be(0, map.capacity & (map.capacity - 1));
+
+	hashmap_destroy(&map);
+	expect_should_be(0, map.controls);
+	expect_should_be(0, map.capacity);
+
+	return true;
+}
+
+static u8 hashmap_should_set_get_and_overwrite(void) {
+	hashmap map;
+	hashmap_create(sizeof(hashmap_test_value), 0, &map);
+
+	hashmap_test_value out = {0};
+	expect_to_be_false(hashmap_u64_get(&map, 42, &out));
+	expect_should_be(0, hashmap_u64_get_ptr(&map, 42));
+
+	hashmap_test_value v = {7, 2.5f, 3};
+	expect_to_be_true(hashmap_u64_set(&map, 42, &v));
+	expect_should_be(1, map.count);
+	expect_to_be_true(hashmap_u64_get(&map, 42, &out));
+	expect_should_be(7, out.id);
+	expect_float_to_be(2.5f, out.weight);
+	expect_should_be(3, out.tag);
+
+	// Setting again replaces the value without adding an entry.
+	v.id = 99;
+	expect_to_be_true(hashmap_u64_set(&map, 42, &v));
+	expect_should_be(1, map.count);
+	hashmap_test_value* ptr = hashmap_u64_get_ptr(&map, 42);
+	expect_should_not_be(0, ptr);
+	expect_should_be(99, ptr->id);
+
+	// Values can be modified in place.
+	ptr->tag = 11;
+	expect_to_be_true(hashmap_u64_get(&map, 42, &out));
+	expect_should_be(11, out.tag);
+
+	hashmap_destroy(&map);
+
+	return true;
+}
+
+static u8 hashmap_should_keep_all_entries_across_growth(void) {
+	hashmap map;
+	hashmap_create(sizeof(u64), 0, &map);
+
+	// Far more entries than slots in the initial groups, so many share control hashes and groups.
+	const u64 entry_count = 10000;
+	for (u64 i = 0; i < entry_count; ++i) {
+		u64 value = i * 31;
+		expect_to_be_true(hashmap_u64_set(&map, i << 12, &value));
+	}
+	expect_should_be(entry_count, map.count);
+	expect_to_be_true((u64)map.count * 8 <= (u64)map.capacity * 7);
+
+	for (u64 i = 0; i < entry_count; ++i) {
+		u64 value = 0;
+		expect_to_be_true(hashmap_u64_get(&map, i << 12, &value));
+		expect_should_be(i * 31, value);
+	}
+	// Keys which were never added are not found.
+	for (u64 i = 0; i < entry_count; ++i) {
+		expect_should_be(0, hashmap_u64_get_ptr(&map, (i << 12) + 1));
+	}
+
+	hashmap_destroy(&map);
+
+	return true;
+}
+
+static u8 hashmap_should_remove_and_reuse_slots(void) {
+	hashmap map;
+	hashmap_create(sizeof(u32), 64, &map);
+	u32 capacity = map.capacity;
+
+	// Churn through many more keys than the capacity, removing every one. Tombstones
+	// must be cleaned up rather than growing the map indefinitely.
+	for (u32 round = 0; round < 100; ++round) {
+		for (u32 i = 0; i < 32; ++i) {
+			u32 key = (round * 32) + i;
+			expect_to_be_true(hashmap_u64_set(&map, key, &key));
+		}
+		expect_should_be(32, map.count);
+		for (u32 i = 0; i < 32; i += 2) {
+			expect_to_be_true(hashmap_u64_remove(&map, (round * 32) + i));
+		}
+		// Removing twice fails.
+		expect_to_be_false(hashmap_u64_remove(&map, round * 32));
+		// Odd keys survive the removal of their neighbours.
+		for (u32 i = 1; i < 32; i += 2) {
+			u32 value = 0;
+			expect_to_be_true(hashmap_u64_get(&map, (round * 32) + i, &value));
+			expect_should_be((round * 32) + i, value);
+		}
+		for (u32 i = 1; i < 32; i += 2) {
+			expect_to_be_true(hashmap_u64_remove(&map, (round * 32) + i));
+		}
+		expect_should_be(0, map.count);
+	}
+	expect_should_be(capacity, map.capacity);
+
+	hashmap_destroy(&map);
+
+	return true;
+}
+
+static u8 hashmap_should_iterate_all_entries(void) {
+	hashmap map;
+	hashmap_create(sizeof(u64), 0, &map);
+
+	u64 expected_sum = 0;
+	for (u64 i = 1; i <= 500; ++i) {
+		hashmap_u64_set(&map, i, &i);
+		expected_sum += i;
+	}
+	hashmap_u64_remove(&map, 250);
+	expected_sum -= 250;
+
+	u32 iterator = 0;
+	u64 key = 0;
+	void* value = 0;
+	u64 key_sum = 0;
+	u32 visited = 0;
+	while (hashmap_iterate(&map, &iterator, &key, &value)) {
+		expect_should_be(key, *(u64*)value);
+		key_sum += key;
+		visited++;
+	}
+	expect_should_be(499, visited);
+	expect_should_be(expected_sum, key_sum);
+
+	hashmap_clear(&map);
+	expect_should_be(0, map.count);
+	iterator = 0;
+	expect_to_be_false(hashmap_iterate(&map, &iterator, 0, 0));
+
+	hashmap_destroy(&map);
+
+	return true;
+}
+
+static u8 hashmap_should_use_kname_keys(void) {
+	hashmap map;
+	hashmap_create(sizeof(void*), 0, &map);
+
+	kname a = 0x1234567890ABCDEFull;
+	kname b = 0xFEDCBA0987654321ull;
+	void* pa = &a;
+	void* pb = &b;
+	expect_to_be_true(hashmap_kname_set(&map, a, &pa));
+	expect_to_be_true(hashmap_kname_set(&map, b, &pb));
+
+	void* out = 0;
+	expect_to_be_true(hashmap_kname_get(&map, a, &out));
+	expect_should_be(pa, out);
+	expect_should_be(pb, *(void**)hashmap_kname_get_ptr(&map, b));
+
+	expect_to_be_true(hashmap_kname_remove(&map, a));
+	expect_to_be_false(hashmap_kname_get(&map, a, &out));
+	expect_should_be(1, map.count);
+
+	hashmap_destroy(&map);
+
+	return true;
+}
+
+void hashmap_register_tests(void) {
+	test_manager_register_test(hashmap_should_create_and_destroy, "Hashmap should create and destroy");
+	test_manager_register_test(hashmap_should_set_get_and_overwrite, "Hashmap should set, get and overwrite values");
+	test_manager_register_test(hashmap_should_keep_all_entries_across_growth, "Hashmap should keep all entries across growth");
+	test_manager_register_test(hashmap_should_remove_and_reuse_slots, "Hashmap should remove entries and reuse their slots");
+	test_manager_register_test(hashmap_should_iterate_all_entries, "Hashmap should iterate all entries");
+	test_manager_register_test(hashmap_should_use_kname_keys, "Hashmap should use kname keys");
+}
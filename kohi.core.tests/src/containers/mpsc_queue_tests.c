@@ -0,0 +1,109 @@
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <containers/mpsc_queue.h>
+#include <defines.h>
+#include <memory/kmemory.h>
+
+typedef struct mpsc_test_value {
+	u64 id;
+	void* ptr;
+	u8 tag;
+} mpsc_test_value;
+
+static u8 mpsc_queue_should_create_and_destroy(void) {
+	mpsc_queue queue;
+	expect_to_be_true(mpsc_queue_create(sizeof(mpsc_test_value), 16, 0, &queue));
+	expect_should_not_be(0, queue.block);
+	expect_should_be(16, queue.capacity);
+	expect_should_be(sizeof(mpsc_test_value), queue.stride);
+
+	mpsc_queue_destroy(&queue);
+	expect_should_be(0, queue.block);
+
+	return true;
+}
+
+static u8 mpsc_queue_should_reject_non_power_of_two_capacity(void) {
+	KDEBUG("The following error message is intentional.");
+	mpsc_queue queue;
+	expect_to_be_false(mpsc_queue_create(sizeof(u32), 12, 0, &queue));
+
+	return true;
+}
+
+static u8 mpsc_queue_should_enqueue_and_dequeue_in_order(void) {
+	mpsc_queue queue;
+	mpsc_queue_create(sizeof(mpsc_test_value), 8, 0, &queue);
+
+	mpsc_test_value out;
+	// Nothing to dequeue yet.
+	expect_to_be_false(mpsc_queue_dequeue(&queue, &out));
+
+	for (u64 i = 0; i < 5; ++i) {
+		mpsc_test_value v = {i * 3, (void*)(i + 1), (u8)i};
+		expect_to_be_true(mpsc_queue_enqueue(&queue, &v));
+	}
+
+	for (u64 i = 0; i < 5; ++i) {
+		expect_to_be_true(mpsc_queue_dequeue(&queue, &out));
+		expect_should_be(i * 3, out.id);
+		expect_should_be((void*)(i + 1), out.ptr);
+		expect_should_be((u8)i, out.tag);
+	}
+	expect_to_be_false(mpsc_queue_dequeue(&queue, &out));
+
+	mpsc_queue_destroy(&queue);
+
+	return true;
+}
+
+static u8 mpsc_queue_should_fail_when_full_and_wrap_around(void) {
+	// Use caller-provided memory this time.
+	u64 requirement = mpsc_queue_memory_requirement(sizeof(u32), 4);
+	void* block = kallocate(requirement, MEMORY_TAG_ENGINE);
+	mpsc_queue queue;
+	mpsc_queue_create(sizeof(u32), 4, block, &queue);
+
+	u32 next_in = 0;
+	u32 next_out = 0;
+	// Go around the ring several times, filling it completely each lap.
+	for (u32 lap = 0; lap < 5; ++lap) {
+		for (u32 i = 0; i < 4; ++i) {
+			expect_to_be_true(mpsc_queue_enqueue(&queue, &next_in));
+			next_in++;
+		}
+		expect_to_be_false(mpsc_queue_enqueue(&queue, &next_in));
+
+		// Drain only part of it, so that the head and tail drift apart.
+		for (u32 i = 0; i < 3; ++i) {
+			u32 out = 0;
+			expect_to_be_true(mpsc_queue_dequeue(&queue, &out));
+			expect_should_be(next_out, out);
+			next_out++;
+		}
+		for (u32 i = 0; i < 3; ++i) {
+			expect_to_be_true(mpsc_queue_enqueue(&queue, &next_in));
+			next_in++;
+		}
+		while (next_out < next_in) {
+			u32 out = 0;
+			expect_to_be_true(mpsc_queue_dequeue(&queue, &out));
+			expect_should_be(next_out, out);
+			next_out++;
+		}
+	}
+
+	mpsc_queue_destroy(&queue);
+	// Memory passed in is not owned by the queue.
+	kfree(block, requirement, MEMORY_TAG_ENGINE);
+
+	return true;
+}
+
+void mpsc_queue_register_tests(void) {
+	test_manager_register_test(mpsc_queue_should_create_and_destroy, "MPSC queue should create and destroy");
+	test_manager_register_test(mpsc_queue_should_reject_non_power_of_two_capacity, "MPSC queue should reject a capacity which is not a power of 2");
+	test_manager_register_test(mpsc_queue_should_enqueue_and_dequeue_in_order, "MPSC queue should enqueue and dequeue in order");
+	test_manager_register_test(mpsc_queue_should_fail_when_full_and_wrap_around, "MPSC queue should fail when full and wrap around");
+}
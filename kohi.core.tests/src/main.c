@@ -2,13 +2,22 @@
 
 #include "containers/array_tests.h"
 #include "containers/binary_string_table_tests.h"
+#include "containers/bvh_tests.h"
 #include "containers/darray_tests.h"
+#include "containers/freelist_benchmark_tests.h"
 #include "containers/freelist_tests.h"
+#include "containers/hashmap_tests.h"
 #include "containers/hashtable_tests.h"
+#include "containers/mpsc_queue_tests.h"
 #include "containers/stackarray_tests.h"
+#include "math/kmath_benchmark_tests.h"
+#include "math/kmath_tests.h"
 #include "memory/dynamic_allocator_tests.h"
+#include "memory/kmemory_tests.h"
 #include "memory/linear_allocator_tests.h"
 #include "parsers/kson_parser_tests.h"
+#include "serializers/kasset_model_serializer_tests.h"
+#include "strings/kname_tests.h"
 #include "strings/string_tests.h"
 #include "test_manager.h"
 
@@ -19,14 +28,29 @@ int main(void) {
 	// TODO: add test registrations here.
 	binary_string_table_register_tests();
 	string_register_tests();
+	kname_register_tests();
 	array_register_tests();
 	darray_register_tests();
 	stackarray_register_tests();
 	kson_parser_register_tests();
 	linear_allocator_register_tests();
 	hashtable_register_tests();
+	hashmap_register_tests();
+	bvh_register_tests();
 	freelist_register_tests();
+#ifdef KOHI_BENCHMARKS
+	// Only reports timings, so is left out of regular runs.
+	freelist_benchmark_register_tests();
+#endif
+	mpsc_queue_register_tests();
 	dynamic_allocator_register_tests();
+	kmemory_register_tests();
+	kmath_register_tests();
+#ifdef KOHI_BENCHMARKS
+	// Only reports timings, so is left out of regular runs.
+	kmath_benchmark_register_tests();
+#endif
+	kasset_model_serializer_register_tests();
 	string_register_tests();
 
 	KDEBUG("Starting tests...");
@@ -0,0 +1,207 @@
+#include "kmath_benchmark_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+#include "../test_random.h"
+
+#include <defines.h>
+#include <math/kmath.h>
+#include <memory/kmemory.h>
+#include <time/kclock.h>
+
+/*
+ * Times each SIMD math kernel against its scalar reference implementation over the
+ * same inputs. Results are folded into a checksum so that no work can be skipped.
+ */
+
+#define BENCH_MATRIX_COUNT 4096
+#define BENCH_PASS_COUNT 64
+
+typedef struct bench_data {
+	mat4* a;
+	mat4* b;
+	mat4* out;
+	vec4* vectors;
+	aabb* local_aabbs;
+	aabb* out_aabbs;
+} bench_data;
+
+static f32 checksum_mat4(const mat4* matrices) {
+	f32 sum = 0;
+	for (u32 i = 0; i < BENCH_MATRIX_COUNT; ++i) {
+		sum += matrices[i].data[0] + matrices[i].data[5] + matrices[i].data[10] + matrices[i].data[15];
+	}
+	return sum;
+}
+
+// Both paths should have produced the same results, to within rounding.
+static b8 sums_match(f32 scalar_sum, f32 simd_sum) {
+	return kabs(scalar_sum - simd_sum) <= 1e-3f * KMAX(1.0f, kabs(scalar_sum));
+}
+
+static void bench_report(const char* name, f64 scalar_time, f64 simd_time) {
+	KINFO("  %-16s scalar %.6f sec, simd %.6f sec (%.2fx)", name, scalar_time, simd_time, simd_time > 0 ? scalar_time / simd_time : 0.0);
+}
+
+static u8 kmath_simd_benchmark(void) {
+	bench_data data;
+	data.a = kallocate(sizeof(mat4) * BENCH_MATRIX_COUNT, MEMORY_TAG_ENGINE);
+	data.b = kallocate(sizeof(mat4) * BENCH_MATRIX_COUNT, MEMORY_TAG_ENGINE);
+	data.out = kallocate(sizeof(mat4) * BENCH_MATRIX_COUNT, MEMORY_TAG_ENGINE);
+	data.vectors = kallocate(sizeof(vec4) * BENCH_MATRIX_COUNT, MEMORY_TAG_ENGINE);
+	data.local_aabbs = kallocate(sizeof(aabb) * BENCH_MATRIX_COUNT, MEMORY_TAG_ENGINE);
+	data.out_aabbs = kallocate(sizeof(aabb) * BENCH_MATRIX_COUNT, MEMORY_TAG_ENGINE);
+
+	u32 rng = 1234;
+	for (u32 i = 0; i < BENCH_MATRIX_COUNT; ++i) {
+		data.a[i] = test_random_transform(&rng);
+		data.b[i] = test_random_transform(&rng);
+		data.vectors[i] = (vec4){test_random_f32(&rng, -10.0f, 10.0f), test_random_f32(&rng, -10.0f, 10.0f), test_random_f32(&rng, -10.0f, 10.0f), 1.0f};
+		vec3 extents = {test_random_f32(&rng, 0.1f, 5.0f), test_random_f32(&rng, 0.1f, 5.0f), test_random_f32(&rng, 0.1f, 5.0f)};
+		data.local_aabbs[i] = aabb_create(vec3_mul_scalar(extents, -1.0f), extents);
+	}
+
+	f32 scalar_sum = 0;
+	f32 simd_sum = 0;
+	kclock clock;
+
+	KINFO("Math SIMD benchmark (%u items, %u passes):", BENCH_MATRIX_COUNT, BENCH_PASS_COUNT);
+
+	// mat4_mul
+	kclock_start(&clock);
+	for (u32 pass = 0; pass < BENCH_PASS_COUNT; ++pass) {
+		for (u32 i = 0; i < BENCH_MATRIX_COUNT; ++i) {
+			data.out[i] = mat4_mul_scalar(data.a[i], data.b[i]);
+		}
+		scalar_sum += checksum_mat4(data.out);
+	}
+	kclock_update(&clock);
+	f64 scalar_time = clock.elapsed;
+
+	kclock_start(&clock);
+	for (u32 pass = 0; pass < BENCH_PASS_COUNT; ++pass) {
+		for (u32 i = 0; i < BENCH_MATRIX_COUNT; ++i) {
+			data.out[i] = mat4_mul(data.a[i], data.b[i]);
+		}
+		simd_sum += checksum_mat4(data.out);
+	}
+	kclock_update(&clock);
+	bench_report("mat4_mul", scalar_time, clock.elapsed);
+	expect_to_be_true(sums_match(scalar_sum, simd_sum));
+
+	// mat4_mul_batch, against the same scalar time.
+	simd_sum = 0;
+	kclock_start(&clock);
+	for (u32 pass = 0; pass < BENCH_PASS_COUNT; ++pass) {
+		mat4_mul_batch(data.a, data.b, data.out, BENCH_MATRIX_COUNT);
+		simd_sum += checksum_mat4(data.out);
+	}
+	kclock_update(&clock);
+	bench_report("mat4_mul_batch", scalar_time, clock.elapsed);
+	expect_to_be_true(sums_match(scalar_sum, simd_sum));
+
+	// mat4_inverse
+	scalar_sum = simd_sum = 0;
+	kclock_start(&clock);
+	for (u32 pass = 0; pass < BENCH_PASS_COUNT; ++pass) {
+		for (u32 i = 0; i < BENCH_MATRIX_COUNT; ++i) {
+			data.out[i] = mat4_inverse_scalar(data.a[i]);
+		}
+		scalar_sum += checksum_mat4(data.out);
+	}
+	kclock_update(&clock);
+	scalar_time = clock.elapsed;
+
+	kclock_start(&clock);
+	for (u32 pass = 0; pass < BENCH_PASS_COUNT; ++pass) {
+		for (u32 i = 0; i < BENCH_MATRIX_COUNT; ++i) {
+			data.out[i] = mat4_inverse(data.a[i]);
+		}
+		simd_sum += checksum_mat4(data.out);
+	}
+	kclock_update(&clock);
+	bench_report("mat4_inverse", scalar_time, clock.elapsed);
+	expect_to_be_true(sums_match(scalar_sum, simd_sum));
+
+	// mat4_from_translation_rotation_scale
+	scalar_sum = simd_sum = 0;
+	kclock_start(&clock);
+	for (u32 pass = 0; pass < BENCH_PASS_COUNT; ++pass) {
+		for (u32 i = 0; i < BENCH_MATRIX_COUNT; ++i) {
+			vec4 v = data.vectors[i];
+			data.out[i] = mat4_from_translation_rotation_scale_scalar(vec3_from_vec4(v), quat_normalize(v), vec3_from_vec4(v));
+		}
+		scalar_sum += checksum_mat4(data.out);
+	}
+	kclock_update(&clock);
+	scalar_time = clock.elapsed;
+
+	kclock_start(&clock);
+	for (u32 pass = 0; pass < BENCH_PASS_COUNT; ++pass) {
+		for (u32 i = 0; i < BENCH_MATRIX_COUNT; ++i) {
+			vec4 v = data.vectors[i];
+			data.out[i] = mat4_from_translation_rotation_scale(vec3_from_vec4(v), quat_normalize(v), vec3_from_vec4(v));
+		}
+		simd_sum += checksum_mat4(data.out);
+	}
+	kclock_update(&clock);
+	bench_report("mat4_trs", scalar_time, clock.elapsed);
+	expect_to_be_true(sums_match(scalar_sum, simd_sum));
+
+	// vec4_mul_mat4
+	scalar_sum = simd_sum = 0;
+	kclock_start(&clock);
+	for (u32 pass = 0; pass < BENCH_PASS_COUNT; ++pass) {
+		for (u32 i = 0; i < BENCH_MATRIX_COUNT; ++i) {
+			vec4 v = vec4_mul_mat4_scalar(data.vectors[i], data.a[i]);
+			scalar_sum += v.x + v.y + v.z + v.w;
+		}
+	}
+	kclock_update(&clock);
+	scalar_time = clock.elapsed;
+
+	kclock_start(&clock);
+	for (u32 pass = 0; pass < BENCH_PASS_COUNT; ++pass) {
+		for (u32 i = 0; i < BENCH_MATRIX_COUNT; ++i) {
+			vec4 v = vec4_mul_mat4(data.vectors[i], data.a[i]);
+			simd_sum += v.x + v.y + v.z + v.w;
+		}
+	}
+	kclock_update(&clock);
+	bench_report("vec4_mul_mat4", scalar_time, clock.elapsed);
+	expect_to_be_true(sums_match(scalar_sum, simd_sum));
+
+	// aabb_transform_batch
+	scalar_sum = simd_sum = 0;
+	kclock_start(&clock);
+	for (u32 pass = 0; pass < BENCH_PASS_COUNT; ++pass) {
+		for (u32 i = 0; i < BENCH_MATRIX_COUNT; ++i) {
+			data.out_aabbs[i] = aabb_from_mat4_extents(data.local_aabbs[i].min, data.local_aabbs[i].max, data.a[i]);
+		}
+		scalar_sum += data.out_aabbs[pass].max.x - data.out_aabbs[pass].min.y;
+	}
+	kclock_update(&clock);
+	scalar_time = clock.elapsed;
+
+	kclock_start(&clock);
+	for (u32 pass = 0; pass < BENCH_PASS_COUNT; ++pass) {
+		aabb_transform_batch(data.local_aabbs, data.a, data.out_aabbs, BENCH_MATRIX_COUNT);
+		simd_sum += data.out_aabbs[pass].max.x - data.out_aabbs[pass].min.y;
+	}
+	kclock_update(&clock);
+	bench_report("aabb_transform", scalar_time, clock.elapsed);
+	expect_to_be_true(sums_match(scalar_sum, simd_sum));
+
+	kfree(data.a, sizeof(mat4) * BENCH_MATRIX_COUNT, MEMORY_TAG_ENGINE);
+	kfree(data.b, sizeof(mat4) * BENCH_MATRIX_COUNT, MEMORY_TAG_ENGINE);
+	kfree(data.out, sizeof(mat4) * BENCH_MATRIX_COUNT, MEMORY_TAG_ENGINE);
+	kfree(data.vectors, sizeof(vec4) * BENCH_MATRIX_COUNT, MEMORY_TAG_ENGINE);
+	kfree(data.local_aabbs, sizeof(aabb) * BENCH_MATRIX_COUNT, MEMORY_TAG_ENGINE);
+	kfree(data.out_aabbs, sizeof(aabb) * BENCH_MATRIX_COUNT, MEMORY_TAG_ENGINE);
+
+	return true;
+}
+
+void kmath_benchmark_register_tests(void) {
+	test_manager_register_test(kmath_simd_benchmark, "Math SIMD kernels benchmark against scalar references");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void kmath_benchmark_register_tests(void);
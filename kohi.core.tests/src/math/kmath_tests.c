@@ -0,0 +1,161 @@
+#include "kmath_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+#include "../test_random.h"
+
+#include <defines.h>
+#include <math/kmath.h>
+
+/*
+ * Checks the SIMD paths of the math kernels against their scalar reference
+ * implementations. On targets without SIMD, both are the same and these trivially pass.
+ */
+
+#define MATRIX_COUNT 256
+
+static mat4 test_random_mat4(u32* state) {
+	mat4 m;
+	for (u32 i = 0; i < 16; ++i) {
+		m.data[i] = test_random_f32(state, -2.0f, 2.0f);
+	}
+	return m;
+}
+
+static b8 floats_close(const f32* a, const f32* b, u32 count, f32 tolerance) {
+	for (u32 i = 0; i < count; ++i) {
+		f32 scale = KMAX(1.0f, KMAX(kabs(a[i]), kabs(b[i])));
+		if (kabs(a[i] - b[i]) > tolerance * scale) {
+			KERROR("--> Element %u differs: %f vs %f.", i, a[i], b[i]);
+			return false;
+		}
+	}
+	return true;
+}
+
+static u8 mat4_mul_matches_scalar(void) {
+	u32 rng = 1234;
+	for (u32 i = 0; i < MATRIX_COUNT; ++i) {
+		mat4 a = test_random_mat4(&rng);
+		mat4 b = test_random_mat4(&rng);
+		mat4 expected = mat4_mul_scalar(a, b);
+		mat4 actual = mat4_mul(a, b);
+		expect_to_be_true(floats_close(expected.data, actual.data, 16, 1e-5f));
+	}
+	return true;
+}
+
+static u8 mat4_inverse_matches_scalar(void) {
+	u32 rng = 1234;
+	mat4 identity = mat4_identity();
+	for (u32 i = 0; i < MATRIX_COUNT; ++i) {
+		mat4 m = test_random_transform(&rng);
+		mat4 expected = mat4_inverse_scalar(m);
+		mat4 actual = mat4_inverse(m);
+		expect_to_be_true(floats_close(expected.data, actual.data, 16, 1e-4f));
+
+		// Multiplying back should give identity.
+		mat4 product = mat4_mul(m, actual);
+		expect_to_be_true(floats_close(identity.data, product.data, 16, 1e-3f));
+	}
+	return true;
+}
+
+static u8 mat4_trs_matches_scalar(void) {
+	u32 rng = 1234;
+	for (u32 i = 0; i < MATRIX_COUNT; ++i) {
+		vec3 axis = vec3_normalized((vec3){test_random_f32(&rng, -1.0f, 1.0f), test_random_f32(&rng, -1.0f, 1.0f), test_random_f32(&rng, -1.0f, 1.0f)});
+		quat rotation = quat_from_axis_angle(axis, test_random_f32(&rng, -K_PI, K_PI), true);
+		vec3 position = {test_random_f32(&rng, -100.0f, 100.0f), test_random_f32(&rng, -100.0f, 100.0f), test_random_f32(&rng, -100.0f, 100.0f)};
+		vec3 scale = {test_random_f32(&rng, -4.0f, 4.0f), test_random_f32(&rng, -4.0f, 4.0f), test_random_f32(&rng, -4.0f, 4.0f)};
+
+		mat4 expected = mat4_from_translation_rotation_scale_scalar(position, rotation, scale);
+		mat4 actual = mat4_from_translation_rotation_scale(position, rotation, scale);
+		expect_to_be_true(floats_close(expected.data, actual.data, 16, 1e-6f));
+	}
+	return true;
+}
+
+static u8 mat4_vec4_mul_matches_scalar(void) {
+	u32 rng = 1234;
+	for (u32 i = 0; i < MATRIX_COUNT; ++i) {
+		mat4 m = test_random_mat4(&rng);
+		vec4 v = {test_random_f32(&rng, -10.0f, 10.0f), test_random_f32(&rng, -10.0f, 10.0f), test_random_f32(&rng, -10.0f, 10.0f), test_random_f32(&rng, -10.0f, 10.0f)};
+
+		vec4 expected = mat4_mul_vec4_scalar(m, v);
+		vec4 actual = mat4_mul_vec4(m, v);
+		expect_to_be_true(floats_close(expected.elements, actual.elements, 4, 1e-5f));
+
+		expected = vec4_mul_mat4_scalar(v, m);
+		actual = vec4_mul_mat4(v, m);
+		expect_to_be_true(floats_close(expected.elements, actual.elements, 4, 1e-5f));
+	}
+	return true;
+}
+
+static u8 mat4_mul_batch_matches_single(void) {
+	u32 rng = 1234;
+	mat4 a[MATRIX_COUNT];
+	mat4 b[MATRIX_COUNT];
+	mat4 out[MATRIX_COUNT];
+	for (u32 i = 0; i < MATRIX_COUNT; ++i) {
+		a[i] = test_random_mat4(&rng);
+		b[i] = test_random_mat4(&rng);
+	}
+
+	mat4_mul_batch(a, b, out, MATRIX_COUNT);
+	for (u32 i = 0; i < MATRIX_COUNT; ++i) {
+		mat4 expected = mat4_mul_scalar(a[i], b[i]);
+		expect_to_be_true(floats_close(expected.data, out[i].data, 16, 1e-5f));
+	}
+
+	// Writing over the second input.
+	mat4 a_copy[MATRIX_COUNT];
+	kcopy_memory(a_copy, a, sizeof(mat4) * MATRIX_COUNT);
+	mat4_mul_batch(a, b, b, MATRIX_COUNT);
+	for (u32 i = 0; i < MATRIX_COUNT; ++i) {
+		expect_to_be_true(floats_close(out[i].data, b[i].data, 16, 0.0f));
+	}
+
+	// Writing over the first input.
+	mat4 b_copy[MATRIX_COUNT];
+	for (u32 i = 0; i < MATRIX_COUNT; ++i) {
+		b_copy[i] = test_random_mat4(&rng);
+		out[i] = mat4_mul_scalar(a_copy[i], b_copy[i]);
+	}
+	mat4_mul_batch(a_copy, b_copy, a_copy, MATRIX_COUNT);
+	for (u32 i = 0; i < MATRIX_COUNT; ++i) {
+		expect_to_be_true(floats_close(out[i].data, a_copy[i].data, 16, 1e-5f));
+	}
+	return true;
+}
+
+static u8 aabb_transform_batch_matches_single(void) {
+	u32 rng = 1234;
+	aabb local[MATRIX_COUNT];
+	mat4 matrices[MATRIX_COUNT];
+	aabb out[MATRIX_COUNT];
+	for (u32 i = 0; i < MATRIX_COUNT; ++i) {
+		vec3 a = {test_random_f32(&rng, -5.0f, 5.0f), test_random_f32(&rng, -5.0f, 5.0f), test_random_f32(&rng, -5.0f, 5.0f)};
+		vec3 b = {test_random_f32(&rng, -5.0f, 5.0f), test_random_f32(&rng, -5.0f, 5.0f), test_random_f32(&rng, -5.0f, 5.0f)};
+		local[i] = aabb_create(vec3_min(a, b), vec3_max(a, b));
+		matrices[i] = test_random_transform(&rng);
+	}
+
+	aabb_transform_batch(local, matrices, out, MATRIX_COUNT);
+	for (u32 i = 0; i < MATRIX_COUNT; ++i) {
+		aabb expected = aabb_from_mat4_extents(local[i].min, local[i].max, matrices[i]);
+		expect_to_be_true(floats_close(expected.min.elements, out[i].min.elements, 3, 1e-5f));
+		expect_to_be_true(floats_close(expected.max.elements, out[i].max.elements, 3, 1e-5f));
+	}
+	return true;
+}
+
+void kmath_register_tests(void) {
+	test_manager_register_test(mat4_mul_matches_scalar, "mat4_mul matches the scalar reference");
+	test_manager_register_test(mat4_inverse_matches_scalar, "mat4_inverse matches the scalar reference");
+	test_manager_register_test(mat4_trs_matches_scalar, "mat4_from_translation_rotation_scale matches the scalar reference");
+	test_manager_register_test(mat4_vec4_mul_matches_scalar, "mat4/vec4 multiplication matches the scalar reference");
+	test_manager_register_test(mat4_mul_batch_matches_single, "mat4_mul_batch matches single multiplication");
+	test_manager_register_test(aabb_transform_batch_matches_single, "aabb_transform_batch matches aabb_from_mat4_extents");
+}
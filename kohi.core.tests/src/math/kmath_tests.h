@@ -0,0 +1,3 @@
+#pragma once
+
+void kmath_register_tests(void);
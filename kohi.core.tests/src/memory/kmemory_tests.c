@@ -0,0 +1,98 @@
+#include "kmemory_tests.h"
+
+#include <defines.h>
+#include <memory/kmemory.h>
+
+#include "../expect.h"
+#include "../test_manager.h"
+
+static b8 memory_system_start(void) {
+	memory_system_configuration config = {0};
+	config.total_alloc_size = MEBIBYTES(8);
+	return memory_system_initialize(config);
+}
+
+static u8 kmemory_small_allocations_should_be_zeroed_and_reused(void) {
+	expect_to_be_true(memory_system_start());
+
+	u64 base_count = get_memory_alloc_count();
+
+	// Dirty a small block, then free it.
+	u8* block = kallocate(40, MEMORY_TAG_ARRAY);
+	expect_should_not_be(0, block);
+	expect_should_be(base_count + 1, get_memory_alloc_count());
+	for (u32 i = 0; i < 40; ++i) {
+		block[i] = 0xAB;
+	}
+	kfree(block, 40, MEMORY_TAG_ARRAY);
+	expect_should_be(base_count, get_memory_alloc_count());
+
+	// A request in the same size class should get the same block back, cleared out.
+	u8* block2 = kallocate(33, MEMORY_TAG_STRING);
+	expect_should_be(block, block2);
+	for (u32 i = 0; i < 33; ++i) {
+		expect_should_be(0, block2[i]);
+	}
+
+	// Size is reported as that of the class it came from.
+	u64 size = 0;
+	u16 alignment = 0;
+	memory_tag tag;
+	expect_to_be_true(kmemory_get_size_alignment(block2, &size, &alignment, &tag));
+	expect_should_be(48, size);
+	expect_should_be(16, alignment);
+	kfree(block2, 33, MEMORY_TAG_STRING);
+
+	memory_system_shutdown();
+
+	return true;
+}
+
+static u8 kmemory_mixed_allocations_should_flush_and_return_all_space(void) {
+	expect_to_be_true(memory_system_start());
+
+	// Start from an empty cache, since anything held in it counts as used space.
+	kmemory_thread_cache_flush();
+	u64 base_count = get_memory_alloc_count();
+	u64 base_free = get_free_memory_space();
+
+	// Enough blocks of varying sizes to refill and flush each cache several times over.
+	const u32 count = 1024;
+	void* blocks[1024];
+	u64 sizes[1024];
+	u16 alignments[1024];
+	for (u32 i = 0; i < count; ++i) {
+		sizes[i] = 1 + ((i * 37) % 700);
+		alignments[i] = (u16)(1 << (i % 5));
+		blocks[i] = kallocate_aligned(sizes[i], alignments[i], MEMORY_TAG_ENGINE);
+		expect_should_not_be(0, blocks[i]);
+		expect_should_be(0, ((u64)blocks[i]) % alignments[i]);
+		kset_memory(blocks[i], (i32)(i & 0xFF), sizes[i]);
+	}
+	expect_should_be(base_count + count, get_memory_alloc_count());
+
+	// Free every other block first, then the rest, verifying contents are intact.
+	for (u32 pass = 0; pass < 2; ++pass) {
+		for (u32 i = pass; i < count; i += 2) {
+			u8* data = blocks[i];
+			for (u64 b = 0; b < sizes[i]; ++b) {
+				expect_should_be((u8)(i & 0xFF), data[b]);
+			}
+			kfree_aligned(blocks[i], sizes[i], alignments[i], MEMORY_TAG_ENGINE);
+		}
+	}
+	expect_should_be(base_count, get_memory_alloc_count());
+
+	// Once this thread's cache is handed back, all of the space should be available again.
+	kmemory_thread_cache_flush();
+	expect_should_be(base_free, get_free_memory_space());
+
+	memory_system_shutdown();
+
+	return true;
+}
+
+void kmemory_register_tests(void) {
+	test_manager_register_test(kmemory_small_allocations_should_be_zeroed_and_reused, "kmemory small allocations should be zeroed and reused");
+	test_manager_register_test(kmemory_mixed_allocations_should_flush_and_return_all_space, "kmemory mixed allocations should flush and return all space");
+}
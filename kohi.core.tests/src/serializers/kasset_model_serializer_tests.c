@@ -0,0 +1,175 @@
+#include "kasset_model_serializer_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+#include "../test_random.h"
+
+#include <assets/kasset_types.h>
+#include <defines.h>
+#include <math/kmath.h>
+#include <memory/kmemory.h>
+#include <serializers/kasset_model_serializer.h>
+#include <strings/kname.h>
+
+// Odd, so that both the 4-wide and the remaining keys of each track get decoded.
+#define KEY_COUNT 39
+
+// Creates a model with a single animation of a single channel, with KEY_COUNT random keys in each track.
+static void test_model_create(kasset_model_key_encoding encoding, kasset_model* out_model) {
+	u32 rng = 4321;
+	kzero_memory(out_model, sizeof(kasset_model));
+	out_model->animation_count = 1;
+	out_model->animations = KALLOC_TYPE_CARRAY(kasset_model_animation, 1);
+	kasset_model_animation* anim = &out_model->animations[0];
+	anim->name = kname_create("test_animation");
+	anim->duration = 120.0f;
+	anim->ticks_per_second = 30.0f;
+	anim->key_encoding = encoding;
+	anim->channel_count = 1;
+	anim->channels = KALLOC_TYPE_CARRAY(kasset_model_channel, 1);
+
+	kasset_model_channel* channel = &anim->channels[0];
+	channel->name = kname_create("test_node");
+	channel->pos_count = KEY_COUNT;
+	channel->rot_count = KEY_COUNT;
+	channel->scale_count = KEY_COUNT;
+	channel->positions = KALLOC_TYPE_CARRAY(kasset_model_key_vec3, KEY_COUNT);
+	channel->rotations = KALLOC_TYPE_CARRAY(kasset_model_key_quat, KEY_COUNT);
+	channel->scales = KALLOC_TYPE_CARRAY(kasset_model_key_vec3, KEY_COUNT);
+	for (u32 i = 0; i < KEY_COUNT; ++i) {
+		f32 time = (anim->duration * i) / (KEY_COUNT - 1);
+		channel->positions[i] = (kasset_model_key_vec3){{{test_random_f32(&rng, -50.0f, 50.0f), test_random_f32(&rng, 0.0f, 10.0f), test_random_f32(&rng, -1.0f, 1.0f)}}, time};
+		channel->scales[i] = (kasset_model_key_vec3){{{1.0f, test_random_f32(&rng, 0.5f, 2.0f), 1.0f}}, time};
+		vec3 axis = vec3_normalized((vec3){test_random_f32(&rng, -1.0f, 1.0f), test_random_f32(&rng, -1.0f, 1.0f), 1.0f});
+		channel->rotations[i] = (kasset_model_key_quat){quat_from_axis_angle(axis, test_random_f32(&rng, -K_PI, K_PI), true), time};
+	}
+}
+
+static void test_model_destroy(kasset_model* model) {
+	for (u32 a = 0; a < model->animation_count; ++a) {
+		kasset_model_animation* anim = &model->animations[a];
+		for (u32 c = 0; c < anim->channel_count; ++c) {
+			kasset_model_channel* channel = &anim->channels[c];
+			KFREE_TYPE_CARRAY(channel->positions, kasset_model_key_vec3, channel->pos_count);
+			KFREE_TYPE_CARRAY(channel->rotations, kasset_model_key_quat, channel->rot_count);
+			KFREE_TYPE_CARRAY(channel->scales, kasset_model_key_vec3, channel->scale_count);
+		}
+		KFREE_TYPE_CARRAY(anim->channels, kasset_model_channel, anim->channel_count);
+	}
+	KFREE_TYPE_CARRAY(model->animations, kasset_model_animation, model->animation_count);
+	kzero_memory(model, sizeof(kasset_model));
+}
+
+static b8 vec3_keys_close(const kasset_model_key_vec3* a, const kasset_model_key_vec3* b, u32 count, f32 value_tolerance, f32 time_tolerance) {
+	for (u32 i = 0; i < count; ++i) {
+		if (kabs(a[i].time - b[i].time) > time_tolerance) {
+			KERROR("--> Key %u time differs: %f vs %f.", i, a[i].time, b[i].time);
+			return false;
+		}
+		for (u32 e = 0; e < 3; ++e) {
+			if (kabs(a[i].value.elements[e] - b[i].value.elements[e]) > value_tolerance) {
+				KERROR("--> Key %u element %u differs: %f vs %f.", i, e, a[i].value.elements[e], b[i].value.elements[e]);
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static u8 full_encoding_round_trips_exactly(void) {
+	kasset_model model;
+	test_model_create(KASSET_MODEL_KEY_ENCODING_FULL, &model);
+
+	u64 size = 0;
+	void* block = kasset_model_serialize(&model, 0, 0, &size);
+	expect_to_be_true(block != 0);
+
+	kasset_model result = {0};
+	expect_to_be_true(kasset_model_deserialize(size, block, &result));
+	expect_should_be(1, result.animation_count);
+	expect_should_be(KASSET_MODEL_KEY_ENCODING_FULL, result.animations[0].key_encoding);
+
+	kasset_model_channel* in = &model.animations[0].channels[0];
+	kasset_model_channel* out = &result.animations[0].channels[0];
+	expect_should_be(KEY_COUNT, out->pos_count);
+	expect_to_be_true(vec3_keys_close(in->positions, out->positions, KEY_COUNT, 0.0f, 0.0f));
+	expect_to_be_true(vec3_keys_close(in->scales, out->scales, KEY_COUNT, 0.0f, 0.0f));
+	for (u32 i = 0; i < KEY_COUNT; ++i) {
+		expect_to_be_true(in->rotations[i].time == out->rotations[i].time);
+		expect_to_be_true(quat_dot(in->rotations[i].value, out->rotations[i].value) == quat_dot(in->rotations[i].value, in->rotations[i].value));
+	}
+
+	kfree(block, size, MEMORY_TAG_BINARY_DATA);
+	test_model_destroy(&result);
+	test_model_destroy(&model);
+	return true;
+}
+
+static u8 quantized_encoding_round_trips_within_tolerance(void) {
+	kasset_model model;
+	test_model_create(KASSET_MODEL_KEY_ENCODING_QUANTIZED, &model);
+
+	u64 size = 0;
+	void* block = kasset_model_serialize(&model, 0, 0, &size);
+	expect_to_be_true(block != 0);
+
+	kasset_model result = {0};
+	expect_to_be_true(kasset_model_deserialize(size, block, &result));
+	expect_should_be(KASSET_MODEL_KEY_ENCODING_QUANTIZED, result.animations[0].key_encoding);
+
+	kasset_model_channel* in = &model.animations[0].channels[0];
+	kasset_model_channel* out = &result.animations[0].channels[0];
+	expect_should_be(KEY_COUNT, out->pos_count);
+	expect_should_be(KEY_COUNT, out->rot_count);
+	expect_should_be(KEY_COUNT, out->scale_count);
+
+	// Half a step of each range: 100 / 65535 for positions, and 120 / 65535 for times.
+	f32 time_tolerance = 0.001f;
+	expect_to_be_true(vec3_keys_close(in->positions, out->positions, KEY_COUNT, 0.001f, time_tolerance));
+	expect_to_be_true(vec3_keys_close(in->scales, out->scales, KEY_COUNT, 0.0001f, time_tolerance));
+
+	for (u32 i = 0; i < KEY_COUNT; ++i) {
+		expect_float_to_be(in->rotations[i].time, out->rotations[i].time);
+		// The sign may be flipped, which is the same rotation.
+		f32 dot = kabs(quat_dot(in->rotations[i].value, out->rotations[i].value));
+		if (dot < 0.99999f) {
+			KERROR("--> Rotation key %u differs (dot=%f).", i, dot);
+			return false;
+		}
+	}
+
+	kfree(block, size, MEMORY_TAG_BINARY_DATA);
+	test_model_destroy(&result);
+	test_model_destroy(&model);
+	return true;
+}
+
+static u8 quantized_encoding_is_smaller(void) {
+	kasset_model full;
+	kasset_model quantized;
+	test_model_create(KASSET_MODEL_KEY_ENCODING_FULL, &full);
+	test_model_create(KASSET_MODEL_KEY_ENCODING_QUANTIZED, &quantized);
+
+	u64 full_size = 0;
+	u64 quantized_size = 0;
+	void* full_block = kasset_model_serialize(&full, 0, 0, &full_size);
+	void* quantized_block = kasset_model_serialize(&quantized, 0, 0, &quantized_size);
+
+	// Key data goes from 16/20/16 bytes per key down to 8 bytes per key in each track, plus
+	// the ranges of each track (32 bytes for a vec3 track, 8 for a rotation track).
+	u64 full_key_size = (sizeof(kasset_model_key_vec3) * 2 + sizeof(kasset_model_key_quat)) * KEY_COUNT;
+	u64 quantized_key_size = (sizeof(u16) * 4 * 3 * KEY_COUNT) + (32 * 2) + 8;
+	expect_should_be(full_size - full_key_size, quantized_size - quantized_key_size);
+
+	kfree(full_block, full_size, MEMORY_TAG_BINARY_DATA);
+	kfree(quantized_block, quantized_size, MEMORY_TAG_BINARY_DATA);
+	test_model_destroy(&full);
+	test_model_destroy(&quantized);
+	return true;
+}
+
+void kasset_model_serializer_register_tests(void) {
+	test_manager_register_test(full_encoding_round_trips_exactly, "Model serializer round trips full precision keys exactly");
+	test_manager_register_test(quantized_encoding_round_trips_within_tolerance, "Model serializer round trips quantized keys within tolerance");
+	test_manager_register_test(quantized_encoding_is_smaller, "Model serializer quantized keys are smaller");
+}
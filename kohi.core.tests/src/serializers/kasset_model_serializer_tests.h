@@ -0,0 +1,3 @@
+#pragma once
+
+void kasset_model_serializer_register_tests(void);
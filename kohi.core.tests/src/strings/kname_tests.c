@@ -0,0 +1,113 @@
+#include "kname_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+#include <memory/kmemory.h>
+#include <strings/kname.h>
+#include <strings/kstring.h>
+#include <strings/kstring_id.h>
+#include <strings/kstring_intern.h>
+#include <utils/crc64.h>
+
+static u8 kname_should_hash_case_insensitively(void) {
+	kname a = kname_create("Default_Texture");
+	kname b = kname_create("default_texture");
+	kname c = kname_create("DEFAULT_TEXTURE");
+	expect_should_not_be(INVALID_KNAME, a);
+	expect_should_be(a, b);
+	expect_should_be(a, c);
+
+	// Names are the hash of the lowercase string.
+	const char* lower = "default_texture";
+	expect_should_be(crc64(0, (const u8*)lower, string_length(lower)), a);
+
+	// The casing first seen is the one kept.
+	expect_to_be_true(strings_equal("Default_Texture", kname_string_get(c)));
+
+	expect_should_be(INVALID_KNAME, kname_create(""));
+	expect_should_be(INVALID_KNAME, kname_create(0));
+	expect_should_be(0, kname_string_get(INVALID_KNAME));
+
+	return true;
+}
+
+static u8 kname_should_keep_long_and_many_strings(void) {
+	// Longer than the chunk used while hashing, and than a whole block of the string pool.
+	const u64 long_length = KIBIBYTES(80);
+	char* long_str = kallocate(long_length + 1, MEMORY_TAG_STRING);
+	for (u64 i = 0; i < long_length; ++i) {
+		long_str[i] = (char)('A' + (i % 26));
+	}
+	long_str[long_length] = 0;
+	kname long_name = kname_create(long_str);
+
+	char* lower = string_duplicate(long_str);
+	string_to_lower(lower);
+	expect_should_be(crc64(0, (const u8*)lower, long_length), long_name);
+	string_free(lower);
+
+	// Enough names to span several blocks of the string pool and regrow the lookup.
+	const u32 name_count = 5000;
+	kname names[5000];
+	for (u32 i = 0; i < name_count; ++i) {
+		char* name_str = string_format("some_fairly_long_resource_name_%u", i);
+		names[i] = kname_create(name_str);
+		string_free(name_str);
+	}
+
+	for (u32 i = 0; i < name_count; ++i) {
+		char* name_str = string_format("some_fairly_long_resource_name_%u", i);
+		expect_to_be_true(strings_equal(name_str, kname_string_get(names[i])));
+		// Creating again gives the same name.
+		expect_should_be(names[i], kname_create(name_str));
+		string_free(name_str);
+	}
+	// Strings are copied, so the original may be freed.
+	kfree(long_str, long_length + 1, MEMORY_TAG_STRING);
+	expect_should_be(long_length, string_length(kname_string_get(long_name)));
+
+	return true;
+}
+
+// Uses a table of its own, as destroying the global one behind knames would affect every other test.
+static u8 kstring_intern_table_should_keep_nothing_after_destroy(void) {
+	kstring_intern_table table = {0};
+	const char* str = "interned_string";
+	u64 hash = crc64(0, (const u8*)str, string_length(str));
+
+	expect_should_be(0, kstring_intern_table_get(&table, hash));
+	const char* interned = kstring_intern_table_insert(&table, hash, str, string_length(str));
+	expect_to_be_true(strings_equal(str, interned));
+	// Inserting again keeps the existing string.
+	expect_should_be(interned, kstring_intern_table_insert(&table, hash, "other", 5));
+	expect_should_be(interned, kstring_intern_table_get(&table, hash));
+
+	kstring_intern_table_destroy(&table);
+	// Nothing is kept after destruction.
+	expect_should_be(0, kstring_intern_table_get(&table, hash));
+
+	// The table may be used again afterward.
+	expect_to_be_true(strings_equal(str, kstring_intern_table_insert(&table, hash, str, string_length(str))));
+	kstring_intern_table_destroy(&table);
+
+	return true;
+}
+
+static u8 kstring_id_should_hash_case_sensitively(void) {
+	kstring_id a = kstring_id_create("Shader");
+	kstring_id b = kstring_id_create("shader");
+	expect_should_not_be(a, b);
+	expect_should_be(a, kstring_id_create("Shader"));
+	expect_to_be_true(strings_equal("Shader", kstring_id_string_get(a)));
+	expect_to_be_true(strings_equal("shader", kstring_id_string_get(b)));
+
+	return true;
+}
+
+void kname_register_tests(void) {
+	test_manager_register_test(kname_should_hash_case_insensitively, "kname should hash case-insensitively and keep the original string");
+	test_manager_register_test(kname_should_keep_long_and_many_strings, "kname should keep long strings and many strings");
+	test_manager_register_test(kstring_intern_table_should_keep_nothing_after_destroy, "kstring intern table should keep nothing after destroy");
+	test_manager_register_test(kstring_id_should_hash_case_sensitively, "kstring_id should hash case-sensitively");
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <defines.h>
+#include <math/kmath.h>
+
+/**
+ * @brief Returns the next number from a xorshift32 generator, so results are the same on every run.
+ * @param state A pointer to the generator's state. Must not start at 0.
+ */
+static inline u32 test_random(u32* state) {
+	u32 x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+/**
+ * @brief Returns the next number from the generator, scaled to the range [min, max].
+ */
+static inline f32 test_random_f32(u32* state, f32 min, f32 max) {
+	return min + ((f32)(test_random(state) & 0xFFFFFF) / (f32)0xFFFFFF) * (max - min);
+}
+
+/**
+ * @brief Returns a random transform, which is always invertible.
+ */
+static inline mat4 test_random_transform(u32* state) {
+	vec3 axis = vec3_normalized((vec3){test_random_f32(state, -1.0f, 1.0f), test_random_f32(state, -1.0f, 1.0f), 1.0f});
+	quat rotation = quat_from_axis_angle(axis, test_random_f32(state, -K_PI, K_PI), true);
+	vec3 position = {test_random_f32(state, -100.0f, 100.0f), test_random_f32(state, -100.0f, 100.0f), test_random_f32(state, -100.0f, 100.0f)};
+	vec3 scale = {test_random_f32(state, 0.1f, 4.0f), test_random_f32(state, 0.1f, 4.0f), test_random_f32(state, 0.1f, 4.0f)};
+	return mat4_from_translation_rotation_scale(position, rotation, scale);
+}
@@ -431,7 +431,7 @@ typedef struct kasset_audio {
 
 #define KASSET_TYPE_NAME_MODEL "Model"
 
-#define KASSET_MODEL_CURRENT_VERSION 1
+#define KASSET_MODEL_CURRENT_VERSION 2
 
 typedef struct kasset_model_key_vec3 {
 	vec3 value;
@@ -453,10 +453,21 @@ typedef struct kasset_model_channel {
 	kasset_model_key_quat* rotations;
 } kasset_model_channel;
 
+// How the keys of an animation's channels are stored when serialized. Keys are always
+// full precision once deserialized.
+typedef enum kasset_model_key_encoding {
+	// Full precision values, each with a full precision time.
+	KASSET_MODEL_KEY_ENCODING_FULL = 0,
+	// Times, translations and scales quantized to 16 bits across the range of each track.
+	// Rotations keep only their smallest three components, at 15 bits each.
+	KASSET_MODEL_KEY_ENCODING_QUANTIZED = 1
+} kasset_model_key_encoding;
+
 typedef struct kasset_model_animation {
 	kname name;
 	f32 duration;
 	f32 ticks_per_second;
+	kasset_model_key_encoding key_encoding;
 	u16 channel_count;
 	kasset_model_channel* channels;
 } kasset_model_animation;
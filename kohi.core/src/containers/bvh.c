@@ -161,6 +161,72 @@ u32 bvh_query_overlaps(const bvh* t, aabb query, bvh_query_callback callback, vo
 	return hits;
 }
 
+typedef struct bvh_frustum_query_entry {
+	u32 id;
+	// A bit per frustum side which must still be tested. Sides whose plane entirely contains a node are cleared.
+	u32 plane_mask;
+} bvh_frustum_query_entry;
+
+u32 bvh_query_frustum(const bvh* t, const kfrustum* f, bvh_query_callback callback, void* usr) {
+	if (t->root == BVH_INVALID_NODE || !f) {
+		return 0;
+	}
+
+	u32 stack_capacity = 64;
+	bvh_frustum_query_entry* stack = KALLOC_TYPE_CARRAY(bvh_frustum_query_entry, stack_capacity);
+	if (!stack) {
+		return 0;
+	}
+	u32 top = 0;
+	u32 hits = 0;
+	stack[top++] = (bvh_frustum_query_entry){t->root, (1u << KFRUSTUM_SIDE_COUNT) - 1};
+	while (top) {
+		bvh_frustum_query_entry entry = stack[--top];
+		const bvh_node* node = &t->nodes[entry.id];
+
+		vec3 center = extents_3d_center(node->aabb);
+		vec3 half_extents = extents_3d_half(node->aabb);
+		b8 outside = false;
+		for (u32 i = 0; i < KFRUSTUM_SIDE_COUNT; ++i) {
+			if (!(entry.plane_mask & (1u << i))) {
+				continue;
+			}
+			const plane_3d* p = &f->sides[i];
+			f32 r = half_extents.x * kabs(p->normal.x) + half_extents.y * kabs(p->normal.y) + half_extents.z * kabs(p->normal.z);
+			f32 distance = plane_signed_distance(p, &center);
+			if (distance <= -r) {
+				outside = true;
+				break;
+			}
+			if (distance >= r) {
+				// Entirely inside this plane, so all children are too.
+				entry.plane_mask &= ~(1u << i);
+			}
+		}
+		if (outside) {
+			continue;
+		}
+
+		if (bvh_is_leaf(node)) {
+			hits += callback(node->user, entry.id, usr);
+		} else {
+			if (top + 2 > stack_capacity) {
+				u32 new_capacity = stack_capacity * 2;
+				bvh_frustum_query_entry* new_stack = KREALLOC_TYPE_CARRAY(stack, bvh_frustum_query_entry, stack_capacity, new_capacity);
+				if (!new_stack) {
+					break;
+				}
+				stack = new_stack;
+				stack_capacity = new_capacity;
+			}
+			stack[top++] = (bvh_frustum_query_entry){node->left, entry.plane_mask};
+			stack[top++] = (bvh_frustum_query_entry){node->right, entry.plane_mask};
+		}
+	}
+	KFREE_TYPE_CARRAY(stack, bvh_frustum_query_entry, stack_capacity);
+	return hits;
+}
+
 raycast_result bvh_raycast(const bvh* t, const ray* r, bvh_raycast_callback callback, void* usr) {
 	raycast_result result = {0};
 	if (t->root == BVH_INVALID_NODE) {
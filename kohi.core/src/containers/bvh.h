@@ -44,6 +44,10 @@ KAPI void bvh_update(bvh* t, bvh_id id, aabb new_tight_aabb);
 typedef u32 (*bvh_query_callback)(bvh_userdata user, bvh_id id, void* usr);
 KAPI u32 bvh_query_overlaps(const bvh* t, aabb query, bvh_query_callback callback, void* context);
 
+// Query - call cb(user, id) for every leaf whose AABB is within or intersects the frustum, return number of hits.
+// Subtrees found to be entirely inside a plane skip testing against that plane further down.
+KAPI u32 bvh_query_frustum(const bvh* t, const kfrustum* f, bvh_query_callback callback, void* context);
+
 // Ray cast (origin + dir, max). Callback gets fraction [0,hit], return 0 to terminate early.
 typedef b8 (*bvh_raycast_callback)(bvh_userdata user, bvh_id id, const ray* r, f32 min, f32 max, f32 dist, vec3 pos, void* usr, raycast_hit* out_result);
 KAPI raycast_result bvh_raycast(const bvh* t, const ray* r, bvh_raycast_callback callback, void* usr);
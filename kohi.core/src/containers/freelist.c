@@ -3,21 +3,79 @@
 #include "logger.h"
 #include "memory/kmemory.h"
 
+/*
+ * Free ranges are indexed two ways, so that neither allocating nor freeing has to walk them:
+ *
+ * - By size, in a two-level segregated fit (TLSF-style) index. The first level splits sizes by
+ *   power of 2, and the second splits each of those into FREELIST_SL_COUNT linear steps. Each bin
+ *   holds a list of free ranges, and a bitmap at each level tracks which bins are non-empty, so a
+ *   suitable range is found with a couple of bit scans.
+ * - By start and end offset, in open-addressed hash tables. A freed range uses these to find the
+ *   free ranges immediately before and after it, and merges with them.
+ */
+
+// The number of bits of a size used to pick its second-level bin.
+#define FREELIST_SL_BITS 4
+// The number of second-level bins per first-level bin.
+#define FREELIST_SL_COUNT (1 << FREELIST_SL_BITS)
+// The number of first-level bins. Enough for any 64-bit size.
+#define FREELIST_FL_COUNT 64
+
+#define FREELIST_INVALID_NODE 0xFFFFFFFFU
+
 typedef struct freelist_node {
 	u64 offset;
+	// The size of the free range. 0 indicates the node is not in use.
 	u64 size;
-	struct freelist_node* next;
+	// The previous node in the same bin.
+	u32 prev;
+	// The next node in the same bin, or the next unused node if this one is not in use.
+	u32 next;
 } freelist_node;
 
 typedef struct internal_state {
 	u64 total_size;
 	u64 max_entries;
-	freelist_node* head;
+	u64 free_space;
+	// The number of slots in each offset table. Always a power of 2.
+	u64 table_capacity;
+	// Shift applied to a hashed offset to get a slot index.
+	u32 table_shift;
+	// The head of the list of unused nodes.
+	u32 first_unused;
+	// Bit n is set if any second-level bin of first-level bin n is non-empty.
+	u64 fl_bitmap;
+	// Bit n is set if second-level bin n is non-empty.
+	u32 sl_bitmaps[FREELIST_FL_COUNT];
+	// The first node in each bin.
+	u32 bins[FREELIST_FL_COUNT][FREELIST_SL_COUNT];
 	freelist_node* nodes;
+	// Node indices of free ranges, keyed by their start offset.
+	u32* start_table;
+	// Node indices of free ranges, keyed by their end offset.
+	u32* end_table;
 } internal_state;
 
-static freelist_node* get_node(freelist* list);
-static void return_node(freelist_node* node);
+static u64 table_capacity_get(u64 max_entries) {
+	// Always leave at least one empty slot so that probing terminates.
+	u64 capacity = 16;
+	while (capacity < max_entries + 1) {
+		capacity <<= 1;
+	}
+	return capacity;
+}
+
+static u64 memory_requirement_get(u64 max_entries) {
+	return sizeof(internal_state) + (sizeof(freelist_node) * max_entries) + (sizeof(u32) * table_capacity_get(max_entries) * 2);
+}
+
+static void state_setup(void* memory, u64 total_size, u64 max_entries);
+static void state_reset(internal_state* state);
+static b8 range_free(internal_state* state, u64 size, u64 offset);
+static u32 find_suitable(internal_state* state, u64 size);
+static void free_range_insert(internal_state* state, u32 index);
+static void free_range_remove(internal_state* state, u32 index);
+static void node_release(internal_state* state, u32 index);
 
 void freelist_create(u64 total_size, u64* memory_requirement, void* memory, freelist* out_list) {
 	// Enough space to hold state, plus array for all nodes.
@@ -28,8 +86,10 @@ void freelist_create(u64 total_size, u64* memory_requirement, void* memory, free
 	if (max_entries < 20) {
 		max_entries = 20;
 	}
+	// Nodes are referenced by 32-bit index.
+	max_entries = KMIN(max_entries, FREELIST_INVALID_NODE - 1);
 
-	*memory_requirement = sizeof(internal_state) + (sizeof(freelist_node) * max_entries);
+	*memory_requirement = memory_requirement_get(max_entries);
 	if (!memory) {
 		return;
 	}
@@ -44,27 +104,17 @@ void freelist_create(u64 total_size, u64* memory_requirement, void* memory, free
 	// }
 
 	out_list->memory = memory;
+	state_setup(out_list->memory, total_size, max_entries);
 
-	// The block's layout is head* first, then array of available nodes.
-	kzero_memory(out_list->memory, *memory_requirement);
-	internal_state* state = out_list->memory;
-	state->nodes = (void*)(out_list->memory + sizeof(internal_state));
-	state->max_entries = max_entries;
-	state->total_size = total_size;
-
-	kzero_memory(state->nodes, sizeof(freelist_node) * state->max_entries);
-
-	state->head = &state->nodes[0];
-	state->head->offset = 0;
-	state->head->size = total_size;
-	state->head->next = 0;
+	// The whole range starts out free.
+	range_free(out_list->memory, total_size, 0);
 }
 
 void freelist_destroy(freelist* list) {
 	if (list && list->memory) {
 		// Just zero out the memory before giving it back.
 		internal_state* state = list->memory;
-		kzero_memory(list->memory, sizeof(internal_state) + sizeof(freelist_node) * state->max_entries);
+		kzero_memory(list->memory, memory_requirement_get(state->max_entries));
 		list->memory = 0;
 	}
 }
@@ -74,132 +124,34 @@ b8 freelist_allocate_block(freelist* list, u64 size, u64* out_offset) {
 		return false;
 	}
 	internal_state* state = list->memory;
-	freelist_node* node = state->head;
-	freelist_node* previous = 0;
-	while (node) {
-		if (node->size == size) {
-			// Exact match. Just return the node.
-			*out_offset = node->offset;
-			freelist_node* node_to_return = 0;
-			if (previous) {
-				previous->next = node->next;
-				node_to_return = node;
-			} else {
-				// This node is the head of the list. Reassign the head
-				// and return the previous head node.
-				node_to_return = state->head;
-				state->head = node->next;
-			}
-			return_node(node_to_return);
-			return true;
-		} else if (node->size > size) {
-			// Node is larger. Deduct the memory from it and move the offset
-			// by that amount.
-			*out_offset = node->offset;
-			node->size -= size;
-			node->offset += size;
-			return true;
-		}
-
-		previous = node;
-		node = node->next;
+	u32 index = find_suitable(state, size);
+	if (index == FREELIST_INVALID_NODE) {
+		u64 free_space = freelist_free_space(list);
+		KWARN("freelist_find_block, no block with enough free space found (requested: %lluB, available: %lluB).", size, free_space);
+		return false;
 	}
 
-	u64 free_space = freelist_free_space(list);
-	KWARN("freelist_find_block, no block with enough free space found (requested: %lluB, available: %lluB).", size, free_space);
-	return false;
+	freelist_node* node = &state->nodes[index];
+	*out_offset = node->offset;
+	free_range_remove(state, index);
+	if (node->size == size) {
+		// Exact match, the whole range is used.
+		node_release(state, index);
+	} else {
+		// Range is larger. Deduct the memory from it and move the offset
+		// by that amount, then re-file it under its new size.
+		node->offset += size;
+		node->size -= size;
+		free_range_insert(state, index);
+	}
+	return true;
 }
 
 b8 freelist_free_block(freelist* list, u64 size, u64 offset) {
 	if (!list || !list->memory || !size) {
 		return false;
 	}
-	internal_state* state = list->memory;
-	freelist_node* node = state->head;
-	freelist_node* previous = 0;
-	if (!node) {
-		// Check for the case where the entire thing is allocated.
-		// In this case a new node is needed at the head.
-		freelist_node* new_node = get_node(list);
-		new_node->offset = offset;
-		new_node->size = size;
-		new_node->next = 0;
-		state->head = new_node;
-		return true;
-	} else {
-		while (node) {
-			if (node->offset + node->size == offset) {
-				// Can be appended to the right of this node.
-				node->size += size;
-
-				// Check if this then connects the range between this and the next
-				// node, and if so, combine them and return the second node..
-				if (node->next && node->next->offset == node->offset + node->size) {
-					node->size += node->next->size;
-					freelist_node* next = node->next;
-					node->next = node->next->next;
-					return_node(next);
-				}
-				return true;
-			} else if (node->offset == offset) {
-				// If there is an exact match, this means the exact block of memory
-				// that is already free is being freed again.
-				KFATAL("Attempting to free already-freed block of memory at offset %llu", node->offset);
-				return false;
-			} else if (node->offset > offset) {
-				// Iterated beyond the space to be freed. Need a new node.
-				freelist_node* new_node = get_node(list);
-				new_node->offset = offset;
-				new_node->size = size;
-
-				// If there is a previous node, the new node should be inserted between this and it.
-				if (previous) {
-					previous->next = new_node;
-					new_node->next = node;
-				} else {
-					// Otherwise, the new node becomes the head.
-					new_node->next = node;
-					state->head = new_node;
-				}
-
-				// Double-check next node to see if it can be joined.
-				if (new_node->next && new_node->offset + new_node->size == new_node->next->offset) {
-					new_node->size += new_node->next->size;
-					freelist_node* rubbish = new_node->next;
-					new_node->next = rubbish->next;
-					return_node(rubbish);
-				}
-
-				// Double-check previous node to see if the new_node can be joined to it.
-				if (previous && previous->offset + previous->size == new_node->offset) {
-					previous->size += new_node->size;
-					freelist_node* rubbish = new_node;
-					previous->next = rubbish->next;
-					return_node(rubbish);
-				}
-
-				return true;
-			}
-
-			// If on the last node and the last node's offset + size < the free offset,
-			// a new node is required.
-			if (!node->next && node->offset + node->size < offset) {
-				freelist_node* new_node = get_node(list);
-				new_node->offset = offset;
-				new_node->size = size;
-				new_node->next = 0;
-				node->next = new_node;
-
-				return true;
-			}
-
-			previous = node;
-			node = node->next;
-		}
-	}
-
-	KWARN("Unable to find block to be freed. Corruption possible?");
-	return false;
+	return range_free(list->memory, size, offset);
 }
 
 b8 freelist_resize(freelist* list, u64* memory_requirement, void* new_memory, u64 new_size, void** out_old_memory) {
@@ -215,8 +167,9 @@ b8 freelist_resize(freelist* list, u64* memory_requirement, void* new_memory, u6
 	if (max_entries < 20) {
 		max_entries = 20;
 	}
+	max_entries = KMIN(max_entries, FREELIST_INVALID_NODE - 1);
 
-	*memory_requirement = sizeof(internal_state) + (sizeof(freelist_node) * max_entries);
+	*memory_requirement = memory_requirement_get(max_entries);
 	if (!new_memory) {
 		return true;
 	}
@@ -224,72 +177,27 @@ b8 freelist_resize(freelist* list, u64* memory_requirement, void* new_memory, u6
 	// Assign the old memory pointer so it can be freed.
 	*out_old_memory = list->memory;
 
-	// Copy over the old state to the new.
 	internal_state* old_state = (internal_state*)list->memory;
 	u64 size_diff = new_size - old_state->total_size;
 
 	// Setup the new memory
 	list->memory = new_memory;
-
-	// The block's layout is head* first, then array of available nodes.
-	kzero_memory(list->memory, *memory_requirement);
-
-	// Setup the new state.
+	state_setup(list->memory, new_size, max_entries);
 	internal_state* state = (internal_state*)list->memory;
-	state->nodes = (void*)(list->memory + sizeof(internal_state));
-	state->max_entries = max_entries;
-	state->total_size = new_size;
-
-	// Invalidate the offset for all but the first node. The invalid
-	// value will be checked for when seeking a new node from the list.
-	kzero_memory(state->nodes, sizeof(freelist_node) * state->max_entries);
-
-	state->head = &state->nodes[0];
-
-	// Copy over the nodes.
-	freelist_node* new_list_node = state->head;
-	freelist_node* old_node = old_state->head;
-	if (!old_node) {
-		// If there is no head, then the entire list is allocated. In this case,
-		// the head should be set to the difference of the space now available, and
-		// at the end of the list.
-		state->head->offset = old_state->total_size;
-		state->head->size = size_diff;
-		state->head->next = 0;
-	} else {
-		// Iterate the old nodes.
-		while (old_node) {
-			// Get a new node, copy the offset/size, and set next to it.
-			freelist_node* new_node = get_node(list);
-			new_node->offset = old_node->offset;
-			new_node->size = old_node->size;
-			new_node->next = 0;
-			new_list_node->next = new_node;
-			// Move to the next entry.
-			new_list_node = new_list_node->next;
-
-			if (old_node->next) {
-				// If there is another node, move on.
-				old_node = old_node->next;
-			} else {
-				// Reached the end of the list.
-				// Check if it extends to the end of the block. If so,
-				// just append to the size. Otherwise, create a new node and
-				// attach to it.
-				if (old_node->offset + old_node->size == old_state->total_size) {
-					new_node->size += size_diff;
-				} else {
-					freelist_node* new_node_end = get_node(list);
-					new_node_end->offset = old_state->total_size;
-					new_node_end->size = size_diff;
-					new_node_end->next = 0;
-					new_node->next = new_node_end;
-				}
-				break;
-			}
+
+	// Carry over the free ranges from the old list.
+	for (u64 i = 0; i < old_state->max_entries; ++i) {
+		freelist_node* old_node = &old_state->nodes[i];
+		if (old_node->size) {
+			range_free(state, old_node->size, old_node->offset);
 		}
 	}
 
+	// The newly-added space at the end is free, and merges with any free range that reached the old end.
+	if (size_diff) {
+		range_free(state, size_diff, old_state->total_size);
+	}
+
 	return true;
 }
 
@@ -299,14 +207,10 @@ void freelist_clear(freelist* list) {
 	}
 
 	internal_state* state = list->memory;
-	// Invalidate the offset for all but the first node. The invalid
-	// value will be checked for when seeking a new node from the list.
-	kzero_memory(state->nodes, sizeof(freelist_node) * state->max_entries);
-
-	// Reset the head to occupy the entire thing.
-	state->head->offset = 0;
-	state->head->size = state->total_size;
-	state->head->next = 0;
+	state_reset(state);
+
+	// Reset to a single range occupying the entire thing.
+	range_free(state, state->total_size, 0);
 }
 
 u64 freelist_free_space(freelist* list) {
@@ -314,33 +218,270 @@ u64 freelist_free_space(freelist* list) {
 		return 0;
 	}
 
-	u64 running_total = 0;
 	internal_state* state = list->memory;
-	freelist_node* node = state->head;
-	while (node) {
-		running_total += node->size;
-		node = node->next;
+	return state->free_space;
+}
+
+u64 freelist_largest_free_block(freelist* list) {
+	if (!list || !list->memory) {
+		return 0;
+	}
+
+	internal_state* state = list->memory;
+	if (!state->fl_bitmap) {
+		return 0;
 	}
 
-	return running_total;
+	// The largest range is somewhere in the highest non-empty bin.
+	u32 fl = 63 - __builtin_clzll(state->fl_bitmap);
+	u32 sl = 31 - __builtin_clz(state->sl_bitmaps[fl]);
+	u64 largest = 0;
+	for (u32 i = state->bins[fl][sl]; i != FREELIST_INVALID_NODE; i = state->nodes[i].next) {
+		largest = KMAX(largest, state->nodes[i].size);
+	}
+	return largest;
 }
 
-static freelist_node* get_node(freelist* list) {
-	internal_state* state = list->memory;
-	for (u64 i = 1; i < state->max_entries; ++i) {
-		if (state->nodes[i].size == 0) {
-			state->nodes[i].next = 0;
-			state->nodes[i].offset = 0;
-			return &state->nodes[i];
-		}
+static void state_setup(void* memory, u64 total_size, u64 max_entries) {
+	// The block's layout is state first, then array of nodes, then the offset tables.
+	internal_state* state = memory;
+	state->total_size = total_size;
+	state->max_entries = max_entries;
+	state->table_capacity = table_capacity_get(max_entries);
+	state->table_shift = 64 - __builtin_ctzll(state->table_capacity);
+	state->nodes = (void*)((u8*)memory + sizeof(internal_state));
+	state->start_table = (void*)((u8*)state->nodes + (sizeof(freelist_node) * max_entries));
+	state->end_table = state->start_table + state->table_capacity;
+	state_reset(state);
+}
+
+static void state_reset(internal_state* state) {
+	state->free_space = 0;
+	state->fl_bitmap = 0;
+	kzero_memory(state->sl_bitmaps, sizeof(state->sl_bitmaps));
+	kset_memory(state->bins, 0xFF, sizeof(state->bins));
+	kset_memory(state->start_table, 0xFF, sizeof(u32) * state->table_capacity);
+	kset_memory(state->end_table, 0xFF, sizeof(u32) * state->table_capacity);
+
+	// Chain up all nodes as unused.
+	for (u64 i = 0; i < state->max_entries; ++i) {
+		freelist_node* node = &state->nodes[i];
+		node->offset = 0;
+		node->size = 0;
+		node->prev = FREELIST_INVALID_NODE;
+		node->next = (i + 1 < state->max_entries) ? (u32)(i + 1) : FREELIST_INVALID_NODE;
 	}
+	state->first_unused = 0;
+}
 
-	// Return nothing if no nodes are available.
-	return 0;
+static u32 node_acquire(internal_state* state) {
+	u32 index = state->first_unused;
+	if (index != FREELIST_INVALID_NODE) {
+		state->first_unused = state->nodes[index].next;
+		state->nodes[index].prev = FREELIST_INVALID_NODE;
+		state->nodes[index].next = FREELIST_INVALID_NODE;
+	}
+	return index;
 }
 
-static void return_node(freelist_node* node) {
+static void node_release(internal_state* state, u32 index) {
+	freelist_node* node = &state->nodes[index];
 	node->offset = 0;
 	node->size = 0;
-	node->next = 0;
+	node->prev = FREELIST_INVALID_NODE;
+	node->next = state->first_unused;
+	state->first_unused = index;
+}
+
+// Gets the bin a range of the given size is filed under.
+static void mapping_insert(u64 size, u32* out_fl, u32* out_sl) {
+	if (size < FREELIST_SL_COUNT) {
+		// Small sizes each get their own bin.
+		*out_fl = 0;
+		*out_sl = (u32)size;
+	} else {
+		u32 msb = 63 - __builtin_clzll(size);
+		*out_fl = msb - (FREELIST_SL_BITS - 1);
+		*out_sl = (u32)(size >> (msb - FREELIST_SL_BITS)) ^ FREELIST_SL_COUNT;
+	}
+}
+
+// Gets the first bin in which every range is guaranteed to be large enough for the given size.
+static void mapping_search(u64 size, u32* out_fl, u32* out_sl) {
+	if (size >= FREELIST_SL_COUNT) {
+		u32 msb = 63 - __builtin_clzll(size);
+		size += (1ULL << (msb - FREELIST_SL_BITS)) - 1;
+	}
+	mapping_insert(size, out_fl, out_sl);
+}
+
+static u32 find_suitable(internal_state* state, u64 size) {
+	u32 fl, sl;
+	mapping_search(size, &fl, &sl);
+
+	// Look for a non-empty bin at this level, then at the next level up that has one.
+	u32 sl_map = (fl < FREELIST_FL_COUNT) ? state->sl_bitmaps[fl] & (~0U << sl) : 0;
+	if (!sl_map) {
+		u64 fl_map = (fl + 1 < FREELIST_FL_COUNT) ? state->fl_bitmap & (~0ULL << (fl + 1)) : 0;
+		if (fl_map) {
+			fl = __builtin_ctzll(fl_map);
+			sl_map = state->sl_bitmaps[fl];
+		}
+	}
+	if (sl_map) {
+		return state->bins[fl][__builtin_ctz(sl_map)];
+	}
+
+	// Rounding up skips the bin the size itself falls in, which may still hold a range that fits.
+	mapping_insert(size, &fl, &sl);
+	for (u32 i = state->bins[fl][sl]; i != FREELIST_INVALID_NODE; i = state->nodes[i].next) {
+		if (state->nodes[i].size >= size) {
+			return i;
+		}
+	}
+	return FREELIST_INVALID_NODE;
+}
+
+static KINLINE u64 table_slot(const internal_state* state, u64 key) {
+	return (key * 0x9E3779B97F4A7C15ULL) >> state->table_shift;
+}
+
+static KINLINE u64 node_key(const internal_state* state, b8 by_end, u32 index) {
+	const freelist_node* node = &state->nodes[index];
+	return by_end ? node->offset + node->size : node->offset;
+}
+
+static u32 table_find(const internal_state* state, const u32* table, b8 by_end, u64 key) {
+	u64 mask = state->table_capacity - 1;
+	for (u64 slot = table_slot(state, key); table[slot] != FREELIST_INVALID_NODE; slot = (slot + 1) & mask) {
+		if (node_key(state, by_end, table[slot]) == key) {
+			return table[slot];
+		}
+	}
+	return FREELIST_INVALID_NODE;
+}
+
+static void table_insert(internal_state* state, u32* table, b8 by_end, u32 index) {
+	u64 mask = state->table_capacity - 1;
+	u64 slot = table_slot(state, node_key(state, by_end, index));
+	while (table[slot] != FREELIST_INVALID_NODE) {
+		slot = (slot + 1) & mask;
+	}
+	table[slot] = index;
+}
+
+static void table_remove(internal_state* state, u32* table, b8 by_end, u32 index) {
+	u64 mask = state->table_capacity - 1;
+	u64 slot = table_slot(state, node_key(state, by_end, index));
+	while (table[slot] != index) {
+		slot = (slot + 1) & mask;
+	}
+	table[slot] = FREELIST_INVALID_NODE;
+
+	// Shift back any following entries which would no longer be reachable from their home slot.
+	u64 hole = slot;
+	for (u64 next = (hole + 1) & mask; table[next] != FREELIST_INVALID_NODE; next = (next + 1) & mask) {
+		u64 home = table_slot(state, node_key(state, by_end, table[next]));
+		// The entry may stay if its home lies cyclically within (hole, next].
+		b8 stays = (hole <= next) ? (home > hole && home <= next) : (home > hole || home <= next);
+		if (!stays) {
+			table[hole] = table[next];
+			table[next] = FREELIST_INVALID_NODE;
+			hole = next;
+		}
+	}
+}
+
+static void free_range_insert(internal_state* state, u32 index) {
+	freelist_node* node = &state->nodes[index];
+	u32 fl, sl;
+	mapping_insert(node->size, &fl, &sl);
+
+	node->prev = FREELIST_INVALID_NODE;
+	node->next = state->bins[fl][sl];
+	if (node->next != FREELIST_INVALID_NODE) {
+		state->nodes[node->next].prev = index;
+	}
+	state->bins[fl][sl] = index;
+	state->fl_bitmap |= (1ULL << fl);
+	state->sl_bitmaps[fl] |= (1U << sl);
+
+	table_insert(state, state->start_table, false, index);
+	table_insert(state, state->end_table, true, index);
+	state->free_space += node->size;
+}
+
+static void free_range_remove(internal_state* state, u32 index) {
+	freelist_node* node = &state->nodes[index];
+	u32 fl, sl;
+	mapping_insert(node->size, &fl, &sl);
+
+	if (node->prev != FREELIST_INVALID_NODE) {
+		state->nodes[node->prev].next = node->next;
+	} else {
+		state->bins[fl][sl] = node->next;
+		if (node->next == FREELIST_INVALID_NODE) {
+			// Bin is now empty.
+			state->sl_bitmaps[fl] &= ~(1U << sl);
+			if (!state->sl_bitmaps[fl]) {
+				state->fl_bitmap &= ~(1ULL << fl);
+			}
+		}
+	}
+	if (node->next != FREELIST_INVALID_NODE) {
+		state->nodes[node->next].prev = node->prev;
+	}
+	node->prev = FREELIST_INVALID_NODE;
+	node->next = FREELIST_INVALID_NODE;
+
+	table_remove(state, state->start_table, false, index);
+	table_remove(state, state->end_table, true, index);
+	state->free_space -= node->size;
+}
+
+static b8 range_free(internal_state* state, u64 size, u64 offset) {
+	if (offset + size > state->total_size) {
+		KWARN("Unable to find block to be freed. Corruption possible?");
+		return false;
+	}
+	if (table_find(state, state->start_table, false, offset) != FREELIST_INVALID_NODE) {
+		// If there is an exact match, this means the exact block of memory
+		// that is already free is being freed again.
+		KFATAL("Attempting to free already-freed block of memory at offset %llu", offset);
+		return false;
+	}
+
+	// Look up the free ranges immediately before and after this one, if any.
+	u32 left = table_find(state, state->end_table, true, offset);
+	u32 right = table_find(state, state->start_table, false, offset + size);
+
+	if (left != FREELIST_INVALID_NODE) {
+		// Append to the range on the left, and also combine with the range on the right if there is one.
+		free_range_remove(state, left);
+		state->nodes[left].size += size;
+		if (right != FREELIST_INVALID_NODE) {
+			free_range_remove(state, right);
+			state->nodes[left].size += state->nodes[right].size;
+			node_release(state, right);
+		}
+		free_range_insert(state, left);
+	} else if (right != FREELIST_INVALID_NODE) {
+		// Prepend to the range on the right.
+		free_range_remove(state, right);
+		state->nodes[right].offset = offset;
+		state->nodes[right].size += size;
+		free_range_insert(state, right);
+	} else {
+		// Not adjacent to anything free, so a new range is needed.
+		u32 index = node_acquire(state);
+		if (index == FREELIST_INVALID_NODE) {
+			KERROR("freelist ran out of nodes to track free ranges with. Memory is too fragmented.");
+			return false;
+		}
+		state->nodes[index].offset = offset;
+		state->nodes[index].size = size;
+		free_range_insert(state, index);
+	}
+
+	return true;
 }
@@ -16,6 +16,10 @@
 /**
  * @brief A data structure to be used alongside an allocator for dynamic memory
  * allocation. Tracks free ranges of memory.
+ *
+ * Free ranges are indexed by size class, as well as by their start and end offsets,
+ * so that allocating and freeing take constant time regardless of fragmentation.
+ * Allocations are good-fit rather than first-fit.
  */
 typedef struct freelist {
 	/** @brief The internal state of the freelist. */
@@ -86,11 +90,18 @@ KAPI b8 freelist_resize(freelist* list, u64* memory_requirement, void* new_memor
 KAPI void freelist_clear(freelist* list);
 
 /**
- * @brief Returns the amount of free space in this list. NOTE: Since this has
- * to iterate the entire internal list, this can be an expensive operation.
- * Use sparingly.
+ * @brief Returns the amount of free space in this list.
  *
  * @param list A pointer to the list to obtain from.
  * @return The amount of free space in bytes.
  */
 KAPI u64 freelist_free_space(freelist* list);
+
+/**
+ * @brief Returns the size of the largest contiguous free block in this list. Comparing
+ * this against the total free space gives an indication of fragmentation.
+ *
+ * @param list A pointer to the list to obtain from.
+ * @return The size of the largest free block in bytes.
+ */
+KAPI u64 freelist_largest_free_block(freelist* list);
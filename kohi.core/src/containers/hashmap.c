@@ -0,0 +1,321 @@
+#include "hashmap.h"
+
+#include "logger.h"
+#include "memory/kmemory.h"
+#include "platform/kfeatures_compile.h"
+
+#if KCOMPILETIME_SSE2
+#	include <emmintrin.h>
+#elif KCOMPILETIME_NEON
+#	include <arm_neon.h>
+#endif
+
+// Control byte states. Occupied slots hold the low 7 bits of their key's hash,
+// so the high bit alone tells an occupied slot from an empty or deleted one.
+#define CONTROL_EMPTY 0x80
+#define CONTROL_DELETED 0xFE
+
+// Maps grow once occupied slots (including tombstones) pass 7/8 of capacity.
+#define HASHMAP_MAX_LOAD_NUMERATOR 7
+#define HASHMAP_MAX_LOAD_DENOMINATOR 8
+
+// A bitmask of slots within a group, with one set bit per matching slot.
+typedef u64 group_mask;
+
+#if KCOMPILETIME_NEON
+// NEON has no movemask, so masks hold 4 bits per slot with only the top bit kept.
+#	define GROUP_MASK_SLOT_SHIFT 2
+#else
+#	define GROUP_MASK_SLOT_SHIFT 0
+#endif
+
+static KINLINE u32 group_mask_first(group_mask mask) {
+	return (u32)__builtin_ctzll(mask) >> GROUP_MASK_SLOT_SHIFT;
+}
+
+static KINLINE group_mask group_mask_next(group_mask mask) {
+	// Clears the lowest set bit.
+	return mask & (mask - 1);
+}
+
+// Obtains the slots of the group whose control bytes equal value.
+static KINLINE group_mask group_match(const u8* group, u8 value) {
+#if KCOMPILETIME_SSE2
+	__m128i controls = _mm_loadu_si128((const __m128i*)group);
+	return (group_mask)(u32)_mm_movemask_epi8(_mm_cmpeq_epi8(controls, _mm_set1_epi8((char)value)));
+#elif KCOMPILETIME_NEON
+	uint8x16_t matches = vceqq_u8(vld1q_u8(group), vdupq_n_u8(value));
+	u64 mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+	return mask & 0x8888888888888888ull;
+#else
+	group_mask mask = 0;
+	for (u32 i = 0; i < HASHMAP_GROUP_WIDTH; ++i) {
+		mask |= (group_mask)(group[i] == value) << i;
+	}
+	return mask;
+#endif
+}
+
+// Obtains the slots of the group which are empty or deleted (i.e. have the high bit set).
+static KINLINE group_mask group_match_available(const u8* group) {
+#if KCOMPILETIME_SSE2
+	return (group_mask)(u32)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+#elif KCOMPILETIME_NEON
+	uint8x16_t available = vcltzq_s8(vreinterpretq_s8_u8(vld1q_u8(group)));
+	u64 mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(available), 4)), 0);
+	return mask & 0x8888888888888888ull;
+#else
+	group_mask mask = 0;
+	for (u32 i = 0; i < HASHMAP_GROUP_WIDTH; ++i) {
+		mask |= (group_mask)(group[i] >> 7) << i;
+	}
+	return mask;
+#endif
+}
+
+static KINLINE u64 hash_key(u64 key) {
+	// Finalizer from splitmix64. Spreads keys which differ only in a few bits (such
+	// as sequential ids) over the whole range, which both the group index and the
+	// 7-bit control hash depend on.
+	key ^= key >> 30;
+	key *= 0xBF58476D1CE4E5B9ull;
+	key ^= key >> 27;
+	key *= 0x94D049BB133111EBull;
+	key ^= key >> 31;
+	return key;
+}
+
+static KINLINE u8 hash_control(u64 hash) {
+	return (u8)(hash & 0x7F);
+}
+
+static KINLINE u32 hash_group(const hashmap* map, u64 hash) {
+	return (u32)(hash >> 7) & ((map->capacity / HASHMAP_GROUP_WIDTH) - 1);
+}
+
+static KINLINE void* value_get(const hashmap* map, u32 slot) {
+	return (u8*)map->values + ((u64)slot * map->value_stride);
+}
+
+static u64 memory_requirement(u32 value_stride, u32 capacity) {
+	// Controls come first, followed by keys (which stay 8-byte aligned since capacity
+	// is a multiple of the group width), then values.
+	return capacity + (sizeof(u64) * capacity) + ((u64)value_stride * capacity);
+}
+
+static void storage_create(hashmap* map, u32 capacity) {
+	u8* block = kallocate(memory_requirement(map->value_stride, capacity), MEMORY_TAG_HASHTABLE);
+	map->capacity = capacity;
+	map->controls = block;
+	map->keys = (u64*)(block + capacity);
+	map->values = block + capacity + (sizeof(u64) * capacity);
+	kset_memory(map->controls, CONTROL_EMPTY, capacity);
+}
+
+static void storage_destroy(hashmap* map) {
+	if (map->controls) {
+		kfree(map->controls, memory_requirement(map->value_stride, map->capacity), MEMORY_TAG_HASHTABLE);
+	}
+	map->controls = 0;
+	map->keys = 0;
+	map->values = 0;
+}
+
+// Obtains the slot holding key, or INVALID_ID if it is not in the map.
+static u32 slot_find(const hashmap* map, u64 key) {
+	if (!map->count) {
+		return INVALID_ID;
+	}
+
+	u64 hash = hash_key(key);
+	u8 control = hash_control(hash);
+	u32 group_mask_bits = (map->capacity / HASHMAP_GROUP_WIDTH) - 1;
+	u32 group = hash_group(map, hash);
+
+	// Groups are probed quadratically (by triangular numbers), which visits every
+	// group exactly once since the group count is a power of 2.
+	for (u32 probe = 1; probe <= group_mask_bits + 1; ++probe) {
+		const u8* controls = map->controls + (group * HASHMAP_GROUP_WIDTH);
+		for (group_mask match = group_match(controls, control); match; match = group_mask_next(match)) {
+			u32 slot = (group * HASHMAP_GROUP_WIDTH) + group_mask_first(match);
+			if (map->keys[slot] == key) {
+				return slot;
+			}
+		}
+		// Probing for a key never passes a group with an empty slot, so neither does finding it.
+		if (group_match(controls, CONTROL_EMPTY)) {
+			return INVALID_ID;
+		}
+		group = (group + probe) & group_mask_bits;
+	}
+
+	return INVALID_ID;
+}
+
+// Obtains the first empty or deleted slot along the probe sequence for hash.
+// Always succeeds, since the load factor guarantees free slots exist.
+static u32 slot_find_available(const hashmap* map, u64 hash) {
+	u32 group_mask_bits = (map->capacity / HASHMAP_GROUP_WIDTH) - 1;
+	u32 group = hash_group(map, hash);
+	for (u32 probe = 1;; ++probe) {
+		group_mask available = group_match_available(map->controls + (group * HASHMAP_GROUP_WIDTH));
+		if (available) {
+			return (group * HASHMAP_GROUP_WIDTH) + group_mask_first(available);
+		}
+		group = (group + probe) & group_mask_bits;
+	}
+}
+
+static void rehash(hashmap* map, u32 new_capacity) {
+	hashmap old = *map;
+	storage_create(map, new_capacity);
+	map->tombstone_count = 0;
+
+	// Keys are known to be unique, so entries can go straight into the first free slot.
+	for (u32 i = 0; i < old.capacity; ++i) {
+		if (!(old.controls[i] & CONTROL_EMPTY)) {
+			u64 hash = hash_key(old.keys[i]);
+			u32 slot = slot_find_available(map, hash);
+			map->controls[slot] = hash_control(hash);
+			map->keys[slot] = old.keys[i];
+			kcopy_memory(value_get(map, slot), value_get(&old, i), map->value_stride);
+		}
+	}
+
+	storage_destroy(&old);
+}
+
+static u32 capacity_for_count(u32 count) {
+	u32 capacity = HASHMAP_GROUP_WIDTH;
+	while ((u64)count * HASHMAP_MAX_LOAD_DENOMINATOR > (u64)capacity * HASHMAP_MAX_LOAD_NUMERATOR) {
+		capacity <<= 1;
+	}
+	return capacity;
+}
+
+b8 hashmap_create(u32 value_stride, u32 initial_capacity, hashmap* out_map) {
+	if (!value_stride || !out_map) {
+		KERROR("hashmap_create requires a nonzero value_stride and a valid pointer to hold the map.");
+		return false;
+	}
+
+	kzero_memory(out_map, sizeof(hashmap));
+	out_map->value_stride = value_stride;
+	storage_create(out_map, capacity_for_count(initial_capacity));
+	return true;
+}
+
+void hashmap_destroy(hashmap* map) {
+	if (map) {
+		storage_destroy(map);
+		kzero_memory(map, sizeof(hashmap));
+	}
+}
+
+void hashmap_clear(hashmap* map) {
+	if (map && map->controls) {
+		kset_memory(map->controls, CONTROL_EMPTY, map->capacity);
+		map->count = 0;
+		map->tombstone_count = 0;
+	}
+}
+
+b8 hashmap_u64_set(hashmap* map, u64 key, const void* value) {
+	if (!map || !map->controls || !value) {
+		KERROR("hashmap_u64_set requires a valid map and value.");
+		return false;
+	}
+
+	u32 slot = slot_find(map, key);
+	if (slot != INVALID_ID) {
+		kcopy_memory(value_get(map, slot), value, map->value_stride);
+		return true;
+	}
+
+	// Tombstones lengthen probe sequences just like live entries, so they count toward the load.
+	u32 used = map->count + map->tombstone_count + 1;
+	if ((u64)used * HASHMAP_MAX_LOAD_DENOMINATOR > (u64)map->capacity * HASHMAP_MAX_LOAD_NUMERATOR) {
+		// If clearing out tombstones alone would leave plenty of room, rehash at the same size instead of growing.
+		u32 new_capacity = capacity_for_count((map->count + 1) * 2) > map->capacity ? map->capacity * 2 : map->capacity;
+		rehash(map, new_capacity);
+	}
+
+	u64 hash = hash_key(key);
+	slot = slot_find_available(map, hash);
+	if (map->controls[slot] == CONTROL_DELETED) {
+		map->tombstone_count--;
+	}
+	map->controls[slot] = hash_control(hash);
+	map->keys[slot] = key;
+	kcopy_memory(value_get(map, slot), value, map->value_stride);
+	map->count++;
+	return true;
+}
+
+b8 hashmap_u64_get(const hashmap* map, u64 key, void* out_value) {
+	if (!map || !out_value) {
+		KERROR("hashmap_u64_get requires valid pointers to map and out_value.");
+		return false;
+	}
+
+	u32 slot = slot_find(map, key);
+	if (slot == INVALID_ID) {
+		return false;
+	}
+	kcopy_memory(out_value, value_get(map, slot), map->value_stride);
+	return true;
+}
+
+void* hashmap_u64_get_ptr(const hashmap* map, u64 key) {
+	if (!map) {
+		return 0;
+	}
+	u32 slot = slot_find(map, key);
+	return slot == INVALID_ID ? 0 : value_get(map, slot);
+}
+
+b8 hashmap_u64_remove(hashmap* map, u64 key) {
+	if (!map) {
+		return false;
+	}
+
+	u32 slot = slot_find(map, key);
+	if (slot == INVALID_ID) {
+		return false;
+	}
+
+	// A group which already has an empty slot ends every probe sequence passing
+	// through it, so nothing can have been placed beyond it on this slot's account
+	// and it can be emptied outright. Otherwise, a tombstone keeps those probes going.
+	u8* group = map->controls + (slot & ~(u32)(HASHMAP_GROUP_WIDTH - 1));
+	if (group_match(group, CONTROL_EMPTY)) {
+		map->controls[slot] = CONTROL_EMPTY;
+	} else {
+		map->controls[slot] = CONTROL_DELETED;
+		map->tombstone_count++;
+	}
+	map->count--;
+	return true;
+}
+
+b8 hashmap_iterate(const hashmap* map, u32* iterator, u64* out_key, void** out_value) {
+	if (!map || !iterator) {
+		return false;
+	}
+
+	for (u32 i = *iterator; i < map->capacity; ++i) {
+		if (!(map->controls[i] & CONTROL_EMPTY)) {
+			if (out_key) {
+				*out_key = map->keys[i];
+			}
+			if (out_value) {
+				*out_value = value_get(map, i);
+			}
+			*iterator = i + 1;
+			return true;
+		}
+	}
+
+	*iterator = map->capacity;
+	return false;
+}
@@ -0,0 +1,139 @@
+/**
+ * @file hashmap.h
+ * @brief This file contains an open-addressing hash map keyed by 64-bit integers.
+ *
+ * Entries are stored in groups of HASHMAP_GROUP_WIDTH slots, in the style of a
+ * SwissTable. Each slot has a control byte holding either a state (empty/deleted)
+ * or 7 bits of the key's hash, so that a whole group can be checked for candidate
+ * matches at once (using SIMD where available) before any key is compared. Keys are
+ * stored alongside values, so colliding keys never overwrite one another. Removed
+ * entries leave tombstones, and the map grows once it becomes 7/8 full.
+ */
+
+#pragma once
+
+#include "defines.h"
+#include "strings/kname.h"
+
+/** @brief The number of slots in each probing group. */
+#define HASHMAP_GROUP_WIDTH 16
+
+/**
+ * @brief Represents an open-addressing hash map with 64-bit keys. Members of this
+ * structure should not be modified outside the functions associated with it.
+ *
+ * The map retains a copy of each value. To store pointers, use a stride of sizeof(void*).
+ */
+typedef struct hashmap {
+	/** @brief The size of each value in bytes. */
+	u32 value_stride;
+	/** @brief The total number of slots. Always a power of 2, and a multiple of HASHMAP_GROUP_WIDTH. */
+	u32 capacity;
+	/** @brief The number of entries currently held. */
+	u32 count;
+	/** @brief The number of slots holding tombstones left behind by removed entries. */
+	u32 tombstone_count;
+	/** @brief One control byte per slot. */
+	u8* controls;
+	/** @brief One key per slot. */
+	u64* keys;
+	/** @brief One value per slot, each value_stride in size. */
+	void* values;
+} hashmap;
+
+/**
+ * @brief Creates a new hash map.
+ *
+ * @param value_stride The size of each value in bytes.
+ * @param initial_capacity The number of entries to make room for up front. The map grows as needed beyond this.
+ * @param out_map A pointer to hold the newly created map.
+ * @returns True on success; otherwise false.
+ */
+KAPI b8 hashmap_create(u32 value_stride, u32 initial_capacity, hashmap* out_map);
+
+/**
+ * @brief Destroys the given map, releasing its memory. Does not release memory
+ * pointed to by any values.
+ *
+ * @param map A pointer to the map to be destroyed.
+ */
+KAPI void hashmap_destroy(hashmap* map);
+
+/**
+ * @brief Removes all entries from the given map, keeping its capacity.
+ *
+ * @param map A pointer to the map to be cleared.
+ */
+KAPI void hashmap_clear(hashmap* map);
+
+/**
+ * @brief Stores a copy of value under the given key, replacing any existing value.
+ *
+ * @param map A pointer to the map to set in.
+ * @param key The key of the entry.
+ * @param value A pointer to the value to be copied in.
+ * @returns True on success; otherwise false.
+ */
+KAPI b8 hashmap_u64_set(hashmap* map, u64 key, const void* value);
+
+/**
+ * @brief Obtains a copy of the value stored under the given key.
+ *
+ * @param map A constant pointer to the map to get from.
+ * @param key The key of the entry.
+ * @param out_value A pointer to hold a copy of the value. Untouched if the key is not found.
+ * @returns True if the key was found; otherwise false.
+ */
+KAPI b8 hashmap_u64_get(const hashmap* map, u64 key, void* out_value);
+
+/**
+ * @brief Obtains a pointer to the value stored under the given key, which may be
+ * modified in place. The pointer is only valid until the map is next added to.
+ *
+ * @param map A constant pointer to the map to get from.
+ * @param key The key of the entry.
+ * @returns A pointer to the value if the key was found; otherwise 0.
+ */
+KAPI void* hashmap_u64_get_ptr(const hashmap* map, u64 key);
+
+/**
+ * @brief Removes the entry with the given key, if it exists.
+ *
+ * @param map A pointer to the map to remove from.
+ * @param key The key of the entry.
+ * @returns True if the key was found and removed; otherwise false.
+ */
+KAPI b8 hashmap_u64_remove(hashmap* map, u64 key);
+
+/**
+ * @brief Iterates the entries of the given map. Start with an iterator of 0, and
+ * call repeatedly until false is returned. The map must not be added to or removed
+ * from while iterating.
+ *
+ * @param map A constant pointer to the map to iterate.
+ * @param iterator A pointer to the iterator, which is advanced by each call.
+ * @param out_key A pointer to hold the key of the next entry. Optional.
+ * @param out_value A pointer to hold a pointer to the value of the next entry. Optional.
+ * @returns True if an entry was obtained; false once there are no more.
+ */
+KAPI b8 hashmap_iterate(const hashmap* map, u32* iterator, u64* out_key, void** out_value);
+
+/** @brief Stores a copy of value under the given name. @see hashmap_u64_set */
+KINLINE b8 hashmap_kname_set(hashmap* map, kname key, const void* value) {
+	return hashmap_u64_set(map, (u64)key, value);
+}
+
+/** @brief Obtains a copy of the value stored under the given name. @see hashmap_u64_get */
+KINLINE b8 hashmap_kname_get(const hashmap* map, kname key, void* out_value) {
+	return hashmap_u64_get(map, (u64)key, out_value);
+}
+
+/** @brief Obtains a pointer to the value stored under the given name. @see hashmap_u64_get_ptr */
+KINLINE void* hashmap_kname_get_ptr(const hashmap* map, kname key) {
+	return hashmap_u64_get_ptr(map, (u64)key);
+}
+
+/** @brief Removes the entry with the given name, if it exists. @see hashmap_u64_remove */
+KINLINE b8 hashmap_kname_remove(hashmap* map, kname key) {
+	return hashmap_u64_remove(map, (u64)key);
+}
@@ -21,6 +21,9 @@
  * pointer types, make sure to use the _ptr setter and getter. Table
  * does not take ownership of pointers or associated memory allocations,
  * and should be managed externally.
+ *
+ * NOTE: Keys are not stored, so colliding keys overwrite one another. Prefer
+ * hashmap (containers/hashmap.h) for anything which needs every key kept.
  */
 typedef struct hashtable {
 	u64 element_size;
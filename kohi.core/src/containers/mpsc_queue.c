@@ -0,0 +1,114 @@
+#include "mpsc_queue.h"
+
+#include "logger.h"
+#include "memory/kmemory.h"
+#include "threads/katomic.h"
+
+// Sequence numbers are kept at the front of each slot, with the value following
+// at an offset which keeps it suitably aligned for pointers and 64-bit values.
+#define MPSC_QUEUE_VALUE_OFFSET 8
+
+static KINLINE u32 slot_stride_get(u32 stride) {
+	return (u32)get_aligned(MPSC_QUEUE_VALUE_OFFSET + stride, MPSC_QUEUE_VALUE_OFFSET);
+}
+
+static KINLINE u8* slot_get(const mpsc_queue* queue, u32 position) {
+	return (u8*)queue->block + ((u64)(position & (queue->capacity - 1)) * queue->slot_stride);
+}
+
+u64 mpsc_queue_memory_requirement(u32 stride, u32 capacity) {
+	return (u64)slot_stride_get(stride) * capacity;
+}
+
+b8 mpsc_queue_create(u32 stride, u32 capacity, void* memory, mpsc_queue* out_queue) {
+	if (!out_queue) {
+		KERROR("mpsc_queue_create requires a valid pointer to hold the queue.");
+		return false;
+	}
+	if (!stride || capacity < 2 || (capacity & (capacity - 1)) != 0) {
+		KERROR("mpsc_queue_create requires a nonzero stride and a capacity which is a power of 2 (got %u).", capacity);
+		return false;
+	}
+
+	out_queue->stride = stride;
+	out_queue->slot_stride = slot_stride_get(stride);
+	out_queue->capacity = capacity;
+	out_queue->enqueue_position = 0;
+	out_queue->dequeue_position = 0;
+	if (memory) {
+		out_queue->owns_memory = false;
+		out_queue->block = memory;
+	} else {
+		out_queue->owns_memory = true;
+		out_queue->block = kallocate(mpsc_queue_memory_requirement(stride, capacity), MEMORY_TAG_RING_QUEUE);
+	}
+
+	// Each slot starts out ready to be written at its own position.
+	for (u32 i = 0; i < capacity; ++i) {
+		*(u32*)slot_get(out_queue, i) = i;
+	}
+
+	return true;
+}
+
+void mpsc_queue_destroy(mpsc_queue* queue) {
+	if (queue) {
+		if (queue->owns_memory) {
+			kfree(queue->block, mpsc_queue_memory_requirement(queue->stride, queue->capacity), MEMORY_TAG_RING_QUEUE);
+		}
+		kzero_memory(queue, sizeof(mpsc_queue));
+	}
+}
+
+b8 mpsc_queue_enqueue(mpsc_queue* queue, const void* value) {
+	if (!queue || !value) {
+		KERROR("mpsc_queue_enqueue requires valid pointers to queue and value.");
+		return false;
+	}
+
+	u32 position = katomic_load_u32(&queue->enqueue_position);
+	u8* slot = 0;
+	while (true) {
+		slot = slot_get(queue, position);
+		u32 sequence = katomic_load_u32((volatile u32*)slot);
+		i32 diff = (i32)(sequence - position);
+		if (diff == 0) {
+			// The slot is free for this position. Try to claim it, which fails if another producer got there first.
+			if (katomic_compare_exchange_u32(&queue->enqueue_position, &position, position + 1)) {
+				break;
+			}
+		} else if (diff < 0) {
+			// The slot still holds a value from the previous lap which has not been consumed, so the queue is full.
+			return false;
+		} else {
+			// Another producer claimed this position already, try again with the latest one.
+			position = katomic_load_u32(&queue->enqueue_position);
+		}
+	}
+
+	kcopy_memory(slot + MPSC_QUEUE_VALUE_OFFSET, value, queue->stride);
+	// Publish the value to the consumer.
+	katomic_store_u32((volatile u32*)slot, position + 1);
+	return true;
+}
+
+b8 mpsc_queue_dequeue(mpsc_queue* queue, void* out_value) {
+	if (!queue || !out_value) {
+		KERROR("mpsc_queue_dequeue requires valid pointers to queue and out_value.");
+		return false;
+	}
+
+	u32 position = queue->dequeue_position;
+	u8* slot = slot_get(queue, position);
+	u32 sequence = katomic_load_u32((volatile u32*)slot);
+	if (sequence != position + 1) {
+		// Empty, or the producer of the next value has not finished writing it yet.
+		return false;
+	}
+
+	kcopy_memory(out_value, slot + MPSC_QUEUE_VALUE_OFFSET, queue->stride);
+	queue->dequeue_position = position + 1;
+	// Hand the slot back to producers for the next lap.
+	katomic_store_u32((volatile u32*)slot, position + queue->capacity);
+	return true;
+}
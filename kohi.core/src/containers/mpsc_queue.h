@@ -0,0 +1,77 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief Represents a bounded, lock-free, multi-producer/single-consumer queue.
+ * Any number of threads may enqueue at once, but only a single thread may dequeue.
+ * Does not resize dynamically. Naturally, this is a first in, first out structure.
+ *
+ * Each slot holds a sequence number alongside its value, which is used to hand the
+ * slot back and forth between producers and the consumer without any locking.
+ */
+typedef struct mpsc_queue {
+	/** @brief The size of each element in bytes. */
+	u32 stride;
+	/** @brief The size of each slot (sequence + element) in bytes. */
+	u32 slot_stride;
+	/** @brief The total number of elements available. Always a power of 2. */
+	u32 capacity;
+	/** @brief The block of memory to hold the slots. */
+	void* block;
+	/** @brief Indicates if the queue owns its memory block. */
+	b8 owns_memory;
+	/** @brief The position of the next slot to be written. Shared by all producers. */
+	volatile u32 enqueue_position;
+	/** @brief The position of the next slot to be read. Only touched by the consumer. */
+	u32 dequeue_position;
+} mpsc_queue;
+
+/**
+ * @brief Obtains the size of the memory block required for a queue of the given stride and capacity.
+ *
+ * @param stride The size of each element in bytes.
+ * @param capacity The total number of elements to be available in the queue. Must be a power of 2.
+ * @returns The required size of the memory block in bytes.
+ */
+KAPI u64 mpsc_queue_memory_requirement(u32 stride, u32 capacity);
+
+/**
+ * @brief Creates a new multi-producer/single-consumer queue of the given capacity and stride.
+ *
+ * @param stride The size of each element in bytes.
+ * @param capacity The total number of elements to be available in the queue. Must be a power of 2.
+ * @param memory The memory block used to hold the data. Should be the size returned by
+ * mpsc_queue_memory_requirement(). If 0 is passed, a block is automatically allocated and
+ * freed upon creation/destruction.
+ * @param out_queue A pointer to hold the newly created queue.
+ * @returns True on success; otherwise false.
+ */
+KAPI b8 mpsc_queue_create(u32 stride, u32 capacity, void* memory, mpsc_queue* out_queue);
+
+/**
+ * @brief Destroys the given queue. If memory was not passed in during creation,
+ * it is freed here. No other thread may be using the queue at this point.
+ *
+ * @param queue A pointer to the queue to destroy.
+ */
+KAPI void mpsc_queue_destroy(mpsc_queue* queue);
+
+/**
+ * @brief Adds value to queue, if space is available. Safe to call from any thread.
+ *
+ * @param queue A pointer to the queue to add data to.
+ * @param value The value to be added.
+ * @return True if success; false if the queue is full.
+ */
+KAPI b8 mpsc_queue_enqueue(mpsc_queue* queue, const void* value);
+
+/**
+ * @brief Attempts to retrieve the next value from the provided queue. Must only
+ * be called from a single (consuming) thread.
+ *
+ * @param queue A pointer to the queue to retrieve data from.
+ * @param out_value A pointer to hold the retrieved value.
+ * @return True if success; false if the queue is empty.
+ */
+KAPI b8 mpsc_queue_dequeue(mpsc_queue* queue, void* out_value);
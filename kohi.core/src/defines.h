@@ -270,6 +270,17 @@ STATIC_ASSERT(sizeof(f64) == 8, "Expected f64 to be 8 bytes.");
 #	error "Unsupported compiler - don't know how to define deprecations!"
 #endif
 
+// Thread-local storage
+#if defined(__clang__) || defined(__gcc__)
+/** @brief Gives a static variable its own instance on each thread. */
+#	define KTHREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+/** @brief Gives a static variable its own instance on each thread. */
+#	define KTHREAD_LOCAL __declspec(thread)
+#else
+#	error "Unsupported compiler - don't know how to define thread-local storage!"
+#endif
+
 /** @brief Gets the number of bytes from amount of gibibytes (GiB) (1024*1024*1024) */
 #define GIBIBYTES(amount) ((amount) * 1024ULL * 1024ULL * 1024ULL)
 /** @brief Gets the number of bytes from amount of mebibytes (MiB) (1024*1024) */
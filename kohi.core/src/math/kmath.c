@@ -103,29 +103,29 @@ plane_3d plane_3d_create(vec3 p1, vec3 norm) {
 kfrustum kfrustum_from_view_projection(mat4 view_projection) {
 	kfrustum f;
 
-	// Get the inverse of the view_projection matrix.
-	mat4 inv = mat4_inverse(view_projection);
-	f32* md = inv.data;
-
-	// Extract the rows.
-	vec4 mat0 = {md[0], md[1], md[2], md[3]};
-	vec4 mat1 = {md[4], md[5], md[6], md[7]};
-	vec4 mat2 = {md[8], md[9], md[10], md[11]};
-	vec4 mat3 = {md[12], md[13], md[14], md[15]};
-
-	// Calculate the projection planes and normalize them, including distances.
+	// Points are transformed as v * view_projection, so each clip-space component
+	// is the dot product of the point with one column of the matrix.
+	const f32* md = view_projection.data;
+	vec4 col0 = {md[0], md[4], md[8], md[12]};
+	vec4 col1 = {md[1], md[5], md[9], md[13]};
+	vec4 col2 = {md[2], md[6], md[10], md[14]};
+	vec4 col3 = {md[3], md[7], md[11], md[15]};
+
+	// Calculate the planes bounding clip space (-w <= x, y <= w, 0 <= z <= w).
 	vec4 sides[6];
-	sides[KFRUSTUM_SIDE_LEFT] = vec4_normalized(vec4_add(mat3, mat0));
-	sides[KFRUSTUM_SIDE_RIGHT] = vec4_normalized(vec4_sub(mat3, mat0));
-	sides[KFRUSTUM_SIDE_TOP] = vec4_normalized(vec4_sub(mat3, mat1));
-	sides[KFRUSTUM_SIDE_BOTTOM] = vec4_normalized(vec4_add(mat3, mat1));
-	sides[KFRUSTUM_SIDE_NEAR] = vec4_normalized(vec4_add(mat3, mat2));
-	sides[KFRUSTUM_SIDE_FAR] = vec4_normalized(vec4_sub(mat3, mat2));
-
-	// Extract normals and distances to planes.
+	sides[KFRUSTUM_SIDE_LEFT] = vec4_add(col3, col0);
+	sides[KFRUSTUM_SIDE_RIGHT] = vec4_sub(col3, col0);
+	sides[KFRUSTUM_SIDE_TOP] = vec4_sub(col3, col1);
+	sides[KFRUSTUM_SIDE_BOTTOM] = vec4_add(col3, col1);
+	sides[KFRUSTUM_SIDE_NEAR] = col2;
+	sides[KFRUSTUM_SIDE_FAR] = vec4_sub(col3, col2);
+
+	// Extract normals and distances to planes, normalizing both by the length of the normal.
 	for (u32 i = 0; i < 6; ++i) {
-		f.sides[i].normal = vec3_from_vec4(sides[i]);
-		f.sides[i].distance = sides[i].w;
+		vec3 normal = vec3_from_vec4(sides[i]);
+		f32 inv_length = 1.0f / vec3_length(normal);
+		f.sides[i].normal = vec3_mul_scalar(normal, inv_length);
+		f.sides[i].distance = -sides[i].w * inv_length;
 	}
 
 	return f;
@@ -154,23 +154,23 @@ kfrustum kfrustum_create(vec3 position, vec3 target, vec3 up, f32 aspect, f32 fo
 
 	// Top plane
 	f.sides[KFRUSTUM_SIDE_TOP] = plane_3d_create(
-		vec3_add(position, forward_far),
-		vec3_cross(right, vec3_sub(forward_far, up_half_v)));
+		position,
+		vec3_cross(vec3_add(forward_far, up_half_v), right));
 
 	// Bottom plane
 	f.sides[KFRUSTUM_SIDE_BOTTOM] = plane_3d_create(
-		vec3_add(position, forward_far),
-		vec3_cross(vec3_add(forward_far, up_half_v), right));
+		position,
+		vec3_cross(right, vec3_sub(forward_far, up_half_v)));
 
 	// Right plane
 	f.sides[KFRUSTUM_SIDE_RIGHT] = plane_3d_create(
-		vec3_add(position, forward_far),
-		vec3_cross(adjusted_up, vec3_sub(forward_far, right_half_h)));
+		position,
+		vec3_cross(adjusted_up, vec3_add(forward_far, right_half_h)));
 
 	// Left plane
 	f.sides[KFRUSTUM_SIDE_LEFT] = plane_3d_create(
-		vec3_add(position, forward_far),
-		vec3_cross(vec3_add(forward_far, right_half_h), adjusted_up));
+		position,
+		vec3_cross(vec3_sub(forward_far, right_half_h), adjusted_up));
 
 	// Far plane
 	f.sides[KFRUSTUM_SIDE_FAR] = plane_3d_create(
@@ -283,6 +283,148 @@ static void seed_randoms(void) {
 	rand_seeded = true;
 }
 
+#if KCOMPILETIME_SSE2 && !KCOMPILETIME_AVX
+// Returns a row of a matrix product: the rows b0-b3 of the second matrix, weighted by the given row of the first.
+KINLINE __m128 mat4_row_mul_sse(__m128 a, __m128 b0, __m128 b1, __m128 b2, __m128 b3) {
+	__m128 r = _mm_mul_ps(_mm_shuffle_ps(a, a, 0x00), b0);
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, 0x55), b1));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, 0xAA), b2));
+	return _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, 0xFF), b3));
+}
+#elif KCOMPILETIME_NEON
+// Returns a row of a matrix product: the rows b0-b3 of the second matrix, weighted by the given row of the first.
+KINLINE float32x4_t mat4_row_mul_neon(float32x4_t a, float32x4_t b0, float32x4_t b1, float32x4_t b2, float32x4_t b3) {
+	float32x4_t r = vmulq_n_f32(b0, vgetq_lane_f32(a, 0));
+	r = vmlaq_n_f32(r, b1, vgetq_lane_f32(a, 1));
+	r = vmlaq_n_f32(r, b2, vgetq_lane_f32(a, 2));
+	return vmlaq_n_f32(r, b3, vgetq_lane_f32(a, 3));
+}
+#endif
+
+void mat4_mul_batch(const mat4* matrices_0, const mat4* matrices_1, mat4* out_matrices, u32 count) {
+	// Works from the arrays directly rather than through copies of each matrix. The rows of
+	// each matrix_1 are loaded (and broadcast) once, then kept in registers for all four output
+	// rows. Everything is loaded before anything is stored, so the output may alias either input.
+#if KCOMPILETIME_AVX
+	for (u32 i = 0; i < count; ++i) {
+		const f32* b = matrices_1[i].data;
+		__m256 b0 = _mm256_broadcast_ps((const __m128*)&b[0]);
+		__m256 b1 = _mm256_broadcast_ps((const __m128*)&b[4]);
+		__m256 b2 = _mm256_broadcast_ps((const __m128*)&b[8]);
+		__m256 b3 = _mm256_broadcast_ps((const __m128*)&b[12]);
+		__m256 a01 = _mm256_loadu_ps(&matrices_0[i].data[0]);
+		__m256 a23 = _mm256_loadu_ps(&matrices_0[i].data[8]);
+
+		__m256 r01 = _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0x00), b0);
+		__m256 r23 = _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0x00), b0);
+		r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0x55), b1));
+		r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0x55), b1));
+		r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0xAA), b2));
+		r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0xAA), b2));
+		r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0xFF), b3));
+		r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0xFF), b3));
+
+		_mm256_storeu_ps(&out_matrices[i].data[0], r01);
+		_mm256_storeu_ps(&out_matrices[i].data[8], r23);
+	}
+#elif KCOMPILETIME_SSE2
+	for (u32 i = 0; i < count; ++i) {
+		const f32* b = matrices_1[i].data;
+		__m128 b0 = _mm_loadu_ps(&b[0]);
+		__m128 b1 = _mm_loadu_ps(&b[4]);
+		__m128 b2 = _mm_loadu_ps(&b[8]);
+		__m128 b3 = _mm_loadu_ps(&b[12]);
+		const f32* a = matrices_0[i].data;
+		__m128 r0 = mat4_row_mul_sse(_mm_loadu_ps(&a[0]), b0, b1, b2, b3);
+		__m128 r1 = mat4_row_mul_sse(_mm_loadu_ps(&a[4]), b0, b1, b2, b3);
+		__m128 r2 = mat4_row_mul_sse(_mm_loadu_ps(&a[8]), b0, b1, b2, b3);
+		__m128 r3 = mat4_row_mul_sse(_mm_loadu_ps(&a[12]), b0, b1, b2, b3);
+		f32* out = out_matrices[i].data;
+		_mm_storeu_ps(&out[0], r0);
+		_mm_storeu_ps(&out[4], r1);
+		_mm_storeu_ps(&out[8], r2);
+		_mm_storeu_ps(&out[12], r3);
+	}
+#elif KCOMPILETIME_NEON
+	for (u32 i = 0; i < count; ++i) {
+		const f32* b = matrices_1[i].data;
+		float32x4_t b0 = vld1q_f32(&b[0]);
+		float32x4_t b1 = vld1q_f32(&b[4]);
+		float32x4_t b2 = vld1q_f32(&b[8]);
+		float32x4_t b3 = vld1q_f32(&b[12]);
+		const f32* a = matrices_0[i].data;
+		float32x4_t r0 = mat4_row_mul_neon(vld1q_f32(&a[0]), b0, b1, b2, b3);
+		float32x4_t r1 = mat4_row_mul_neon(vld1q_f32(&a[4]), b0, b1, b2, b3);
+		float32x4_t r2 = mat4_row_mul_neon(vld1q_f32(&a[8]), b0, b1, b2, b3);
+		float32x4_t r3 = mat4_row_mul_neon(vld1q_f32(&a[12]), b0, b1, b2, b3);
+		f32* out = out_matrices[i].data;
+		vst1q_f32(&out[0], r0);
+		vst1q_f32(&out[4], r1);
+		vst1q_f32(&out[8], r2);
+		vst1q_f32(&out[12], r3);
+	}
+#else
+	for (u32 i = 0; i < count; ++i) {
+		out_matrices[i] = mat4_mul_scalar(matrices_0[i], matrices_1[i]);
+	}
+#endif
+}
+
+void aabb_transform_batch(const aabb* local_aabbs, const mat4* matrices, aabb* out_aabbs, u32 count) {
+#if KCOMPILETIME_SSE2 || KCOMPILETIME_NEON
+	for (u32 i = 0; i < count; ++i) {
+		const aabb* local = &local_aabbs[i];
+		const f32* m = matrices[i].data;
+		f32 cx = (local->min.x + local->max.x) * 0.5f;
+		f32 cy = (local->min.y + local->max.y) * 0.5f;
+		f32 cz = (local->min.z + local->max.z) * 0.5f;
+		f32 hx = (local->max.x - local->min.x) * 0.5f;
+		f32 hy = (local->max.y - local->min.y) * 0.5f;
+		f32 hz = (local->max.z - local->min.z) * 0.5f;
+
+		// The world center is the local center transformed as a point, and the world
+		// half extents are the local half extents weighted by the absolute basis vectors.
+		// Only the first 3 lanes are kept.
+		f32 world_min[4];
+		f32 world_max[4];
+#	if KCOMPILETIME_SSE2
+		__m128 r0 = _mm_loadu_ps(&m[0]);
+		__m128 r1 = _mm_loadu_ps(&m[4]);
+		__m128 r2 = _mm_loadu_ps(&m[8]);
+		__m128 center = _mm_mul_ps(r0, _mm_set1_ps(cx));
+		center = _mm_add_ps(center, _mm_mul_ps(r1, _mm_set1_ps(cy)));
+		center = _mm_add_ps(center, _mm_mul_ps(r2, _mm_set1_ps(cz)));
+		center = _mm_add_ps(center, _mm_loadu_ps(&m[12]));
+		__m128 sign_mask = _mm_set1_ps(-0.0f);
+		__m128 half = _mm_mul_ps(_mm_andnot_ps(sign_mask, r0), _mm_set1_ps(hx));
+		half = _mm_add_ps(half, _mm_mul_ps(_mm_andnot_ps(sign_mask, r1), _mm_set1_ps(hy)));
+		half = _mm_add_ps(half, _mm_mul_ps(_mm_andnot_ps(sign_mask, r2), _mm_set1_ps(hz)));
+		_mm_storeu_ps(world_min, _mm_sub_ps(center, half));
+		_mm_storeu_ps(world_max, _mm_add_ps(center, half));
+#	else
+		float32x4_t r0 = vld1q_f32(&m[0]);
+		float32x4_t r1 = vld1q_f32(&m[4]);
+		float32x4_t r2 = vld1q_f32(&m[8]);
+		float32x4_t center = vmulq_n_f32(r0, cx);
+		center = vmlaq_n_f32(center, r1, cy);
+		center = vmlaq_n_f32(center, r2, cz);
+		center = vaddq_f32(center, vld1q_f32(&m[12]));
+		float32x4_t half = vmulq_n_f32(vabsq_f32(r0), hx);
+		half = vmlaq_n_f32(half, vabsq_f32(r1), hy);
+		half = vmlaq_n_f32(half, vabsq_f32(r2), hz);
+		vst1q_f32(world_min, vsubq_f32(center, half));
+		vst1q_f32(world_max, vaddq_f32(center, half));
+#	endif
+		out_aabbs[i].min = (vec3){world_min[0], world_min[1], world_min[2]};
+		out_aabbs[i].max = (vec3){world_max[0], world_max[1], world_max[2]};
+	}
+#else
+	for (u32 i = 0; i < count; ++i) {
+		out_aabbs[i] = aabb_from_mat4_extents(local_aabbs[i].min, local_aabbs[i].max, matrices[i]);
+	}
+#endif
+}
+
 ray ray_transformed(const ray* r, mat4 transform) {
 	ray out = {
 		.origin = vec3_transform(r->origin, 1.0f, transform),
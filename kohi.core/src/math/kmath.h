@@ -16,8 +16,17 @@
 #include "defines.h"
 #include "math_types.h"
 #include "memory/kmemory.h"
+#include "platform/kfeatures_compile.h"
 #include <float.h>
 
+#if KCOMPILETIME_AVX
+#	include <immintrin.h>
+#elif KCOMPILETIME_SSE2
+#	include <emmintrin.h>
+#elif KCOMPILETIME_NEON
+#	include <arm_neon.h>
+#endif
+
 /** @brief An approximate representation of PI. */
 #define K_PI 3.14159265358979323846f
 
@@ -1377,13 +1386,14 @@ KINLINE mat4 mat4_identity(void) {
 }
 
 /**
- * @brief Returns the result of multiplying matrix_0 and matrix_1.
+ * @brief Returns the result of multiplying matrix_0 and matrix_1, without using SIMD.
+ * This is the reference implementation for mat4_mul.
  *
  * @param matrix_0 The first matrix to be multiplied.
  * @param matrix_1 The second matrix to be multiplied.
  * @return The result of the matrix multiplication.
  */
-KINLINE mat4 mat4_mul(mat4 matrix_0, mat4 matrix_1) {
+KINLINE mat4 mat4_mul_scalar(mat4 matrix_0, mat4 matrix_1) {
 	mat4 out_matrix = mat4_identity();
 
 	const f32* m1_ptr = matrix_0.data;
@@ -1401,6 +1411,79 @@ KINLINE mat4 mat4_mul(mat4 matrix_0, mat4 matrix_1) {
 	return out_matrix;
 }
 
+/**
+ * @brief Returns the result of multiplying matrix_0 and matrix_1. Uses SIMD where
+ * available, adding products in the same order as mat4_mul_scalar.
+ *
+ * @param matrix_0 The first matrix to be multiplied.
+ * @param matrix_1 The second matrix to be multiplied.
+ * @return The result of the matrix multiplication.
+ */
+KINLINE mat4 mat4_mul(mat4 matrix_0, mat4 matrix_1) {
+#if KCOMPILETIME_AVX
+	// Two output rows at a time, with each row of matrix_1 repeated in both lanes.
+	mat4 out_matrix;
+	__m256 b0 = _mm256_broadcast_ps((const __m128*)&matrix_1.data[0]);
+	__m256 b1 = _mm256_broadcast_ps((const __m128*)&matrix_1.data[4]);
+	__m256 b2 = _mm256_broadcast_ps((const __m128*)&matrix_1.data[8]);
+	__m256 b3 = _mm256_broadcast_ps((const __m128*)&matrix_1.data[12]);
+	for (i32 i = 0; i < 16; i += 8) {
+		__m256 a = _mm256_loadu_ps(&matrix_0.data[i]);
+		__m256 r = _mm256_mul_ps(_mm256_shuffle_ps(a, a, 0x00), b0);
+		r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(a, a, 0x55), b1));
+		r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(a, a, 0xAA), b2));
+		r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(a, a, 0xFF), b3));
+		_mm256_storeu_ps(&out_matrix.data[i], r);
+	}
+	return out_matrix;
+#elif KCOMPILETIME_SSE2
+	// Each output row is the rows of matrix_1, weighted by the matching row of matrix_0.
+	mat4 out_matrix;
+	__m128 b0 = _mm_loadu_ps(&matrix_1.data[0]);
+	__m128 b1 = _mm_loadu_ps(&matrix_1.data[4]);
+	__m128 b2 = _mm_loadu_ps(&matrix_1.data[8]);
+	__m128 b3 = _mm_loadu_ps(&matrix_1.data[12]);
+	for (i32 i = 0; i < 16; i += 4) {
+		__m128 a = _mm_loadu_ps(&matrix_0.data[i]);
+		__m128 r = _mm_mul_ps(_mm_shuffle_ps(a, a, 0x00), b0);
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, 0x55), b1));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, 0xAA), b2));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, 0xFF), b3));
+		_mm_storeu_ps(&out_matrix.data[i], r);
+	}
+	return out_matrix;
+#elif KCOMPILETIME_NEON
+	mat4 out_matrix;
+	float32x4_t b0 = vld1q_f32(&matrix_1.data[0]);
+	float32x4_t b1 = vld1q_f32(&matrix_1.data[4]);
+	float32x4_t b2 = vld1q_f32(&matrix_1.data[8]);
+	float32x4_t b3 = vld1q_f32(&matrix_1.data[12]);
+	for (i32 i = 0; i < 16; i += 4) {
+		const f32* a = &matrix_0.data[i];
+		float32x4_t r = vmulq_n_f32(b0, a[0]);
+		r = vmlaq_n_f32(r, b1, a[1]);
+		r = vmlaq_n_f32(r, b2, a[2]);
+		r = vmlaq_n_f32(r, b3, a[3]);
+		vst1q_f32(&out_matrix.data[i], r);
+	}
+	return out_matrix;
+#else
+	return mat4_mul_scalar(matrix_0, matrix_1);
+#endif
+}
+
+/**
+ * @brief Multiplies each matrix of matrices_0 by the matrix at the same index of
+ * matrices_1, as mat4_mul does. Uses SIMD where available. out_matrices may be the
+ * same array as either input.
+ *
+ * @param matrices_0 An array of the first matrices to be multiplied.
+ * @param matrices_1 An array of the second matrices to be multiplied.
+ * @param out_matrices An array to hold the results. Must hold at least count matrices.
+ * @param count The number of multiplications to perform.
+ */
+KAPI void mat4_mul_batch(const mat4* matrices_0, const mat4* matrices_1, mat4* out_matrices, u32 count);
+
 /**
  * @brief Creates and returns an orthographic projection matrix. Typically used
  * to render flat or 2D scenes.
@@ -1554,12 +1637,13 @@ KINLINE f32 mat4_determinant(mat4 matrix) {
 }
 
 /**
- * @brief Creates and returns an inverse of the provided matrix.
+ * @brief Creates and returns an inverse of the provided matrix, without using SIMD.
+ * This is the reference implementation for mat4_inverse.
  *
  * @param matrix The matrix to be inverted.
- * @return A inverted copy of the provided matrix.
+ * @return A inverted copy of the provided matrix, or identity if the matrix is singular.
  */
-KINLINE mat4 mat4_inverse(mat4 matrix) {
+KINLINE mat4 mat4_inverse_scalar(mat4 matrix) {
 	const f32* m = matrix.data;
 
 	f32 t0 = m[10] * m[15];
@@ -1639,6 +1723,174 @@ KINLINE mat4 mat4_inverse(mat4 matrix) {
 	return out_matrix;
 }
 
+#if KCOMPILETIME_SSE2
+// 2x2 matrix helpers for mat4_inverse, with each 2x2 matrix held row by row in one register.
+// Returns a * b.
+KINLINE __m128 mat2_mul_sse(__m128 a, __m128 b) {
+	return _mm_add_ps(_mm_mul_ps(a, _mm_shuffle_ps(b, b, 0xCC)),
+					  _mm_mul_ps(_mm_shuffle_ps(a, a, 0xB1), _mm_shuffle_ps(b, b, 0x66)));
+}
+
+// Returns adjugate(a) * b.
+KINLINE __m128 mat2_adj_mul_sse(__m128 a, __m128 b) {
+	return _mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(a, a, 0x0F), b),
+					  _mm_mul_ps(_mm_shuffle_ps(a, a, 0xA5), _mm_shuffle_ps(b, b, 0x4E)));
+}
+
+// Returns a * adjugate(b).
+KINLINE __m128 mat2_mul_adj_sse(__m128 a, __m128 b) {
+	return _mm_sub_ps(_mm_mul_ps(a, _mm_shuffle_ps(b, b, 0x33)),
+					  _mm_mul_ps(_mm_shuffle_ps(a, a, 0xB1), _mm_shuffle_ps(b, b, 0x66)));
+}
+#elif KCOMPILETIME_NEON
+// Returns lanes i0 and i1 of a followed by lanes i2 and i3 of b, as _mm_shuffle_ps does.
+#	define KNEON_SHUFFLE(a, b, i0, i1, i2, i3) \
+		((float32x4_t){vgetq_lane_f32(a, i0), vgetq_lane_f32(a, i1), vgetq_lane_f32(b, i2), vgetq_lane_f32(b, i3)})
+
+// 2x2 matrix helpers for mat4_inverse, the same as the SSE versions above.
+// Returns a * b.
+KINLINE float32x4_t mat2_mul_neon(float32x4_t a, float32x4_t b) {
+	return vaddq_f32(vmulq_f32(a, KNEON_SHUFFLE(b, b, 0, 3, 0, 3)),
+					 vmulq_f32(KNEON_SHUFFLE(a, a, 1, 0, 3, 2), KNEON_SHUFFLE(b, b, 2, 1, 2, 1)));
+}
+
+// Returns adjugate(a) * b.
+KINLINE float32x4_t mat2_adj_mul_neon(float32x4_t a, float32x4_t b) {
+	return vsubq_f32(vmulq_f32(KNEON_SHUFFLE(a, a, 3, 3, 0, 0), b),
+					 vmulq_f32(KNEON_SHUFFLE(a, a, 1, 1, 2, 2), KNEON_SHUFFLE(b, b, 2, 3, 0, 1)));
+}
+
+// Returns a * adjugate(b).
+KINLINE float32x4_t mat2_mul_adj_neon(float32x4_t a, float32x4_t b) {
+	return vsubq_f32(vmulq_f32(a, KNEON_SHUFFLE(b, b, 3, 0, 3, 0)),
+					 vmulq_f32(KNEON_SHUFFLE(a, a, 1, 0, 3, 2), KNEON_SHUFFLE(b, b, 2, 1, 2, 1)));
+}
+#endif
+
+/**
+ * @brief Creates and returns an inverse of the provided matrix. Uses SIMD where
+ * available, in which case results match mat4_inverse_scalar to within rounding.
+ *
+ * @param matrix The matrix to be inverted.
+ * @return A inverted copy of the provided matrix, or identity if the matrix is singular.
+ */
+KINLINE mat4 mat4_inverse(mat4 matrix) {
+#if KCOMPILETIME_SSE2
+	// Inverts blockwise, treating the matrix as the 2x2 blocks | A B |
+	//                                                          | C D |
+	__m128 r0 = _mm_loadu_ps(&matrix.data[0]);
+	__m128 r1 = _mm_loadu_ps(&matrix.data[4]);
+	__m128 r2 = _mm_loadu_ps(&matrix.data[8]);
+	__m128 r3 = _mm_loadu_ps(&matrix.data[12]);
+
+	__m128 a = _mm_movelh_ps(r0, r1);
+	__m128 b = _mm_movehl_ps(r1, r0);
+	__m128 c = _mm_movelh_ps(r2, r3);
+	__m128 d = _mm_movehl_ps(r3, r2);
+
+	// Determinants of the blocks, as (|A|, |B|, |C|, |D|).
+	__m128 det_sub = _mm_sub_ps(
+		_mm_mul_ps(_mm_shuffle_ps(r0, r2, 0x88), _mm_shuffle_ps(r1, r3, 0xDD)),
+		_mm_mul_ps(_mm_shuffle_ps(r0, r2, 0xDD), _mm_shuffle_ps(r1, r3, 0x88)));
+	__m128 det_a = _mm_shuffle_ps(det_sub, det_sub, 0x00);
+	__m128 det_b = _mm_shuffle_ps(det_sub, det_sub, 0x55);
+	__m128 det_c = _mm_shuffle_ps(det_sub, det_sub, 0xAA);
+	__m128 det_d = _mm_shuffle_ps(det_sub, det_sub, 0xFF);
+
+	__m128 d_c = mat2_adj_mul_sse(d, c);
+	__m128 a_b = mat2_adj_mul_sse(a, b);
+
+	// Adjugates of the blocks of the inverse, before scaling by 1/|M|.
+	__m128 x = _mm_sub_ps(_mm_mul_ps(det_d, a), mat2_mul_sse(b, d_c));
+	__m128 w = _mm_sub_ps(_mm_mul_ps(det_a, d), mat2_mul_sse(c, a_b));
+	__m128 y = _mm_sub_ps(_mm_mul_ps(det_b, c), mat2_mul_adj_sse(d, a_b));
+	__m128 z = _mm_sub_ps(_mm_mul_ps(det_c, b), mat2_mul_adj_sse(a, d_c));
+
+	// |M| = |A||D| + |B||C| - tr((A#B)(D#C))
+	__m128 tr = _mm_mul_ps(a_b, _mm_shuffle_ps(d_c, d_c, 0xD8));
+	tr = _mm_add_ps(tr, _mm_shuffle_ps(tr, tr, 0xB1));
+	tr = _mm_add_ps(tr, _mm_shuffle_ps(tr, tr, 0x4E));
+	__m128 det_m = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(det_a, det_d), _mm_mul_ps(det_b, det_c)), tr);
+
+	// Check for singular matrix (determinant near zero), as mat4_inverse_scalar does.
+	if (kabs(1.0f / _mm_cvtss_f32(det_m)) < 1e-6f) {
+		return mat4_identity();
+	}
+
+	__m128 r_det_m = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det_m);
+	x = _mm_mul_ps(x, r_det_m);
+	y = _mm_mul_ps(y, r_det_m);
+	z = _mm_mul_ps(z, r_det_m);
+	w = _mm_mul_ps(w, r_det_m);
+
+	// Applying the final adjugate shuffle while reassembling rows.
+	mat4 out_matrix;
+	_mm_storeu_ps(&out_matrix.data[0], _mm_shuffle_ps(x, y, 0x77));
+	_mm_storeu_ps(&out_matrix.data[4], _mm_shuffle_ps(x, y, 0x22));
+	_mm_storeu_ps(&out_matrix.data[8], _mm_shuffle_ps(z, w, 0x77));
+	_mm_storeu_ps(&out_matrix.data[12], _mm_shuffle_ps(z, w, 0x22));
+	return out_matrix;
+#elif KCOMPILETIME_NEON
+	// The same blockwise inversion as the SSE path.
+	float32x4_t r0 = vld1q_f32(&matrix.data[0]);
+	float32x4_t r1 = vld1q_f32(&matrix.data[4]);
+	float32x4_t r2 = vld1q_f32(&matrix.data[8]);
+	float32x4_t r3 = vld1q_f32(&matrix.data[12]);
+
+	float32x4_t a = vcombine_f32(vget_low_f32(r0), vget_low_f32(r1));
+	float32x4_t b = vcombine_f32(vget_high_f32(r0), vget_high_f32(r1));
+	float32x4_t c = vcombine_f32(vget_low_f32(r2), vget_low_f32(r3));
+	float32x4_t d = vcombine_f32(vget_high_f32(r2), vget_high_f32(r3));
+
+	// Determinants of the blocks, as (|A|, |B|, |C|, |D|).
+	float32x4_t det_sub = vsubq_f32(
+		vmulq_f32(KNEON_SHUFFLE(r0, r2, 0, 2, 0, 2), KNEON_SHUFFLE(r1, r3, 1, 3, 1, 3)),
+		vmulq_f32(KNEON_SHUFFLE(r0, r2, 1, 3, 1, 3), KNEON_SHUFFLE(r1, r3, 0, 2, 0, 2)));
+	float32x4_t det_a = vdupq_n_f32(vgetq_lane_f32(det_sub, 0));
+	float32x4_t det_b = vdupq_n_f32(vgetq_lane_f32(det_sub, 1));
+	float32x4_t det_c = vdupq_n_f32(vgetq_lane_f32(det_sub, 2));
+	float32x4_t det_d = vdupq_n_f32(vgetq_lane_f32(det_sub, 3));
+
+	float32x4_t d_c = mat2_adj_mul_neon(d, c);
+	float32x4_t a_b = mat2_adj_mul_neon(a, b);
+
+	// Adjugates of the blocks of the inverse, before scaling by 1/|M|.
+	float32x4_t x = vsubq_f32(vmulq_f32(det_d, a), mat2_mul_neon(b, d_c));
+	float32x4_t w = vsubq_f32(vmulq_f32(det_a, d), mat2_mul_neon(c, a_b));
+	float32x4_t y = vsubq_f32(vmulq_f32(det_b, c), mat2_mul_adj_neon(d, a_b));
+	float32x4_t z = vsubq_f32(vmulq_f32(det_c, b), mat2_mul_adj_neon(a, d_c));
+
+	// |M| = |A||D| + |B||C| - tr((A#B)(D#C))
+	float32x4_t tr = vmulq_f32(a_b, KNEON_SHUFFLE(d_c, d_c, 0, 2, 1, 3));
+	tr = vaddq_f32(tr, KNEON_SHUFFLE(tr, tr, 1, 0, 3, 2));
+	tr = vaddq_f32(tr, KNEON_SHUFFLE(tr, tr, 2, 3, 0, 1));
+	f32 det_m = vgetq_lane_f32(vsubq_f32(vaddq_f32(vmulq_f32(det_a, det_d), vmulq_f32(det_b, det_c)), tr), 0);
+
+	// Check for singular matrix (determinant near zero), as mat4_inverse_scalar does.
+	f32 r_det_m = 1.0f / det_m;
+	if (kabs(r_det_m) < 1e-6f) {
+		return mat4_identity();
+	}
+
+	// Every lane of |M| is the same, so a scalar reciprocal serves (ARMv7 NEON has no vector divide).
+	float32x4_t signed_r_det_m = vmulq_n_f32((float32x4_t){1.0f, -1.0f, -1.0f, 1.0f}, r_det_m);
+	x = vmulq_f32(x, signed_r_det_m);
+	y = vmulq_f32(y, signed_r_det_m);
+	z = vmulq_f32(z, signed_r_det_m);
+	w = vmulq_f32(w, signed_r_det_m);
+
+	// Applying the final adjugate shuffle while reassembling rows.
+	mat4 out_matrix;
+	vst1q_f32(&out_matrix.data[0], KNEON_SHUFFLE(x, y, 3, 1, 3, 1));
+	vst1q_f32(&out_matrix.data[4], KNEON_SHUFFLE(x, y, 2, 0, 2, 0));
+	vst1q_f32(&out_matrix.data[8], KNEON_SHUFFLE(z, w, 3, 1, 3, 1));
+	vst1q_f32(&out_matrix.data[12], KNEON_SHUFFLE(z, w, 2, 0, 2, 0));
+	return out_matrix;
+#else
+	return mat4_inverse_scalar(matrix);
+#endif
+}
+
 /**
  * @brief Creates and returns a translation matrix from the given position.
  *
@@ -1668,14 +1920,15 @@ KINLINE mat4 mat4_scale(vec3 scale) {
 }
 
 /**
- * @brief Returns a matrix created from the provided translation, rotation and scale (TRS).
+ * @brief Returns a matrix created from the provided translation, rotation and scale (TRS),
+ * without using SIMD. This is the reference implementation for mat4_from_translation_rotation_scale.
  *
  * @param position The position to be used to create the matrix.
  * @param rotation The quaternion rotation to be used to create the matrix.
  * @param scale The 3-component scale to be used to create the matrix.
  * @return A matrix created in TRS order.
  */
-KINLINE mat4 mat4_from_translation_rotation_scale(vec3 t, quat r, vec3 s) {
+KINLINE mat4 mat4_from_translation_rotation_scale_scalar(vec3 t, quat r, vec3 s) {
 	mat4 out_matrix;
 
 	out_matrix.data[0] = (1.0f - 2.0f * (r.y * r.y + r.z * r.z)) * s.x;
@@ -1698,6 +1951,75 @@ KINLINE mat4 mat4_from_translation_rotation_scale(vec3 t, quat r, vec3 s) {
 	return out_matrix;
 }
 
+/**
+ * @brief Returns a matrix created from the provided translation, rotation and scale (TRS).
+ * Uses SIMD where available, in which case results match
+ * mat4_from_translation_rotation_scale_scalar to within rounding.
+ *
+ * @param position The position to be used to create the matrix.
+ * @param rotation The quaternion rotation to be used to create the matrix.
+ * @param scale The 3-component scale to be used to create the matrix.
+ * @return A matrix created in TRS order.
+ */
+KINLINE mat4 mat4_from_translation_rotation_scale(vec3 t, quat r, vec3 s) {
+	// The diagonal comes from the squares of the quaternion's components, and the rest from
+	// the sums (p) and differences (m) of its cross products. With q2 = q + q:
+	//   d = 1 - (2yy + 2zz, 2xx + 2zz, 2xx + 2yy)
+	//   p = (2xz + 2wy, 2xy + 2wz, 2yz + 2wx)
+	//   m = (2xz - 2wy, 2xy - 2wz, 2yz - 2wx)
+	// giving the rows (d0, p1, m0), (m1, d1, p2) and (p0, m2, d2), each then scaled.
+#if KCOMPILETIME_SSE2
+	__m128 q = _mm_setr_ps(r.x, r.y, r.z, r.w);
+	__m128 q2 = _mm_add_ps(q, q);
+
+	__m128 squares = _mm_mul_ps(q, q2);
+	__m128 d = _mm_add_ps(_mm_shuffle_ps(squares, squares, 0xC1), _mm_shuffle_ps(squares, squares, 0xDA));
+	d = _mm_and_ps(_mm_sub_ps(_mm_set1_ps(1.0f), d), _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0)));
+
+	__m128 a = _mm_mul_ps(_mm_shuffle_ps(q, q, 0xD0), _mm_shuffle_ps(q2, q2, 0xE6));
+	__m128 b = _mm_mul_ps(_mm_shuffle_ps(q, q, 0xFF), _mm_shuffle_ps(q2, q2, 0xC9));
+	__m128 p = _mm_add_ps(a, b);
+	__m128 m = _mm_sub_ps(a, b);
+
+	// (p1, p2, m0, m1) and (p0, p0, m2, m2).
+	__m128 pm = _mm_shuffle_ps(p, m, 0x49);
+	__m128 pm2 = _mm_shuffle_ps(p, m, 0xA0);
+	__m128 row0 = _mm_shuffle_ps(d, pm, 0x8C);
+	row0 = _mm_shuffle_ps(row0, row0, 0x78);
+	__m128 row1 = _mm_shuffle_ps(d, pm, 0x7D);
+	row1 = _mm_shuffle_ps(row1, row1, 0x72);
+	__m128 row2 = _mm_shuffle_ps(pm2, d, 0xE8);
+
+	mat4 out_matrix;
+	_mm_storeu_ps(&out_matrix.data[0], _mm_mul_ps(row0, _mm_set1_ps(s.x)));
+	_mm_storeu_ps(&out_matrix.data[4], _mm_mul_ps(row1, _mm_set1_ps(s.y)));
+	_mm_storeu_ps(&out_matrix.data[8], _mm_mul_ps(row2, _mm_set1_ps(s.z)));
+	_mm_storeu_ps(&out_matrix.data[12], _mm_setr_ps(t.x, t.y, t.z, 1.0f));
+	return out_matrix;
+#elif KCOMPILETIME_NEON
+	float32x4_t q = vld1q_f32(r.elements);
+	float32x4_t q2 = vaddq_f32(q, q);
+
+	float32x4_t squares = vmulq_f32(q, q2);
+	float32x4_t d = vaddq_f32(KNEON_SHUFFLE(squares, squares, 1, 0, 0, 3), KNEON_SHUFFLE(squares, squares, 2, 2, 1, 3));
+	d = vsubq_f32(vdupq_n_f32(1.0f), d);
+
+	float32x4_t a = vmulq_f32(KNEON_SHUFFLE(q, q, 0, 0, 1, 3), KNEON_SHUFFLE(q2, q2, 2, 1, 2, 3));
+	float32x4_t b = vmulq_n_f32(KNEON_SHUFFLE(q2, q2, 1, 2, 0, 3), vgetq_lane_f32(q, 3));
+	float32x4_t p = vaddq_f32(a, b);
+	float32x4_t m = vsubq_f32(a, b);
+
+	mat4 out_matrix;
+	vst1q_f32(&out_matrix.data[0], vmulq_n_f32((float32x4_t){vgetq_lane_f32(d, 0), vgetq_lane_f32(p, 1), vgetq_lane_f32(m, 0), 0.0f}, s.x));
+	vst1q_f32(&out_matrix.data[4], vmulq_n_f32((float32x4_t){vgetq_lane_f32(m, 1), vgetq_lane_f32(d, 1), vgetq_lane_f32(p, 2), 0.0f}, s.y));
+	vst1q_f32(&out_matrix.data[8], vmulq_n_f32((float32x4_t){vgetq_lane_f32(p, 0), vgetq_lane_f32(m, 2), vgetq_lane_f32(d, 2), 0.0f}, s.z));
+	vst1q_f32(&out_matrix.data[12], (float32x4_t){t.x, t.y, t.z, 1.0f});
+	return out_matrix;
+#else
+	return mat4_from_translation_rotation_scale_scalar(t, r, s);
+#endif
+}
+
 /**
  * @brief Creates a rotation matrix from the provided x angle.
  *
@@ -1913,13 +2235,13 @@ KINLINE vec3 vec3_mul_mat4(vec3 v, mat4 m) {
 }
 
 /**
- * @brief Performs m * v
+ * @brief Performs m * v, without using SIMD. This is the reference implementation for mat4_mul_vec4.
  *
  * @param m The matrix to be multiplied.
  * @param v The vector to multiply by.
  * @return The transformed vector.
  */
-KINLINE vec4 mat4_mul_vec4(mat4 m, vec4 v) {
+KINLINE vec4 mat4_mul_vec4_scalar(mat4 m, vec4 v) {
 	return (vec4){
 		v.x * m.data[0] + v.y * m.data[1] + v.z * m.data[2] + v.w * m.data[3],
 		v.x * m.data[4] + v.y * m.data[5] + v.z * m.data[6] + v.w * m.data[7],
@@ -1928,13 +2250,50 @@ KINLINE vec4 mat4_mul_vec4(mat4 m, vec4 v) {
 }
 
 /**
- * @brief Performs v * m
+ * @brief Performs m * v. Uses SIMD where available.
+ *
+ * @param m The matrix to be multiplied.
+ * @param v The vector to multiply by.
+ * @return The transformed vector.
+ */
+KINLINE vec4 mat4_mul_vec4(mat4 m, vec4 v) {
+#if KCOMPILETIME_SSE2
+	// Transposed, so the result is the columns of m weighted by v.
+	__m128 c0 = _mm_loadu_ps(&m.data[0]);
+	__m128 c1 = _mm_loadu_ps(&m.data[4]);
+	__m128 c2 = _mm_loadu_ps(&m.data[8]);
+	__m128 c3 = _mm_loadu_ps(&m.data[12]);
+	_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+	__m128 r = _mm_mul_ps(_mm_set1_ps(v.x), c0);
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(v.y), c1));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(v.z), c2));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(v.w), c3));
+	vec4 out_vector;
+	_mm_storeu_ps(out_vector.elements, r);
+	return out_vector;
+#elif KCOMPILETIME_NEON
+	// De-interleaving on load transposes m.
+	float32x4x4_t c = vld4q_f32(m.data);
+	float32x4_t r = vmulq_n_f32(c.val[0], v.x);
+	r = vmlaq_n_f32(r, c.val[1], v.y);
+	r = vmlaq_n_f32(r, c.val[2], v.z);
+	r = vmlaq_n_f32(r, c.val[3], v.w);
+	vec4 out_vector;
+	vst1q_f32(out_vector.elements, r);
+	return out_vector;
+#else
+	return mat4_mul_vec4_scalar(m, v);
+#endif
+}
+
+/**
+ * @brief Performs v * m, without using SIMD. This is the reference implementation for vec4_mul_mat4.
  *
  * @param v The vector to bemultiplied.
  * @param m The matrix to be multiply by.
  * @return The transformed vector.
  */
-KINLINE vec4 vec4_mul_mat4(vec4 v, mat4 m) {
+KINLINE vec4 vec4_mul_mat4_scalar(vec4 v, mat4 m) {
 	return (vec4){
 		v.x * m.data[0] + v.y * m.data[4] + v.z * m.data[8] + v.w * m.data[12],
 		v.x * m.data[1] + v.y * m.data[5] + v.z * m.data[9] + v.w * m.data[13],
@@ -1942,6 +2301,35 @@ KINLINE vec4 vec4_mul_mat4(vec4 v, mat4 m) {
 		v.x * m.data[3] + v.y * m.data[7] + v.z * m.data[11] + v.w * m.data[15]};
 }
 
+/**
+ * @brief Performs v * m. Uses SIMD where available.
+ *
+ * @param v The vector to bemultiplied.
+ * @param m The matrix to be multiply by.
+ * @return The transformed vector.
+ */
+KINLINE vec4 vec4_mul_mat4(vec4 v, mat4 m) {
+#if KCOMPILETIME_SSE2
+	__m128 r = _mm_mul_ps(_mm_set1_ps(v.x), _mm_loadu_ps(&m.data[0]));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(v.y), _mm_loadu_ps(&m.data[4])));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(v.z), _mm_loadu_ps(&m.data[8])));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(v.w), _mm_loadu_ps(&m.data[12])));
+	vec4 out_vector;
+	_mm_storeu_ps(out_vector.elements, r);
+	return out_vector;
+#elif KCOMPILETIME_NEON
+	float32x4_t r = vmulq_n_f32(vld1q_f32(&m.data[0]), v.x);
+	r = vmlaq_n_f32(r, vld1q_f32(&m.data[4]), v.y);
+	r = vmlaq_n_f32(r, vld1q_f32(&m.data[8]), v.z);
+	r = vmlaq_n_f32(r, vld1q_f32(&m.data[12]), v.w);
+	vec4 out_vector;
+	vst1q_f32(out_vector.elements, r);
+	return out_vector;
+#else
+	return vec4_mul_mat4_scalar(v, m);
+#endif
+}
+
 // ------------------------------------------
 // Quaternion
 // ------------------------------------------
@@ -2215,6 +2603,10 @@ KINLINE quat quat_from_axis_angle(vec3 axis, f32 angle, b8 normalize) {
  * @brief Calculates spherical linear interpolation of a given percentage
  * between two quaternions.
  *
+ * @note Deliberately scalar. The cost is in the acos and sin calls rather than
+ * the few 4-wide operations around them, so SIMD gains nothing here. Where exact
+ * slerp is not needed, a normalized lerp is far cheaper.
+ *
  * @param q_0 The first quaternion.
  * @param q_1 The second quaternion.
  * @param percentage The percentage of interpolation, typically a value from
@@ -2377,6 +2769,14 @@ KAPI plane_3d plane_3d_create(vec3 p1, vec3 norm);
  */
 KAPI kfrustum kfrustum_create(vec3 position, vec3 target, vec3 up, f32 aspect, f32 fov, f32 near, f32 far);
 
+/**
+ * @brief Creates and returns a frustum bounding exactly what is visible through
+ * the provided combined view/projection matrix (i.e. mat4_mul(view, projection)).
+ * Works for both perspective and orthographic projections.
+ *
+ * @param view_projection The combined view/projection matrix.
+ * @return A shiny new frustum.
+ */
 KAPI kfrustum kfrustum_from_view_projection(mat4 view_projection);
 
 /**
@@ -2670,6 +3070,17 @@ KINLINE aabb aabb_from_mat4_extents(vec3 local_min, vec3 local_max, mat4 mat) {
 		vec3_add(center, half));
 }
 
+/**
+ * @brief Transforms each local-space AABB by the matrix at the same index, producing
+ * world-space AABBs as aabb_from_mat4_extents does. Uses SIMD where available.
+ *
+ * @param local_aabbs An array of the local-space AABBs.
+ * @param matrices An array of the world matrices to transform by.
+ * @param out_aabbs An array to hold the world-space AABBs. Must hold at least count AABBs. May be the same array as local_aabbs.
+ * @param count The number of AABBs to transform.
+ */
+KAPI void aabb_transform_batch(const aabb* local_aabbs, const mat4* matrices, aabb* out_aabbs, u32 count);
+
 /**
  * @brief Indicates if point is inside the provided AABB.
  *
@@ -6,6 +6,7 @@
 #include "memory/allocators/dynamic_allocator.h"
 #include "platform/platform.h"
 #include "strings/kstring.h"
+#include "threads/katomic.h"
 #include "threads/kmutex.h"
 
 // TODO: Custom string lib
@@ -80,11 +81,151 @@ typedef struct memory_system_state {
 	void* allocator_block;
 	// A mutex for allocations/frees
 	kmutex allocation_mutex;
+	// Identifies this instance of the memory system, so that thread caches filled by a previous one are never reused.
+	u32 generation;
 } memory_system_state;
 
 // Pointer to system state.
 static memory_system_state* state_ptr;
 
+// Bumped each time the memory system is initialized.
+static u32 memory_system_generation = 0;
+
+#if K_USE_CUSTOM_MEMORY_ALLOCATOR
+/*
+ * Small allocations are served from per-thread caches of free blocks, split into size classes.
+ * Each class is refilled from (and flushed back to) the dynamic allocator a batch at a time, so
+ * the allocation mutex is only taken once per batch rather than on every allocation and free.
+ *
+ * Cached blocks are allocated from the dynamic allocator with the size of their class and an
+ * alignment of KMEMORY_SMALL_ALIGNMENT. Any block whose header matches that is known to belong
+ * to a cache, regardless of the size passed in when freeing it.
+ */
+
+// Requests of up to this size (with up to KMEMORY_SMALL_ALIGNMENT alignment) are served by the thread caches.
+#	define KMEMORY_SMALL_MAX_SIZE 512
+// The alignment of every block held in a thread cache.
+#	define KMEMORY_SMALL_ALIGNMENT 16
+// The number of small size classes.
+#	define KMEMORY_SMALL_CLASS_COUNT 10
+// The number of blocks moved between a thread cache and the dynamic allocator at once.
+#	define KMEMORY_CACHE_BATCH_SIZE 32
+// Once a thread holds more than this many free blocks of one class, a batch is returned to the dynamic allocator.
+#	define KMEMORY_CACHE_MAX_BLOCKS (KMEMORY_CACHE_BATCH_SIZE * 2)
+
+static const u32 small_class_sizes[KMEMORY_SMALL_CLASS_COUNT] = {16, 32, 48, 64, 96, 128, 192, 256, 384, 512};
+
+// Maps a size, in units of KMEMORY_SMALL_ALIGNMENT (rounded up), to its size class.
+static const u8 small_class_lookup[(KMEMORY_SMALL_MAX_SIZE / KMEMORY_SMALL_ALIGNMENT) + 1] = {
+	0, 0, 1, 2, 3, 4, 4, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7,
+	8, 8, 8, 8, 8, 8, 8, 8, 9, 9, 9, 9, 9, 9, 9, 9};
+
+// A free block in a thread cache. The link is stored in the block itself.
+typedef struct small_free_block {
+	struct small_free_block* next;
+} small_free_block;
+
+typedef struct thread_cache {
+	// The generation of the memory system these blocks came from.
+	u32 generation;
+	u32 counts[KMEMORY_SMALL_CLASS_COUNT];
+	small_free_block* heads[KMEMORY_SMALL_CLASS_COUNT];
+} thread_cache;
+
+static KTHREAD_LOCAL thread_cache local_cache;
+
+static KINLINE u8 small_class_get(u64 size) {
+	return small_class_lookup[(size + KMEMORY_SMALL_ALIGNMENT - 1) / KMEMORY_SMALL_ALIGNMENT];
+}
+
+static KINLINE b8 is_small_request(u64 size, u16 alignment) {
+	return size <= KMEMORY_SMALL_MAX_SIZE && alignment <= KMEMORY_SMALL_ALIGNMENT;
+}
+
+static thread_cache* thread_cache_get(void) {
+	thread_cache* cache = &local_cache;
+	if (cache->generation != state_ptr->generation) {
+		// Anything in here belonged to a previous instance of the memory system, and is already gone.
+		kzero_memory(cache, sizeof(thread_cache));
+		cache->generation = state_ptr->generation;
+	}
+	return cache;
+}
+
+// Returns up to count blocks of the given class to the dynamic allocator. The allocation mutex must be held.
+static void thread_cache_release(thread_cache* cache, u8 class_index, u32 count) {
+	for (u32 i = 0; i < count && cache->heads[class_index]; ++i) {
+		small_free_block* block = cache->heads[class_index];
+		cache->heads[class_index] = block->next;
+		cache->counts[class_index]--;
+		dynamic_allocator_free_aligned(&state_ptr->allocator, block, MEMORY_TAG_UNKNOWN);
+	}
+}
+
+static void* small_allocate(u8 class_index, memory_tag tag, const char* file, u32 line) {
+	thread_cache* cache = thread_cache_get();
+	if (!cache->heads[class_index]) {
+		// Refill a whole batch under one lock.
+		if (!kmutex_lock(&state_ptr->allocation_mutex)) {
+			KFATAL("Error obtaining mutex lock during allocation.");
+			return 0;
+		}
+		for (u32 i = 0; i < KMEMORY_CACHE_BATCH_SIZE; ++i) {
+			small_free_block* block = dynamic_allocator_allocate_aligned(&state_ptr->allocator, small_class_sizes[class_index], KMEMORY_SMALL_ALIGNMENT, (u8)tag, file, line);
+			if (!block) {
+				break;
+			}
+			block->next = cache->heads[class_index];
+			cache->heads[class_index] = block;
+			cache->counts[class_index]++;
+		}
+		kmutex_unlock(&state_ptr->allocation_mutex);
+
+		if (!cache->heads[class_index]) {
+			return 0;
+		}
+	}
+
+	small_free_block* block = cache->heads[class_index];
+	cache->heads[class_index] = block->next;
+	cache->counts[class_index]--;
+	return block;
+}
+
+static void small_free(u8 class_index, void* block) {
+	thread_cache* cache = thread_cache_get();
+	small_free_block* free_block = block;
+	free_block->next = cache->heads[class_index];
+	cache->heads[class_index] = free_block;
+	cache->counts[class_index]++;
+
+	if (cache->counts[class_index] > KMEMORY_CACHE_MAX_BLOCKS) {
+		// Too many held by this thread, give a batch back so other threads can use it.
+		if (!kmutex_lock(&state_ptr->allocation_mutex)) {
+			KFATAL("Unable to obtain mutex lock for free operation. Heap corruption is likely.");
+			return;
+		}
+		thread_cache_release(cache, class_index, KMEMORY_CACHE_BATCH_SIZE);
+		kmutex_unlock(&state_ptr->allocation_mutex);
+	}
+}
+#endif
+
+// NOTE: Statistics are updated atomically rather than under the allocation mutex, since cached allocations never take it.
+static void stats_record_allocation(u64 size, memory_tag tag) {
+	katomic_fetch_add_u64(&state_ptr->stats.total_allocated, size);
+	katomic_fetch_add_u64(&state_ptr->stats.tagged_allocations[tag], size);
+	katomic_fetch_add_u64(&state_ptr->stats.new_tagged_allocations[tag], size);
+	katomic_fetch_add_u64(&state_ptr->alloc_count, 1);
+}
+
+static void stats_record_free(u64 size, memory_tag tag) {
+	katomic_fetch_sub_u64(&state_ptr->stats.total_allocated, size);
+	katomic_fetch_sub_u64(&state_ptr->stats.tagged_allocations[tag], size);
+	katomic_fetch_add_u64(&state_ptr->stats.new_tagged_deallocations[tag], size);
+	katomic_fetch_sub_u64(&state_ptr->alloc_count, 1);
+}
+
 b8 memory_system_initialize(memory_system_configuration config) {
 #if K_USE_CUSTOM_MEMORY_ALLOCATOR
 	// The amount needed by the system state.
@@ -134,6 +275,9 @@ b8 memory_system_initialize(memory_system_configuration config) {
 		return false;
 	}
 
+	memory_system_generation++;
+	state_ptr->generation = memory_system_generation;
+
 	f32 amount = 0;
 	const char* unit = get_unit_for_size(config.total_alloc_size, &amount);
 
@@ -174,24 +318,31 @@ void* _kallocate_aligned(u64 size, u16 alignment, memory_tag tag, const char* fi
 	// really happen.
 	void* block = 0;
 	if (state_ptr) {
-		// Make sure multithreaded requests don't trample each other.
-		if (!kmutex_lock(&state_ptr->allocation_mutex)) {
-			KFATAL("Error obtaining mutex lock during allocation.");
-			return 0;
-		}
-
-		// Track aligned alloc offset as part of size.
-		state_ptr->stats.total_allocated += aligned_size;
-		state_ptr->stats.tagged_allocations[tag] += aligned_size;
-		state_ptr->stats.new_tagged_allocations[tag] += aligned_size;
-		state_ptr->alloc_count++;
-
 #if K_USE_CUSTOM_MEMORY_ALLOCATOR
-		block = dynamic_allocator_allocate_aligned(&state_ptr->allocator, size, alignment, (u8)tag, file, line);
+		if (is_small_request(aligned_size, alignment)) {
+			// Served from this thread's cache. Tracked as the full size of its class, since that is what it occupies.
+			u8 class_index = small_class_get(aligned_size);
+			stats_record_allocation(small_class_sizes[class_index], tag);
+			block = small_allocate(class_index, tag, file, line);
+		} else {
+#endif
+			// Track aligned alloc offset as part of size.
+			stats_record_allocation(aligned_size, tag);
+
+			// Make sure multithreaded requests don't trample each other.
+			if (!kmutex_lock(&state_ptr->allocation_mutex)) {
+				KFATAL("Error obtaining mutex lock during allocation.");
+				return 0;
+			}
+#if K_USE_CUSTOM_MEMORY_ALLOCATOR
+			block = dynamic_allocator_allocate_aligned(&state_ptr->allocator, size, alignment, (u8)tag, file, line);
 #else
-		block = kaligned_alloc(size, alignment);
+			block = kaligned_alloc(size, alignment);
+#endif
+			kmutex_unlock(&state_ptr->allocation_mutex);
+#if K_USE_CUSTOM_MEMORY_ALLOCATOR
+		}
 #endif
-		kmutex_unlock(&state_ptr->allocation_mutex);
 	} else {
 		// If the system is not up yet, warn about it but give memory for now.
 		// printf("Warning: kallocate_aligned called before the memory system is initialized.");
@@ -209,16 +360,7 @@ void* _kallocate_aligned(u64 size, u16 alignment, memory_tag tag, const char* fi
 }
 
 void kallocate_report(u64 size, memory_tag tag) {
-	// Make sure multithreaded requests don't trample each other.
-	if (!kmutex_lock(&state_ptr->allocation_mutex)) {
-		KFATAL("Error obtaining mutex lock during allocation reporting.");
-		return;
-	}
-	state_ptr->stats.total_allocated += size;
-	state_ptr->stats.tagged_allocations[tag] += size;
-	state_ptr->stats.new_tagged_allocations[tag] += size;
-	state_ptr->alloc_count++;
-	kmutex_unlock(&state_ptr->allocation_mutex);
+	stats_record_allocation(size, tag);
 }
 
 void* _kreallocate(void* block, u64 old_size, u64 new_size, memory_tag tag, const char* filename, u32 line) {
@@ -256,19 +398,35 @@ void kfree_aligned(void* block, u64 size, u16 alignment, memory_tag tag) {
 		KWARN("kfree_aligned called using MEMORY_TAG_UNKNOWN. Re-class this allocation.");
 	}
 	if (state_ptr) {
+		/* size = get_aligned(size, alignment); */
+
+#if K_USE_CUSTOM_MEMORY_ALLOCATOR
+		// NOTE: The header of a block is only ever touched by its owner, so this does not need the lock.
+		u64 osize = 0;
+		u16 oalignment = 0;
+		u8 otag;
+		b8 owned = dynamic_allocator_get_size_alignment(&state_ptr->allocator, block, &osize, &oalignment, &otag);
+		if (owned && is_small_request(osize, oalignment) && oalignment == KMEMORY_SMALL_ALIGNMENT) {
+			// A block from a thread cache. The header describes its class, and its tag is that of whoever
+			// first allocated it, so only check that the requested size would have landed in the same class.
+			u64 aligned_size = get_aligned(size, alignment);
+			if (!is_small_request(aligned_size, alignment) || small_class_sizes[small_class_get(aligned_size)] != osize) {
+				printf("Free size mismatch! (original class=%llu, requested=%llu, alignment=%hu)\n", osize, size, alignment);
+				printf("Block first allocated at %s:%u\n", dynamic_allocator_get_file(&state_ptr->allocator, block), dynamic_allocator_get_line(&state_ptr->allocator, block));
+			}
+			stats_record_free(osize, tag);
+			small_free(small_class_get(osize), block);
+			return;
+		}
+#endif
+
 		// Make sure multithreaded requests don't trample each other.
 		if (!kmutex_lock(&state_ptr->allocation_mutex)) {
 			KFATAL("Unable to obtain mutex lock for free operation. Heap corruption is likely.");
 			return;
 		}
 
-		/* size = get_aligned(size, alignment); */
-
 #if K_USE_CUSTOM_MEMORY_ALLOCATOR
-		u64 osize = 0;
-		u16 oalignment = 0;
-		u8 otag;
-		dynamic_allocator_get_size_alignment(&state_ptr->allocator, block, &osize, &oalignment, &otag);
 		b8 print_debug = false;
 		if (osize != size) {
 			printf("Free size mismatch! (original=%llu, requested=%llu)\n", osize, size);
@@ -288,11 +446,7 @@ void kfree_aligned(void* block, u64 size, u16 alignment, memory_tag tag) {
 		}
 #endif
 		u64 aligned_size = get_aligned(size, alignment);
-
-		state_ptr->stats.total_allocated -= aligned_size;
-		state_ptr->stats.tagged_allocations[tag] -= aligned_size;
-		state_ptr->stats.new_tagged_deallocations[tag] += aligned_size;
-		state_ptr->alloc_count--;
+		stats_record_free(aligned_size, tag);
 #if K_USE_CUSTOM_MEMORY_ALLOCATOR
 		b8 result = dynamic_allocator_free_aligned(&state_ptr->allocator, block, tag);
 #else
@@ -317,16 +471,7 @@ void kfree_aligned(void* block, u64 size, u16 alignment, memory_tag tag) {
 }
 
 void kfree_report(u64 size, memory_tag tag) {
-	// Make sure multithreaded requests don't trample each other.
-	if (!kmutex_lock(&state_ptr->allocation_mutex)) {
-		KFATAL("Error obtaining mutex lock during allocation reporting.");
-		return;
-	}
-	state_ptr->stats.total_allocated -= size;
-	state_ptr->stats.tagged_allocations[tag] -= size;
-	state_ptr->stats.new_tagged_deallocations[tag] += size;
-	state_ptr->alloc_count--;
-	kmutex_unlock(&state_ptr->allocation_mutex);
+	stats_record_free(size, tag);
 }
 
 b8 kmemory_get_size_alignment(void* block, u64* out_size, u16* out_alignment, memory_tag* out_tag) {
@@ -345,6 +490,23 @@ b8 kmemory_get_size_alignment(void* block, u64* out_size, u16* out_alignment, me
 	return result;
 }
 
+void kmemory_thread_cache_flush(void) {
+#if K_USE_CUSTOM_MEMORY_ALLOCATOR
+	if (!state_ptr) {
+		return;
+	}
+	thread_cache* cache = thread_cache_get();
+	if (!kmutex_lock(&state_ptr->allocation_mutex)) {
+		KFATAL("Unable to obtain mutex lock for thread cache flush. Heap corruption is likely.");
+		return;
+	}
+	for (u8 i = 0; i < KMEMORY_SMALL_CLASS_COUNT; ++i) {
+		thread_cache_release(cache, i, cache->counts[i]);
+	}
+	kmutex_unlock(&state_ptr->allocation_mutex);
+#endif
+}
+
 void* kzero_memory(void* block, u64 size) {
 	return platform_zero_memory(block, size);
 }
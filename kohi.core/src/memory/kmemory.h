@@ -270,6 +270,13 @@ KAPI void kfree_report(u64 size, memory_tag tag);
  */
 KAPI b8 kmemory_get_size_alignment(void* block, u64* out_size, u16* out_alignment, memory_tag* out_tag);
 
+/**
+ * @brief Returns all blocks held in the calling thread's small allocation cache back
+ * to the memory system. Should be called by threads which exit before the memory system
+ * is shut down, as anything left in their cache is otherwise unavailable until then.
+ */
+KAPI void kmemory_thread_cache_flush(void);
+
 /**
  * @brief Zeroes out the provided memory block.
  * @param block A pointer to the block of memory to be zeroed out.
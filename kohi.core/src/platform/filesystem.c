@@ -176,11 +176,13 @@ const void* filesystem_read_entire_binary_file(const char* filepath, u64* out_si
 
 	// File size
 	if (!filesystem_size(&f, out_size)) {
+		filesystem_close(&f);
 		return 0;
 	}
 	char* buf = kallocate(*out_size, MEMORY_TAG_ARRAY);
 	fread(buf, 1, *out_size, (FILE*)f.handle);
 
+	filesystem_close(&f);
 	return buf;
 }
 
@@ -22,6 +22,6 @@
 #	define KCOMPILETIME_AVX2 1
 #endif
 
-#if defined(__NEON__)
+#if defined(__NEON__) || defined(__ARM_NEON)
 #	define KCOMPILETIME_NEON 1
 #endif
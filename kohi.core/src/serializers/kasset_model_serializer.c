@@ -5,11 +5,21 @@
 #include "debug/kassert.h"
 #include "defines.h"
 #include "logger.h"
+#include "math/kmath.h"
 #include "math/math_types.h"
 #include "memory/kmemory.h"
+#include "platform/kfeatures_compile.h"
 #include "strings/kname.h"
 #include "strings/kstring.h"
 
+#if KCOMPILETIME_SSE2
+#	include <emmintrin.h>
+#	include <xmmintrin.h>
+#endif
+
+// Animations carry a key encoding from this version on. Earlier versions only hold full precision keys.
+#define K3D_VERSION_KEY_ENCODINGS 2
+
 typedef enum k3d_mesh_type {
 	K3D_MESH_TYPE_STATIC = 0,  // maps to vertex_3d
 	K3D_MESH_TYPE_SKINNED = 1, // maps to skinned_vertex_3d
@@ -86,8 +96,35 @@ typedef struct k3d_animations {
 	f32* durations;
 	f32* ticks_per_seconds;
 	u16* channel_counts;
+	// Cast to kasset_model_key_encoding. Only present from K3D_VERSION_KEY_ENCODINGS on.
+	u8* key_encodings;
 } k3d_animations;
 
+// The range a quantized stream covers. A value of q decodes to min + (q * step).
+typedef struct k3d_quantized_range {
+	f32 min;
+	f32 step;
+} k3d_quantized_range;
+
+// A quantized track is a header, followed by one stream of 16-bit values per component (time first), each
+// holding one value per key. Keeping components in separate streams lets several keys be decoded at once.
+typedef struct k3d_quantized_vec3_header {
+	k3d_quantized_range time;
+	k3d_quantized_range values[3];
+} k3d_quantized_vec3_header;
+
+// Rotation streams hold the smallest three components of each (unit) quaternion in their low 15 bits.
+// The top bits of the first two streams hold the index of the largest component, which is rebuilt from
+// the others as it is always made positive. Component ranges are fixed, so only time needs a range.
+typedef struct k3d_quantized_quat_header {
+	k3d_quantized_range time;
+} k3d_quantized_quat_header;
+
+// The smallest three components of a unit quaternion each lie within +/- sqrt(1/2).
+#define K3D_QUAT_COMPONENT_MAX 32767
+#define K3D_QUAT_COMPONENT_MASK 0x7FFF
+static const k3d_quantized_range k3d_quat_component_range = {-K_SQRT_ONE_OVER_TWO, (2.0f * K_SQRT_ONE_OVER_TWO) / K3D_QUAT_COMPONENT_MAX};
+
 typedef struct k3d_animation_channels {
 	u16* animation_ids;
 	u16* name_ids;
@@ -104,6 +141,12 @@ static u64 write_binary(void* block, const void* source, u64 offset, u64 size);
 static u64 write_binary_u32(void* block, u32 value, u64 offset);
 static u64 write_binary_u16(void* block, u16 value, u64 offset);
 static u64 write_binary_array(void* block, const void* source, u64 offset, u64 element_size, u32 count);
+static u32 track_size_vec3(kasset_model_key_encoding encoding, u32 count);
+static u32 track_size_quat(kasset_model_key_encoding encoding, u32 count);
+static void track_encode_vec3(const kasset_model_key_vec3* keys, u32 count, u8* out_data);
+static void track_encode_quat(const kasset_model_key_quat* keys, u32 count, u8* out_data);
+static void track_decode_vec3(const u8* data, u32 count, kasset_model_key_vec3* out_keys);
+static void track_decode_quat(const u8* data, u32 count, kasset_model_key_quat* out_keys);
 
 static u32 read_guard(const void* in_block, u64* offset) {
 	u32 guard = *(u32*)(((u8*)in_block) + *offset);
@@ -240,6 +283,11 @@ KAPI b8 kasset_model_deserialize(u64 size, const void* in_block, kasset_model* o
 		animations.channel_counts = (u16*)(((u8*)in_block) + offset);
 		offset += (header->animation_count * sizeof(u16));
 
+		if (header->version >= K3D_VERSION_KEY_ENCODINGS) {
+			animations.key_encodings = (u8*)(((u8*)in_block) + offset);
+			offset += (header->animation_count * sizeof(u8));
+		}
+
 		// Read the next guard
 		guard = read_guard(in_block, &offset);
 
@@ -274,9 +322,10 @@ KAPI b8 kasset_model_deserialize(u64 size, const void* in_block, kasset_model* o
 
 			u64 data_buffer_size = 0;
 			for (u32 i = 0; i < animations.total_channel_count; ++i) {
-				data_buffer_size += (sizeof(kasset_model_key_vec3) * channels.pos_counts[i]);
-				data_buffer_size += (sizeof(kasset_model_key_quat) * channels.rot_counts[i]);
-				data_buffer_size += (sizeof(kasset_model_key_vec3) * channels.scale_counts[i]);
+				kasset_model_key_encoding encoding = animations.key_encodings ? animations.key_encodings[channels.animation_ids[i]] : KASSET_MODEL_KEY_ENCODING_FULL;
+				data_buffer_size += track_size_vec3(encoding, channels.pos_counts[i]);
+				data_buffer_size += track_size_quat(encoding, channels.rot_counts[i]);
+				data_buffer_size += track_size_vec3(encoding, channels.scale_counts[i]);
 			}
 			channels.data_buffer = (f32*)(((u8*)in_block) + offset);
 			offset += data_buffer_size;
@@ -422,6 +471,8 @@ KAPI b8 kasset_model_deserialize(u64 size, const void* in_block, kasset_model* o
 			anim->channel_count = animations.channel_counts[i];
 			anim->duration = animations.durations[i];
 			anim->ticks_per_second = animations.ticks_per_seconds[i];
+			anim->key_encoding = animations.key_encodings ? (kasset_model_key_encoding)animations.key_encodings[i] : KASSET_MODEL_KEY_ENCODING_FULL;
+			b8 quantized = anim->key_encoding == KASSET_MODEL_KEY_ENCODING_QUANTIZED;
 
 			anim->channels = KALLOC_TYPE_CARRAY(kasset_model_channel, anim->channel_count);
 
@@ -440,22 +491,34 @@ KAPI b8 kasset_model_deserialize(u64 size, const void* in_block, kasset_model* o
 					channel->pos_count = channels.pos_counts[c];
 					if (channel->pos_count) {
 						channel->positions = KALLOC_TYPE_CARRAY(kasset_model_key_vec3, channel->pos_count);
-						u64 size = sizeof(kasset_model_key_vec3) * channel->pos_count;
-						kcopy_memory(channel->positions, ((u8*)channels.data_buffer) + channels.pos_offsets[c], size);
+						const u8* data = ((u8*)channels.data_buffer) + channels.pos_offsets[c];
+						if (quantized) {
+							track_decode_vec3(data, channel->pos_count, channel->positions);
+						} else {
+							kcopy_memory(channel->positions, data, sizeof(kasset_model_key_vec3) * channel->pos_count);
+						}
 					}
 
 					channel->rot_count = channels.rot_counts[c];
 					if (channel->rot_count) {
 						channel->rotations = KALLOC_TYPE_CARRAY(kasset_model_key_quat, channel->rot_count);
-						u64 size = sizeof(kasset_model_key_quat) * channel->rot_count;
-						kcopy_memory(channel->rotations, ((u8*)channels.data_buffer) + channels.rot_offsets[c], size);
+						const u8* data = ((u8*)channels.data_buffer) + channels.rot_offsets[c];
+						if (quantized) {
+							track_decode_quat(data, channel->rot_count, channel->rotations);
+						} else {
+							kcopy_memory(channel->rotations, data, sizeof(kasset_model_key_quat) * channel->rot_count);
+						}
 					}
 
 					channel->scale_count = channels.scale_counts[c];
 					if (channel->scale_count) {
 						channel->scales = KALLOC_TYPE_CARRAY(kasset_model_key_vec3, channel->scale_count);
-						u64 size = sizeof(kasset_model_key_vec3) * channel->scale_count;
-						kcopy_memory(channel->scales, ((u8*)channels.data_buffer) + channels.scale_offsets[c], size);
+						const u8* data = ((u8*)channels.data_buffer) + channels.scale_offsets[c];
+						if (quantized) {
+							track_decode_vec3(data, channel->scale_count, channel->scales);
+						} else {
+							kcopy_memory(channel->scales, data, sizeof(kasset_model_key_vec3) * channel->scale_count);
+						}
 					}
 
 					cid++;
@@ -642,6 +705,7 @@ KAPI void* kasset_model_serialize(const kasset_model* asset, u32 exporter_type,
 			.ticks_per_seconds = KALLOC_TYPE_CARRAY(f32, header.animation_count),
 			.durations = KALLOC_TYPE_CARRAY(f32, header.animation_count),
 			.channel_counts = KALLOC_TYPE_CARRAY(u16, header.animation_count),
+			.key_encodings = KALLOC_TYPE_CARRAY(u8, header.animation_count),
 			.total_channel_count = 0};
 		for (u16 i = 0; i < header.animation_count; ++i) {
 			animations.total_channel_count += asset->animations[i].channel_count;
@@ -649,6 +713,7 @@ KAPI void* kasset_model_serialize(const kasset_model* asset, u32 exporter_type,
 			animations.channel_counts[i] = asset->animations[i].channel_count;
 			animations.durations[i] = asset->animations[i].duration;
 			animations.ticks_per_seconds[i] = asset->animations[i].ticks_per_second;
+			animations.key_encodings[i] = (u8)asset->animations[i].key_encoding;
 
 			const char* name = kname_string_get(asset->animations[i].name);
 			animations.name_ids[i] = name ? binary_string_table_add(&string_table, name) : INVALID_ID_U16;
@@ -658,6 +723,7 @@ KAPI void* kasset_model_serialize(const kasset_model* asset, u32 exporter_type,
 		total_block_size += (sizeof(f32) * header.animation_count);
 		total_block_size += (sizeof(f32) * header.animation_count);
 		total_block_size += (sizeof(u16) * header.animation_count);
+		total_block_size += (sizeof(u8) * header.animation_count);
 		total_block_size += sizeof(u16);
 
 		for (u16 i = 0; i < header.animation_count; ++i) {
@@ -665,9 +731,9 @@ KAPI void* kasset_model_serialize(const kasset_model* asset, u32 exporter_type,
 			for (u16 c = 0; c < animations.channel_counts[i]; c++) {
 				kasset_model_channel* channel = &anim->channels[c];
 
-				channel_buffer_size += (sizeof(kasset_model_key_vec3) * channel->pos_count);
-				channel_buffer_size += (sizeof(kasset_model_key_vec3) * channel->scale_count);
-				channel_buffer_size += (sizeof(kasset_model_key_quat) * channel->rot_count);
+				channel_buffer_size += track_size_vec3(anim->key_encoding, channel->pos_count);
+				channel_buffer_size += track_size_vec3(anim->key_encoding, channel->scale_count);
+				channel_buffer_size += track_size_quat(anim->key_encoding, channel->rot_count);
 			}
 		}
 
@@ -700,6 +766,7 @@ KAPI void* kasset_model_serialize(const kasset_model* asset, u32 exporter_type,
 			u32 channel_data_buffer_offset = 0;
 			for (u16 i = 0; i < header.animation_count; ++i) {
 				kasset_model_animation* anim = &asset->animations[i];
+				b8 quantized = anim->key_encoding == KASSET_MODEL_KEY_ENCODING_QUANTIZED;
 				for (u16 c = 0; c < animations.channel_counts[i]; c++) {
 					kasset_model_channel* channel = &anim->channels[c];
 
@@ -713,20 +780,33 @@ KAPI void* kasset_model_serialize(const kasset_model* asset, u32 exporter_type,
 					channels.scale_counts[channel_id] = channel->scale_count;
 
 					// NOTE: write position, rotation, then scale per channel
-					u32 pos_size = sizeof(kasset_model_key_vec3) * channel->pos_count;
-					u32 rot_size = sizeof(kasset_model_key_quat) * channel->rot_count;
-					u32 scale_size = sizeof(kasset_model_key_vec3) * channel->scale_count;
+					u32 pos_size = track_size_vec3(anim->key_encoding, channel->pos_count);
+					u32 rot_size = track_size_quat(anim->key_encoding, channel->rot_count);
+					u32 scale_size = track_size_vec3(anim->key_encoding, channel->scale_count);
+					u8* data = (u8*)channels.data_buffer;
 
 					channels.pos_offsets[channel_id] = channel_data_buffer_offset;
-					kcopy_memory(((u8*)channels.data_buffer) + channel_data_buffer_offset, channel->positions, pos_size);
+					if (quantized) {
+						track_encode_vec3(channel->positions, channel->pos_count, data + channel_data_buffer_offset);
+					} else {
+						kcopy_memory(data + channel_data_buffer_offset, channel->positions, pos_size);
+					}
 					channel_data_buffer_offset += pos_size;
 
 					channels.rot_offsets[channel_id] = channel_data_buffer_offset;
-					kcopy_memory(((u8*)channels.data_buffer) + channel_data_buffer_offset, channel->rotations, rot_size);
+					if (quantized) {
+						track_encode_quat(channel->rotations, channel->rot_count, data + channel_data_buffer_offset);
+					} else {
+						kcopy_memory(data + channel_data_buffer_offset, channel->rotations, rot_size);
+					}
 					channel_data_buffer_offset += rot_size;
 
 					channels.scale_offsets[channel_id] = channel_data_buffer_offset;
-					kcopy_memory(((u8*)channels.data_buffer) + channel_data_buffer_offset, channel->scales, scale_size);
+					if (quantized) {
+						track_encode_vec3(channel->scales, channel->scale_count, data + channel_data_buffer_offset);
+					} else {
+						kcopy_memory(data + channel_data_buffer_offset, channel->scales, scale_size);
+					}
 					channel_data_buffer_offset += scale_size;
 
 					channel_id++;
@@ -799,6 +879,7 @@ KAPI void* kasset_model_serialize(const kasset_model* asset, u32 exporter_type,
 		offset = write_binary_array(block, animations.durations, offset, sizeof(f32), header.animation_count);
 		offset = write_binary_array(block, animations.ticks_per_seconds, offset, sizeof(f32), header.animation_count);
 		offset = write_binary_array(block, animations.channel_counts, offset, sizeof(u16), header.animation_count);
+		offset = write_binary_array(block, animations.key_encodings, offset, sizeof(u8), header.animation_count);
 
 		if (animations.total_channel_count) {
 			KDEBUG("->Animation channels guard offset=%llu", offset);
@@ -832,8 +913,12 @@ KAPI void* kasset_model_serialize(const kasset_model* asset, u32 exporter_type,
 	KFREE_TYPE_CARRAY(submeshes.mesh_types, u8, header.submesh_count);
 	KFREE_TYPE_CARRAY(submeshes.centers, vec3, header.submesh_count);
 	KFREE_TYPE_CARRAY(submeshes.extents, extents_3d, header.submesh_count);
-	kfree(submeshes.vertex_data_buffer, total_submesh_vertex_buffer_size, MEMORY_TAG_BINARY_DATA);
-	kfree(submeshes.index_data_buffer, total_submesh_index_buffer_size, MEMORY_TAG_BINARY_DATA);
+	if (submeshes.vertex_data_buffer) {
+		kfree(submeshes.vertex_data_buffer, total_submesh_vertex_buffer_size, MEMORY_TAG_BINARY_DATA);
+	}
+	if (submeshes.index_data_buffer) {
+		kfree(submeshes.index_data_buffer, total_submesh_index_buffer_size, MEMORY_TAG_BINARY_DATA);
+	}
 
 	// cleanup bones
 	KFREE_TYPE_CARRAY(bones.name_ids, u16, header.bone_count);
@@ -849,6 +934,7 @@ KAPI void* kasset_model_serialize(const kasset_model* asset, u32 exporter_type,
 	KFREE_TYPE_CARRAY(animations.durations, f32, header.animation_count);
 	KFREE_TYPE_CARRAY(animations.ticks_per_seconds, f32, header.animation_count);
 	KFREE_TYPE_CARRAY(animations.channel_counts, u16, header.animation_count);
+	KFREE_TYPE_CARRAY(animations.key_encodings, u8, header.animation_count);
 
 	// cleanup animation channels
 	KFREE_TYPE_CARRAY(channels.animation_ids, u16, animations.total_channel_count);
@@ -886,3 +972,187 @@ static u64 write_binary_u16(void* block, u16 value, u64 offset) {
 static u64 write_binary_array(void* block, const void* source, u64 offset, u64 element_size, u32 count) {
 	return write_binary(block, source, offset, element_size * count);
 }
+
+static u32 track_size_vec3(kasset_model_key_encoding encoding, u32 count) {
+	if (encoding == KASSET_MODEL_KEY_ENCODING_QUANTIZED) {
+		return count ? sizeof(k3d_quantized_vec3_header) + (sizeof(u16) * 4 * count) : 0;
+	}
+	return sizeof(kasset_model_key_vec3) * count;
+}
+
+static u32 track_size_quat(kasset_model_key_encoding encoding, u32 count) {
+	if (encoding == KASSET_MODEL_KEY_ENCODING_QUANTIZED) {
+		return count ? sizeof(k3d_quantized_quat_header) + (sizeof(u16) * 4 * count) : 0;
+	}
+	return sizeof(kasset_model_key_quat) * count;
+}
+
+// Obtains the range covering count values, each stride floats apart.
+static k3d_quantized_range quantized_range_get(const f32* values, u32 stride, u32 count) {
+	f32 min = values[0];
+	f32 max = values[0];
+	for (u32 i = 1; i < count; ++i) {
+		min = KMIN(min, values[i * stride]);
+		max = KMAX(max, values[i * stride]);
+	}
+	return (k3d_quantized_range){min, (max - min) / U16_MAX};
+}
+
+static u16 quantize(f32 value, k3d_quantized_range range, u32 max) {
+	if (range.step <= 0.0f) {
+		return 0;
+	}
+	f32 q = kfloor(((value - range.min) / range.step) + 0.5f);
+	return (u16)KCLAMP(q, 0.0f, (f32)max);
+}
+
+static void track_encode_vec3(const kasset_model_key_vec3* keys, u32 count, u8* out_data) {
+	if (!count) {
+		return;
+	}
+	u32 stride = sizeof(kasset_model_key_vec3) / sizeof(f32);
+	k3d_quantized_vec3_header header = {.time = quantized_range_get(&keys[0].time, stride, count)};
+	for (u32 e = 0; e < 3; ++e) {
+		header.values[e] = quantized_range_get(&keys[0].value.elements[e], stride, count);
+	}
+	kcopy_memory(out_data, &header, sizeof(header));
+
+	u16* streams = (u16*)(out_data + sizeof(header));
+	for (u32 i = 0; i < count; ++i) {
+		streams[i] = quantize(keys[i].time, header.time, U16_MAX);
+		for (u32 e = 0; e < 3; ++e) {
+			streams[((e + 1) * count) + i] = quantize(keys[i].value.elements[e], header.values[e], U16_MAX);
+		}
+	}
+}
+
+static void track_encode_quat(const kasset_model_key_quat* keys, u32 count, u8* out_data) {
+	if (!count) {
+		return;
+	}
+	k3d_quantized_quat_header header = {.time = quantized_range_get(&keys[0].time, sizeof(kasset_model_key_quat) / sizeof(f32), count)};
+	kcopy_memory(out_data, &header, sizeof(header));
+
+	u16* streams = (u16*)(out_data + sizeof(header));
+	for (u32 i = 0; i < count; ++i) {
+		streams[i] = quantize(keys[i].time, header.time, U16_MAX);
+
+		quat q = quat_normalize(keys[i].value);
+		f32 components[4] = {q.x, q.y, q.z, q.w};
+		u32 largest = 0;
+		for (u32 e = 1; e < 4; ++e) {
+			if (kabs(components[e]) > kabs(components[largest])) {
+				largest = e;
+			}
+		}
+		// q and -q are the same rotation, so flip the sign if needed to keep the dropped component positive.
+		f32 sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+		for (u32 e = 0, s = 0; e < 4; ++e) {
+			if (e != largest) {
+				streams[((s + 1) * count) + i] = quantize(components[e] * sign, k3d_quat_component_range, K3D_QUAT_COMPONENT_MAX);
+				s++;
+			}
+		}
+		streams[count + i] |= (u16)((largest & 1) << 15);
+		streams[(2 * count) + i] |= (u16)((largest >> 1) << 15);
+	}
+}
+
+#if KCOMPILETIME_SSE2
+// Decodes 4 consecutive values of a quantized stream.
+static KINLINE __m128 dequantize4_sse(const u16* stream, u32 mask, k3d_quantized_range range) {
+	__m128i q = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)stream), _mm_setzero_si128());
+	q = _mm_and_si128(q, _mm_set1_epi32((i32)mask));
+	return _mm_add_ps(_mm_set1_ps(range.min), _mm_mul_ps(_mm_cvtepi32_ps(q), _mm_set1_ps(range.step)));
+}
+#endif
+
+static KINLINE f32 dequantize(u16 q, u32 mask, k3d_quantized_range range) {
+	return range.min + ((f32)(q & mask) * range.step);
+}
+
+static void track_decode_vec3(const u8* data, u32 count, kasset_model_key_vec3* out_keys) {
+	k3d_quantized_vec3_header header;
+	kcopy_memory(&header, data, sizeof(header));
+	const u16* times = (const u16*)(data + sizeof(header));
+	const u16* xs = times + count;
+	const u16* ys = xs + count;
+	const u16* zs = ys + count;
+
+	u32 i = 0;
+#if KCOMPILETIME_SSE2
+	// Keys are laid out as x, y, z, time, so a transpose of 4 keys' worth of each stream writes 4 whole keys.
+	for (; i + 4 <= count; i += 4) {
+		__m128 x = dequantize4_sse(xs + i, U16_MAX, header.values[0]);
+		__m128 y = dequantize4_sse(ys + i, U16_MAX, header.values[1]);
+		__m128 z = dequantize4_sse(zs + i, U16_MAX, header.values[2]);
+		__m128 t = dequantize4_sse(times + i, U16_MAX, header.time);
+		_MM_TRANSPOSE4_PS(x, y, z, t);
+		_mm_storeu_ps((f32*)&out_keys[i + 0], x);
+		_mm_storeu_ps((f32*)&out_keys[i + 1], y);
+		_mm_storeu_ps((f32*)&out_keys[i + 2], z);
+		_mm_storeu_ps((f32*)&out_keys[i + 3], t);
+	}
+#endif
+	for (; i < count; ++i) {
+		out_keys[i].value.x = dequantize(xs[i], U16_MAX, header.values[0]);
+		out_keys[i].value.y = dequantize(ys[i], U16_MAX, header.values[1]);
+		out_keys[i].value.z = dequantize(zs[i], U16_MAX, header.values[2]);
+		out_keys[i].time = dequantize(times[i], U16_MAX, header.time);
+	}
+}
+
+// For each index of the largest component, the source of each of x, y, z and w, where 0-2 are the
+// stored components in order and 3 is the rebuilt largest one.
+static const u8 smallest_three_order[4][4] = {
+	{3, 0, 1, 2},
+	{0, 3, 1, 2},
+	{0, 1, 3, 2},
+	{0, 1, 2, 3}};
+
+static void track_decode_quat(const u8* data, u32 count, kasset_model_key_quat* out_keys) {
+	k3d_quantized_quat_header header;
+	kcopy_memory(&header, data, sizeof(header));
+	const u16* times = (const u16*)(data + sizeof(header));
+	const u16* as = times + count;
+	const u16* bs = as + count;
+	const u16* cs = bs + count;
+
+	u32 i = 0;
+#if KCOMPILETIME_SSE2
+	for (; i + 4 <= count; i += 4) {
+		__m128 a = dequantize4_sse(as + i, K3D_QUAT_COMPONENT_MASK, k3d_quat_component_range);
+		__m128 b = dequantize4_sse(bs + i, K3D_QUAT_COMPONENT_MASK, k3d_quat_component_range);
+		__m128 c = dequantize4_sse(cs + i, K3D_QUAT_COMPONENT_MASK, k3d_quat_component_range);
+		__m128 t = dequantize4_sse(times + i, U16_MAX, header.time);
+		__m128 sum = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, a), _mm_mul_ps(b, b)), _mm_mul_ps(c, c));
+		__m128 largest = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(1.0f), sum), _mm_setzero_ps()));
+
+		f32 components[4][4];
+		f32 key_times[4];
+		_mm_storeu_ps(components[0], a);
+		_mm_storeu_ps(components[1], b);
+		_mm_storeu_ps(components[2], c);
+		_mm_storeu_ps(components[3], largest);
+		_mm_storeu_ps(key_times, t);
+		for (u32 k = 0; k < 4; ++k) {
+			const u8* order = smallest_three_order[(as[i + k] >> 15) | ((bs[i + k] >> 15) << 1)];
+			kasset_model_key_quat* key = &out_keys[i + k];
+			key->value = (quat){components[order[0]][k], components[order[1]][k], components[order[2]][k], components[order[3]][k]};
+			key->time = key_times[k];
+		}
+	}
+#endif
+	for (; i < count; ++i) {
+		f32 components[4];
+		components[0] = dequantize(as[i], K3D_QUAT_COMPONENT_MASK, k3d_quat_component_range);
+		components[1] = dequantize(bs[i], K3D_QUAT_COMPONENT_MASK, k3d_quat_component_range);
+		components[2] = dequantize(cs[i], K3D_QUAT_COMPONENT_MASK, k3d_quat_component_range);
+		f32 sum = (components[0] * components[0]) + (components[1] * components[1]) + (components[2] * components[2]);
+		components[3] = ksqrt(KMAX(1.0f - sum, 0.0f));
+
+		const u8* order = smallest_three_order[(as[i] >> 15) | ((bs[i] >> 15) << 1)];
+		out_keys[i].value = (quat){components[order[0]], components[order[1]], components[order[2]], components[order[3]]};
+		out_keys[i].time = dequantize(times[i], U16_MAX, header.time);
+	}
+}
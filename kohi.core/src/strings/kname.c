@@ -1,46 +1,51 @@
 #include "kname.h"
 
-#include "containers/u64_bst.h"
 #include "debug/kassert.h"
-#include "logger.h"
 #include "strings/kstring.h"
+#include "strings/kstring_intern.h"
 #include "utils/crc64.h"
 
 // Global lookup table for saved names.
-static bt_node* string_lookup = 0;
+static kstring_intern_table string_lookup = {0};
+
+// Hashes the lowercase form of str without needing a lowercase copy of it, by
+// converting a chunk at a time into a small stack buffer.
+static u64 hash_lowercase(const char* str, u64 length) {
+	char chunk[128];
+	u64 hash = 0;
+	for (u64 offset = 0; offset < length; offset += sizeof(chunk)) {
+		u64 chunk_length = KMIN(sizeof(chunk), length - offset);
+		for (u64 i = 0; i < chunk_length; ++i) {
+			char c = str[offset + i];
+			// NOTE: Must match string_to_lower(), or names would no longer hash the same.
+			chunk[i] = codepoint_is_upper(c) ? c + ('a' - 'A') : c;
+		}
+		hash = crc64(hash, (const u8*)chunk, chunk_length);
+	}
+	return hash;
+}
 
 kname kname_create(const char* str) {
-	if (!str || string_length(str) == 0) {
+	if (!str) {
+		return INVALID_KNAME;
+	}
+	u64 length = string_length(str);
+	if (length == 0) {
 		return INVALID_KNAME;
 	}
 
-	// Take a copy of the string to hash.
-	char* copy = string_duplicate(str);
-	// Convert it to lowercase _before_ hashing.
-	string_to_lower(copy);
-
-	// Hash the lowercase string.
-	kname name = crc64(0, (const u8*)copy, string_length(copy));
+	// Hash the string as lowercase.
+	kname name = hash_lowercase(str, length);
 	// NOTE: A hash of 0 is never allowed.
 	KASSERT_MSG(name != 0, string_format("kname_create - provided string '%s' hashed to 0, an invalid value. Please change the string to something else to avoid this.", str));
 
-	// Dispose of the lowercase string.
-	string_free(copy);
-
-	// Register in a global lookup table if not already there.
-	const bt_node* entry = u64_bst_find(string_lookup, name);
-	if (!entry) {
-		// Take a copy in case it was dynamically allocated and might
-		// later be freed. Storing a copy of the *original* string for reference,
-		// even though this is _not_ what is used for lookup.
-		bt_node_value value;
-		value.str = string_duplicate(str);
-		bt_node* inserted = u64_bst_insert(string_lookup, name, value);
-		if (!inserted) {
-			KERROR("Failed to save kname string '%s' to global lookup table.");
-		} else if (!string_lookup) {
-			string_lookup = inserted;
-		}
+	// Register in a global lookup table if not already there. Most names are created
+	// many times over, so check first, which takes a single lookup and no allocation.
+	if (!kstring_intern_table_get(&string_lookup, name)) {
+		// Save a copy in case it was dynamically allocated and might later be freed.
+		// Storing a copy of the *original* string for reference, even though this is
+		// _not_ what is used for lookup.
+		kstring_intern_table_insert(&string_lookup, name, str, length);
 	}
 	return name;
 }
@@ -50,16 +55,11 @@ const char* kname_string_get(kname name) {
 		return 0;
 	}
 
-	const bt_node* entry = u64_bst_find(string_lookup, name);
-	if (entry) {
-		// NOTE: For now, just return the existing pointer to the string.
-		// If this ever becomes a problem, return a copy instead.
-		return entry->value.str;
-	}
-
-	return 0;
+	// NOTE: For now, just return the existing pointer to the string.
+	// If this ever becomes a problem, return a copy instead.
+	return kstring_intern_table_get(&string_lookup, name);
 }
 
 void kname_shutdown(void) {
-	u64_bst_cleanup_with_strings(string_lookup);
+	kstring_intern_table_destroy(&string_lookup);
 }
@@ -1,51 +1,41 @@
 #include "kstring_id.h"
 
-#include "containers/u64_bst.h"
 #include "debug/kassert.h"
 #include "kstring.h"
 #include "logger.h"
+#include "strings/kstring_intern.h"
 #include "utils/crc64.h"
 
 // Global lookup table for saved strings.
-static bt_node* kstring_id_lookup = 0;
+static kstring_intern_table kstring_id_lookup = {0};
 
 kstring_id kstring_id_create(const char* str) {
-	if (!str || string_length(str) == 0) {
+	u64 length = str ? string_length(str) : 0;
+	if (length == 0) {
 		KERROR("kstring_id_create requires a valid pointer to a string and the string must have a nonzero length.");
 		return INVALID_KSTRING_ID;
 	}
 
 	// Hash the string.
-	kstring_id new_string_id = crc64(0, (const u8*)str, string_length(str));
+	kstring_id new_string_id = crc64(0, (const u8*)str, length);
 	// NOTE: A hash of 0 is never allowed.
 	KASSERT_MSG(new_string_id != 0, string_format("kstring_id_create - provided string '%s' hashed to 0, an invalid value. Please change the string to something else to avoid this.", str));
 
 	// Register in a global lookup table if not already there.
-	const bt_node* entry = u64_bst_find(kstring_id_lookup, new_string_id);
-	if (!entry) {
-		bt_node_value value;
-		value.str = string_duplicate(str);
-		bt_node* inserted = u64_bst_insert(kstring_id_lookup, new_string_id, value);
-		if (!inserted) {
-			KERROR("Failed to save kstring_id string '%s' to global lookup table.");
-		} else if (!kstring_id_lookup) {
-			kstring_id_lookup = inserted;
+	if (!kstring_intern_table_get(&kstring_id_lookup, new_string_id)) {
+		if (!kstring_intern_table_insert(&kstring_id_lookup, new_string_id, str, length)) {
+			KERROR("Failed to save kstring_id string '%s' to global lookup table.", str);
 		}
 	}
 	return new_string_id;
 }
 
 const char* kstring_id_string_get(kstring_id stringid) {
-	const bt_node* entry = u64_bst_find(kstring_id_lookup, stringid);
-	if (entry) {
-		// NOTE: For now, just return the existing pointer to the string.
-		// If this ever becomes a problem, return a copy instead.
-		return entry->value.str;
-	}
-
-	return 0;
+	// NOTE: For now, just return the existing pointer to the string.
+	// If this ever becomes a problem, return a copy instead.
+	return kstring_intern_table_get(&kstring_id_lookup, stringid);
 }
 
 void kstring_id_shutdown(void) {
-	u64_bst_cleanup_with_strings(kstring_id_lookup);
+	kstring_intern_table_destroy(&kstring_id_lookup);
 }
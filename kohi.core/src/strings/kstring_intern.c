@@ -0,0 +1,103 @@
+#include "kstring_intern.h"
+
+#include "logger.h"
+#include "memory/kmemory.h"
+#include "threads/katomic.h"
+
+// Size of each block in the string pool. Strings too large to share a block get one of their own.
+#define KSTRING_INTERN_BLOCK_SIZE KIBIBYTES(64)
+// Room made in the lookup when first used, to avoid early regrowth for typical name counts.
+#define KSTRING_INTERN_INITIAL_CAPACITY 1024
+
+struct kstring_intern_block {
+	// The previously created block.
+	kstring_intern_block* next;
+	// The size of this block, including this header.
+	u64 size;
+	// The number of bytes used, including this header.
+	u64 used;
+};
+
+static void table_lock(kstring_intern_table* table) {
+	u32 expected = 0;
+	while (!katomic_compare_exchange_u32(&table->lock, &expected, 1)) {
+		expected = 0;
+		katomic_pause();
+	}
+}
+
+static void table_unlock(kstring_intern_table* table) {
+	katomic_store_u32(&table->lock, 0);
+}
+
+static char* pool_allocate(kstring_intern_table* table, u64 size) {
+	kstring_intern_block* block = table->head;
+	if (!block || block->used + size > block->size) {
+		u64 block_size = KMAX(KSTRING_INTERN_BLOCK_SIZE, sizeof(kstring_intern_block) + size);
+		kstring_intern_block* new_block = kallocate(block_size, MEMORY_TAG_STRING);
+		new_block->size = block_size;
+		new_block->used = sizeof(kstring_intern_block);
+		if (block && block_size > KSTRING_INTERN_BLOCK_SIZE) {
+			// A dedicated block for one large string. Keep writing to the current block afterward.
+			new_block->next = block->next;
+			block->next = new_block;
+		} else {
+			new_block->next = block;
+			table->head = new_block;
+		}
+		block = new_block;
+	}
+
+	char* memory = (char*)block + block->used;
+	block->used += size;
+	return memory;
+}
+
+const char* kstring_intern_table_get(kstring_intern_table* table, u64 hash) {
+	const char* str = 0;
+	table_lock(table);
+	if (table->lookup.controls) {
+		hashmap_u64_get(&table->lookup, hash, (void*)&str);
+	}
+	table_unlock(table);
+	return str;
+}
+
+const char* kstring_intern_table_insert(kstring_intern_table* table, u64 hash, const char* str, u64 length) {
+	const char* interned = 0;
+	table_lock(table);
+
+	if (!table->lookup.controls) {
+		if (!hashmap_create(sizeof(const char*), KSTRING_INTERN_INITIAL_CAPACITY, &table->lookup)) {
+			KERROR("kstring_intern_table_insert failed to create lookup.");
+			table_unlock(table);
+			return 0;
+		}
+	}
+
+	if (!hashmap_u64_get(&table->lookup, hash, (void*)&interned)) {
+		char* copy = pool_allocate(table, length + 1);
+		kcopy_memory(copy, str, length);
+		copy[length] = 0;
+		interned = copy;
+		hashmap_u64_set(&table->lookup, hash, (void*)&interned);
+	}
+
+	table_unlock(table);
+	return interned;
+}
+
+void kstring_intern_table_destroy(kstring_intern_table* table) {
+	table_lock(table);
+
+	kstring_intern_block* block = table->head;
+	while (block) {
+		kstring_intern_block* next = block->next;
+		kfree(block, block->size, MEMORY_TAG_STRING);
+		block = next;
+	}
+	table->head = 0;
+	hashmap_destroy(&table->lookup);
+
+	table_unlock(table);
+}
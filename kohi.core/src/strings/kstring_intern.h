@@ -0,0 +1,62 @@
+/**
+ * @file kstring_intern.h
+ * @brief This file contains a thread-safe table of interned strings, keyed by hash.
+ *
+ * @details
+ * Used to back knames and kstring_ids. Each string is copied once into a string pool
+ * made of large blocks, rather than being allocated individually, and is then found
+ * again by its hash with a single open-addressed lookup. Strings are never removed
+ * individually; the whole table is released at once on destruction.
+ *
+ * A zeroed table is ready for use, so tables may be declared statically and used
+ * before any systems are initialized.
+ */
+
+#pragma once
+
+#include "containers/hashmap.h"
+#include "defines.h"
+
+typedef struct kstring_intern_block kstring_intern_block;
+
+/**
+ * @brief A table of interned strings. Members of this structure should not be
+ * modified outside the functions associated with it.
+ */
+typedef struct kstring_intern_table {
+	/** @brief Guards all other members. Held only briefly, so it is simply spun on. */
+	volatile u32 lock;
+	/** @brief Maps string hashes to pointers to strings within the pool. */
+	hashmap lookup;
+	/** @brief The most recently created block of the string pool, which is written to next. */
+	kstring_intern_block* head;
+} kstring_intern_table;
+
+/**
+ * @brief Obtains the interned string with the given hash.
+ *
+ * @param table A pointer to the table to search.
+ * @param hash The hash of the string.
+ * @returns A pointer to the interned string if found; otherwise 0. Remains valid until the table is destroyed. Do *NOT* free this string!
+ */
+KAPI const char* kstring_intern_table_get(kstring_intern_table* table, u64 hash);
+
+/**
+ * @brief Interns a copy of the given string under the given hash, unless a string
+ * with that hash is already held, in which case the existing string is kept.
+ *
+ * @param table A pointer to the table to intern into.
+ * @param hash The hash of the string.
+ * @param str The string to be copied in.
+ * @param length The length of the string in bytes, not including the null terminator.
+ * @returns A pointer to the interned string. Remains valid until the table is destroyed. Do *NOT* free this string!
+ */
+KAPI const char* kstring_intern_table_insert(kstring_intern_table* table, u64 hash, const char* str, u64 length);
+
+/**
+ * @brief Destroys the given table, releasing all interned strings. The table may
+ * be used again afterward, starting out empty.
+ *
+ * @param table A pointer to the table to destroy.
+ */
+KAPI void kstring_intern_table_destroy(kstring_intern_table* table);
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * Atomic operations on plain integers and pointers, used for lock-free
+ * synchronization between threads. These map directly onto compiler
+ * intrinsics, which are supported by clang on all platforms.
+ *
+ * Loads use acquire semantics, stores use release semantics and all
+ * read-modify-write operations are sequentially consistent unless
+ * otherwise noted.
+ */
+
+/**
+ * @brief Atomically loads the value at the given address.
+ * @param ptr A pointer to the value to load.
+ * @returns The loaded value.
+ */
+KINLINE u32 katomic_load_u32(const volatile u32* ptr) {
+	return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Atomically stores the given value at the given address.
+ * @param ptr A pointer to the value to be stored to.
+ * @param value The value to store.
+ */
+KINLINE void katomic_store_u32(volatile u32* ptr, u32 value) {
+	__atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Atomically adds to the value at the given address.
+ * @param ptr A pointer to the value to be modified.
+ * @param value The amount to add.
+ * @returns The value held before the addition.
+ */
+KINLINE u32 katomic_fetch_add_u32(volatile u32* ptr, u32 value) {
+	return __atomic_fetch_add(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Atomically subtracts from the value at the given address.
+ * @param ptr A pointer to the value to be modified.
+ * @param value The amount to subtract.
+ * @returns The value held before the subtraction.
+ */
+KINLINE u32 katomic_fetch_sub_u32(volatile u32* ptr, u32 value) {
+	return __atomic_fetch_sub(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Atomically replaces the value at the given address with desired, but only
+ * if it currently matches expected.
+ * @param ptr A pointer to the value to be modified.
+ * @param expected A pointer to the expected value. On failure, this is updated to the current value.
+ * @param desired The value to be stored on success.
+ * @returns True if the exchange took place; otherwise false.
+ */
+KINLINE b8 katomic_compare_exchange_u32(volatile u32* ptr, u32* expected, u32 desired) {
+	return __atomic_compare_exchange_n(ptr, expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Atomically loads the value at the given address.
+ * @param ptr A pointer to the value to load.
+ * @returns The loaded value.
+ */
+KINLINE u64 katomic_load_u64(const volatile u64* ptr) {
+	return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Atomically stores the given value at the given address.
+ * @param ptr A pointer to the value to be stored to.
+ * @param value The value to store.
+ */
+KINLINE void katomic_store_u64(volatile u64* ptr, u64 value) {
+	__atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Atomically adds to the value at the given address.
+ * @param ptr A pointer to the value to be modified.
+ * @param value The amount to add.
+ * @returns The value held before the addition.
+ */
+KINLINE u64 katomic_fetch_add_u64(volatile u64* ptr, u64 value) {
+	return __atomic_fetch_add(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Atomically subtracts from the value at the given address.
+ * @param ptr A pointer to the value to be modified.
+ * @param value The amount to subtract.
+ * @returns The value held before the subtraction.
+ */
+KINLINE u64 katomic_fetch_sub_u64(volatile u64* ptr, u64 value) {
+	return __atomic_fetch_sub(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Atomically replaces the value at the given address with desired, but only
+ * if it currently matches expected.
+ * @param ptr A pointer to the value to be modified.
+ * @param expected A pointer to the expected value. On failure, this is updated to the current value.
+ * @param desired The value to be stored on success.
+ * @returns True if the exchange took place; otherwise false.
+ */
+KINLINE b8 katomic_compare_exchange_u64(volatile u64* ptr, u64* expected, u64 desired) {
+	return __atomic_compare_exchange_n(ptr, expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Atomically loads the pointer at the given address.
+ * @param ptr A pointer to the pointer to load.
+ * @returns The loaded pointer.
+ */
+KINLINE void* katomic_load_ptr(void* const volatile* ptr) {
+	return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Atomically stores the given pointer at the given address.
+ * @param ptr A pointer to the pointer to be stored to.
+ * @param value The pointer to store.
+ */
+KINLINE void katomic_store_ptr(void* volatile* ptr, void* value) {
+	__atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Atomically replaces the pointer at the given address with desired, but only
+ * if it currently matches expected.
+ * @param ptr A pointer to the pointer to be modified.
+ * @param expected A pointer to the expected pointer. On failure, this is updated to the current value.
+ * @param desired The pointer to be stored on success.
+ * @returns True if the exchange took place; otherwise false.
+ */
+KINLINE b8 katomic_compare_exchange_ptr(void* volatile* ptr, void** expected, void* desired) {
+	return __atomic_compare_exchange_n(ptr, expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Hints to the processor that the calling thread is in a spin-wait loop.
+ */
+KINLINE void katomic_pause(void) {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+	__asm__ __volatile__("yield");
+#endif
+}
@@ -83,6 +83,8 @@ typedef struct krhi_vulkan {
 	RHI_VULKAN_DECL(vkCreateFence);
 	RHI_VULKAN_DECL(vkDestroyFence);
 	RHI_VULKAN_DECL(vkWaitForFences);
+	RHI_VULKAN_DECL(vkGetFenceStatus);
+	RHI_VULKAN_DECL(vkGetSemaphoreCounterValue);
 	RHI_VULKAN_DECL(vkAcquireNextImageKHR);
 	RHI_VULKAN_DECL(vkResetFences);
 	RHI_VULKAN_DECL(vkCreateDescriptorSetLayout);
@@ -91,6 +93,9 @@ typedef struct krhi_vulkan {
 	RHI_VULKAN_DECL(vkDestroyDescriptorPool);
 	RHI_VULKAN_DECL(vkCreateShaderModule);
 	RHI_VULKAN_DECL(vkDestroyShaderModule);
+	RHI_VULKAN_DECL(vkCreatePipelineCache);
+	RHI_VULKAN_DECL(vkDestroyPipelineCache);
+	RHI_VULKAN_DECL(vkGetPipelineCacheData);
 	RHI_VULKAN_DECL(vkCreateSampler);
 	RHI_VULKAN_DECL(vkDestroySampler);
 	RHI_VULKAN_DECL(vkCreateBuffer);
@@ -138,6 +143,7 @@ typedef struct krhi_vulkan {
 	RHI_VULKAN_DECL(vkCmdBindIndexBuffer);
 	RHI_VULKAN_DECL(vkCmdDraw);
 	RHI_VULKAN_DECL(vkCmdDrawIndexed);
+	RHI_VULKAN_DECL(vkCmdDrawIndexedIndirect);
 	RHI_VULKAN_DECL(vkCmdBindDescriptorSets);
 
 	RHI_VULKAN_DECL(vkQueueSubmit);
@@ -32,6 +32,8 @@
 #include "vulkan_device.h"
 #include "vulkan_image.h"
 #include "vulkan_loader.h"
+#include "vulkan_shader_cache.h"
+#include "vulkan_staging.h"
 #include "vulkan_swapchain.h"
 #include "vulkan_types.h"
 #include "vulkan_utils.h"
@@ -46,6 +48,11 @@
 #	define KVULKAN_USE_CUSTOM_ALLOCATOR 1
 #endif
 
+// The size of each window's staging ring.
+#define VULKAN_STAGING_RING_SIZE MEBIBYTES(64)
+// The minimum alignment of staging allocations, which covers the texel block size of all supported formats.
+#define VULKAN_STAGING_ALIGNMENT 16
+
 VKAPI_ATTR VkBool32 VKAPI_CALL vk_debug_callback(
 	VkDebugUtilsMessageSeverityFlagBitsEXT message_severity,
 	VkDebugUtilsMessageTypeFlagsEXT message_types,
@@ -57,9 +64,14 @@ static b8 vulkan_buffer_copy_range_internal(vulkan_context* context,
 											VkBuffer source, u64 source_offset,
 											VkBuffer dest, u64 dest_offset,
 											u64 size, b8 queue_wait);
+static b8 buffer_draw_bound(renderer_backend_interface* backend, krenderbuffer handle, u32 element_count, u32 instance_count, u32 first_instance);
 static vulkan_command_buffer* get_current_command_buffer(vulkan_context* context);
 static u32 get_current_image_index(vulkan_context* context);
 static u32 get_current_frame_index(vulkan_context* context);
+// Returns the current window's staging ring, or 0 if there is no window.
+static vulkan_staging_ring* get_staging_ring(vulkan_context* context);
+// Returns the fence signalled once the current frame's workload completes.
+static VkFence get_current_frame_fence(vulkan_context* context);
 
 // Returns the current image count. Typically 2 for double-buffering, 3 for triple.
 // Should NOT be used when determining resource size. See VULKAN_RESOURCE_IMAGE_COUNT.
@@ -321,6 +333,19 @@ b8 vulkan_renderer_backend_initialize(renderer_backend_interface* backend, const
 		return false;
 	}
 
+	// Uploads on the transfer queue are tracked with a timeline semaphore. Without one, they are performed right away.
+	context->uploads.batches = darray_create(vulkan_upload_batch);
+	if ((context->device.support_flags & VULKAN_DEVICE_SUPPORT_FLAG_TIMELINE_SEMAPHORE_BIT) && rhi->kvkGetSemaphoreCounterValue) {
+		VkSemaphoreTypeCreateInfo semaphore_type_info = {VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO};
+		semaphore_type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		semaphore_type_info.initialValue = 0;
+		VkSemaphoreCreateInfo semaphore_create_info = {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+		semaphore_create_info.pNext = &semaphore_type_info;
+		VK_CHECK(rhi->kvkCreateSemaphore(context->device.logical_device, &semaphore_create_info, context->allocator, &context->uploads.timeline));
+	} else {
+		KINFO("Timeline semaphores are not supported. Uploads will be performed on the graphics queue.");
+	}
+
 	// Textures array. Matches array size in texture system.
 	context->max_texture_count = config->max_texture_count;
 	context->textures = KALLOC_TYPE_CARRAY(vulkan_texture_handle_data, config->max_texture_count);
@@ -334,6 +359,12 @@ b8 vulkan_renderer_backend_initialize(renderer_backend_interface* backend, const
 	// Create a shader compiler to be used.
 	context->shader_compiler = shaderc_compiler_initialize();
 
+	// Load previously compiled shader stages and pipelines, so unchanged ones aren't compiled again.
+	if (!vulkan_shader_cache_create(context)) {
+		KERROR("Failed to create shader cache.");
+		return false;
+	}
+
 	KINFO("Renderer config requests %s-buffering to be used.", config->use_triple_buffering ? "triple" : "double");
 	context->triple_buffering_enabled = config->use_triple_buffering;
 
@@ -360,6 +391,23 @@ void vulkan_renderer_backend_shutdown(renderer_backend_interface* backend) {
 		context->shader_compiler = 0;
 	}
 
+	// Save and destroy the shader cache. Requires the device.
+	vulkan_shader_cache_destroy(context);
+
+	// Destroy the upload queue. Batches hold nothing on the GPU beyond the timeline itself.
+	if (context->uploads.batches) {
+		u32 batch_count = darray_length(context->uploads.batches);
+		for (u32 i = 0; i < batch_count; ++i) {
+			darray_destroy(context->uploads.batches[i].targets);
+		}
+		darray_destroy(context->uploads.batches);
+		context->uploads.batches = KNULL;
+	}
+	if (context->uploads.timeline) {
+		rhi->kvkDestroySemaphore(context->device.logical_device, context->uploads.timeline, context->allocator);
+		context->uploads.timeline = 0;
+	}
+
 	KDEBUG("Destroying Vulkan device...");
 	vulkan_device_destroy(context);
 
@@ -458,11 +506,6 @@ b8 vulkan_renderer_on_window_created(renderer_backend_interface* backend, kwindo
 		window_backend->frame_texture_updated_list = KALLOC_TYPE_CARRAY(ktexture*, window_backend->max_frames_in_flight);
 		window_backend->graphics_command_buffers = KALLOC_TYPE_CARRAY(vulkan_command_buffer, window_backend->max_frames_in_flight);
 
-		// The staging buffer also goes here since it is tied to the frame.
-		// TODO: Reduce this to a single buffer split by max_frames_in_flight.
-		const u64 staging_buffer_size = MEBIBYTES(768); // FIXME: This is huge. Need to queue updates per frame in flight to shrink this down.
-		window_backend->staging = kallocate(sizeof(krenderbuffer) * window_backend->max_frames_in_flight, MEMORY_TAG_ARRAY);
-
 		for (u8 i = 0; i < window_backend->swapchain.image_count; ++i) {
 			VkSemaphoreCreateInfo semaphore_create_info = {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
 			VK_CHECK(rhi->kvkCreateSemaphore(context->device.logical_device, &semaphore_create_info, context->allocator, &window_backend->submit_semaphores[i]));
@@ -482,16 +525,6 @@ b8 vulkan_renderer_on_window_created(renderer_backend_interface* backend, kwindo
 
 			VK_SET_DEBUG_OBJECT_NAME_INDEXED(context, VK_OBJECT_TYPE_FENCE, window_backend->in_flight_fences[i], "in_flight_fences_", i);
 
-			// Staging buffer.
-			// TODO: Reduce this to a single buffer split by max_frames_in_flight.
-			char* buf_name = string_format("window_staging_%u", i);
-			window_backend->staging[i] = renderer_renderbuffer_create(backend->frontend_state, kname_create(buf_name), RENDERBUFFER_TYPE_STAGING, staging_buffer_size, RENDERBUFFER_TRACK_TYPE_LINEAR, RENDERBUFFER_FLAG_NONE);
-			string_free(buf_name);
-			if (window_backend->staging[i] == KRENDERBUFFER_INVALID) {
-				KERROR("Failed to create staging buffer.");
-				return false;
-			}
-
 			// Create the per-frame list of updated texture handles.
 			window_backend->frame_texture_updated_list[i] = darray_create(ktexture);
 
@@ -511,6 +544,15 @@ b8 vulkan_renderer_on_window_created(renderer_backend_interface* backend, kwindo
 
 			KDEBUG("Vulkan command buffers created.")
 		}
+
+		// The staging ring also goes here since its space is reclaimed as frames complete.
+		char* staging_name = string_format("%s_staging", window->name);
+		b8 staging_result = vulkan_staging_ring_create(backend, kname_create(staging_name), VULKAN_STAGING_RING_SIZE, &window_backend->staging);
+		string_free(staging_name);
+		if (!staging_result) {
+			KERROR("Failed to create staging ring.");
+			return false;
+		}
 	}
 
 	// If there is not yet a current window, assign it now.
@@ -541,10 +583,10 @@ void vulkan_renderer_on_window_destroyed(renderer_backend_interface* backend, kw
 
 	// Destroy per-frame-in-flight resources.
 	{
-		for (u32 i = 0; i < window_backend->max_frames_in_flight; ++i) {
-			// Destroy staging buffers
-			renderer_renderbuffer_destroy(backend->frontend_state, window_backend->staging[i]);
+		// Destroy the staging ring.
+		vulkan_staging_ring_destroy(backend, &window_backend->staging);
 
+		for (u32 i = 0; i < window_backend->max_frames_in_flight; ++i) {
 			// Sync objects
 			if (window_backend->acquire_semaphores[i]) {
 				rhi->kvkDestroySemaphore(context->device.logical_device, window_backend->acquire_semaphores[i], context->allocator);
@@ -567,9 +609,6 @@ void vulkan_renderer_on_window_destroyed(renderer_backend_interface* backend, kw
 		KFREE_TYPE_CARRAY(window_backend->in_flight_fences, VkFence, window_backend->max_frames_in_flight);
 		window_backend->in_flight_fences = KNULL;
 
-		KFREE_TYPE_CARRAY(window_backend->staging, krenderbuffer, window_backend->max_frames_in_flight);
-		window_backend->staging = KNULL;
-
 		KFREE_TYPE_CARRAY(window_backend->graphics_command_buffers, vulkan_command_buffer, window_backend->max_frames_in_flight);
 		window_backend->graphics_command_buffers = KNULL;
 
@@ -690,6 +729,10 @@ b8 vulkan_renderer_frame_prepare_window_surface(renderer_backend_interface* back
 		return false;
 	}
 
+	// Reclaim staging space used by completed frames and uploads. This must happen before
+	// the fence is reset below, or this frame's previous use of it would look incomplete.
+	vulkan_staging_ring_reclaim(backend, &window_backend->staging);
+
 	// Increment texture generations in list of handles updated within frame workload.
 	ktexture* updated_textures = context->current_window->renderer_state->backend_state->frame_texture_updated_list[window_backend->current_frame];
 	u32 updated_texture_count = 0;
@@ -730,12 +773,6 @@ b8 vulkan_renderer_frame_prepare_window_surface(renderer_backend_interface* back
 	// Reset the fence for use on the next frame
 	VK_CHECK(rhi->kvkResetFences(context->device.logical_device, 1, &window_backend->in_flight_fences[window_backend->current_frame]));
 
-	// Reset staging buffer.
-	if (!renderer_renderbuffer_clear(backend->frontend_state, window_backend->staging[window_backend->current_frame], false)) {
-		KERROR("Failed to clear staging buffer.");
-		return false;
-	}
-
 	return true;
 }
 
@@ -1000,6 +1037,8 @@ b8 vulkan_renderer_frame_submit(struct renderer_backend_interface* backend, stru
 		1,
 		// Wait semaphore ensures that the operation cannot begin until the image is available.
 		&window_backend->acquire_semaphores[window_backend->current_frame],
+		0,
+		0,
 		window_backend->in_flight_fences[window_backend->current_frame]);
 
 	if (!result) {
@@ -2016,6 +2055,37 @@ b8 vulkan_renderer_texture_resize(renderer_backend_interface* backend, ktexture
 	return true;
 }
 
+// Obtains staging memory for an upload outside of the frame workload. This is taken from the
+// ring if the upload fits, waiting on earlier uploads if it is full. Otherwise, a buffer is
+// created just for this upload, which must be handed to vulkan_staging_upload_submit.
+static u8* staging_acquire(renderer_backend_interface* backend, vulkan_staging_ring* ring, u64 size, u64 alignment, VkBuffer* out_handle, u64* out_offset, krenderbuffer* out_dedicated_buffer) {
+	vulkan_context* context = (vulkan_context*)backend->internal_context;
+
+	*out_dedicated_buffer = KRENDERBUFFER_INVALID;
+	*out_offset = 0;
+
+	if (ring && size <= ring->capacity) {
+		VkFence frame_fence = get_current_frame_fence(context);
+		u8* memory = vulkan_staging_ring_allocate(backend, ring, size, alignment, out_offset);
+		while (!memory && vulkan_staging_ring_wait_oldest(backend, ring, frame_fence)) {
+			memory = vulkan_staging_ring_allocate(backend, ring, size, alignment, out_offset);
+		}
+		if (memory) {
+			*out_handle = context->renderbuffers[ring->buffer].infos[0].handle;
+			return memory;
+		}
+	}
+
+	krenderbuffer dedicated_buffer = renderer_renderbuffer_create(backend->frontend_state, kname_create("temp_staging"), RENDERBUFFER_TYPE_STAGING, size, RENDERBUFFER_TRACK_TYPE_NONE, RENDERBUFFER_FLAG_AUTO_MAP_MEMORY_BIT);
+	if (dedicated_buffer == KRENDERBUFFER_INVALID) {
+		KERROR("Failed to create dedicated staging buffer.");
+		return 0;
+	}
+	*out_dedicated_buffer = dedicated_buffer;
+	*out_handle = context->renderbuffers[dedicated_buffer].infos[0].handle;
+	return context->renderbuffers[dedicated_buffer].infos[0].mapped_memory;
+}
+
 b8 vulkan_renderer_texture_write_data(renderer_backend_interface* backend, ktexture t, u32 offset, u32 size, const u8* pixels, b8 include_in_frame_workload) {
 
 	KASSERT_DEBUG_MSG(t != INVALID_KTEXTURE, "Invalid texture handle passed.");
@@ -2028,76 +2098,52 @@ b8 vulkan_renderer_texture_write_data(renderer_backend_interface* backend, ktext
 		include_in_frame_workload = false;
 	}
 
-	// Temporary command buffer, if needed.
-	vulkan_command_buffer temp_command_buffer;
+	vulkan_staging_ring* ring = get_staging_ring(context);
+	u64 alignment = KMAX(VULKAN_STAGING_ALIGNMENT, context->device.properties.limits.optimalBufferCopyOffsetAlignment);
 
-	// A pointer to the staging buffer to be used.
-	krenderbuffer staging = KRENDERBUFFER_INVALID;
-	// A pointer to the command buffer to be used.
-	vulkan_command_buffer* command_buffer = 0;
-	if (include_in_frame_workload) {
-		// Including in the frame workload means the current window's current-frame staging buffer can be used.
-		u32 current_frame = context->current_window->renderer_state->backend_state->current_frame;
-		staging = context->current_window->renderer_state->backend_state->staging[current_frame];
-		command_buffer = get_current_command_buffer(context);
-	} else {
-		// Not including in the frame workload means a temporary staging buffer needs to be created and bound.
-		// This buffer is the exact size required for the operation, so no allocation is needed later.
-		staging = renderer_renderbuffer_create(backend->frontend_state, kname_create("temp_staging"), RENDERBUFFER_TYPE_STAGING, size * texture->image_count, RENDERBUFFER_TRACK_TYPE_NONE, RENDERBUFFER_FLAG_NONE);
-	}
 	for (u32 i = 0; i < texture->image_count; ++i) {
 		vulkan_image* image = &texture->images[i];
 
-		// Staging buffer.
+		// Uploads are always recorded to a single-use command buffer, which is submitted
+		// without waiting. Staging space is reclaimed once that submission completes.
+		// HACK: Recording into the frame's command buffer breaks things...
+		vulkan_command_buffer command_buffer;
+		vulkan_staging_upload_begin(context, context->device.graphics_command_pool, &command_buffer);
+
 		u64 staging_offset = 0;
-		if (include_in_frame_workload) {
-			// If including in frame workload, space needs to be allocated from the buffer.
-			renderer_renderbuffer_allocate(backend->frontend_state, staging, size, &staging_offset);
+		VkBuffer staging_handle = 0;
+		krenderbuffer dedicated_buffer = KRENDERBUFFER_INVALID;
+		u8* staging_memory = staging_acquire(backend, ring, size, alignment, &staging_handle, &staging_offset, &dedicated_buffer);
+		if (!staging_memory) {
+			KERROR("Failed to obtain staging memory for texture upload.");
+			vulkan_command_buffer_end(context, &command_buffer);
+			vulkan_command_buffer_free(context, context->device.graphics_command_pool, &command_buffer);
+			return false;
 		}
-
-		// Results in a wait if not included in frame workload.
-		vulkan_buffer_load_range(backend, staging, staging_offset, size, pixels, include_in_frame_workload);
-
-		// Need a temp command buffer if not included in frame workload.
-		// HACK: Not doing this breaks things...
-		// if (!include_in_frame_workload) {
-		vulkan_command_buffer_allocate_and_begin_single_use(
-			context,
-			context->device.graphics_command_pool,
-			&temp_command_buffer);
-		command_buffer = &temp_command_buffer;
-		// }
+		kcopy_memory(staging_memory, pixels, size);
 
 		// Transition the layout from whatever it is currently to optimal for recieving data.
-		vulkan_image_transition_layout(context, command_buffer, image, image->format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+		vulkan_image_transition_layout(context, &command_buffer, image, image->format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
 
 		// Copy the data from the buffer.
-		vulkan_image_copy_from_buffer(context, image, context->renderbuffers[staging].infos[0].handle, staging_offset, command_buffer);
+		vulkan_image_copy_from_buffer(context, image, staging_handle, staging_offset, &command_buffer);
 
-		if (image->mip_levels <= 1 || !vulkan_image_mipmaps_generate(context, image, command_buffer)) {
+		if (image->mip_levels <= 1 || !vulkan_image_mipmaps_generate(context, image, &command_buffer)) {
 			// If mip generation isn't needed or fails, fall back to ordinary transition.
 			// Transition from optimal for data reciept to shader-read-only optimal layout.
-			vulkan_image_transition_layout(context, command_buffer, image, image->format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+			vulkan_image_transition_layout(context, &command_buffer, image, image->format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 		}
 
-		// Need to submit temp command buffer.
-		// HACK: Not doing this breaks things...
-		// if (!include_in_frame_workload) {
-		vulkan_command_buffer_end_single_use(
-			context,
-			context->device.graphics_command_pool,
-			command_buffer,
-			context->device.graphics_queue);
-		command_buffer = 0;
-		// }
+		if (!vulkan_staging_upload_submit(backend, ring, &command_buffer, dedicated_buffer)) {
+			KERROR("Failed to submit texture upload.");
+			return false;
+		}
 	}
 
 	if (!include_in_frame_workload) {
-		renderer_renderbuffer_destroy(backend->frontend_state, staging);
-
-		// Counts as a texture update. The texture generation here can only really be updated if
-		// we _don't_ include the upload in the frame workload, since that results in a wait.
-		// If we include it in the frame workload, then we must also wait until that frame's queue is complete.
+		// Counts as a texture update. The upload is submitted ahead of any work which could use
+		// the texture, so the generation can be updated right away. If it is included in the
+		// frame workload, then it must wait until that frame's queue is complete.
 		texture->generation++;
 		// Roll over when at max u16.
 		if (texture->generation == INVALID_ID_U16) {
@@ -3299,69 +3345,92 @@ static b8 create_shader_module(vulkan_context* context, vulkan_shader* internal_
 		return false;
 	}
 
-	KDEBUG("Compiling stage '%s' for shader '%s'...", shader_stage_to_string(stage), kname_string_get(internal_shader->name));
+	u64 source_length = string_length(source);
+	u64 cache_key = vulkan_shader_cache_key(stage, source, source_length);
 
-	// KTRACE("Shader source:\n%s", source);
+	// Use the previously compiled code if the source is unchanged.
+	u32 cached_code_size = 0;
+	const u32* cached_code = vulkan_shader_cache_spirv_get(context, cache_key, source_length, &cached_code_size);
+	if (cached_code) {
+		KDEBUG("Using cached stage '%s' for shader '%s'.", shader_stage_to_string(stage), kname_string_get(internal_shader->name));
 
-	// Attempt to compile the shader.
-	shaderc_compile_options_t options = shaderc_compile_options_initialize();
-	// shaderc_compile_options_set_target_env(options, shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_3);
-	shaderc_compile_options_set_target_env(options, shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_2);
-	u32 source_length = string_length(source);
-	shaderc_compilation_result_t compilation_result = shaderc_compile_into_spv(
-		context->shader_compiler,
-		source,
-		source_length,
-		shader_kind,
-		filename,
-		"main",
-		options);
+		kzero_memory(&out_stage->create_info, sizeof(VkShaderModuleCreateInfo));
+		out_stage->create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		out_stage->create_info.codeSize = cached_code_size;
+		out_stage->create_info.pCode = cached_code;
 
-	if (!compilation_result) {
-		KERROR("An unknown error occurred while trying to compile the shader. Unable to process futher.");
-		return false;
-	}
-	shaderc_compilation_status status = shaderc_result_get_compilation_status(compilation_result);
-	shaderc_compile_options_release(options);
+		VK_CHECK(rhi->kvkCreateShaderModule(context->device.logical_device, &out_stage->create_info, context->allocator, &out_stage->handle));
+	} else {
+		KDEBUG("Compiling stage '%s' for shader '%s'...", shader_stage_to_string(stage), kname_string_get(internal_shader->name));
+
+		// KTRACE("Shader source:\n%s", source);
+
+		// Attempt to compile the shader.
+		// NOTE: Changing compile options requires bumping the shader cache version.
+		shaderc_compile_options_t options = shaderc_compile_options_initialize();
+		// shaderc_compile_options_set_target_env(options, shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_3);
+		shaderc_compile_options_set_target_env(options, shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_2);
+		shaderc_compilation_result_t compilation_result = shaderc_compile_into_spv(
+			context->shader_compiler,
+			source,
+			source_length,
+			shader_kind,
+			filename,
+			"main",
+			options);
+
+		if (!compilation_result) {
+			KERROR("An unknown error occurred while trying to compile the shader. Unable to process futher.");
+			return false;
+		}
+		shaderc_compilation_status status = shaderc_result_get_compilation_status(compilation_result);
+		shaderc_compile_options_release(options);
+
+		// Handle errors, if any.
+		if (status != shaderc_compilation_status_success) {
+			const char* error_message = shaderc_result_get_error_message(compilation_result);
+			u64 error_count = shaderc_result_get_num_errors(compilation_result);
+			KERROR("Error compiling shader with %llu errors.", error_count);
+			KERROR("Error(s):\n%s", error_message);
+			shaderc_result_release(compilation_result);
+			return false;
+		}
 
-	// Handle errors, if any.
-	if (status != shaderc_compilation_status_success) {
-		const char* error_message = shaderc_result_get_error_message(compilation_result);
-		u64 error_count = shaderc_result_get_num_errors(compilation_result);
-		KERROR("Error compiling shader with %llu errors.", error_count);
-		KERROR("Error(s):\n%s", error_message);
-		shaderc_result_release(compilation_result);
-		return false;
-	}
+		KDEBUG("Shader compiled successfully.");
 
-	KDEBUG("Shader compiled successfully.");
+		// Output warnings if there are any.
+		u64 warning_count = shaderc_result_get_num_warnings(compilation_result);
+		if (warning_count) {
+			// NOTE: Not sure this it the correct way to obtain warnings.
+			KWARN("%llu warnings were generated during shader compilation:\n%s", warning_count, shaderc_result_get_error_message(compilation_result));
+		}
 
-	// Output warnings if there are any.
-	u64 warning_count = shaderc_result_get_num_warnings(compilation_result);
-	if (warning_count) {
-		// NOTE: Not sure this it the correct way to obtain warnings.
-		KWARN("%llu warnings were generated during shader compilation:\n%s", warning_count, shaderc_result_get_error_message(compilation_result));
-	}
+		// Extract the data from the result.
+		const char* bytes = shaderc_result_get_bytes(compilation_result);
+		size_t result_length = shaderc_result_get_length(compilation_result);
+		// Take a copy of the result data and cast it to a u32* as is required by Vulkan.
+		u32* code = kallocate(result_length, MEMORY_TAG_RENDERER);
+		kcopy_memory(code, bytes, result_length);
 
-	// Extract the data from the result.
-	const char* bytes = shaderc_result_get_bytes(compilation_result);
-	size_t result_length = shaderc_result_get_length(compilation_result);
-	// Take a copy of the result data and cast it to a u32* as is required by Vulkan.
-	u32* code = kallocate(result_length, MEMORY_TAG_RENDERER);
-	kcopy_memory(code, bytes, result_length);
+		// Release the compilation result.
+		shaderc_result_release(compilation_result);
 
-	// Release the compilation result.
-	shaderc_result_release(compilation_result);
+		kzero_memory(&out_stage->create_info, sizeof(VkShaderModuleCreateInfo));
+		out_stage->create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		out_stage->create_info.codeSize = result_length;
+		out_stage->create_info.pCode = code;
 
-	kzero_memory(&out_stage->create_info, sizeof(VkShaderModuleCreateInfo));
-	out_stage->create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	out_stage->create_info.codeSize = result_length;
-	out_stage->create_info.pCode = code;
+		VK_CHECK(rhi->kvkCreateShaderModule(context->device.logical_device, &out_stage->create_info, context->allocator, &out_stage->handle));
 
-	VK_CHECK(rhi->kvkCreateShaderModule(context->device.logical_device, &out_stage->create_info, context->allocator, &out_stage->handle));
+		// Keep the code for next time.
+		vulkan_shader_cache_spirv_add(context, cache_key, source_length, (u32)result_length, code);
 
-	// Release the copy of the code.
-	kfree(code, result_length, MEMORY_TAG_RENDERER);
+		// Release the copy of the code.
+		kfree(code, result_length, MEMORY_TAG_RENDERER);
+	}
+
+	// The code isn't needed past module creation.
+	out_stage->create_info.pCode = 0;
 
 	// Shader stage info
 	kzero_memory(&out_stage->shader_stage_create_info, sizeof(VkPipelineShaderStageCreateInfo));
@@ -3469,6 +3538,11 @@ b8 vulkan_renderbuffer_create(renderer_backend_interface* backend, kname name, u
 		internal_buffer->usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
 		internal_buffer->memory_property_flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 		break;
+	case RENDERBUFFER_TYPE_INDIRECT:
+		// NOTE: Kept host visible, both so commands can be written directly and so they can be read back when multi-draw-indirect is unsupported.
+		internal_buffer->usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		internal_buffer->memory_property_flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		break;
 	default:
 		KERROR("Unsupported buffer type: %i", type);
 		return false;
@@ -3658,6 +3732,9 @@ b8 vulkan_buffer_resize(renderer_backend_interface* backend, krenderbuffer handl
 		}
 	}
 
+	// Track the new size, so later resizes copy over everything.
+	internal_buffer->size = new_size;
+
 	return true;
 }
 
@@ -3816,6 +3893,47 @@ b8 vulkan_buffer_read(renderer_backend_interface* backend, krenderbuffer handle,
 	return true;
 }
 
+// Uploads data to a device-local buffer outside of the frame workload. Data is staged in chunks
+// well under the size of the ring, each submitted on its own, so that large uploads are spread
+// out and the next chunk can be staged while earlier ones are still being copied.
+static b8 buffer_upload(renderer_backend_interface* backend, vulkan_staging_ring* ring, VkBuffer dest, u64 dest_offset, u64 size, const void* data) {
+	vulkan_context* context = (vulkan_context*)backend->internal_context;
+	krhi_vulkan* rhi = &context->rhi;
+
+	u64 chunk_size = ring ? ring->capacity / 4 : size;
+	for (u64 uploaded = 0; uploaded < size;) {
+		u64 chunk = KMIN(chunk_size, size - uploaded);
+
+		u64 staging_offset = 0;
+		VkBuffer staging_handle = 0;
+		krenderbuffer dedicated_buffer = KRENDERBUFFER_INVALID;
+		u8* staging_memory = staging_acquire(backend, ring, chunk, VULKAN_STAGING_ALIGNMENT, &staging_handle, &staging_offset, &dedicated_buffer);
+		if (!staging_memory) {
+			KERROR("Failed to obtain staging memory for buffer upload.");
+			return false;
+		}
+		kcopy_memory(staging_memory, (const u8*)data + uploaded, chunk);
+
+		vulkan_command_buffer command_buffer;
+		vulkan_staging_upload_begin(context, context->device.graphics_command_pool, &command_buffer);
+
+		VkBufferCopy copy_region;
+		copy_region.srcOffset = staging_offset;
+		copy_region.dstOffset = dest_offset + uploaded;
+		copy_region.size = chunk;
+		rhi->kvkCmdCopyBuffer(command_buffer.handle, staging_handle, dest, 1, &copy_region);
+
+		if (!vulkan_staging_upload_submit(backend, ring, &command_buffer, dedicated_buffer)) {
+			KERROR("Failed to submit buffer upload.");
+			return false;
+		}
+
+		uploaded += chunk;
+	}
+
+	return true;
+}
+
 b8 vulkan_buffer_load_range(
 	renderer_backend_interface* backend,
 	krenderbuffer handle,
@@ -3836,17 +3954,24 @@ b8 vulkan_buffer_load_range(
 	if (vulkan_buffer_is_device_local(backend, internal_buffer) &&
 		!vulkan_buffer_is_host_visible(backend, internal_buffer)) {
 		// NOTE: If a staging buffer is needed (i.e.) the target buffer's memory is
-		// not host visible but is device-local, create a staging buffer to load the
-		// data into first. Then copy from it to the target buffer.
-
-		// Load the data into the staging buffer.
-		u64 staging_offset = 0;
-		krenderbuffer staging = context->current_window->renderer_state->backend_state->staging[get_current_frame_index(context)];
-		renderer_renderbuffer_allocate(backend->frontend_state, staging, size, &staging_offset);
-		vulkan_buffer_load_range(backend, staging, staging_offset, size, data, include_in_frame_workload);
+		// not host visible but is device-local, stage the data first. Then copy
+		// from there to the target buffer.
+		vulkan_staging_ring* ring = get_staging_ring(context);
+		VkBuffer dest = internal_buffer->infos[index].handle;
+
+		if (include_in_frame_workload && ring) {
+			// Copy as part of the frame, with the staging space held until the frame completes.
+			u64 staging_offset = 0;
+			u8* staging_memory = vulkan_staging_ring_allocate(backend, ring, size, VULKAN_STAGING_ALIGNMENT, &staging_offset);
+			if (staging_memory) {
+				kcopy_memory(staging_memory, data, size);
+				vulkan_staging_ring_retire(ring, get_current_frame_fence(context));
+				return vulkan_buffer_copy_range_internal(context, context->renderbuffers[ring->buffer].infos[0].handle, staging_offset, dest, offset, size, true);
+			}
+			// No room this frame, so upload it on its own instead.
+		}
 
-		// Perform the copy from staging to the device local buffer.
-		vulkan_buffer_copy_range(backend, staging, staging_offset, handle, offset, size, include_in_frame_workload);
+		return buffer_upload(backend, ring, dest, offset, size, data);
 	} else {
 		// If no staging buffer is needed, map/copy/unmap.
 		void* data_ptr;
@@ -3944,15 +4069,78 @@ b8 vulkan_buffer_draw(renderer_backend_interface* backend, krenderbuffer handle,
 		return true;
 	}
 
+	return buffer_draw_bound(backend, handle, element_count, 1, 0);
+}
+
+b8 vulkan_buffer_draw_instanced(renderer_backend_interface* backend, krenderbuffer handle, u64 offset, u32 element_count, u32 instance_count, u32 first_instance, u32 binding_index) {
+	if (!vulkan_buffer_bind(backend, handle, offset, binding_index)) {
+		KERROR("Failed to bind renderbuffer. See logs for details.");
+		return false;
+	}
+
+	return buffer_draw_bound(backend, handle, element_count, instance_count, first_instance);
+}
+
+// Indirect commands are written by the frontend and read directly by the device.
+STATIC_ASSERT(sizeof(renderer_indexed_indirect_command) == sizeof(VkDrawIndexedIndirectCommand), "renderer_indexed_indirect_command must match VkDrawIndexedIndirectCommand.");
+
+b8 vulkan_buffer_draw_indirect(renderer_backend_interface* backend, krenderbuffer handle, u64 offset, u32 draw_count) {
+	if (handle == KRENDERBUFFER_INVALID) {
+		KERROR("%s - requires valid handle to a buffer.", __FUNCTION__);
+		return false;
+	}
+
+	vulkan_context* context = (vulkan_context*)backend->internal_context;
+	krhi_vulkan* rhi = &context->rhi;
+	vulkan_command_buffer* command_buffer = get_current_command_buffer(context);
+	vulkan_buffer* internal_buffer = &context->renderbuffers[handle];
+
+	if (internal_buffer->type != RENDERBUFFER_TYPE_INDIRECT) {
+		KERROR("Cannot draw indirect from buffer of type: %i", internal_buffer->type);
+		return false;
+	}
+
+	u8 index = internal_buffer->handle_count == 1 ? 0 : get_current_image_index(context);
+	const u32 stride = sizeof(renderer_indexed_indirect_command);
+
+	if (context->device.support_flags & VULKAN_DEVICE_SUPPORT_FLAG_MULTI_DRAW_INDIRECT_BIT) {
+		// Split up anything over the device's limit.
+		u32 max_draw_count = KMAX(context->device.properties.limits.maxDrawIndirectCount, 1);
+		while (draw_count) {
+			u32 count = KMIN(draw_count, max_draw_count);
+			rhi->kvkCmdDrawIndexedIndirect(command_buffer->handle, internal_buffer->infos[index].handle, offset, count, stride);
+			offset += (u64)count * stride;
+			draw_count -= count;
+		}
+		return true;
+	}
+
+	// Without multi-draw-indirect, read the commands back and draw each directly.
+	const u8* mapped_memory = internal_buffer->infos[index].mapped_memory;
+	if (!mapped_memory) {
+		KERROR("%s - buffer memory must be mapped to draw without multi-draw-indirect support.", __FUNCTION__);
+		return false;
+	}
+	const renderer_indexed_indirect_command* commands = (const renderer_indexed_indirect_command*)(mapped_memory + offset);
+	for (u32 i = 0; i < draw_count; ++i) {
+		const renderer_indexed_indirect_command* c = &commands[i];
+		rhi->kvkCmdDrawIndexed(command_buffer->handle, c->index_count, c->instance_count, c->first_index, c->vertex_offset, c->first_instance);
+	}
+
+	return true;
+}
+
+// Records a draw of the given, already bound, buffer.
+static b8 buffer_draw_bound(renderer_backend_interface* backend, krenderbuffer handle, u32 element_count, u32 instance_count, u32 first_instance) {
 	vulkan_context* context = (vulkan_context*)backend->internal_context;
 	krhi_vulkan* rhi = &context->rhi;
 	vulkan_command_buffer* command_buffer = get_current_command_buffer(context);
 	vulkan_buffer* internal_buffer = &context->renderbuffers[handle];
 
 	if (internal_buffer->type == RENDERBUFFER_TYPE_VERTEX) {
-		rhi->kvkCmdDraw(command_buffer->handle, element_count, 1, 0, 0);
+		rhi->kvkCmdDraw(command_buffer->handle, element_count, instance_count, 0, first_instance);
 	} else if (internal_buffer->type == RENDERBUFFER_TYPE_INDEX) {
-		rhi->kvkCmdDrawIndexed(command_buffer->handle, element_count, 1, 0, 0, 0);
+		rhi->kvkCmdDrawIndexed(command_buffer->handle, element_count, instance_count, 0, 0, first_instance);
 	} else {
 		KERROR("Cannot draw buffer of type: %i", internal_buffer->type);
 		return false;
@@ -3961,6 +4149,317 @@ b8 vulkan_buffer_draw(renderer_backend_interface* backend, krenderbuffer handle,
 	return true;
 }
 
+// Begins recording a new batch of uploads to the transfer queue.
+static void upload_batch_begin(vulkan_context* context, vulkan_upload_batch* out_batch, vulkan_command_buffer* out_command_buffer) {
+	kzero_memory(out_batch, sizeof(vulkan_upload_batch));
+	out_batch->targets = darray_create(vulkan_upload_target);
+	vulkan_staging_upload_begin(context, context->device.transfer_command_pool, out_command_buffer);
+}
+
+// Releases everything written by the batch to the graphics queue, then submits it to signal the
+// next timeline value. Empty batches are submitted too, so that uploads always complete in order.
+static b8 upload_batch_submit(renderer_backend_interface* backend, vulkan_staging_ring* ring, vulkan_upload_batch* batch, vulkan_command_buffer* command_buffer, krenderbuffer dedicated_buffer) {
+	vulkan_context* context = (vulkan_context*)backend->internal_context;
+	krhi_vulkan* rhi = &context->rhi;
+	vulkan_upload_queue* queue = &context->uploads;
+
+	// Resources are not shared between queue families, so ownership must be released here and
+	// acquired on the graphics queue. See vulkan_renderer_uploads_acquire.
+	if (context->device.transfer_queue_index != context->device.graphics_queue_index) {
+		u32 target_count = darray_length(batch->targets);
+		for (u32 i = 0; i < target_count; ++i) {
+			vulkan_upload_target* target = &batch->targets[i];
+			if (target->texture != INVALID_KTEXTURE) {
+				VkImageMemoryBarrier barrier = target->image_barrier;
+				barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				barrier.dstAccessMask = 0;
+				rhi->kvkCmdPipelineBarrier(command_buffer->handle, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, 0, 0, 0, 1, &barrier);
+			} else {
+				VkBufferMemoryBarrier barrier = target->buffer_barrier;
+				barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				barrier.dstAccessMask = 0;
+				rhi->kvkCmdPipelineBarrier(command_buffer->handle, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, 0, 1, &barrier, 0, 0);
+			}
+		}
+	}
+
+	batch->timeline_value = queue->timeline_value + 1;
+	if (!vulkan_staging_upload_submit_queue(
+			backend, ring,
+			context->device.transfer_queue, context->device.transfer_command_pool,
+			command_buffer, dedicated_buffer,
+			queue->timeline, 0, batch->timeline_value)) {
+		KERROR("Failed to submit upload batch.");
+		darray_destroy(batch->targets);
+		batch->targets = KNULL;
+		return false;
+	}
+
+	queue->timeline_value = batch->timeline_value;
+	darray_push(queue->batches, *batch);
+	return true;
+}
+
+// Marks the uploads recorded into a batch which failed to submit as failed, as they will not complete.
+static void upload_batch_fail(u32 first, u32 end, b8* out_results) {
+	for (u32 i = first; i < end; ++i) {
+		out_results[i] = false;
+	}
+}
+
+b8 vulkan_renderer_uploads_submit(renderer_backend_interface* backend, u32 upload_count, const renderer_upload* uploads, b8* out_results) {
+	vulkan_context* context = (vulkan_context*)backend->internal_context;
+	krhi_vulkan* rhi = &context->rhi;
+	vulkan_upload_queue* queue = &context->uploads;
+
+	if (!queue->timeline) {
+		// Completion can't be tracked on another queue, so perform the uploads right away instead.
+		b8 result = true;
+		for (u32 i = 0; i < upload_count; ++i) {
+			const renderer_upload* upload = &uploads[i];
+			b8 written = upload->type == RENDERER_UPLOAD_TYPE_TEXTURE
+							 ? vulkan_renderer_texture_write_data(backend, upload->texture, (u32)upload->offset, (u32)upload->size, upload->data, false)
+							 : vulkan_buffer_load_range(backend, upload->buffer, upload->offset, upload->size, upload->data, false);
+			out_results[i] = written;
+			if (!written) {
+				KERROR("Failed to perform upload %llu.", upload->id);
+				result = false;
+			}
+			queue->completed_upload_id = upload->id;
+		}
+		return result;
+	}
+
+	vulkan_staging_ring* ring = get_staging_ring(context);
+	u64 image_alignment = KMAX(VULKAN_STAGING_ALIGNMENT, context->device.properties.limits.optimalBufferCopyOffsetAlignment);
+
+	vulkan_upload_batch batch;
+	vulkan_command_buffer command_buffer;
+	krenderbuffer batch_dedicated_buffer = KRENDERBUFFER_INVALID;
+	upload_batch_begin(context, &batch, &command_buffer);
+	// The index of the first upload recorded into the current batch.
+	u32 batch_first = 0;
+
+	b8 result = true;
+	for (u32 i = 0; i < upload_count; ++i) {
+		const renderer_upload* upload = &uploads[i];
+		out_results[i] = true;
+
+		if (upload->type == RENDERER_UPLOAD_TYPE_RENDERBUFFER) {
+			vulkan_buffer* internal_buffer = &context->renderbuffers[upload->buffer];
+			if (internal_buffer->handle_count != 1 || !vulkan_buffer_is_device_local(backend, internal_buffer) || vulkan_buffer_is_host_visible(backend, internal_buffer)) {
+				// Written directly or per-frame, so nothing to do on the transfer queue. Completes along with the batch.
+				if (!vulkan_buffer_load_range(backend, upload->buffer, upload->offset, upload->size, upload->data, false)) {
+					KERROR("Failed to perform upload %llu.", upload->id);
+					out_results[i] = false;
+					result = false;
+				}
+				batch.last_upload_id = upload->id;
+				continue;
+			}
+		}
+
+		u64 alignment = upload->type == RENDERER_UPLOAD_TYPE_TEXTURE ? image_alignment : VULKAN_STAGING_ALIGNMENT;
+		u64 staging_offset = 0;
+		VkBuffer staging_handle = 0;
+		krenderbuffer dedicated_buffer = KRENDERBUFFER_INVALID;
+		u8* staging_memory = staging_acquire(backend, ring, upload->size, alignment, &staging_handle, &staging_offset, &dedicated_buffer);
+		if (!staging_memory) {
+			KERROR("Failed to obtain staging memory for upload %llu.", upload->id);
+			out_results[i] = false;
+			result = false;
+			continue;
+		}
+		kcopy_memory(staging_memory, upload->data, upload->size);
+
+		if (dedicated_buffer != KRENDERBUFFER_INVALID) {
+			// A submission holds at most one dedicated buffer, so start a new batch if this one already has one.
+			if (batch.has_dedicated_buffer) {
+				if (!upload_batch_submit(backend, ring, &batch, &command_buffer, batch_dedicated_buffer)) {
+					upload_batch_fail(batch_first, i, out_results);
+					result = false;
+				}
+				upload_batch_begin(context, &batch, &command_buffer);
+				batch_first = i;
+			}
+			batch.has_dedicated_buffer = true;
+			batch_dedicated_buffer = dedicated_buffer;
+		}
+
+		vulkan_upload_target target = {0};
+		target.texture = INVALID_KTEXTURE;
+		target.buffer = KRENDERBUFFER_INVALID;
+
+		if (upload->type == RENDERER_UPLOAD_TYPE_TEXTURE) {
+			vulkan_texture_handle_data* texture = &context->textures[upload->texture];
+			target.texture = upload->texture;
+
+			// The data is staged once and copied to every image of the texture.
+			for (u32 image_index = 0; image_index < texture->image_count; ++image_index) {
+				vulkan_image* image = &texture->images[image_index];
+
+				// The previous contents are overwritten, so the old layout can be discarded. Mips are
+				// generated once the image is handed over, as blits aren't supported on all transfer queues.
+				VkImageMemoryBarrier barrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+				barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+				barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+				barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.image = image->handle;
+				barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				barrier.subresourceRange.baseMipLevel = 0;
+				barrier.subresourceRange.levelCount = image->mip_levels;
+				barrier.subresourceRange.baseArrayLayer = 0;
+				barrier.subresourceRange.layerCount = image->layer_count;
+				barrier.srcAccessMask = 0;
+				barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				rhi->kvkCmdPipelineBarrier(command_buffer.handle, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, 0, 0, 0, 1, &barrier);
+
+				vulkan_image_copy_from_buffer(context, image, staging_handle, staging_offset, &command_buffer);
+
+				target.image_index = image_index;
+				target.image_barrier = barrier;
+				target.image_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+				target.image_barrier.srcQueueFamilyIndex = context->device.transfer_queue_index;
+				target.image_barrier.dstQueueFamilyIndex = context->device.graphics_queue_index;
+				darray_push(batch.targets, target);
+			}
+		} else {
+			VkBuffer dest = context->renderbuffers[upload->buffer].infos[0].handle;
+
+			VkBufferCopy copy_region;
+			copy_region.srcOffset = staging_offset;
+			copy_region.dstOffset = upload->offset;
+			copy_region.size = upload->size;
+			rhi->kvkCmdCopyBuffer(command_buffer.handle, staging_handle, dest, 1, &copy_region);
+
+			target.buffer = upload->buffer;
+			target.buffer_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			target.buffer_barrier.srcQueueFamilyIndex = context->device.transfer_queue_index;
+			target.buffer_barrier.dstQueueFamilyIndex = context->device.graphics_queue_index;
+			target.buffer_barrier.buffer = dest;
+			target.buffer_barrier.offset = upload->offset;
+			target.buffer_barrier.size = upload->size;
+			darray_push(batch.targets, target);
+		}
+
+		batch.last_upload_id = upload->id;
+	}
+
+	if (!upload_batch_submit(backend, ring, &batch, &command_buffer, batch_dedicated_buffer)) {
+		upload_batch_fail(batch_first, upload_count, out_results);
+		result = false;
+	}
+
+	return result;
+}
+
+b8 vulkan_renderer_uploads_acquire(renderer_backend_interface* backend, u64* out_completed_id) {
+	vulkan_context* context = (vulkan_context*)backend->internal_context;
+	krhi_vulkan* rhi = &context->rhi;
+	vulkan_upload_queue* queue = &context->uploads;
+
+	*out_completed_id = queue->completed_upload_id;
+
+	u32 batch_count = queue->batches ? darray_length(queue->batches) : 0;
+	if (!queue->timeline || !batch_count) {
+		return true;
+	}
+
+	// Poll rather than wait, so the graphics queue never stalls on uploads. Batches signal the
+	// timeline in submission order, so everything up to its current value has completed.
+	u64 timeline_value = 0;
+	VkResult result = rhi->kvkGetSemaphoreCounterValue(context->device.logical_device, queue->timeline, &timeline_value);
+	if (!vulkan_result_is_success(result)) {
+		KERROR("Failed to query upload timeline: %s", vulkan_result_string(result, true));
+		return false;
+	}
+
+	u32 completed_count = 0;
+	while (completed_count < batch_count && queue->batches[completed_count].timeline_value <= timeline_value) {
+		completed_count++;
+	}
+	if (!completed_count) {
+		return true;
+	}
+
+	// Hand everything over in a submission of its own ahead of the frame's, which waits on the
+	// timeline so that all later work on the graphics queue sees what was written.
+	vulkan_command_buffer command_buffer;
+	vulkan_staging_upload_begin(context, context->device.graphics_command_pool, &command_buffer);
+
+	b8 transfer_ownership = context->device.transfer_queue_index != context->device.graphics_queue_index;
+	for (u32 b = 0; b < completed_count; ++b) {
+		vulkan_upload_batch* batch = &queue->batches[b];
+		u32 target_count = darray_length(batch->targets);
+		for (u32 i = 0; i < target_count; ++i) {
+			vulkan_upload_target* target = &batch->targets[i];
+
+			if (target->texture != INVALID_KTEXTURE) {
+				// Skip images released (or replaced) since the batch was submitted.
+				vulkan_texture_handle_data* texture = &context->textures[target->texture];
+				if (!texture->images || target->image_index >= texture->image_count || texture->images[target->image_index].handle != target->image_barrier.image) {
+					continue;
+				}
+				vulkan_image* image = &texture->images[target->image_index];
+
+				if (transfer_ownership) {
+					VkImageMemoryBarrier barrier = target->image_barrier;
+					barrier.srcAccessMask = 0;
+					barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+					rhi->kvkCmdPipelineBarrier(command_buffer.handle, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, 0, 0, 0, 1, &barrier);
+				}
+
+				if (image->mip_levels <= 1 || !vulkan_image_mipmaps_generate(context, image, &command_buffer)) {
+					// If mip generation isn't needed or fails, fall back to ordinary transition.
+					vulkan_image_transition_layout(context, &command_buffer, image, image->format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+				}
+
+				// Counts as a texture update once all of its images are written.
+				if (target->image_index == texture->image_count - 1) {
+					texture->generation++;
+					// Roll over when at max u16.
+					if (texture->generation == INVALID_ID_U16) {
+						texture->generation = 0;
+					}
+				}
+			} else if (transfer_ownership) {
+				// Skip buffers destroyed (or replaced) since the batch was submitted.
+				vulkan_buffer* internal_buffer = &context->renderbuffers[target->buffer];
+				if (!internal_buffer->infos || internal_buffer->infos[0].handle != target->buffer_barrier.buffer) {
+					continue;
+				}
+
+				VkBufferMemoryBarrier barrier = target->buffer_barrier;
+				barrier.srcAccessMask = 0;
+				barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+				rhi->kvkCmdPipelineBarrier(command_buffer.handle, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, 0, 1, &barrier, 0, 0);
+			}
+		}
+	}
+
+	u64 wait_value = queue->batches[completed_count - 1].timeline_value;
+	if (!vulkan_staging_upload_submit_queue(
+			backend, get_staging_ring(context),
+			context->device.graphics_queue, context->device.graphics_command_pool,
+			&command_buffer, KRENDERBUFFER_INVALID,
+			queue->timeline, wait_value, 0)) {
+		// The batches are kept, and handed over again next time.
+		KERROR("Failed to submit upload handover.");
+		return false;
+	}
+
+	for (u32 b = 0; b < completed_count; ++b) {
+		vulkan_upload_batch batch;
+		darray_pop_at(queue->batches, 0, &batch);
+		darray_destroy(batch.targets);
+		queue->completed_upload_id = batch.last_upload_id;
+	}
+
+	*out_completed_id = queue->completed_upload_id;
+	return true;
+}
+
 void vulkan_renderer_wait_for_idle(renderer_backend_interface* backend) {
 	if (backend) {
 		vulkan_context* context = backend->internal_context;
@@ -4017,6 +4516,15 @@ static u32 get_current_frame_index(vulkan_context* context) {
 	return context->current_window->renderer_state->backend_state->current_frame;
 }
 
+static vulkan_staging_ring* get_staging_ring(vulkan_context* context) {
+	return context->current_window ? &context->current_window->renderer_state->backend_state->staging : 0;
+}
+
+static VkFence get_current_frame_fence(vulkan_context* context) {
+	kwindow_renderer_backend_state* window_backend = context->current_window->renderer_state->backend_state;
+	return window_backend->in_flight_fences[window_backend->current_frame];
+}
+
 static u32 get_current_image_count(vulkan_context* context) {
 	// 3 for triple-buffered, otherwise 2.
 	return context->triple_buffering_enabled ? 3 : 2;
@@ -4300,7 +4808,7 @@ static b8 vulkan_graphics_pipeline_create(vulkan_context* context, const vulkan_
 
 	VkResult result = rhi->kvkCreateGraphicsPipelines(
 		context->device.logical_device,
-		VK_NULL_HANDLE,
+		context->shader_cache.pipeline_cache,
 		1,
 		&pipeline_create_info,
 		context->allocator,
@@ -134,6 +134,11 @@ b8 vulkan_buffer_read(renderer_backend_interface* backend, krenderbuffer handle,
 b8 vulkan_buffer_load_range(renderer_backend_interface* backend, krenderbuffer handle, u64 offset, u64 size, const void* data, b8 include_in_frame_workload);
 b8 vulkan_buffer_copy_range(renderer_backend_interface* backend, krenderbuffer source, u64 source_offset, krenderbuffer dest, u64 dest_offset, u64 size, b8 include_in_frame_workload);
 b8 vulkan_buffer_draw(renderer_backend_interface* backend, krenderbuffer handle, u64 offset, u32 element_count, u32 binding_index, b8 bind_only);
+b8 vulkan_buffer_draw_instanced(renderer_backend_interface* backend, krenderbuffer handle, u64 offset, u32 element_count, u32 instance_count, u32 first_instance, u32 binding_index);
+b8 vulkan_buffer_draw_indirect(renderer_backend_interface* backend, krenderbuffer handle, u64 offset, u32 draw_count);
+
+b8 vulkan_renderer_uploads_submit(renderer_backend_interface* backend, u32 upload_count, const renderer_upload* uploads, b8* out_results);
+b8 vulkan_renderer_uploads_acquire(renderer_backend_interface* backend, u64* out_completed_id);
 
 void vulkan_renderer_wait_for_idle(renderer_backend_interface* backend);
 
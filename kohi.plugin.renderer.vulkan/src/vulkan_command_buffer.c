@@ -137,6 +137,8 @@ b8 vulkan_command_buffer_submit(
 	VkSemaphore* signal_semaphores,
 	u32 wait_semaphore_count,
 	VkSemaphore* wait_semaphores,
+	const VkPipelineStageFlags* wait_stages,
+	const VkTimelineSemaphoreSubmitInfo* timeline_info,
 	VkFence fence) {
 	krhi_vulkan* rhi = &context->rhi;
 	if (command_buffer->state != COMMAND_BUFFER_STATE_RECORDING_ENDED) {
@@ -147,6 +149,7 @@ b8 vulkan_command_buffer_submit(
 	// Submit the queue and wait for the operation to complete.
 	// Begin queue submission
 	VkSubmitInfo submit_info = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+	submit_info.pNext = timeline_info;
 
 	// Command buffer(s) to be executed.
 	submit_info.commandBufferCount = 1;
@@ -172,7 +175,7 @@ b8 vulkan_command_buffer_submit(
 	// colour attachment writes from executing until the semaphore signals (i.e.
 	// one frame is presented at a time)
 	VkPipelineStageFlags flags[1] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-	submit_info.pWaitDstStageMask = flags;
+	submit_info.pWaitDstStageMask = wait_stages ? wait_stages : flags;
 
 	VkResult result = rhi->kvkQueueSubmit(queue, 1, &submit_info, fence);
 	if (result != VK_SUCCESS) {
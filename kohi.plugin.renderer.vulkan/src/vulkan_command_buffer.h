@@ -83,6 +83,8 @@ void vulkan_command_buffer_end(vulkan_context* context, vulkan_command_buffer* c
  * @param signal_semaphores The semaphore(s) to be signaled when the queue is complete.
  * @param wait_semaphore_count The number of semaphore(s) to wait on before the command buffer is executed.
  * @param wait_semaphores The semaphore(s) to be waited on before the command buffer is executed.
+ * @param wait_stages The pipeline stage each wait semaphore is waited on at. If 0, all are waited on before colour attachment output.
+ * @param timeline_info Optional timeline semaphore values for the wait and signal semaphores. 0 if none are timeline semaphores.
  * @param fence An optional handle to a fence to be signaled once all submitted command buffers have completed execution.
  * @return b8 True on success; otherwise false.
  */
@@ -94,6 +96,8 @@ b8 vulkan_command_buffer_submit(
 	VkSemaphore* signal_semaphores,
 	u32 wait_semaphore_count,
 	VkSemaphore* wait_semaphores,
+	const VkPipelineStageFlags* wait_stages,
+	const VkTimelineSemaphoreSubmitInfo* timeline_info,
 	VkFence fence);
 
 /**
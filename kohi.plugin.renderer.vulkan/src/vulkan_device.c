@@ -165,6 +165,11 @@ b8 vulkan_device_create(vulkan_context* context, b8 require_discrete_gpu) {
 	if (!device_features.features.shaderClipDistance) {
 		KERROR("shaderClipDistance not supported by Vulkan device '%s'!", context->device.properties.deviceName);
 	}
+	// Multi-draw-indirect, if supported.
+	if (context->device.support_flags & VULKAN_DEVICE_SUPPORT_FLAG_MULTI_DRAW_INDIRECT_BIT) {
+		device_features.features.multiDrawIndirect = VK_TRUE;
+		device_features.features.drawIndirectFirstInstance = VK_TRUE;
+	}
 
 	// Dynamic rendering.
 	VkPhysicalDeviceDynamicRenderingFeatures dynamic_rendering_ext = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES};
@@ -196,6 +201,14 @@ b8 vulkan_device_create(vulkan_context* context, b8 require_discrete_gpu) {
 		descriptor_indexing_features.pNext = &line_rasterization_ext;
 	}
 
+	// Timeline semaphores, if supported.
+	VkPhysicalDeviceTimelineSemaphoreFeatures timeline_semaphore_features = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES};
+	if (context->device.support_flags & VULKAN_DEVICE_SUPPORT_FLAG_TIMELINE_SEMAPHORE_BIT) {
+		timeline_semaphore_features.timelineSemaphore = VK_TRUE;
+		timeline_semaphore_features.pNext = dynamic_rendering_ext.pNext;
+		dynamic_rendering_ext.pNext = &timeline_semaphore_features;
+	}
+
 // #if defined(VK_USE_PLATFORM_MACOS_MVK)
 // 	MVKPhysicalDeviceMetalFeatures metal_features = {
 // 		.sType = MKV
@@ -299,6 +312,16 @@ b8 vulkan_device_create(vulkan_context* context, b8 require_discrete_gpu) {
 		&context->device.graphics_command_pool));
 	KINFO("Graphics command pool created.");
 
+	// Create command pool for transfer queue. Only single-use command buffers are allocated from it.
+	pool_create_info.queueFamilyIndex = context->device.transfer_queue_index;
+	pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	VK_CHECK(rhi->kvkCreateCommandPool(
+		context->device.logical_device,
+		&pool_create_info,
+		context->allocator,
+		&context->device.transfer_command_pool));
+	KINFO("Transfer command pool created.");
+
 	return true;
 }
 
@@ -313,6 +336,10 @@ void vulkan_device_destroy(vulkan_context* context) {
 		context->device.logical_device,
 		context->device.graphics_command_pool,
 		context->allocator);
+	context->rhi.kvkDestroyCommandPool(
+		context->device.logical_device,
+		context->device.transfer_command_pool,
+		context->allocator);
 
 	// Destroy logical device
 	KINFO("Destroying logical device...");
@@ -490,6 +517,9 @@ static b8 select_physical_device(vulkan_context* context, b8 require_discrete_gp
 		// Check for smooth line rasterisation support via extension.
 		VkPhysicalDeviceLineRasterizationFeaturesEXT smooth_line_next = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_LINE_RASTERIZATION_FEATURES_EXT};
 		dynamic_state_next.pNext = &smooth_line_next;
+		// Check for timeline semaphore support.
+		VkPhysicalDeviceTimelineSemaphoreFeatures timeline_semaphore_next = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES};
+		smooth_line_next.pNext = &timeline_semaphore_next;
 		// Perform the query.
 		rhi->kvkGetPhysicalDeviceFeatures2(physical_devices[i], &features2);
 
@@ -590,6 +620,14 @@ static b8 select_physical_device(vulkan_context* context, b8 require_discrete_gp
 			if (smooth_line_next.smoothLines) {
 				context->device.support_flags |= VULKAN_DEVICE_SUPPORT_FLAG_LINE_SMOOTH_RASTERISATION_BIT;
 			}
+			// Check for multi-draw-indirect support. Indirect commands also need to be able to start at any instance.
+			if (features.multiDrawIndirect && features.drawIndirectFirstInstance) {
+				context->device.support_flags |= VULKAN_DEVICE_SUPPORT_FLAG_MULTI_DRAW_INDIRECT_BIT;
+			}
+			// Check for timeline semaphore support, which is core as of Vulkan 1.2.
+			if (timeline_semaphore_next.timelineSemaphore && (context->device.api_major > 1 || context->device.api_minor >= 2)) {
+				context->device.support_flags |= VULKAN_DEVICE_SUPPORT_FLAG_TIMELINE_SEMAPHORE_BIT;
+			}
 			break;
 		}
 	}
@@ -84,6 +84,8 @@ b8 vulkan_loader_load_device(krhi_vulkan* rhi, VkDevice device) {
 	RHI_DEVICE_FUNCTION(vkCreateFence);
 	RHI_DEVICE_FUNCTION(vkDestroyFence);
 	RHI_DEVICE_FUNCTION(vkWaitForFences);
+	RHI_DEVICE_FUNCTION(vkGetFenceStatus);
+	RHI_DEVICE_FUNCTION(vkGetSemaphoreCounterValue);
 	RHI_DEVICE_FUNCTION(vkAcquireNextImageKHR);
 	RHI_DEVICE_FUNCTION(vkResetFences);
 	RHI_DEVICE_FUNCTION(vkCreateDescriptorSetLayout);
@@ -92,6 +94,9 @@ b8 vulkan_loader_load_device(krhi_vulkan* rhi, VkDevice device) {
 	RHI_DEVICE_FUNCTION(vkDestroyDescriptorPool);
 	RHI_DEVICE_FUNCTION(vkCreateShaderModule);
 	RHI_DEVICE_FUNCTION(vkDestroyShaderModule);
+	RHI_DEVICE_FUNCTION(vkCreatePipelineCache);
+	RHI_DEVICE_FUNCTION(vkDestroyPipelineCache);
+	RHI_DEVICE_FUNCTION(vkGetPipelineCacheData);
 	RHI_DEVICE_FUNCTION(vkCreateSampler);
 	RHI_DEVICE_FUNCTION(vkDestroySampler);
 	RHI_DEVICE_FUNCTION(vkCreateBuffer);
@@ -144,6 +149,7 @@ b8 vulkan_loader_load_device(krhi_vulkan* rhi, VkDevice device) {
 	RHI_DEVICE_FUNCTION(vkCmdBindIndexBuffer);
 	RHI_DEVICE_FUNCTION(vkCmdDraw);
 	RHI_DEVICE_FUNCTION(vkCmdDrawIndexed);
+	RHI_DEVICE_FUNCTION(vkCmdDrawIndexedIndirect);
 	RHI_DEVICE_FUNCTION(vkCmdBindDescriptorSets);
 
 	RHI_DEVICE_FUNCTION(vkQueueSubmit);
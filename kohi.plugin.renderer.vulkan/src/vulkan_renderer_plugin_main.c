@@ -108,6 +108,10 @@ b8 kohi_plugin_renderer_vulkan_create(kruntime_plugin* out_plugin) {
 	backend->renderbuffer_load_range = vulkan_buffer_load_range;
 	backend->renderbuffer_copy_range = vulkan_buffer_copy_range;
 	backend->renderbuffer_draw = vulkan_buffer_draw;
+	backend->renderbuffer_draw_instanced = vulkan_buffer_draw_instanced;
+	backend->renderbuffer_draw_indirect = vulkan_buffer_draw_indirect;
+	backend->uploads_submit = vulkan_renderer_uploads_submit;
+	backend->uploads_acquire = vulkan_renderer_uploads_acquire;
 	backend->wait_for_idle = vulkan_renderer_wait_for_idle;
 #if KOHI_DEBUG
 	backend->debug_pump_brakes = vulkan_renderer_debug_pump_brakes;
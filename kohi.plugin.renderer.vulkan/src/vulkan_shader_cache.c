@@ -0,0 +1,286 @@
+#include "vulkan_shader_cache.h"
+
+#include <containers/darray.h>
+#include <containers/hashmap.h>
+#include <logger.h>
+#include <memory/kmemory.h>
+#include <platform/filesystem.h>
+#include <utils/crc64.h>
+
+#include "platform/vulkan_platform.h"
+#include "vulkan_types.h"
+#include "vulkan_utils.h"
+
+// Both files are kept in the working directory, next to the application.
+#define VULKAN_PIPELINE_CACHE_PATH "vulkan_pipeline.cache"
+#define VULKAN_SPIRV_CACHE_PATH "vulkan_spirv.cache"
+
+// 'KSPV'
+#define VULKAN_SPIRV_CACHE_MAGIC 0x5650534BU
+// Bump whenever compile settings change (i.e. the target environment), invalidating all cached SPIR-V.
+#define VULKAN_SPIRV_CACHE_VERSION 1
+
+typedef struct vulkan_spirv_cache_file_header {
+	u32 magic;
+	u32 version;
+	u32 entry_count;
+	u32 padding;
+} vulkan_spirv_cache_file_header;
+
+typedef struct vulkan_spirv_cache_file_entry {
+	u64 key;
+	u64 source_length;
+	u32 code_size;
+	u32 padding;
+} vulkan_spirv_cache_file_entry;
+
+static void spirv_cache_load(vulkan_shader_cache* cache) {
+	if (!filesystem_exists(VULKAN_SPIRV_CACHE_PATH)) {
+		return;
+	}
+
+	u64 size = 0;
+	const u8* data = filesystem_read_entire_binary_file(VULKAN_SPIRV_CACHE_PATH, &size);
+	if (!data) {
+		KWARN("Failed to read SPIR-V cache file '%s'. Shaders will be compiled.", VULKAN_SPIRV_CACHE_PATH);
+		return;
+	}
+
+	const vulkan_spirv_cache_file_header* header = (const vulkan_spirv_cache_file_header*)data;
+	if (size < sizeof(vulkan_spirv_cache_file_header) || header->magic != VULKAN_SPIRV_CACHE_MAGIC || header->version != VULKAN_SPIRV_CACHE_VERSION) {
+		KINFO("SPIR-V cache file '%s' is invalid or out of date, and will be replaced.", VULKAN_SPIRV_CACHE_PATH);
+		kfree((void*)data, size, MEMORY_TAG_ARRAY);
+		return;
+	}
+
+	u64 offset = sizeof(vulkan_spirv_cache_file_header);
+	for (u32 i = 0; i < header->entry_count; ++i) {
+		if (offset + sizeof(vulkan_spirv_cache_file_entry) > size) {
+			KWARN("SPIR-V cache file '%s' is truncated. Only some entries were loaded.", VULKAN_SPIRV_CACHE_PATH);
+			break;
+		}
+		const vulkan_spirv_cache_file_entry* file_entry = (const vulkan_spirv_cache_file_entry*)(data + offset);
+		offset += sizeof(vulkan_spirv_cache_file_entry);
+		if (offset + file_entry->code_size > size || !file_entry->code_size || (file_entry->code_size % sizeof(u32))) {
+			KWARN("SPIR-V cache file '%s' is truncated. Only some entries were loaded.", VULKAN_SPIRV_CACHE_PATH);
+			break;
+		}
+
+		vulkan_spirv_cache_entry entry = {
+			.key = file_entry->key,
+			.source_length = file_entry->source_length,
+			.code_size = file_entry->code_size,
+			.code = kallocate(file_entry->code_size, MEMORY_TAG_RENDERER),
+			.used = false};
+		kcopy_memory(entry.code, data + offset, entry.code_size);
+		offset += entry.code_size;
+
+		u32 index = (u32)darray_length(cache->spirv_entries);
+		darray_push(cache->spirv_entries, entry);
+		hashmap_u64_set(&cache->spirv_lookup, entry.key, &index);
+	}
+
+	KDEBUG("Loaded %u cached shader stages.", (u32)darray_length(cache->spirv_entries));
+	kfree((void*)data, size, MEMORY_TAG_ARRAY);
+}
+
+static void spirv_cache_save(vulkan_shader_cache* cache) {
+	u32 entry_count = (u32)darray_length(cache->spirv_entries);
+
+	// Only entries used this run are kept, so stale stages (i.e. from since-edited sources) don't pile up.
+	u32 used_count = 0;
+	u64 size = sizeof(vulkan_spirv_cache_file_header);
+	for (u32 i = 0; i < entry_count; ++i) {
+		if (cache->spirv_entries[i].used) {
+			used_count++;
+			size += sizeof(vulkan_spirv_cache_file_entry) + cache->spirv_entries[i].code_size;
+		}
+	}
+	if (!cache->spirv_dirty && used_count == entry_count) {
+		// Nothing has changed.
+		return;
+	}
+
+	u8* data = kallocate(size, MEMORY_TAG_ARRAY);
+	vulkan_spirv_cache_file_header* header = (vulkan_spirv_cache_file_header*)data;
+	header->magic = VULKAN_SPIRV_CACHE_MAGIC;
+	header->version = VULKAN_SPIRV_CACHE_VERSION;
+	header->entry_count = used_count;
+
+	u64 offset = sizeof(vulkan_spirv_cache_file_header);
+	for (u32 i = 0; i < entry_count; ++i) {
+		const vulkan_spirv_cache_entry* entry = &cache->spirv_entries[i];
+		if (!entry->used) {
+			continue;
+		}
+		vulkan_spirv_cache_file_entry* file_entry = (vulkan_spirv_cache_file_entry*)(data + offset);
+		file_entry->key = entry->key;
+		file_entry->source_length = entry->source_length;
+		file_entry->code_size = entry->code_size;
+		offset += sizeof(vulkan_spirv_cache_file_entry);
+		kcopy_memory(data + offset, entry->code, entry->code_size);
+		offset += entry->code_size;
+	}
+
+	if (!filesystem_write_entire_binary_file(VULKAN_SPIRV_CACHE_PATH, size, data)) {
+		KWARN("Failed to write SPIR-V cache file '%s'. Shaders will be compiled on next run.", VULKAN_SPIRV_CACHE_PATH);
+	}
+	kfree(data, size, MEMORY_TAG_ARRAY);
+}
+
+// Saved pipeline cache data is only usable by the same driver on the same device.
+static b8 pipeline_cache_data_valid(vulkan_context* context, const u8* data, u64 size) {
+	if (size < sizeof(VkPipelineCacheHeaderVersionOne)) {
+		return false;
+	}
+	VkPipelineCacheHeaderVersionOne header;
+	kcopy_memory(&header, data, sizeof(VkPipelineCacheHeaderVersionOne));
+	const VkPhysicalDeviceProperties* properties = &context->device.properties;
+	if (header.headerSize < sizeof(VkPipelineCacheHeaderVersionOne) ||
+		header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+		header.vendorID != properties->vendorID ||
+		header.deviceID != properties->deviceID) {
+		return false;
+	}
+	for (u32 i = 0; i < VK_UUID_SIZE; ++i) {
+		if (header.pipelineCacheUUID[i] != properties->pipelineCacheUUID[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void pipeline_cache_save(vulkan_context* context) {
+	krhi_vulkan* rhi = &context->rhi;
+	VkPipelineCache pipeline_cache = context->shader_cache.pipeline_cache;
+
+	size_t size = 0;
+	if (rhi->kvkGetPipelineCacheData(context->device.logical_device, pipeline_cache, &size, 0) != VK_SUCCESS || !size) {
+		return;
+	}
+	void* data = kallocate(size, MEMORY_TAG_ARRAY);
+	VkResult result = rhi->kvkGetPipelineCacheData(context->device.logical_device, pipeline_cache, &size, data);
+	if (result == VK_SUCCESS) {
+		if (!filesystem_write_entire_binary_file(VULKAN_PIPELINE_CACHE_PATH, size, data)) {
+			KWARN("Failed to write pipeline cache file '%s'.", VULKAN_PIPELINE_CACHE_PATH);
+		}
+	} else {
+		KWARN("vkGetPipelineCacheData failed with %s. Pipeline cache was not saved.", vulkan_result_string(result, true));
+	}
+	kfree(data, size, MEMORY_TAG_ARRAY);
+}
+
+b8 vulkan_shader_cache_create(vulkan_context* context) {
+	krhi_vulkan* rhi = &context->rhi;
+	vulkan_shader_cache* cache = &context->shader_cache;
+
+	if (!hashmap_create(sizeof(u32), 256, &cache->spirv_lookup)) {
+		KERROR("Failed to create SPIR-V cache lookup.");
+		return false;
+	}
+	cache->spirv_entries = darray_create(vulkan_spirv_cache_entry);
+	cache->spirv_dirty = false;
+	spirv_cache_load(cache);
+
+	// Seed the pipeline cache with saved data, if any is usable.
+	u64 data_size = 0;
+	const u8* data = 0;
+	if (filesystem_exists(VULKAN_PIPELINE_CACHE_PATH)) {
+		data = filesystem_read_entire_binary_file(VULKAN_PIPELINE_CACHE_PATH, &data_size);
+		if (data && !pipeline_cache_data_valid(context, data, data_size)) {
+			KINFO("Pipeline cache file '%s' is from a different device or driver, and will be replaced.", VULKAN_PIPELINE_CACHE_PATH);
+			kfree((void*)data, data_size, MEMORY_TAG_ARRAY);
+			data = 0;
+		}
+	}
+
+	VkPipelineCacheCreateInfo create_info = {VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+	create_info.initialDataSize = data ? data_size : 0;
+	create_info.pInitialData = data;
+	VkResult result = rhi->kvkCreatePipelineCache(context->device.logical_device, &create_info, context->allocator, &cache->pipeline_cache);
+	if (data) {
+		kfree((void*)data, data_size, MEMORY_TAG_ARRAY);
+	}
+	if (!vulkan_result_is_success(result)) {
+		// Pipelines can still be created without a cache, just more slowly.
+		KWARN("vkCreatePipelineCache failed with %s. Pipelines will not be cached.", vulkan_result_string(result, true));
+		cache->pipeline_cache = VK_NULL_HANDLE;
+	}
+
+	return true;
+}
+
+void vulkan_shader_cache_destroy(vulkan_context* context) {
+	krhi_vulkan* rhi = &context->rhi;
+	vulkan_shader_cache* cache = &context->shader_cache;
+
+	if (cache->pipeline_cache) {
+		pipeline_cache_save(context);
+		rhi->kvkDestroyPipelineCache(context->device.logical_device, cache->pipeline_cache, context->allocator);
+		cache->pipeline_cache = VK_NULL_HANDLE;
+	}
+
+	if (cache->spirv_entries) {
+		spirv_cache_save(cache);
+		u32 entry_count = (u32)darray_length(cache->spirv_entries);
+		for (u32 i = 0; i < entry_count; ++i) {
+			kfree(cache->spirv_entries[i].code, cache->spirv_entries[i].code_size, MEMORY_TAG_RENDERER);
+		}
+		darray_destroy(cache->spirv_entries);
+		cache->spirv_entries = 0;
+	}
+	hashmap_destroy(&cache->spirv_lookup);
+}
+
+u64 vulkan_shader_cache_key(shader_stage stage, const char* source, u64 source_length) {
+	u32 settings[2] = {(u32)stage, VULKAN_SPIRV_CACHE_VERSION};
+	u64 key = crc64(0, (const u8*)source, source_length);
+	return crc64(key, (const u8*)settings, sizeof(settings));
+}
+
+const u32* vulkan_shader_cache_spirv_get(vulkan_context* context, u64 key, u64 source_length, u32* out_code_size) {
+	vulkan_shader_cache* cache = &context->shader_cache;
+	u32 index = INVALID_ID;
+	if (!cache->spirv_entries || !hashmap_u64_get(&cache->spirv_lookup, key, &index)) {
+		return 0;
+	}
+
+	vulkan_spirv_cache_entry* entry = &cache->spirv_entries[index];
+	if (entry->source_length != source_length) {
+		return 0;
+	}
+	entry->used = true;
+	*out_code_size = entry->code_size;
+	return entry->code;
+}
+
+void vulkan_shader_cache_spirv_add(vulkan_context* context, u64 key, u64 source_length, u32 code_size, const u32* code) {
+	vulkan_shader_cache* cache = &context->shader_cache;
+	if (!cache->spirv_entries) {
+		return;
+	}
+
+	u32 index = INVALID_ID;
+	if (hashmap_u64_get(&cache->spirv_lookup, key, &index)) {
+		// Replace the existing entry, i.e. one whose source length didn't match.
+		vulkan_spirv_cache_entry* existing = &cache->spirv_entries[index];
+		kfree(existing->code, existing->code_size, MEMORY_TAG_RENDERER);
+		existing->source_length = source_length;
+		existing->code_size = code_size;
+		existing->code = kallocate(code_size, MEMORY_TAG_RENDERER);
+		kcopy_memory(existing->code, code, code_size);
+		existing->used = true;
+	} else {
+		vulkan_spirv_cache_entry entry = {
+			.key = key,
+			.source_length = source_length,
+			.code_size = code_size,
+			.code = kallocate(code_size, MEMORY_TAG_RENDERER),
+			.used = true};
+		kcopy_memory(entry.code, code, code_size);
+		index = (u32)darray_length(cache->spirv_entries);
+		darray_push(cache->spirv_entries, entry);
+		hashmap_u64_set(&cache->spirv_lookup, key, &index);
+	}
+	cache->spirv_dirty = true;
+}
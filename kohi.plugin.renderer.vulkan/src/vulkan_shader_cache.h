@@ -0,0 +1,64 @@
+/**
+ * @file vulkan_shader_cache.h
+ * @brief This file contains persistent caches of compiled SPIR-V and Vulkan pipelines.
+ *
+ * @details
+ * Compiled shader stages are keyed on a hash of their source text (which includes any
+ * defines), their stage and the compile settings, so a stage is only ever compiled again
+ * once one of those changes. Pipelines are created through a VkPipelineCache. Both are
+ * loaded from files in the working directory (i.e. next to the application) on startup,
+ * and written back on shutdown.
+ */
+
+#pragma once
+
+#include "vulkan_types.h"
+
+/**
+ * @brief Creates the shader cache for the given context, loading any previously saved data.
+ * Must be called after device creation. Failing to load saved data is not an error.
+ *
+ * @param context A pointer to the Vulkan context.
+ * @return True on success; otherwise false.
+ */
+b8 vulkan_shader_cache_create(vulkan_context* context);
+
+/**
+ * @brief Saves the shader cache of the given context to disk, then destroys it.
+ * Must be called before device destruction.
+ *
+ * @param context A pointer to the Vulkan context.
+ */
+void vulkan_shader_cache_destroy(vulkan_context* context);
+
+/**
+ * @brief Obtains the cache key for the given stage source.
+ *
+ * @param stage The stage the source is for.
+ * @param source The source text.
+ * @param source_length The length of the source text.
+ * @return The cache key.
+ */
+u64 vulkan_shader_cache_key(shader_stage stage, const char* source, u64 source_length);
+
+/**
+ * @brief Obtains previously compiled SPIR-V for the given key.
+ *
+ * @param context A pointer to the Vulkan context.
+ * @param key The cache key of the stage. @see vulkan_shader_cache_key
+ * @param source_length The length of the stage's source text.
+ * @param out_code_size A pointer to hold the size of the code in bytes.
+ * @return A pointer to the code if found; otherwise 0. Owned by the cache.
+ */
+const u32* vulkan_shader_cache_spirv_get(vulkan_context* context, u64 key, u64 source_length, u32* out_code_size);
+
+/**
+ * @brief Stores a copy of newly compiled SPIR-V under the given key.
+ *
+ * @param context A pointer to the Vulkan context.
+ * @param key The cache key of the stage. @see vulkan_shader_cache_key
+ * @param source_length The length of the stage's source text.
+ * @param code_size The size of the code in bytes.
+ * @param code The SPIR-V code.
+ */
+void vulkan_shader_cache_spirv_add(vulkan_context* context, u64 key, u64 source_length, u32 code_size, const u32* code);
@@ -0,0 +1,286 @@
+#include "vulkan_staging.h"
+
+#include <containers/darray.h>
+#include <logger.h>
+#include <memory/kmemory.h>
+#include <renderer/renderer_frontend.h>
+
+#include "platform/vulkan_platform.h"
+#include "vulkan_command_buffer.h"
+#include "vulkan_types.h"
+#include "vulkan_utils.h"
+
+static void submission_release(renderer_backend_interface* backend, vulkan_staging_submission* submission) {
+	vulkan_context* context = (vulkan_context*)backend->internal_context;
+	krhi_vulkan* rhi = &context->rhi;
+
+	if (submission->owns_fence) {
+		rhi->kvkDestroyFence(context->device.logical_device, submission->fence, context->allocator);
+		vulkan_command_buffer_free(context, submission->command_pool, &submission->command_buffer);
+	}
+	submission->fence = 0;
+
+	// NOTE: Destroying a renderbuffer waits for the device to idle. Dedicated buffers are
+	// only used for uploads too large for the ring, so this should be rare.
+	if (submission->dedicated_buffer != KRENDERBUFFER_INVALID) {
+		renderer_renderbuffer_destroy(backend->frontend_state, submission->dedicated_buffer);
+		submission->dedicated_buffer = KRENDERBUFFER_INVALID;
+	}
+}
+
+static void submission_push(vulkan_staging_ring* ring, VkFence fence, vulkan_command_buffer* owned_command_buffer, VkCommandPool command_pool, krenderbuffer dedicated_buffer) {
+	vulkan_staging_submission submission = {0};
+	submission.end = ring->head;
+	submission.size = ring->unretired;
+	submission.fence = fence;
+	submission.owns_fence = owned_command_buffer != 0;
+	if (owned_command_buffer) {
+		submission.command_buffer = *owned_command_buffer;
+		submission.command_pool = command_pool;
+	}
+	submission.dedicated_buffer = dedicated_buffer;
+	darray_push(ring->submissions, submission);
+	ring->unretired = 0;
+}
+
+static b8 ring_reserve(vulkan_staging_ring* ring, u64 size, u64 alignment, u64* out_offset) {
+	if (ring->used == 0) {
+		// Nothing in use, so start over from the beginning to keep the whole buffer contiguous.
+		ring->head = 0;
+		ring->tail = 0;
+	} else if (ring->head == ring->tail) {
+		// In use and caught up with the tail, so full.
+		return false;
+	}
+
+	u64 start = (ring->head + (alignment - 1)) & ~(alignment - 1);
+	u64 skipped = start - ring->head;
+	if (ring->head >= ring->tail) {
+		// Free space runs from the head to the end, then wraps around to the tail.
+		if (start + size > ring->capacity) {
+			if (ring->used != 0 && size > ring->tail) {
+				return false;
+			}
+			// Skip the remainder of the buffer and wrap around.
+			skipped = ring->capacity - ring->head;
+			start = 0;
+		}
+	} else if (start + size > ring->tail) {
+		// Free space runs from the head to the tail.
+		return false;
+	}
+
+	ring->used += skipped + size;
+	ring->unretired += skipped + size;
+	ring->head = start + size;
+	*out_offset = start;
+	return true;
+}
+
+b8 vulkan_staging_ring_create(renderer_backend_interface* backend, kname name, u64 capacity, vulkan_staging_ring* out_ring) {
+	vulkan_context* context = (vulkan_context*)backend->internal_context;
+	kzero_memory(out_ring, sizeof(vulkan_staging_ring));
+
+	out_ring->buffer = renderer_renderbuffer_create(backend->frontend_state, name, RENDERBUFFER_TYPE_STAGING, capacity, RENDERBUFFER_TRACK_TYPE_NONE, RENDERBUFFER_FLAG_AUTO_MAP_MEMORY_BIT);
+	if (out_ring->buffer == KRENDERBUFFER_INVALID) {
+		KERROR("Failed to create staging ring buffer.");
+		return false;
+	}
+
+	out_ring->mapped_memory = context->renderbuffers[out_ring->buffer].infos[0].mapped_memory;
+	out_ring->capacity = capacity;
+	out_ring->submissions = darray_create(vulkan_staging_submission);
+	return true;
+}
+
+void vulkan_staging_ring_destroy(renderer_backend_interface* backend, vulkan_staging_ring* ring) {
+	if (ring->submissions) {
+		u32 submission_count = darray_length(ring->submissions);
+		for (u32 i = 0; i < submission_count; ++i) {
+			submission_release(backend, &ring->submissions[i]);
+		}
+		darray_destroy(ring->submissions);
+	}
+
+	if (ring->buffer != KRENDERBUFFER_INVALID) {
+		renderer_renderbuffer_destroy(backend->frontend_state, ring->buffer);
+	}
+
+	kzero_memory(ring, sizeof(vulkan_staging_ring));
+	ring->buffer = KRENDERBUFFER_INVALID;
+}
+
+void vulkan_staging_ring_reclaim(renderer_backend_interface* backend, vulkan_staging_ring* ring) {
+	vulkan_context* context = (vulkan_context*)backend->internal_context;
+	krhi_vulkan* rhi = &context->rhi;
+
+	// Space is released strictly in allocation order, so stop at the first submission still in progress.
+	while (darray_length(ring->submissions)) {
+		vulkan_staging_submission* oldest = &ring->submissions[0];
+		if (rhi->kvkGetFenceStatus(context->device.logical_device, oldest->fence) != VK_SUCCESS) {
+			break;
+		}
+
+		// Submissions using only a dedicated buffer hold no ring space, and their end may
+		// predate the ring starting over, so they must not move the tail.
+		if (oldest->size) {
+			ring->tail = oldest->end;
+			ring->used -= oldest->size;
+		}
+
+		vulkan_staging_submission released;
+		darray_pop_at(ring->submissions, 0, &released);
+		submission_release(backend, &released);
+	}
+}
+
+u8* vulkan_staging_ring_allocate(renderer_backend_interface* backend, vulkan_staging_ring* ring, u64 size, u64 alignment, u64* out_offset) {
+	if (!size || size > ring->capacity) {
+		return 0;
+	}
+
+	if (!ring_reserve(ring, size, alignment, out_offset)) {
+		vulkan_staging_ring_reclaim(backend, ring);
+		if (!ring_reserve(ring, size, alignment, out_offset)) {
+			return 0;
+		}
+	}
+
+	return ring->mapped_memory + *out_offset;
+}
+
+void vulkan_staging_ring_retire(vulkan_staging_ring* ring, VkFence fence) {
+	if (!ring->unretired) {
+		return;
+	}
+
+	// Frame workload allocations share the frame's fence, so merge them into one submission.
+	u32 submission_count = darray_length(ring->submissions);
+	if (submission_count) {
+		vulkan_staging_submission* newest = &ring->submissions[submission_count - 1];
+		if (newest->fence == fence && !newest->owns_fence && newest->dedicated_buffer == KRENDERBUFFER_INVALID) {
+			newest->end = ring->head;
+			newest->size += ring->unretired;
+			ring->unretired = 0;
+			return;
+		}
+	}
+
+	submission_push(ring, fence, 0, 0, KRENDERBUFFER_INVALID);
+}
+
+b8 vulkan_staging_ring_wait_oldest(renderer_backend_interface* backend, vulkan_staging_ring* ring, VkFence frame_fence) {
+	vulkan_context* context = (vulkan_context*)backend->internal_context;
+	krhi_vulkan* rhi = &context->rhi;
+
+	if (!darray_length(ring->submissions)) {
+		return false;
+	}
+
+	// The current frame's fence is not signalled until the frame is submitted, so waiting on it would never return.
+	vulkan_staging_submission* oldest = &ring->submissions[0];
+	if (!oldest->owns_fence && oldest->fence == frame_fence) {
+		return false;
+	}
+
+	VkResult result = rhi->kvkWaitForFences(context->device.logical_device, 1, &oldest->fence, true, U64_MAX);
+	if (!vulkan_result_is_success(result)) {
+		KERROR("Failed to wait on staging submission: %s", vulkan_result_string(result, true));
+		return false;
+	}
+
+	vulkan_staging_ring_reclaim(backend, ring);
+	return true;
+}
+
+void vulkan_staging_upload_begin(vulkan_context* context, VkCommandPool command_pool, vulkan_command_buffer* out_command_buffer) {
+	krhi_vulkan* rhi = &context->rhi;
+	vulkan_command_buffer_allocate_and_begin_single_use(context, command_pool, out_command_buffer);
+
+	// Earlier work may still be using what is about to be overwritten. Wait on it here, which
+	// holds up only this upload rather than idling the whole queue.
+	VkMemoryBarrier barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+	barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	rhi->kvkCmdPipelineBarrier(
+		out_command_buffer->handle,
+		VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0, 1, &barrier, 0, 0, 0, 0);
+}
+
+b8 vulkan_staging_upload_submit(renderer_backend_interface* backend, vulkan_staging_ring* ring, vulkan_command_buffer* command_buffer, krenderbuffer dedicated_buffer) {
+	vulkan_context* context = (vulkan_context*)backend->internal_context;
+	return vulkan_staging_upload_submit_queue(backend, ring, context->device.graphics_queue, context->device.graphics_command_pool, command_buffer, dedicated_buffer, 0, 0, 0);
+}
+
+b8 vulkan_staging_upload_submit_queue(
+	renderer_backend_interface* backend,
+	vulkan_staging_ring* ring,
+	VkQueue queue,
+	VkCommandPool command_pool,
+	vulkan_command_buffer* command_buffer,
+	krenderbuffer dedicated_buffer,
+	VkSemaphore timeline,
+	u64 wait_value,
+	u64 signal_value) {
+	vulkan_context* context = (vulkan_context*)backend->internal_context;
+	krhi_vulkan* rhi = &context->rhi;
+
+	// The upload is not waited on, so make all later work (in this or any later submission) wait on its writes.
+	VkMemoryBarrier barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+	rhi->kvkCmdPipelineBarrier(
+		command_buffer->handle,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+		0, 1, &barrier, 0, 0, 0, 0);
+
+	vulkan_command_buffer_end(context, command_buffer);
+
+	VkFence fence = 0;
+	VkFenceCreateInfo fence_create_info = {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+	VK_CHECK(rhi->kvkCreateFence(context->device.logical_device, &fence_create_info, context->allocator, &fence));
+
+	vulkan_staging_submission submission = {0};
+	submission.fence = fence;
+	submission.owns_fence = true;
+	submission.command_buffer = *command_buffer;
+	submission.command_pool = command_pool;
+	submission.dedicated_buffer = dedicated_buffer;
+
+	// The timeline semaphore, if given, may be waited on before the upload begins and/or signalled once it completes.
+	VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+	VkTimelineSemaphoreSubmitInfo timeline_info = {VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
+	timeline_info.waitSemaphoreValueCount = (timeline && wait_value) ? 1 : 0;
+	timeline_info.pWaitSemaphoreValues = &wait_value;
+	timeline_info.signalSemaphoreValueCount = (timeline && signal_value) ? 1 : 0;
+	timeline_info.pSignalSemaphoreValues = &signal_value;
+
+	if (!vulkan_command_buffer_submit(
+			context, command_buffer, queue,
+			timeline_info.signalSemaphoreValueCount, &timeline,
+			timeline_info.waitSemaphoreValueCount, &timeline, &wait_stage,
+			timeline ? &timeline_info : 0,
+			fence)) {
+		KERROR("Failed to submit staging upload.");
+		// Nothing was submitted, so the fence would never be signalled. Any ring space used is
+		// left unretired, and is handed back along with whatever is retired next.
+		submission_release(backend, &submission);
+		return false;
+	}
+
+	if (!ring) {
+		// Nowhere to track the upload, so wait for it instead.
+		VkResult result = rhi->kvkWaitForFences(context->device.logical_device, 1, &fence, true, U64_MAX);
+		if (!vulkan_result_is_success(result)) {
+			KERROR("Failed to wait on staging upload: %s", vulkan_result_string(result, true));
+		}
+		submission_release(backend, &submission);
+		return vulkan_result_is_success(result);
+	}
+
+	submission_push(ring, fence, &submission.command_buffer, command_pool, dedicated_buffer);
+	return true;
+}
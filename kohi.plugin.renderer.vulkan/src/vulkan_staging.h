@@ -0,0 +1,127 @@
+/**
+ * @file vulkan_staging.h
+ * @brief This file contains a ring-allocated staging buffer used to upload data to
+ * GPU-only buffers and images.
+ *
+ * @details
+ * Each window owns a single, fixed-size staging ring which is shared by all frames in
+ * flight. Every allocation is retired against a fence right after it is made: either
+ * the current frame's in-flight fence when the copy is part of the frame workload,
+ * or the fence of a single-use submission otherwise. Space is then reclaimed in
+ * allocation order as those fences are signalled, so uploads never need to wait on
+ * the queue unless the ring is full.
+ */
+
+#pragma once
+
+#include "vulkan_types.h"
+
+/**
+ * @brief Creates a staging ring of the given size.
+ *
+ * @param backend A pointer to the renderer backend interface.
+ * @param name The name of the underlying staging buffer.
+ * @param capacity The size of the ring in bytes.
+ * @param out_ring A pointer to hold the newly created ring.
+ * @return True on success; otherwise false.
+ */
+b8 vulkan_staging_ring_create(renderer_backend_interface* backend, kname name, u64 capacity, vulkan_staging_ring* out_ring);
+
+/**
+ * @brief Destroys the given staging ring, along with anything held by its submissions.
+ * The device must be idle.
+ *
+ * @param backend A pointer to the renderer backend interface.
+ * @param ring A pointer to the ring to destroy.
+ */
+void vulkan_staging_ring_destroy(renderer_backend_interface* backend, vulkan_staging_ring* ring);
+
+/**
+ * @brief Releases the space of all submissions whose fences have been signalled,
+ * oldest first. Stops at the first which has not.
+ *
+ * @param backend A pointer to the renderer backend interface.
+ * @param ring A pointer to the ring to reclaim space in.
+ */
+void vulkan_staging_ring_reclaim(renderer_backend_interface* backend, vulkan_staging_ring* ring);
+
+/**
+ * @brief Allocates space from the given staging ring, reclaiming space first if needed.
+ * Never waits. The space must be retired before anything else is allocated.
+ *
+ * @param backend A pointer to the renderer backend interface.
+ * @param ring A pointer to the ring to allocate from.
+ * @param size The size of the allocation in bytes.
+ * @param alignment The alignment of the allocation's offset. Must be a power of 2.
+ * @param out_offset A pointer to hold the offset of the allocation within the ring's buffer.
+ * @return A pointer to the mapped memory of the allocation if there is room; otherwise 0.
+ */
+u8* vulkan_staging_ring_allocate(renderer_backend_interface* backend, vulkan_staging_ring* ring, u64 size, u64 alignment, u64* out_offset);
+
+/**
+ * @brief Marks all space allocated since the last retirement as in use until the given fence is signalled.
+ *
+ * @param ring A pointer to the ring whose allocations to retire.
+ * @param fence The fence which is signalled once the GPU is done with the space.
+ */
+void vulkan_staging_ring_retire(vulkan_staging_ring* ring, VkFence fence);
+
+/**
+ * @brief Waits for the oldest submission of the given ring to complete, then reclaims space.
+ *
+ * @param backend A pointer to the renderer backend interface.
+ * @param ring A pointer to the ring to wait on.
+ * @param frame_fence The fence of the frame currently being recorded, which cannot be waited on since it has not yet been submitted.
+ * @return True if a submission was waited on; false if there was nothing which could be waited on.
+ */
+b8 vulkan_staging_ring_wait_oldest(renderer_backend_interface* backend, vulkan_staging_ring* ring, VkFence frame_fence);
+
+/**
+ * @brief Allocates and begins a single-use command buffer for an upload outside of the frame workload.
+ * Commands recorded afterward wait on all earlier work on the queue.
+ *
+ * @param context A pointer to the Vulkan context.
+ * @param command_pool The pool to allocate the command buffer from, which determines the queue it may be submitted to.
+ * @param out_command_buffer A pointer to hold the command buffer.
+ */
+void vulkan_staging_upload_begin(vulkan_context* context, VkCommandPool command_pool, vulkan_command_buffer* out_command_buffer);
+
+/**
+ * @brief Ends and submits the given upload command buffer to the graphics queue without waiting on it. Later
+ * work is made to wait on the upload's writes. All space allocated from the ring since
+ * the last retirement, the command buffer and dedicated_buffer (if provided) are released
+ * once the upload completes.
+ *
+ * @param backend A pointer to the renderer backend interface.
+ * @param ring A pointer to the ring the upload was staged in. If 0, waits for the upload to complete.
+ * @param command_buffer A pointer to the command buffer from vulkan_staging_upload_begin. Owned by the ring afterward.
+ * @param dedicated_buffer A staging buffer created just for this upload, or KRENDERBUFFER_INVALID.
+ * @return True on success; otherwise false.
+ */
+b8 vulkan_staging_upload_submit(renderer_backend_interface* backend, vulkan_staging_ring* ring, vulkan_command_buffer* command_buffer, krenderbuffer dedicated_buffer);
+
+/**
+ * @brief As vulkan_staging_upload_submit, but to the given queue, optionally waiting on
+ * and/or signalling a timeline semaphore.
+ *
+ * @param backend A pointer to the renderer backend interface.
+ * @param ring A pointer to the ring the upload was staged in. If 0, waits for the upload to complete.
+ * @param queue The queue to submit to. Must belong to the family of command_pool.
+ * @param command_pool The pool the command buffer was allocated from.
+ * @param command_buffer A pointer to the command buffer from vulkan_staging_upload_begin. Owned by the ring afterward.
+ * @param dedicated_buffer A staging buffer created just for this upload, or KRENDERBUFFER_INVALID.
+ * @param timeline A timeline semaphore, or 0 if none.
+ * @param wait_value The value of the timeline to wait on before the upload begins, or 0 to not wait.
+ * @param signal_value The value to signal the timeline with once the upload completes, or 0 to not signal.
+ * @return True on success; otherwise false.
+ */
+b8 vulkan_staging_upload_submit_queue(
+	renderer_backend_interface* backend,
+	vulkan_staging_ring* ring,
+	VkQueue queue,
+	VkCommandPool command_pool,
+	vulkan_command_buffer* command_buffer,
+	krenderbuffer dedicated_buffer,
+	VkSemaphore timeline,
+	u64 wait_value,
+	u64 signal_value);
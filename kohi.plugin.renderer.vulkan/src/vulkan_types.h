@@ -14,6 +14,7 @@
 
 #include <vulkan/vulkan.h>
 
+#include "containers/hashmap.h"
 #include "core_render_types.h"
 #include "debug/kassert.h"
 #include "defines.h"
@@ -98,7 +99,13 @@ typedef enum vulkan_device_support_flag_bits {
 
 	/** @brief Indicates if this device supports dynamic state. If not, the renderer will need to generate a separate pipeline per topology type. */
 	VULKAN_DEVICE_SUPPORT_FLAG_DYNAMIC_STATE_BIT = 0x02,
-	VULKAN_DEVICE_SUPPORT_FLAG_LINE_SMOOTH_RASTERISATION_BIT = 0x04
+	VULKAN_DEVICE_SUPPORT_FLAG_LINE_SMOOTH_RASTERISATION_BIT = 0x04,
+
+	/** @brief Indicates if the device can issue several indirect draws at once, with a nonzero first instance. If not, indirect draws are issued directly instead. */
+	VULKAN_DEVICE_SUPPORT_FLAG_MULTI_DRAW_INDIRECT_BIT = 0x08,
+
+	/** @brief Indicates if the device supports timeline semaphores. If not, uploads are performed on the graphics queue instead of the transfer queue. */
+	VULKAN_DEVICE_SUPPORT_FLAG_TIMELINE_SEMAPHORE_BIT = 0x10
 } vulkan_device_support_flag_bits;
 
 /** @brief Bitwise flags for device support. @see vulkan_device_support_flag_bits. */
@@ -144,6 +151,8 @@ typedef struct vulkan_device {
 
 	/** @brief A handle to a command pool for graphics operations. */
 	VkCommandPool graphics_command_pool;
+	/** @brief A handle to a command pool for operations on the transfer queue. */
+	VkCommandPool transfer_command_pool;
 
 	/** @brief The physical device properties. */
 	VkPhysicalDeviceProperties properties;
@@ -597,6 +606,126 @@ typedef struct vulkan_shader {
 // Forward declare shaderc compiler.
 struct shaderc_compiler;
 
+/**
+ * @brief A compiled shader stage held by the shader cache.
+ */
+typedef struct vulkan_spirv_cache_entry {
+	/** @brief Identifies the stage's source text and compile settings. */
+	u64 key;
+	/** @brief The length of the source text. Guards against key collisions. */
+	u64 source_length;
+	/** @brief The size of the SPIR-V code in bytes. */
+	u32 code_size;
+	/** @brief The SPIR-V code. */
+	u32* code;
+	/** @brief Indicates if the entry was used this run. Unused entries are dropped when the cache is saved. */
+	b8 used;
+} vulkan_spirv_cache_entry;
+
+/**
+ * @brief Caches compiled SPIR-V and pipelines across runs, so warm starts and
+ * reloads of unchanged shaders skip compilation.
+ */
+typedef struct vulkan_shader_cache {
+	/** @brief Used for the creation of all pipelines. Persisted to disk on shutdown. */
+	VkPipelineCache pipeline_cache;
+	/** @brief Maps SPIR-V cache keys to indices into spirv_entries. */
+	hashmap spirv_lookup;
+	/** @brief darray of compiled stages. */
+	vulkan_spirv_cache_entry* spirv_entries;
+	/** @brief Indicates if any stage was compiled this run, and thus the SPIR-V cache needs saving. */
+	b8 spirv_dirty;
+} vulkan_shader_cache;
+
+/**
+ * @brief A span of a staging ring which may be reused once its fence is signalled.
+ */
+typedef struct vulkan_staging_submission {
+	/** @brief The ring offset just past the end of the span. */
+	u64 end;
+	/** @brief The size of the span in bytes, including any skipped when wrapping. */
+	u64 size;
+	/** @brief Signalled once the GPU is done reading from the span. */
+	VkFence fence;
+	/** @brief Indicates if the fence and command buffer belong to this submission, and are to be destroyed along with it. */
+	b8 owns_fence;
+	/** @brief The single-use command buffer which performed the upload, if owned. */
+	vulkan_command_buffer command_buffer;
+	/** @brief The pool the command buffer was allocated from, if owned. */
+	VkCommandPool command_pool;
+	/** @brief A dedicated staging buffer for an upload too large for the ring, destroyed along with the submission. */
+	krenderbuffer dedicated_buffer;
+} vulkan_staging_submission;
+
+/**
+ * @brief A fixed-size staging buffer which is allocated from in a ring. Space is
+ * reclaimed in allocation order as the fences of the uploads using it are signalled.
+ */
+typedef struct vulkan_staging_ring {
+	/** @brief The underlying staging buffer, which is persistently mapped. */
+	krenderbuffer buffer;
+	/** @brief The mapped memory of the buffer. */
+	u8* mapped_memory;
+	/** @brief The size of the buffer in bytes. */
+	u64 capacity;
+	/** @brief The offset the next allocation is made from. */
+	u64 head;
+	/** @brief The offset of the oldest span still in use. */
+	u64 tail;
+	/** @brief The number of bytes in use, including those not yet retired. */
+	u64 used;
+	/** @brief The number of bytes allocated since the last retirement. */
+	u64 unretired;
+	/** @brief darray of retired spans, oldest first. */
+	vulkan_staging_submission* submissions;
+} vulkan_staging_ring;
+
+/**
+ * @brief A buffer range or texture image written on the transfer queue, which must be
+ * handed over to the graphics queue before it can be used.
+ */
+typedef struct vulkan_upload_target {
+	/** @brief The texture written, or INVALID_KTEXTURE if a renderbuffer was written. */
+	ktexture texture;
+	/** @brief The index of the texture image written. */
+	u32 image_index;
+	/** @brief The renderbuffer written, or KRENDERBUFFER_INVALID if a texture was written. */
+	krenderbuffer buffer;
+	/** @brief The barrier acquiring the buffer range on the graphics queue. Used for renderbuffers. */
+	VkBufferMemoryBarrier buffer_barrier;
+	/** @brief The barrier acquiring the image on the graphics queue. Used for textures. */
+	VkImageMemoryBarrier image_barrier;
+} vulkan_upload_target;
+
+/**
+ * @brief A group of uploads recorded to a single transfer queue submission.
+ */
+typedef struct vulkan_upload_batch {
+	/** @brief The value the upload timeline semaphore is signalled with once the batch completes. */
+	u64 timeline_value;
+	/** @brief The id of the last upload in the batch. */
+	u64 last_upload_id;
+	/** @brief darray of everything written by the batch. */
+	vulkan_upload_target* targets;
+	/** @brief Indicates if the batch's staging memory is a dedicated buffer, in which case nothing more can be added to it. */
+	b8 has_dedicated_buffer;
+} vulkan_upload_batch;
+
+/**
+ * @brief Uploads performed on the transfer queue, in submission order. Completion is
+ * tracked with a timeline semaphore, whose value is raised by each batch in turn.
+ */
+typedef struct vulkan_upload_queue {
+	/** @brief The timeline semaphore signalled by upload batches. 0 if not supported, in which case uploads are performed immediately. */
+	VkSemaphore timeline;
+	/** @brief The timeline value used by the most recently submitted batch. */
+	u64 timeline_value;
+	/** @brief darray of submitted batches not yet handed over to the graphics queue, oldest first. */
+	vulkan_upload_batch* batches;
+	/** @brief The id of the last upload which has completed and been handed over to the graphics queue. */
+	u64 completed_upload_id;
+} vulkan_upload_queue;
+
 /**
  * @brief The Vulkan-specific backend window state.
  *
@@ -636,8 +765,8 @@ typedef struct kwindow_renderer_backend_state {
 	 */
 	VkFence* in_flight_fences;
 
-	/** @brief Resusable staging buffers (one per frame in flight) to transfer data from a resource to a GPU-only buffer. */
-	krenderbuffer* staging;
+	/** @brief The staging ring used to transfer data from a resource to a GPU-only buffer or image. Shared by all frames in flight. */
+	vulkan_staging_ring staging;
 
 	/**
 	 * @brief Array of darrays of handles to textures that were updated as part of a frame's workload.
@@ -771,4 +900,10 @@ typedef struct vulkan_context {
 	 * Used for dynamic compilation of vulkan shaders (using the shaderc lib.)
 	 */
 	struct shaderc_compiler* shader_compiler;
+
+	/** @brief Persistent caches of compiled shader stages and pipelines. */
+	vulkan_shader_cache shader_cache;
+
+	/** @brief Uploads in progress on the transfer queue. */
+	vulkan_upload_queue uploads;
 } vulkan_context;
@@ -6,6 +6,14 @@ struct animation_skin_data {
     mat4 bones[KANIMATION_SSBO_MAX_BONES_PER_MESH];
 };
 
+struct instance_data {
+    uint transform_index;
+    uint animation_index;
+    uint num_p_lights;
+    uint padding;
+    uvec2 packed_point_light_indices;
+};
+
 // =========================================================
 // Inputs
 // =========================================================
@@ -37,14 +45,21 @@ layout(std430, set = 0, binding = 2) readonly buffer global_animations_ssbo {
     animation_skin_data animations[]; // indexed by immediate.animation_index;
 } global_animations;
 
+// Per-instance data for instanced draws
+layout(std430, set = 0, binding = 3) readonly buffer global_instances_ssbo {
+    instance_data instances[]; // indexed by gl_InstanceIndex when immediate.instanced is set
+} global_instances;
+
 
 // Immediate data
 layout(push_constant) uniform immediate_data {
     uint transform_index;
+    uint instanced; // If nonzero, the transform index comes from global_instances
 } immediate;
 
 void main() {
-    mat4 model = global_transforms.transforms[immediate.transform_index];
+    uint transform_index = immediate.instanced != 0 ? global_instances.instances[gl_InstanceIndex].transform_index : immediate.transform_index;
+    mat4 model = global_transforms.transforms[transform_index];
     mat4 view = global_settings.view;
     mat4 projection = global_settings.projection;
 
@@ -188,7 +188,8 @@ layout(push_constant) uniform immediate_data {
     // bytes 64-79
     uint transform_index;
     uint geo_type; // 0=static, 1=animated
-    vec2 padding;
+    uint instanced; // If nonzero, transform, animation and point light data come from global_instances
+    float padding;
     // 80-128 available
 } immediate;
 
@@ -205,6 +206,9 @@ layout(location = 0) in dto {
 	vec2 tex_coord;
 } in_dto;
 
+// Point lights bound to the geometry, resolved per instance by the vertex shader. x = count, yz = packed indices.
+layout(location = 12) flat in uvec3 in_point_lights;
+
 // =========================================================
 // Outputs
 // =========================================================
@@ -523,13 +527,13 @@ void main() {
         }
 
         // Point light radiance
-        // Get point light indices by unpacking each element of immediate.packed_point_light_indices
+        // Get point light indices by unpacking each packed element of in_point_lights
         uint plights_rendered = 0;
-        for(uint ppli = 0; ppli < 2 && plights_rendered < immediate.num_p_lights; ++ppli) {
-            uint packed = immediate.packed_point_light_indices[ppli];
+        for(uint ppli = 0; ppli < 2 && plights_rendered < in_point_lights.x; ++ppli) {
+            uint packed = in_point_lights[1 + ppli];
             uint unpacked[4];
             unpack_u32_u8s(packed, unpacked[0], unpacked[1], unpacked[2], unpacked[3]);
-            for(uint upi = 0; upi < 4 && plights_rendered < immediate.num_p_lights; ++upi) {
+            for(uint upi = 0; upi < 4 && plights_rendered < in_point_lights.x; ++upi) {
                 light_data light = global_lighting.lights[unpacked[upi]];
                 vec3 light_direction = normalize(light.position.xyz - in_dto.frag_position.xyz);
                 vec3 radiance = calculate_point_light_radiance(light, view_direction, in_dto.frag_position.xyz);
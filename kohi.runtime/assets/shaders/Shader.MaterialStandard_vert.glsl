@@ -48,6 +48,15 @@ struct animation_skin_data {
     mat4 bones[KANIMATION_SSBO_MAX_BONES_PER_MESH];
 };
 
+struct instance_data {
+    uint transform_index;
+    uint animation_index;
+    uint num_p_lights;
+    uint padding;
+    // Index into the global point lights array. Up to 8 indices as u8s packed into 2 uints.
+    uvec2 packed_point_light_indices;
+};
+
 // =========================================================
 // Inputs
 // =========================================================
@@ -108,6 +117,11 @@ layout(std430, set = 0, binding = 4) readonly buffer global_animations_ssbo {
     animation_skin_data animations[]; // indexed by immediate.animation_index;
 } global_animations;
 
+// Per-instance data for instanced draws
+layout(std430, set = 0, binding = 9) readonly buffer global_instances_ssbo {
+    instance_data instances[]; // indexed by gl_InstanceIndex when immediate.instanced is set
+} global_instances;
+
 
 // Immediate data
 layout(push_constant) uniform immediate_data {
@@ -136,7 +150,8 @@ layout(push_constant) uniform immediate_data {
     // bytes 64-79
     uint transform_index;
     uint geo_type; // 0=static, 1=animated
-    vec2 padding;
+    uint instanced; // If nonzero, transform, animation and point light data come from global_instances
+    float padding;
     // 80-128 available
 } immediate;
 
@@ -157,6 +172,9 @@ layout(location = 0) out dto {
 	vec2 tex_coord;
 } out_dto;
 
+// Point lights bound to the geometry. x = count, yz = packed indices.
+layout(location = 12) flat out uvec3 out_point_lights;
+
 /** 
  * Used to convert from NDC -> UVW by taking the x/y components and transforming them:
  * 
@@ -170,7 +188,17 @@ const mat4 ndc_to_uvw = mat4(
 );
 
 void main() {
-    mat4 model = global_transforms.transforms[immediate.transform_index];
+    uint transform_index = immediate.transform_index;
+    uint animation_index = immediate.animation_index;
+    out_point_lights = uvec3(immediate.num_p_lights, immediate.packed_point_light_indices);
+    if(immediate.instanced != 0) {
+        instance_data instance = global_instances.instances[gl_InstanceIndex];
+        transform_index = instance.transform_index;
+        animation_index = instance.animation_index;
+        out_point_lights = uvec3(instance.num_p_lights, instance.packed_point_light_indices);
+    }
+
+    mat4 model = global_transforms.transforms[transform_index];
     mat4 view = global_settings.views[immediate.view_index];
     mat4 projection = global_settings.projections[immediate.projection_index];
     base_material_data base_material = global_materials.base_materials[immediate.base_material_index];
@@ -34,6 +34,7 @@ layout(push_constant) uniform immediate_data {
     uint cascade_index;
     uint animation_index;
     uint geo_type; // 0=static, 1=animaten
+    uint instanced; // If nonzero, transform and animation indices come from global_instances
 } immediate;
 
 // Data Transfer Object from vertex shader
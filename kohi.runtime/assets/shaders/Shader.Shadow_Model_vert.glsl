@@ -8,6 +8,14 @@ struct animation_skin_data {
     mat4 bones[KANIMATION_SSBO_MAX_BONES_PER_MESH];
 };
 
+struct instance_data {
+    uint transform_index;
+    uint animation_index;
+    uint num_p_lights;
+    uint padding;
+    uvec2 packed_point_light_indices;
+};
+
 // =========================================================
 // Inputs
 // =========================================================
@@ -35,11 +43,17 @@ layout(std430, set = 0, binding = 2) readonly buffer global_animations_ssbo {
     animation_skin_data animations[]; // indexed by immediate.animation_index;
 } global_animations;
 
+// Per-instance data for instanced draws
+layout(std430, set = 0, binding = 3) readonly buffer global_instances_ssbo {
+    instance_data instances[]; // indexed by gl_InstanceIndex when immediate.instanced is set
+} global_instances;
+
 layout(push_constant) uniform immediate_data {
     uint transform_index;
     uint cascade_index;
     uint animation_index;
     uint geo_type; // 0=static, 1=animated
+    uint instanced; // If nonzero, transform and animation indices come from global_instances
 } immediate;
 
 // =========================================================
@@ -52,7 +66,14 @@ layout(location = 1) out struct dto {
 } out_dto;
 
 void main() {
-    mat4 model = global_transforms.transforms[immediate.transform_index];
+    uint transform_index = immediate.transform_index;
+    uint animation_index = immediate.animation_index;
+    if(immediate.instanced != 0) {
+        transform_index = global_instances.instances[gl_InstanceIndex].transform_index;
+        animation_index = global_instances.instances[gl_InstanceIndex].animation_index;
+    }
+
+    mat4 model = global_transforms.transforms[transform_index];
     out_dto.tex_coord = in_texcoord;
 
     gl_Position = global_ubo.view_projections[immediate.cascade_index] * model * vec4(in_position, 1.0);
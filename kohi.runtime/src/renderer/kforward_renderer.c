@@ -2,6 +2,7 @@
 
 #include <core/engine.h>
 #include <core/frame_data.h>
+#include <core/kvar.h>
 #include <core_render_types.h>
 #include <debug/kassert.h>
 #include <defines.h>
@@ -45,6 +46,8 @@ typedef struct shadow_staticmesh_immediate_data {
 	u32 cascade_index;
 	u32 animation_index;
 	u32 geo_type; // 0=static, 1=animated
+	// If nonzero, transform and animation indices are instead taken from the instance storage buffer.
+	u32 instanced;
 } shadow_staticmesh_immediate_data;
 
 typedef struct world_debug_global_ubo {
@@ -73,8 +76,20 @@ typedef struct depth_prepass_global_ubo {
 
 typedef struct depth_prepass_immediate_data {
 	u32 transform_index;
+	// If nonzero, the transform index is instead taken from the instance storage buffer.
+	u32 instanced;
 } depth_prepass_immediate_data;
 
+// A group of identical geometries (same vertex/index data, material instance and winding), drawn with a single instanced draw.
+typedef struct geometry_instance_group {
+	// The first geometry of the group, whose draw data is shared by all of it.
+	const kgeometry_render_data* geo;
+	// The number of instances in the group.
+	u32 instance_count;
+	// The instance index of the group's first instance, or INVALID_ID if the group is drawn without instancing.
+	u32 first_instance;
+} geometry_instance_group;
+
 b8 kforward_renderer_create(ktexture colour_buffer, ktexture depth_stencil_buffer, kforward_renderer* out_renderer) {
 	KASSERT_DEBUG(out_renderer);
 
@@ -90,6 +105,20 @@ b8 kforward_renderer_create(ktexture colour_buffer, ktexture depth_stencil_buffe
 	out_renderer->standard_vertex_buffer = renderer_renderbuffer_get(out_renderer->renderer_state, kname_create(KRENDERBUFFER_NAME_VERTEX_STANDARD));
 	out_renderer->index_buffer = renderer_renderbuffer_get(out_renderer->renderer_state, kname_create(KRENDERBUFFER_NAME_INDEX_STANDARD));
 
+	if (!hashmap_create(sizeof(u32), 256, &out_renderer->instance_group_lookup)) {
+		KERROR("Failed to create instance group lookup.");
+		return false;
+	}
+
+	out_renderer->indirect_capacity = KFORWARD_DEFAULT_INDIRECT_CAPACITY;
+	out_renderer->indirect_buffer = renderer_renderbuffer_create(out_renderer->renderer_state, kname_create(KRENDERBUFFER_NAME_FORWARD_INDIRECT), RENDERBUFFER_TYPE_INDIRECT, sizeof(renderer_indexed_indirect_command) * out_renderer->indirect_capacity, RENDERBUFFER_TRACK_TYPE_NONE, RENDERBUFFER_FLAG_AUTO_MAP_MEMORY_BIT | RENDERBUFFER_FLAG_TRIPLE_BUFFERED_BIT);
+	if (out_renderer->indirect_buffer == KRENDERBUFFER_INVALID) {
+		KERROR("Failed to create indirect draw buffer.");
+		return false;
+	}
+	// Indirect draws can be turned off at runtime, i.e. to compare against direct draws.
+	kvar_i32_set("use_indirect_draws", 0, 1);
+
 	// Shadow pass data
 	{
 		// Default shadowmap resolution. // TODO: configurable
@@ -184,99 +213,407 @@ b8 kforward_renderer_create(ktexture colour_buffer, ktexture depth_stencil_buffe
 void kforward_renderer_destroy(kforward_renderer* renderer) {
 	if (renderer) {
 		KFREE_TYPE_CARRAY(renderer->shadow_pass.sm_set1_instance_ids, u32, renderer->shadow_pass.sm_set1_max_instances);
+		hashmap_destroy(&renderer->instance_group_lookup);
+		renderer_renderbuffer_destroy(renderer->renderer_state, renderer->indirect_buffer);
 	}
 }
 
-static void draw_geo_list(kforward_renderer* renderer, frame_data* p_frame_data, kdirectional_light_data directional_light, u32 view_index, vec4 clipping_plane, u32 meshes_by_material_count, kmaterial_render_data* meshes_by_material) {
-	for (u32 m = 0; m < meshes_by_material_count; ++m) {
-		kmaterial_render_data* material = &meshes_by_material[m];
+static u64 geometry_instance_key(const kgeometry_render_data* geo) {
+	// Only needs to spread the tuple well, since the tuple itself is compared before geometries are grouped.
+	u64 key = geo->vertex_offset;
+	key = (key * 0x9E3779B97F4A7C15ull) ^ geo->index_offset;
+	key = (key * 0x9E3779B97F4A7C15ull) ^ geo->material_instance_id;
+	key = (key << 2) | ((u64)(geo->animation_id != INVALID_ID_U16) << 1) | (u64)FLAG_GET(geo->flags, KGEOMETRY_RENDER_DATA_FLAG_WINDING_INVERTED_BIT);
+	return key;
+}
 
-		// Apply base-material-level (i.e. group-level) data.
-		kmaterial_renderer_bind_base(renderer->material_renderer, material->base_material);
+static b8 geometry_instance_matches(const kgeometry_render_data* a, const kgeometry_render_data* b) {
+	return a->vertex_offset == b->vertex_offset &&
+		   a->vertex_count == b->vertex_count &&
+		   a->index_offset == b->index_offset &&
+		   a->index_count == b->index_count &&
+		   a->material_instance_id == b->material_instance_id &&
+		   (a->animation_id != INVALID_ID_U16) == (b->animation_id != INVALID_ID_U16) &&
+		   FLAG_GET(a->flags, KGEOMETRY_RENDER_DATA_FLAG_WINDING_INVERTED_BIT) == FLAG_GET(b->flags, KGEOMETRY_RENDER_DATA_FLAG_WINDING_INVERTED_BIT);
+}
 
-		// Each geometry
-		for (u32 g = 0; g < material->geometry_count; ++g) {
-			kgeometry_render_data* geo = &material->geometries[g];
+/**
+ * Groups identical geometries of the given list, and writes the per-instance data of each
+ * group contiguously into this frame's instance storage buffer. Groups are ordered by their
+ * first geometry. If cascade_mask is nonzero, only geometries within those cascades are included.
+ * If the instance buffer is full, every geometry gets a group of its own, drawn without instancing.
+ * Returns the number of groups. The groups themselves are allocated from the frame allocator.
+ */
+static u32 geometry_groups_build(kforward_renderer* renderer, frame_data* p_frame_data, u32 geometry_count, const kgeometry_render_data* geometries, u8 cascade_mask, geometry_instance_group** out_groups) {
+	*out_groups = 0;
+	if (!geometry_count) {
+		return 0;
+	}
 
-			kmaterial_instance inst = {
-				.base_material = material->base_material,
-				.instance_id = geo->material_instance_id};
+	geometry_instance_group* groups = p_frame_data->allocator.allocate(sizeof(geometry_instance_group) * geometry_count);
+	// The group of each geometry, or INVALID_ID for those not included.
+	u32* geometry_groups = p_frame_data->allocator.allocate(sizeof(u32) * geometry_count);
 
-			b8 is_animated = geo->animation_id != INVALID_ID_U16;
-			kmaterial_renderer_set_animated(renderer->material_renderer, is_animated);
+	hashmap* lookup = &renderer->instance_group_lookup;
+	hashmap_clear(lookup);
 
-			kmaterial_render_immediate_data immediate_data = {
-				.view_index = view_index,
-				.projection_index = 0, // FIXME: Pass in projection_index
-				.animation_index = is_animated ? geo->animation_id : 0,
-				.base_material_index = material->base_material,
-				.dir_light_index = directional_light.light,
-				.irradiance_cubemap_index = 0, // TODO: pass in irradiance_cubemap_index from scene data
-				.num_p_lights = geo->bound_point_light_count,
-				.transform_index = geo->transform,
-				.clipping_plane = clipping_plane,
-				.geo_type = (u32)is_animated};
+	u32 group_count = 0;
+	u32 included_count = 0;
+	for (u32 i = 0; i < geometry_count; ++i) {
+		const kgeometry_render_data* geo = &geometries[i];
+		if (cascade_mask && !(geo->cascade_mask & cascade_mask)) {
+			geometry_groups[i] = INVALID_ID;
+			continue;
+		}
+		included_count++;
+
+		u64 key = geometry_instance_key(geo);
+		u32 group_index = INVALID_ID;
+		hashmap_u64_get(lookup, key, &group_index);
+		if (group_index == INVALID_ID || !geometry_instance_matches(groups[group_index].geo, geo)) {
+			// NOTE: A different tuple with the same key (rare) takes over the lookup entry, which only costs some grouping.
+			group_index = group_count++;
+			groups[group_index] = (geometry_instance_group){.geo = geo, .instance_count = 0, .first_instance = INVALID_ID};
+			hashmap_u64_set(lookup, key, &group_index);
+		}
+		groups[group_index].instance_count++;
+		geometry_groups[i] = group_index;
+	}
 
-			// Pack the point light indices
-			immediate_data.packed_point_light_indices.elements[0] = pack_u8_into_u32(geo->bound_point_light_indices[0], geo->bound_point_light_indices[1], geo->bound_point_light_indices[2], geo->bound_point_light_indices[3]);
-			immediate_data.packed_point_light_indices.elements[1] = pack_u8_into_u32(geo->bound_point_light_indices[4], geo->bound_point_light_indices[5], geo->bound_point_light_indices[6], geo->bound_point_light_indices[7]);
-			/* u8 written = 0;
-			for (u8 i = 0; i < 2 && written < geo->bound_point_light_count; ++i) {
-				u32 vi = 0;
+	u32 first_instance = 0;
+	kmaterial_render_instance_data* instances = kmaterial_renderer_instances_allocate(renderer->material_renderer, included_count, &first_instance);
+	if (!instances) {
+		// No room for instance data this frame. Draw each geometry on its own using immediates.
+		group_count = 0;
+		for (u32 i = 0; i < geometry_count; ++i) {
+			if (geometry_groups[i] != INVALID_ID) {
+				groups[group_count++] = (geometry_instance_group){.geo = &geometries[i], .instance_count = 1, .first_instance = INVALID_ID};
+			}
+		}
+		*out_groups = groups;
+		return group_count;
+	}
 
-				for (u8 p = 0; p < 4 && written < geo->bound_point_light_count; ++p) {
+	// Lay out each group's instances one after another, then fill them in.
+	u32 next_instance = first_instance;
+	for (u32 g = 0; g < group_count; ++g) {
+		groups[g].first_instance = next_instance;
+		next_instance += groups[g].instance_count;
+		groups[g].instance_count = 0;
+	}
+	for (u32 i = 0; i < geometry_count; ++i) {
+		if (geometry_groups[i] == INVALID_ID) {
+			continue;
+		}
+		const kgeometry_render_data* geo = &geometries[i];
+		geometry_instance_group* group = &groups[geometry_groups[i]];
+		kmaterial_render_instance_data* instance = &instances[(group->first_instance - first_instance) + group->instance_count];
+		group->instance_count++;
+
+		instance->transform_index = geo->transform;
+		instance->animation_index = geo->animation_id != INVALID_ID_U16 ? geo->animation_id : 0;
+		instance->num_p_lights = geo->bound_point_light_count;
+		instance->padding = 0;
+		instance->packed_point_light_indices.elements[0] = pack_u8_into_u32(geo->bound_point_light_indices[0], geo->bound_point_light_indices[1], geo->bound_point_light_indices[2], geo->bound_point_light_indices[3]);
+		instance->packed_point_light_indices.elements[1] = pack_u8_into_u32(geo->bound_point_light_indices[4], geo->bound_point_light_indices[5], geo->bound_point_light_indices[6], geo->bound_point_light_indices[7]);
+	}
 
-					// Pack the u8 into the given u32
-					vi |= ((u32)geo->bound_point_light_indices[p] << ((3 - p) * 8));
-					++written;
-				}
+	*out_groups = groups;
+	return group_count;
+}
 
-				// Store the packed u32
-				immediate_data.packed_point_light_indices.elements[i] = vi;
-			} */
+// Draws every instance of the given group. Shader, immediates and render state must already be set.
+static b8 geometry_group_draw(kforward_renderer* renderer, const geometry_instance_group* group) {
+	const kgeometry_render_data* geo = group->geo;
+	u32 first_instance = group->first_instance == INVALID_ID ? 0 : group->first_instance;
 
-			// Apply material-instance-level immediate data.
-			kmaterial_renderer_apply_immediates(renderer->material_renderer, inst, &immediate_data);
+	if (geo->index_count > 0) {
+		if (!renderer_renderbuffer_draw(renderer->renderer_state, renderer->standard_vertex_buffer, geo->vertex_offset, geo->vertex_count, 0, true)) {
+			KERROR("renderer_renderbuffer_draw failed to bind standard vertex buffer.");
+			return false;
+		}
+		return renderer_renderbuffer_draw_instanced(renderer->renderer_state, renderer->index_buffer, geo->index_offset, geo->index_count, group->instance_count, first_instance, 0);
+	}
 
-			// Invert winding if needed
-			b8 winding_inverted = FLAG_GET(geo->flags, KGEOMETRY_RENDER_DATA_FLAG_WINDING_INVERTED_BIT);
-			if (winding_inverted) {
-				renderer_winding_set(RENDERER_WINDING_CLOCKWISE);
-			}
+	return renderer_renderbuffer_draw_instanced(renderer->renderer_state, renderer->standard_vertex_buffer, geo->vertex_offset, geo->vertex_count, group->instance_count, first_instance, 0);
+}
 
-			// For double-sided materials, turn off backface culling.
-			b8 cull_disabled = false;
-			if (kmaterial_flag_get(engine_systems_get()->material_system, material->base_material, KMATERIAL_FLAG_DOUBLE_SIDED_BIT)) {
-				renderer_cull_mode_set(RENDERER_CULL_MODE_NONE);
-				cull_disabled = true;
-			}
+// Applies what a group's draw needs beyond the state shared by its list (i.e. immediates). Called for each group drawn
+// directly, and for the first group of each indirect batch on behalf of the whole batch.
+typedef void (*PFN_geometry_group_apply)(kforward_renderer* renderer, const geometry_instance_group* group, void* context);
+
+static void indirect_commands_begin(kforward_renderer* renderer) {
+	// Grow to fit the last frame's commands. Groups which didn't fit were simply drawn directly.
+	if (renderer->indirect_demand > renderer->indirect_capacity) {
+		u32 new_capacity = KMAX(renderer->indirect_capacity * 2, renderer->indirect_demand);
+		if (renderer_renderbuffer_resize(renderer->renderer_state, renderer->indirect_buffer, sizeof(renderer_indexed_indirect_command) * new_capacity)) {
+			renderer->indirect_capacity = new_capacity;
+		} else {
+			KERROR("Failed to resize the indirect draw buffer. Some groups will be drawn directly.");
+		}
+	}
 
-			// Draw it.
-			b8 includes_index_data = geo->index_count > 0;
+	renderer->indirect_count = 0;
+	renderer->indirect_demand = 0;
+	renderer->indirect_commands = renderer_renderbuffer_get_mapped_memory(renderer->renderer_state, renderer->indirect_buffer);
 
-			KASSERT_DEBUG_MSG(
-				renderer_renderbuffer_draw(renderer->renderer_state, renderer->standard_vertex_buffer, geo->vertex_offset, geo->vertex_count, 0, includes_index_data),
-				"renderer_renderbuffer_draw failed to draw vertex buffer");
+	i32 use_indirect_draws = 1;
+	kvar_i32_get("use_indirect_draws", &use_indirect_draws);
+	renderer->use_indirect_draws = use_indirect_draws != 0;
+}
+
+// Reserves room for count commands in this frame's indirect buffer. Returns 0 if there is no room.
+static renderer_indexed_indirect_command* indirect_commands_allocate(kforward_renderer* renderer, u32 count, u32* out_first_command) {
+	renderer->indirect_demand += count;
+	if (!renderer->indirect_commands || renderer->indirect_count + count > renderer->indirect_capacity) {
+		return 0;
+	}
+
+	*out_first_command = renderer->indirect_count;
+	renderer->indirect_count += count;
+	return renderer->indirect_commands + *out_first_command;
+}
+
+// Indirect commands locate geometry in whole vertices and indices from the start of the bound
+// buffers, so only instanced, indexed groups whose offsets fall on whole elements qualify.
+static b8 geometry_group_indirect_eligible(const geometry_instance_group* group) {
+	const kgeometry_render_data* geo = group->geo;
+	if (group->first_instance == INVALID_ID || !geo->index_count) {
+		return false;
+	}
+	u64 vertex_stride = geo->animation_id != INVALID_ID_U16 ? sizeof(skinned_vertex_3d) : sizeof(vertex_3d);
+	return (geo->vertex_offset % vertex_stride) == 0 &&
+		   (geo->vertex_offset / vertex_stride) <= I32_MAX &&
+		   (geo->index_offset % sizeof(u32)) == 0;
+}
+
+// Groups sharing a key can share an indirect draw, as they need the same vertex layout, winding and, if split, material instance.
+static u64 geometry_group_batch_key(const kgeometry_render_data* geo, b8 split_by_material_instance) {
+	u64 key = split_by_material_instance ? ((u64)geo->material_instance_id << 2) : 0;
+	return key | ((u64)(geo->animation_id != INVALID_ID_U16) << 1) | (u64)FLAG_GET(geo->flags, KGEOMETRY_RENDER_DATA_FLAG_WINDING_INVERTED_BIT);
+}
 
-			if (includes_index_data) {
-				KASSERT_DEBUG_MSG(
-					renderer_renderbuffer_draw(renderer->renderer_state, renderer->index_buffer, geo->index_offset, geo->index_count, 0, !includes_index_data),
-					"renderer_renderbuffer_draw failed to draw index buffer");
+/**
+ * Draws the given groups in order. Where enabled, eligible groups are gathered into batches which are each drawn with
+ * a single indirect draw, at the position of the batch's first group. All other groups are drawn directly. Winding is
+ * set per group (or batch), and apply is called before each draw. Returns false if any draw failed.
+ */
+static b8 geometry_groups_draw(kforward_renderer* renderer, frame_data* p_frame_data, u32 group_count, const geometry_instance_group* groups, b8 split_by_material_instance, PFN_geometry_group_apply apply, void* context) {
+	// The batch of each group, or INVALID_ID if drawn directly. No batches at all if 0.
+	u32* group_batches = 0;
+	// The first command of each batch relative to first_command, and the number of commands in it.
+	u32* batch_firsts = 0;
+	u32* batch_counts = 0;
+	u32 first_command = 0;
+
+	// Nothing is saved by drawing a lone group indirectly.
+	if (renderer->use_indirect_draws && group_count > 1) {
+		group_batches = p_frame_data->allocator.allocate(sizeof(u32) * group_count);
+		// There can be no more batches than groups.
+		batch_firsts = p_frame_data->allocator.allocate(sizeof(u32) * group_count);
+		batch_counts = p_frame_data->allocator.allocate(sizeof(u32) * group_count);
+
+		// Groups have been built already, so the lookup can be reused here.
+		hashmap* lookup = &renderer->instance_group_lookup;
+		hashmap_clear(lookup);
+
+		u32 batch_count = 0;
+		u32 eligible_count = 0;
+		for (u32 g = 0; g < group_count; ++g) {
+			group_batches[g] = INVALID_ID;
+			if (!geometry_group_indirect_eligible(&groups[g])) {
+				continue;
 			}
+			u64 key = geometry_group_batch_key(groups[g].geo, split_by_material_instance);
+			u32 batch = INVALID_ID;
+			if (!hashmap_u64_get(lookup, key, &batch)) {
+				batch = batch_count++;
+				batch_counts[batch] = 0;
+				hashmap_u64_set(lookup, key, &batch);
+			}
+			batch_counts[batch]++;
+			group_batches[g] = batch;
+			eligible_count++;
+		}
 
-			// Restore backface culling if needed
-			if (cull_disabled) {
-				renderer_cull_mode_set(RENDERER_CULL_MODE_BACK);
+		renderer_indexed_indirect_command* commands = eligible_count ? indirect_commands_allocate(renderer, eligible_count, &first_command) : 0;
+		if (!commands) {
+			// Nothing eligible, or no room for commands this frame. Draw everything directly.
+			group_batches = 0;
+		} else {
+			// Lay out each batch's commands one after another, then fill them in.
+			u32 next_command = 0;
+			for (u32 b = 0; b < batch_count; ++b) {
+				batch_firsts[b] = next_command;
+				next_command += batch_counts[b];
+				batch_counts[b] = 0;
 			}
+			for (u32 g = 0; g < group_count; ++g) {
+				u32 batch = group_batches[g];
+				if (batch == INVALID_ID) {
+					continue;
+				}
+				const geometry_instance_group* group = &groups[g];
+				const kgeometry_render_data* geo = group->geo;
+				u64 vertex_stride = geo->animation_id != INVALID_ID_U16 ? sizeof(skinned_vertex_3d) : sizeof(vertex_3d);
+				renderer_indexed_indirect_command* command = &commands[batch_firsts[batch] + batch_counts[batch]];
+				batch_counts[batch]++;
+
+				command->index_count = geo->index_count;
+				command->instance_count = group->instance_count;
+				command->first_index = (u32)(geo->index_offset / sizeof(u32));
+				command->vertex_offset = (i32)(geo->vertex_offset / vertex_stride);
+				command->first_instance = group->first_instance;
+			}
+		}
+	}
+
+	b8 result = true;
+	for (u32 g = 0; g < group_count; ++g) {
+		const geometry_instance_group* group = &groups[g];
+		u32 batch = group_batches ? group_batches[g] : INVALID_ID;
+		if (batch != INVALID_ID && !batch_counts[batch]) {
+			// Already drawn along with the rest of its batch.
+			continue;
+		}
+
+		apply(renderer, group, context);
 
-			// Change back if needed
-			if (winding_inverted) {
-				renderer_winding_set(RENDERER_WINDING_COUNTER_CLOCKWISE);
+		// Invert winding if needed
+		b8 winding_inverted = FLAG_GET(group->geo->flags, KGEOMETRY_RENDER_DATA_FLAG_WINDING_INVERTED_BIT);
+		if (winding_inverted) {
+			renderer_winding_set(RENDERER_WINDING_CLOCKWISE);
+		}
+
+		if (batch != INVALID_ID) {
+			// Commands address the whole buffers, so bind both from the start.
+			if (!renderer_renderbuffer_draw(renderer->renderer_state, renderer->standard_vertex_buffer, 0, 0, 0, true) ||
+				!renderer_renderbuffer_draw(renderer->renderer_state, renderer->index_buffer, 0, 0, 0, true)) {
+				KERROR("Failed to bind standard vertex and index buffers for indirect draw.");
+				result = false;
+			} else if (!renderer_renderbuffer_draw_indirect(renderer->renderer_state, renderer->indirect_buffer, sizeof(renderer_indexed_indirect_command) * (first_command + batch_firsts[batch]), batch_counts[batch])) {
+				KERROR("Failed to draw batch of %u geometry groups indirectly.", batch_counts[batch]);
+				result = false;
 			}
+			batch_counts[batch] = 0;
+		} else if (!geometry_group_draw(renderer, group)) {
+			KERROR("Failed to draw geometry group.");
+			result = false;
+		}
+
+		// Change back if needed
+		if (winding_inverted) {
+			renderer_winding_set(RENDERER_WINDING_COUNTER_CLOCKWISE);
+		}
+	}
+
+	return result;
+}
+
+typedef struct forward_group_apply_context {
+	kmaterial base_material;
+	kdirectional_light_data directional_light;
+	u32 view_index;
+	vec4 clipping_plane;
+	// Set for double-sided materials.
+	b8 cull_disabled;
+} forward_group_apply_context;
+
+static void forward_group_apply(kforward_renderer* renderer, const geometry_instance_group* group, void* context) {
+	const forward_group_apply_context* ctx = context;
+	const kgeometry_render_data* geo = group->geo;
+
+	kmaterial_instance inst = {
+		.base_material = ctx->base_material,
+		.instance_id = geo->material_instance_id};
+
+	b8 is_animated = geo->animation_id != INVALID_ID_U16;
+	kmaterial_renderer_set_animated(renderer->material_renderer, is_animated);
+
+	// NOTE: Transform, animation and point light data come from the instance buffer when instanced.
+	kmaterial_render_immediate_data immediate_data = {
+		.view_index = ctx->view_index,
+		.projection_index = 0, // FIXME: Pass in projection_index
+		.animation_index = is_animated ? geo->animation_id : 0,
+		.base_material_index = ctx->base_material,
+		.dir_light_index = ctx->directional_light.light,
+		.irradiance_cubemap_index = 0, // TODO: pass in irradiance_cubemap_index from scene data
+		.num_p_lights = geo->bound_point_light_count,
+		.transform_index = geo->transform,
+		.clipping_plane = ctx->clipping_plane,
+		.geo_type = (u32)is_animated,
+		.instanced = group->first_instance != INVALID_ID};
+
+	// Pack the point light indices
+	immediate_data.packed_point_light_indices.elements[0] = pack_u8_into_u32(geo->bound_point_light_indices[0], geo->bound_point_light_indices[1], geo->bound_point_light_indices[2], geo->bound_point_light_indices[3]);
+	immediate_data.packed_point_light_indices.elements[1] = pack_u8_into_u32(geo->bound_point_light_indices[4], geo->bound_point_light_indices[5], geo->bound_point_light_indices[6], geo->bound_point_light_indices[7]);
+
+	// Apply material-instance-level immediate data.
+	kmaterial_renderer_apply_immediates(renderer->material_renderer, inst, &immediate_data);
+
+	// For double-sided materials, turn off backface culling.
+	if (ctx->cull_disabled) {
+		renderer_cull_mode_set(RENDERER_CULL_MODE_NONE);
+	}
+}
+
+static void draw_geo_list(kforward_renderer* renderer, frame_data* p_frame_data, kdirectional_light_data directional_light, u32 view_index, vec4 clipping_plane, u32 meshes_by_material_count, kmaterial_render_data* meshes_by_material) {
+	for (u32 m = 0; m < meshes_by_material_count; ++m) {
+		kmaterial_render_data* material = &meshes_by_material[m];
+
+		// Apply base-material-level (i.e. group-level) data.
+		kmaterial_renderer_bind_base(renderer->material_renderer, material->base_material);
+
+		// Identical geometries are drawn together, instanced. Material instances are applied
+		// through immediates, so indirect batches can't span more than one.
+		geometry_instance_group* groups = 0;
+		u32 group_count = geometry_groups_build(renderer, p_frame_data, material->geometry_count, material->geometries, 0, &groups);
+		forward_group_apply_context context = {
+			.base_material = material->base_material,
+			.directional_light = directional_light,
+			.view_index = view_index,
+			.clipping_plane = clipping_plane,
+			.cull_disabled = kmaterial_flag_get(engine_systems_get()->material_system, material->base_material, KMATERIAL_FLAG_DOUBLE_SIDED_BIT)};
+		if (!geometry_groups_draw(renderer, p_frame_data, group_count, groups, true, forward_group_apply, &context)) {
+			KERROR("Failed to draw geometry groups.");
+		}
+
+		// Restore backface culling if needed
+		if (context.cull_disabled) {
+			renderer_cull_mode_set(RENDERER_CULL_MODE_BACK);
 		}
 	}
 }
 
+static void depth_prepass_group_apply(kforward_renderer* renderer, const geometry_instance_group* group, void* context) {
+	depth_prepass_immediate_data immediate_data = {
+		.transform_index = group->geo->transform,
+		.instanced = group->first_instance != INVALID_ID};
+
+	kshader_set_immediate_data(renderer->depth_prepass.depth_prepass_shader, &immediate_data, sizeof(immediate_data));
+}
+
+static void shadow_group_apply(kforward_renderer* renderer, const geometry_instance_group* group, void* context) {
+	u32 cascade_index = *(const u32*)context;
+	const kgeometry_render_data* geo_data = group->geo;
+
+	b8 is_animated = geo_data->animation_id != INVALID_ID_U16;
+
+	// Ensure the right vertex layout index is used.
+	kshader_system_use(renderer->shadow_pass.staticmesh_shader, is_animated ? VERTEX_LAYOUT_INDEX_SKINNED : VERTEX_LAYOUT_INDEX_STATIC);
+	renderer_cull_mode_set(RENDERER_CULL_MODE_NONE);
+
+	// Set immediate data.
+	shadow_staticmesh_immediate_data immediate_data = {
+		.transform_index = geo_data->transform,
+		.cascade_index = cascade_index,
+		.geo_type = (u32)is_animated,
+		.animation_index = is_animated ? geo_data->animation_id : 0,
+		.instanced = group->first_instance != INVALID_ID};
+
+	kshader_set_immediate_data(renderer->shadow_pass.staticmesh_shader, &immediate_data, sizeof(shadow_staticmesh_immediate_data));
+}
+
 static void set_render_state_defaults(rect_2di vp_rect) {
 	renderer_begin_debug_label("frame defaults", vec3_zero());
 
@@ -376,38 +713,11 @@ static b8 scene_pass(
 		for (u32 m = 0; m < pass_data->opaque_meshes_by_material_count; ++m) {
 			kmaterial_render_data* material = &pass_data->opaque_meshes_by_material[m];
 
-			// Each geometry
-			for (u32 g = 0; g < material->geometry_count; ++g) {
-				kgeometry_render_data* geo = &material->geometries[g];
-
-				depth_prepass_immediate_data immediate_data = {
-					.transform_index = geo->transform};
-
-				kshader_set_immediate_data(renderer->depth_prepass.depth_prepass_shader, &immediate_data, sizeof(immediate_data));
-
-				// Invert winding if needed
-				b8 winding_inverted = FLAG_GET(geo->flags, KGEOMETRY_RENDER_DATA_FLAG_WINDING_INVERTED_BIT);
-				if (winding_inverted) {
-					renderer_winding_set(RENDERER_WINDING_CLOCKWISE);
-				}
-
-				// Draw it.
-				b8 includes_index_data = geo->index_count > 0;
-
-				KASSERT_DEBUG_MSG(
-					renderer_renderbuffer_draw(renderer->renderer_state, renderer->standard_vertex_buffer, geo->vertex_offset, geo->vertex_count, 0, includes_index_data),
-					"renderer_renderbuffer_draw failed to draw vertex buffer");
-
-				if (includes_index_data) {
-					KASSERT_DEBUG_MSG(
-						renderer_renderbuffer_draw(renderer->renderer_state, renderer->index_buffer, geo->index_offset, geo->index_count, 0, !includes_index_data),
-						"renderer_renderbuffer_draw failed to draw index buffer");
-				}
-
-				// Change back if needed
-				if (winding_inverted) {
-					renderer_winding_set(RENDERER_WINDING_COUNTER_CLOCKWISE);
-				}
+			// Each group of identical geometries. Everything uses the same shader and set, so batches can span material instances.
+			geometry_instance_group* groups = 0;
+			u32 group_count = geometry_groups_build(renderer, p_frame_data, material->geometry_count, material->geometries, 0, &groups);
+			if (!geometry_groups_draw(renderer, p_frame_data, group_count, groups, false, depth_prepass_group_apply, 0)) {
+				KERROR("Failed to draw geometry groups in depth prepass.");
 			}
 		}
 
@@ -663,6 +973,10 @@ b8 kforward_renderer_render_frame(kforward_renderer* renderer, frame_data* p_fra
 
 		// NOTE: frame begin logic here, if required.
 
+		// Instance data is written from scratch each frame as geometries are grouped.
+		kmaterial_renderer_instances_begin(renderer->material_renderer);
+		indirect_commands_begin(renderer);
+
 		// Set default dynamic state for the frame here.
 		// TODO: This can probably be moved to the creation phase since these defaults really
 		// only need to run once.
@@ -805,50 +1119,12 @@ b8 kforward_renderer_render_frame(kforward_renderer* renderer, frame_data* p_fra
 				// Ensure the binding set is applied.
 				kshader_apply_binding_set(renderer->shadow_pass.staticmesh_shader, 1, instance_id);
 
-				// Now draw each mesh geometry.
-				for (u32 m = 0; m < material->geometry_count; ++m) {
-
-					kgeometry_render_data* geo_data = &material->geometries[m];
-
-					b8 is_animated = geo_data->animation_id != INVALID_ID_U16;
-
-					// Ensure the right vertex layout index is used.
-					kshader_system_use(renderer->shadow_pass.staticmesh_shader, is_animated ? VERTEX_LAYOUT_INDEX_SKINNED : VERTEX_LAYOUT_INDEX_STATIC);
-					renderer_cull_mode_set(RENDERER_CULL_MODE_NONE);
-
-					// Set immediate data.
-					shadow_staticmesh_immediate_data immediate_data = {
-						.transform_index = geo_data->transform,
-						.cascade_index = p,
-						.geo_type = (u32)is_animated,
-						.animation_index = is_animated ? geo_data->animation_id : 0};
-
-					kshader_set_immediate_data(renderer->shadow_pass.staticmesh_shader, &immediate_data, sizeof(shadow_staticmesh_immediate_data));
-
-					// Invert if needed
-					b8 winding_inverted = FLAG_GET(geo_data->flags, KGEOMETRY_RENDER_DATA_FLAG_WINDING_INVERTED_BIT);
-					if (winding_inverted) {
-						renderer_winding_set(RENDERER_WINDING_CLOCKWISE);
-					}
-
-					// Draw it.
-					b8 includes_index_data = geo_data->index_count > 0;
-
-					if (!renderer_renderbuffer_draw(renderer->renderer_state, renderer->standard_vertex_buffer, geo_data->vertex_offset, geo_data->vertex_count, 0, includes_index_data)) {
-						KERROR("renderer_renderbuffer_draw failed to draw standard vertex buffer;");
-						return false;
-					}
-					if (includes_index_data) {
-						if (!renderer_renderbuffer_draw(renderer->renderer_state, renderer->index_buffer, geo_data->index_offset, geo_data->index_count, 0, !includes_index_data)) {
-							KERROR("renderer_renderbuffer_draw failed to draw index buffer;");
-							return false;
-						}
-					}
-
-					// Change back if needed
-					if (winding_inverted) {
-						renderer_winding_set(RENDERER_WINDING_COUNTER_CLOCKWISE);
-					}
+				// Now draw each group of identical mesh geometries within this cascade.
+				geometry_instance_group* groups = 0;
+				u32 group_count = geometry_groups_build(renderer, p_frame_data, material->geometry_count, material->geometries, (u8)(1 << p), &groups);
+				if (!geometry_groups_draw(renderer, p_frame_data, group_count, groups, false, shadow_group_apply, &p)) {
+					KERROR("Failed to draw geometry groups in shadow pass.");
+					return false;
 				}
 			}
 
@@ -863,49 +1139,12 @@ b8 kforward_renderer_render_frame(kforward_renderer* renderer, frame_data* p_fra
 				// Ensure the binding set is applied.
 				kshader_apply_binding_set(renderer->shadow_pass.staticmesh_shader, 1, instance_id);
 
-				// Now draw each mesh geometry.
-				for (u32 m = 0; m < render_data->shadow_data.opaque_geometry_count; ++m) {
-
-					kgeometry_render_data* geo_data = &render_data->shadow_data.opaque_geometries[m];
-
-					b8 is_animated = geo_data->animation_id != INVALID_ID_U16;
-
-					// Ensure the right vertex layout index is used.
-					kshader_system_use(renderer->shadow_pass.staticmesh_shader, is_animated ? VERTEX_LAYOUT_INDEX_SKINNED : VERTEX_LAYOUT_INDEX_STATIC);
-
-					// Set immediate data.
-					shadow_staticmesh_immediate_data immediate_data = {
-						.transform_index = geo_data->transform,
-						.cascade_index = p,
-						.geo_type = (u32)is_animated,
-						.animation_index = is_animated ? geo_data->animation_id : 0};
-
-					kshader_set_immediate_data(renderer->shadow_pass.staticmesh_shader, &immediate_data, sizeof(shadow_staticmesh_immediate_data));
-
-					// Invert if needed
-					b8 winding_inverted = FLAG_GET(geo_data->flags, KGEOMETRY_RENDER_DATA_FLAG_WINDING_INVERTED_BIT);
-					if (winding_inverted) {
-						renderer_winding_set(RENDERER_WINDING_CLOCKWISE);
-					}
-
-					// Draw it.
-					b8 includes_index_data = geo_data->index_count > 0;
-
-					if (!renderer_renderbuffer_draw(renderer->renderer_state, renderer->standard_vertex_buffer, geo_data->vertex_offset, geo_data->vertex_count, 0, includes_index_data)) {
-						KERROR("renderer_renderbuffer_draw failed to draw standard vertex buffer;");
-						return false;
-					}
-					if (includes_index_data) {
-						if (!renderer_renderbuffer_draw(renderer->renderer_state, renderer->index_buffer, geo_data->index_offset, geo_data->index_count, 0, !includes_index_data)) {
-							KERROR("renderer_renderbuffer_draw failed to draw index buffer;");
-							return false;
-						}
-					}
-
-					// Change back if needed
-					if (winding_inverted) {
-						renderer_winding_set(RENDERER_WINDING_COUNTER_CLOCKWISE);
-					}
+				// Now draw each group of identical mesh geometries within this cascade.
+				geometry_instance_group* groups = 0;
+				u32 group_count = geometry_groups_build(renderer, p_frame_data, render_data->shadow_data.opaque_geometry_count, render_data->shadow_data.opaque_geometries, (u8)(1 << p), &groups);
+				if (!geometry_groups_draw(renderer, p_frame_data, group_count, groups, false, shadow_group_apply, &p)) {
+					KERROR("Failed to draw geometry groups in shadow pass.");
+					return false;
 				}
 			}
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <containers/hashmap.h>
 #include <core/frame_data.h>
 #include <core_render_types.h>
 #include <core_resource_types.h>
@@ -15,6 +16,10 @@
 #define DEFAULT_SHADOW_FADE_DIST 5.0f
 #define DEFAULT_SHADOW_SPLIT_MULT 0.75f
 
+#define KRENDERBUFFER_NAME_FORWARD_INDIRECT "Kohi.IndirectBuffer.Forward"
+// The number of indirect draw commands room is made for up front. Grown as needed.
+#define KFORWARD_DEFAULT_INDIRECT_CAPACITY 4096
+
 struct renderer_system_state;
 struct standard_ui_renderable;
 
@@ -84,6 +89,22 @@ typedef struct kforward_renderer {
 	krenderbuffer standard_vertex_buffer;
 	krenderbuffer index_buffer;
 
+	// Maps geometry keys to instance groups while grouping a list of geometries for instanced drawing. Reused for every list.
+	hashmap instance_group_lookup;
+
+	// Indirect draw commands for instanced groups, written from scratch each frame.
+	krenderbuffer indirect_buffer;
+	// The number of commands the indirect buffer can hold.
+	u32 indirect_capacity;
+	// The number of commands written so far this frame.
+	u32 indirect_count;
+	// The number of commands asked for so far this frame, including those which did not fit.
+	u32 indirect_demand;
+	// Mapped memory of this frame's copy of the indirect buffer.
+	renderer_indexed_indirect_command* indirect_commands;
+	// Whether eligible groups are drawn with indirect draws this frame. Controlled by the "use_indirect_draws" kvar.
+	b8 use_indirect_draws;
+
 } kforward_renderer;
 
 typedef struct kskybox_render_data {
@@ -120,6 +141,9 @@ typedef struct kgeometry_render_data {
 
 	u8 bound_point_light_count;
 	u8 bound_point_light_indices[KMATERIAL_MAX_BOUND_POINT_LIGHTS];
+
+	// For shadow pass data, a bit per cascade whose view contains the geometry. Geometry is only drawn to those cascades.
+	u8 cascade_mask;
 } kgeometry_render_data;
 
 typedef struct kmaterial_render_data {
@@ -96,6 +96,11 @@ b8 kmaterial_renderer_initialize(kmaterial_renderer* out_state, u32 max_material
 	KASSERT(out_state->material_global_ssbo != KRENDERBUFFER_INVALID);
 	KDEBUG("Created material global storage buffer.");
 
+	// Global instance storage buffer, rewritten every frame.
+	out_state->instance_capacity = KMATERIAL_DEFAULT_INSTANCE_CAPACITY;
+	out_state->instance_global_ssbo = renderer_renderbuffer_create(out_state->renderer, kname_create(KRENDERBUFFER_NAME_INSTANCES_GLOBAL), RENDERBUFFER_TYPE_STORAGE, sizeof(kmaterial_render_instance_data) * out_state->instance_capacity, RENDERBUFFER_TRACK_TYPE_NONE, RENDERBUFFER_FLAG_AUTO_MAP_MEMORY_BIT | RENDERBUFFER_FLAG_TRIPLE_BUFFERED_BIT);
+	KASSERT(out_state->instance_global_ssbo != KRENDERBUFFER_INVALID);
+
 	// Some default settings.
 	out_state->settings.fog_colour = (colour3){0.6f, 0.7f, 0.8f};
 	out_state->settings.fog_start = 1.0f;
@@ -193,7 +198,7 @@ b8 kmaterial_renderer_initialize(kmaterial_renderer* out_state, u32 max_material
 		shader_binding_set_config* set_0 = &mat_std_shader.binding_sets[0];
 		set_0->max_instance_count = 1;
 		set_0->name = kname_create("material skinned shader global binding set");
-		set_0->binding_count = 9;
+		set_0->binding_count = 10;
 		set_0->bindings = KALLOC_TYPE_CARRAY(shader_binding_config, set_0->binding_count);
 
 		u8 bidx = 0;
@@ -252,6 +257,11 @@ b8 kmaterial_renderer_initialize(kmaterial_renderer* out_state, u32 max_material
 		set_0->sampler_count++;
 		bidx++;
 
+		set_0->bindings[bidx].binding_type = SHADER_BINDING_TYPE_SSBO;
+		set_0->bindings[bidx].name = kname_create(KRENDERBUFFER_NAME_INSTANCES_GLOBAL);
+		set_0->ssbo_count++;
+		bidx++;
+
 		KASSERT_DEBUG(bidx == set_0->binding_count);
 
 		// Set 1
@@ -337,6 +347,7 @@ void kmaterial_renderer_shutdown(kmaterial_renderer* state) {
 	if (state) {
 		// TODO: Free resources, etc.
 		renderer_renderbuffer_destroy(state->renderer, state->material_global_ssbo);
+		renderer_renderbuffer_destroy(state->renderer, state->instance_global_ssbo);
 	}
 }
 
@@ -652,3 +663,34 @@ void kmaterial_renderer_apply_immediates(kmaterial_renderer* state, kmaterial_in
 		break;
 	}
 }
+
+void kmaterial_renderer_instances_begin(kmaterial_renderer* state) {
+	KASSERT_DEBUG(state);
+
+	// Grow to fit the last frame's instances. Draws which didn't fit were simply not instanced.
+	if (state->instance_demand > state->instance_capacity) {
+		u32 new_capacity = KMAX(state->instance_capacity * 2, state->instance_demand);
+		if (renderer_renderbuffer_resize(state->renderer, state->instance_global_ssbo, sizeof(kmaterial_render_instance_data) * new_capacity)) {
+			state->instance_capacity = new_capacity;
+		} else {
+			KERROR("Failed to resize the global instance storage buffer. Some draws will not be instanced.");
+		}
+	}
+
+	state->instance_count = 0;
+	state->instance_demand = 0;
+	state->instances = renderer_renderbuffer_get_mapped_memory(state->renderer, state->instance_global_ssbo);
+}
+
+kmaterial_render_instance_data* kmaterial_renderer_instances_allocate(kmaterial_renderer* state, u32 count, u32* out_first_instance) {
+	KASSERT_DEBUG(state && out_first_instance);
+
+	state->instance_demand += count;
+	if (!state->instances || state->instance_count + count > state->instance_capacity) {
+		return 0;
+	}
+
+	*out_first_instance = state->instance_count;
+	state->instance_count += count;
+	return state->instances + *out_first_instance;
+}
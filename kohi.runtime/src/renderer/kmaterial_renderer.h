@@ -12,6 +12,10 @@
 #define KMATERIAL_UBO_MAX_SHADOW_CASCADES 4
 
 #define KRENDERBUFFER_NAME_MATERIALS_GLOBAL "Kohi.StorageBuffer.MaterialsGlobal"
+#define KRENDERBUFFER_NAME_INSTANCES_GLOBAL "Kohi.StorageBuffer.InstancesGlobal"
+
+// The number of instances the instance storage buffer has room for at first. Grown as needed.
+#define KMATERIAL_DEFAULT_INSTANCE_CAPACITY 4096
 
 /**
  * The uniform data for a light. 32 bytes.
@@ -123,15 +127,41 @@ typedef struct kmaterial_render_immediate_data {
 	// bytes 64-79
 	u32 transform_index;
 	u32 geo_type;
-	vec2 padding;
+	// If nonzero, transform, animation and point light data are instead taken from the instance storage buffer, indexed by instance index.
+	u32 instanced;
+	f32 padding;
 	// 80-128 available
 } kmaterial_render_immediate_data;
 
+/**
+ * Per-instance data for instanced draws, read from the global instance storage
+ * buffer at the instance index. 24 bytes.
+ */
+typedef struct kmaterial_render_instance_data {
+	u32 transform_index;
+	u32 animation_index;
+	u32 num_p_lights;
+	u32 padding;
+	// Index into the global point lights array. Up to 8 indices as u8s packed into 2 uints.
+	uvec2 packed_point_light_indices;
+} kmaterial_render_instance_data;
+
 /** @brief State for the material renderer. */
 typedef struct kmaterial_renderer {
 	// Global storage buffer used for rendering materials.
 	krenderbuffer material_global_ssbo;
 
+	// Global storage buffer holding per-instance data for instanced draws. Written from the start each frame.
+	krenderbuffer instance_global_ssbo;
+	// The number of instances the instance storage buffer has room for.
+	u32 instance_capacity;
+	// The number of instances written so far this frame.
+	u32 instance_count;
+	// The number of instances requested so far this frame, including any which did not fit.
+	u32 instance_demand;
+	// The copy of the instance storage buffer mapped for this frame.
+	kmaterial_render_instance_data* instances;
+
 	ktexture shadow_map_texture;
 	u8 ibl_cubemap_texture_count;
 	ktexture ibl_cubemap_textures[KMATERIAL_MAX_IRRADIANCE_CUBEMAP_COUNT];
@@ -190,3 +220,23 @@ KAPI void kmaterial_renderer_set_animated(kmaterial_renderer* state, b8 is_anima
 
 // Updates material instance immediates using the provided data.
 KAPI void kmaterial_renderer_apply_immediates(kmaterial_renderer* state, kmaterial_instance instance, const kmaterial_render_immediate_data* immediates);
+
+/**
+ * @brief Starts writing instance data for a new frame, discarding that of the last.
+ * Grows the instance storage buffer first if the last frame asked for more than it held.
+ * Must be called once per frame before any instance data is obtained.
+ *
+ * @param state A pointer to the material renderer state.
+ */
+KAPI void kmaterial_renderer_instances_begin(kmaterial_renderer* state);
+
+/**
+ * @brief Obtains room for the given number of consecutive instances in the instance
+ * storage buffer for this frame, to be filled in by the caller.
+ *
+ * @param state A pointer to the material renderer state.
+ * @param count The number of instances required.
+ * @param out_first_instance A pointer to hold the instance index of the first instance.
+ * @returns A pointer to the first instance to be written, or 0 if this frame's buffer is full, in which case draws should not be instanced.
+ */
+KAPI kmaterial_render_instance_data* kmaterial_renderer_instances_allocate(kmaterial_renderer* state, u32 count, u32* out_first_instance);
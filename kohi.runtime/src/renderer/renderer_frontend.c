@@ -17,6 +17,7 @@
 #include <platform/platform.h>
 #include <strings/kname.h>
 #include <strings/kstring.h>
+#include <threads/kmutex.h>
 
 #include "core/engine.h"
 #include "core/event.h"
@@ -32,6 +33,8 @@
 typedef struct renderbuffer_queued_deletion {
 	/** @brief The number of frames remaining until the deletion occurs. */
 	u8 frames_until_delete;
+	/** @brief The id of the most recent upload requested before the deletion. The range is held until it and all before it are done. */
+	u64 upload_id;
 	/** @brief The range to be deleted. Considered a "free" slot if range's values are 0. */
 	krange range;
 } renderbuffer_queued_deletion;
@@ -65,6 +68,18 @@ typedef struct krenderbuffer_data {
 	renderbuffer_queued_deletion* delete_queue;
 } krenderbuffer_data;
 
+/**
+ * @brief An asynchronous upload, along with what to do once it completes.
+ */
+typedef struct renderer_upload_request {
+	/** @brief The upload. Its data is owned by the request until passed to the backend. */
+	renderer_upload upload;
+	/** @brief The callback made once the upload completes. May be 0. */
+	PFN_renderer_upload_complete callback;
+	/** @brief The context passed to the callback. */
+	void* context;
+} renderer_upload_request;
+
 typedef struct renderer_system_state {
 	/** @brief The current frame number. Rolls over about every 18 minutes at 60FPS. */
 	u16 frame_number;
@@ -97,6 +112,15 @@ typedef struct renderer_system_state {
 
 	/** @brief Default textures. Registered from the texture system. */
 	ktexture default_textures[RENDERER_DEFAULT_TEXTURE_COUNT];
+
+	/** @brief Guards the upload request queues, as uploads may be requested from any thread. */
+	kmutex upload_mutex;
+	/** @brief The id of the most recently requested upload. */
+	u64 upload_id;
+	/** @brief darray of upload requests not yet passed to the backend, in id order. */
+	renderer_upload_request* pending_uploads;
+	/** @brief darray of upload requests passed to the backend, but not yet completed, in id order. */
+	renderer_upload_request* submitted_uploads;
 } renderer_system_state;
 
 b8 renderer_system_deserialize_config(const char* config_str, renderer_system_config* out_config) {
@@ -261,6 +285,15 @@ b8 renderer_system_initialize(u64* memory_requirement, renderer_system_state* st
 		state->default_textures[i] = INVALID_KTEXTURE;
 	}
 
+	// Asynchronous upload setup.
+	if (!kmutex_create(&state->upload_mutex)) {
+		KERROR("Failed to create upload mutex.");
+		return false;
+	}
+	state->upload_id = 0;
+	state->pending_uploads = darray_create(renderer_upload_request);
+	state->submitted_uploads = darray_create(renderer_upload_request);
+
 	// Renderbuffer setup.
 	state->renderbuffers = darray_create(krenderbuffer_data);
 
@@ -290,6 +323,17 @@ void renderer_system_shutdown(renderer_system_state* state) {
 
 		// renderer_wait_for_idle();
 
+		// Drop any uploads not yet performed.
+		u32 pending_count = darray_length(state->pending_uploads);
+		for (u32 i = 0; i < pending_count; ++i) {
+			kfree((void*)state->pending_uploads[i].upload.data, state->pending_uploads[i].upload.size, MEMORY_TAG_RENDERER);
+		}
+		darray_destroy(state->pending_uploads);
+		state->pending_uploads = KNULL;
+		darray_destroy(state->submitted_uploads);
+		state->submitted_uploads = KNULL;
+		kmutex_destroy(&state->upload_mutex);
+
 		// Destroy buffers.
 		renderer_renderbuffer_destroy(state, state->standard_vertex_buffer);
 		renderer_renderbuffer_destroy(state, state->geometry_index_buffer);
@@ -416,6 +460,92 @@ void renderer_end_debug_label(void) {
 #endif
 }
 
+// Queues a copy of the given upload, to be passed to the backend on the next update.
+static b8 upload_request_add(renderer_system_state* state, renderer_upload upload, PFN_renderer_upload_complete callback, void* context) {
+	if (!upload.size || !upload.data) {
+		KERROR("Asynchronous uploads require a nonzero size and a valid pointer to data.");
+		return false;
+	}
+
+	// Copy the data, so the caller may free or reuse theirs right away.
+	void* data = kallocate(upload.size, MEMORY_TAG_RENDERER);
+	kcopy_memory(data, upload.data, upload.size);
+	upload.data = data;
+
+	renderer_upload_request request = {0};
+	request.callback = callback;
+	request.context = context;
+
+	kmutex_lock(&state->upload_mutex);
+	upload.id = ++state->upload_id;
+	request.upload = upload;
+	darray_push(state->pending_uploads, request);
+	kmutex_unlock(&state->upload_mutex);
+
+	return true;
+}
+
+// Makes callbacks for completed uploads, then passes pending uploads to the backend.
+static void uploads_update(renderer_system_state* state) {
+	u64 completed_id = 0;
+	if (state->backend->uploads_acquire(state->backend, &completed_id)) {
+		while (true) {
+			kmutex_lock(&state->upload_mutex);
+			if (!darray_length(state->submitted_uploads) || state->submitted_uploads[0].upload.id > completed_id) {
+				kmutex_unlock(&state->upload_mutex);
+				break;
+			}
+			renderer_upload_request request;
+			darray_pop_at(state->submitted_uploads, 0, &request);
+			kmutex_unlock(&state->upload_mutex);
+
+			// Made outside of the lock, so the callback may request more uploads.
+			if (request.callback) {
+				request.callback(request.context);
+			}
+		}
+	}
+
+	// Take the pending requests, so more may be added while these are submitted.
+	kmutex_lock(&state->upload_mutex);
+	renderer_upload_request* requests = state->pending_uploads;
+	u32 request_count = darray_length(requests);
+	if (request_count) {
+		state->pending_uploads = darray_create(renderer_upload_request);
+	}
+	kmutex_unlock(&state->upload_mutex);
+
+	if (!request_count) {
+		return;
+	}
+
+	renderer_upload* uploads = KALLOC_TYPE_CARRAY(renderer_upload, request_count);
+	b8* results = KALLOC_TYPE_CARRAY(b8, request_count);
+	for (u32 i = 0; i < request_count; ++i) {
+		uploads[i] = requests[i].upload;
+	}
+
+	// The backend copies the data, so it can be freed right after.
+	state->backend->uploads_submit(state->backend, request_count, uploads, results);
+
+	kmutex_lock(&state->upload_mutex);
+	for (u32 i = 0; i < request_count; ++i) {
+		renderer_upload_request* request = &requests[i];
+		kfree((void*)request->upload.data, request->upload.size, MEMORY_TAG_RENDERER);
+		request->upload.data = 0;
+		if (results[i]) {
+			darray_push(state->submitted_uploads, *request);
+		} else {
+			KERROR("Failed to submit upload %llu. Its callback will not be made.", request->upload.id);
+		}
+	}
+	kmutex_unlock(&state->upload_mutex);
+
+	KFREE_TYPE_CARRAY(results, b8, request_count);
+	KFREE_TYPE_CARRAY(uploads, renderer_upload, request_count);
+	darray_destroy(requests);
+}
+
 b8 renderer_frame_prepare(struct renderer_system_state* state, struct frame_data* p_frame_data) {
 	KASSERT(state && p_frame_data);
 
@@ -423,7 +553,12 @@ b8 renderer_frame_prepare(struct renderer_system_state* state, struct frame_data
 	// This always occurs no matter what, even if a frame doesn't wind up rendering.
 	state->frame_number++;
 
-	return state->backend->frame_prepare(state->backend, p_frame_data);
+	b8 result = state->backend->frame_prepare(state->backend, p_frame_data);
+
+	// Also always occurs, so uploads keep moving even while frames are skipped.
+	uploads_update(state);
+
+	return result;
 }
 
 b8 renderer_frame_prepare_window_surface(struct renderer_system_state* state, struct kwindow* window, struct frame_data* p_frame_data) {
@@ -434,6 +569,17 @@ b8 renderer_frame_prepare_window_surface(struct renderer_system_state* state, st
 }
 
 b8 renderer_frame_command_list_begin(struct renderer_system_state* state, struct frame_data* p_frame_data) {
+	// Uploads before this id have all completed or been dropped.
+	kmutex_lock(&state->upload_mutex);
+	u64 outstanding_upload_id = state->upload_id + 1;
+	if (darray_length(state->pending_uploads)) {
+		outstanding_upload_id = state->pending_uploads[0].upload.id;
+	}
+	if (darray_length(state->submitted_uploads)) {
+		outstanding_upload_id = KMIN(outstanding_upload_id, state->submitted_uploads[0].upload.id);
+	}
+	kmutex_unlock(&state->upload_mutex);
+
 	// Before the frame starts, check registered renderbuffers to see if deletes are needed.
 	u32 registered_renderbuffer_count = darray_length(state->renderbuffers);
 	for (u32 i = 0; i < registered_renderbuffer_count; ++i) {
@@ -445,6 +591,9 @@ b8 renderer_frame_command_list_begin(struct renderer_system_state* state, struct
 				if (q->frames_until_delete > 0) {
 					// If there are wait frames, decrement it and check again next frame.
 					q->frames_until_delete--;
+				} else if (q->upload_id >= outstanding_upload_id) {
+					// An upload which may write to the range is still in progress. Check again next frame.
+					continue;
 				} else {
 					// If the frame wait count is 0, then it may be up for deletion or may be empty,
 					// depending on the range. Only ranges with a size are considered.
@@ -642,6 +791,20 @@ b8 renderer_texture_write_data(struct renderer_system_state* state, ktexture t,
 	return false;
 }
 
+b8 renderer_texture_write_data_async(struct renderer_system_state* state, ktexture t, u32 offset, u32 size, const u8* pixels, PFN_renderer_upload_complete callback, void* context) {
+	if (state && t != INVALID_KTEXTURE) {
+		renderer_upload upload = {0};
+		upload.type = RENDERER_UPLOAD_TYPE_TEXTURE;
+		upload.texture = t;
+		upload.buffer = KRENDERBUFFER_INVALID;
+		upload.offset = offset;
+		upload.size = size;
+		upload.data = pixels;
+		return upload_request_add(state, upload, callback, context);
+	}
+	return false;
+}
+
 b8 renderer_texture_read_data(struct renderer_system_state* state, ktexture t, u32 offset, u32 size, u8** out_pixels) {
 	if (state && t != INVALID_KTEXTURE) {
 		return state->backend->texture_read_data(state->backend, t, offset, size, out_pixels);
@@ -1188,6 +1351,11 @@ b8 renderer_renderbuffer_free(struct renderer_system_state* state, krenderbuffer
 
 	// NOTE: Don't actually perform the free, register it for deletion on a later frame.
 
+	// Uploads to the range may still be in progress, even if cancelled.
+	kmutex_lock(&state->upload_mutex);
+	u64 upload_id = state->upload_id;
+	kmutex_unlock(&state->upload_mutex);
+
 	// Start by searching for a free slot.
 	u32 delete_count = darray_length(buffer->delete_queue);
 	for (u32 i = 0; i < delete_count; ++i) {
@@ -1195,6 +1363,7 @@ b8 renderer_renderbuffer_free(struct renderer_system_state* state, krenderbuffer
 		if (!deletion->range.size) {
 			// Found one, use it.
 			deletion->frames_until_delete = RENDERER_MAX_FRAME_COUNT;
+			deletion->upload_id = upload_id;
 			deletion->range.offset = offset;
 			deletion->range.size = size;
 			return true;
@@ -1204,6 +1373,7 @@ b8 renderer_renderbuffer_free(struct renderer_system_state* state, krenderbuffer
 	// If one wasn't found, create and push a new entry.
 	renderbuffer_queued_deletion new_deletion = {0};
 	new_deletion.frames_until_delete = RENDERER_MAX_FRAME_COUNT;
+	new_deletion.upload_id = upload_id;
 	new_deletion.range.offset = offset;
 	new_deletion.range.size = size;
 	darray_push(buffer->delete_queue, new_deletion);
@@ -1240,6 +1410,53 @@ b8 renderer_renderbuffer_load_range(struct renderer_system_state* state, krender
 	return state->backend->renderbuffer_load_range(state->backend, buffer, offset, size, data, include_in_frame_workload);
 }
 
+b8 renderer_renderbuffer_load_range_async(struct renderer_system_state* state, krenderbuffer buffer, u64 offset, u64 size, const void* data, PFN_renderer_upload_complete callback, void* context) {
+	if (buffer == KRENDERBUFFER_INVALID) {
+		KERROR("%s - requires a valid buffer.", __FUNCTION__);
+		return false;
+	}
+
+	renderer_upload upload = {0};
+	upload.type = RENDERER_UPLOAD_TYPE_RENDERBUFFER;
+	upload.texture = INVALID_KTEXTURE;
+	upload.buffer = buffer;
+	upload.offset = offset;
+	upload.size = size;
+	upload.data = data;
+	return upload_request_add(state, upload, callback, context);
+}
+
+void renderer_uploads_cancel(struct renderer_system_state* state, void* context) {
+	if (!context) {
+		return;
+	}
+
+	kmutex_lock(&state->upload_mutex);
+
+	// Not yet passed to the backend, so these can simply be dropped.
+	for (u32 i = 0; i < darray_length(state->pending_uploads);) {
+		if (state->pending_uploads[i].context == context) {
+			renderer_upload_request request;
+			darray_pop_at(state->pending_uploads, i, &request);
+			kfree((void*)request.upload.data, request.upload.size, MEMORY_TAG_RENDERER);
+		} else {
+			++i;
+		}
+	}
+
+	// These are kept so completion is still tracked in order, but without a callback.
+	u32 submitted_count = darray_length(state->submitted_uploads);
+	for (u32 i = 0; i < submitted_count; ++i) {
+		renderer_upload_request* request = &state->submitted_uploads[i];
+		if (request->context == context) {
+			request->callback = 0;
+			request->context = 0;
+		}
+	}
+
+	kmutex_unlock(&state->upload_mutex);
+}
+
 b8 renderer_renderbuffer_copy_range(struct renderer_system_state* state, krenderbuffer source, u64 source_offset, krenderbuffer dest, u64 dest_offset, u64 size, b8 include_in_frame_workload) {
 	return state->backend->renderbuffer_copy_range(state->backend, source, source_offset, dest, dest_offset, size, include_in_frame_workload);
 }
@@ -1248,6 +1465,14 @@ b8 renderer_renderbuffer_draw(struct renderer_system_state* state, krenderbuffer
 	return state->backend->renderbuffer_draw(state->backend, buffer, offset, element_count, binding_index, bind_only);
 }
 
+b8 renderer_renderbuffer_draw_instanced(struct renderer_system_state* state, krenderbuffer buffer, u64 offset, u32 element_count, u32 instance_count, u32 first_instance, u32 binding_index) {
+	return state->backend->renderbuffer_draw_instanced(state->backend, buffer, offset, element_count, instance_count, first_instance, binding_index);
+}
+
+b8 renderer_renderbuffer_draw_indirect(struct renderer_system_state* state, krenderbuffer buffer, u64 offset, u32 draw_count) {
+	return state->backend->renderbuffer_draw_indirect(state->backend, buffer, offset, draw_count);
+}
+
 krenderbuffer renderer_renderbuffer_get(struct renderer_system_state* state, kname name) {
 	u16 len = darray_length(state->renderbuffers);
 	for (u16 i = 0; i < len; ++i) {
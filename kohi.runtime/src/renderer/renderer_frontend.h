@@ -327,6 +327,22 @@ KAPI b8 renderer_texture_resize(struct renderer_system_state* state, ktexture t,
  */
 KAPI b8 renderer_texture_write_data(struct renderer_system_state* state, ktexture t, u32 offset, u32 size, const u8* pixels);
 
+/**
+ * @brief Requests the given data be written to the provided texture without waiting on it.
+ * May be called from any thread. The data is copied, and is written on the transfer queue
+ * where supported. The texture's generation is updated once it has been written.
+ *
+ * @param state A pointer to the renderer system state.
+ * @param t A handle to the texture to be written to. Must not be in use by the GPU.
+ * @param offset The offset in bytes from the beginning of the data to be written.
+ * @param size The number of bytes to be written.
+ * @param pixels The raw image data to be written.
+ * @param callback An optional callback made on the main thread once the write has completed.
+ * @param context An optional context passed to the callback. Also used to cancel the request. See renderer_uploads_cancel.
+ * @returns True if the request was queued; otherwise false.
+ */
+KAPI b8 renderer_texture_write_data_async(struct renderer_system_state* state, ktexture t, u32 offset, u32 size, const u8* pixels, PFN_renderer_upload_complete callback, void* context);
+
 /**
  * @brief Reads the given data from the provided texture.
  *
@@ -794,6 +810,33 @@ KAPI b8 renderer_renderbuffer_clear(struct renderer_system_state* state, krender
  */
 KAPI b8 renderer_renderbuffer_load_range(struct renderer_system_state* state, krenderbuffer buffer, u64 offset, u64 size, const void* data, b8 include_in_frame_workload);
 
+/**
+ * @brief Requests the provided data be loaded into the specified range of the given buffer
+ * without waiting on it. May be called from any thread. The data is copied, and is loaded on
+ * the transfer queue where supported.
+ *
+ * @param state A pointer to the renderer state.
+ * @param buffer A handle to the buffer to load data into.
+ * @param offset The offset in bytes from the beginning of the buffer. The range must not be in use by the GPU.
+ * @param size The size of the data in bytes to be loaded.
+ * @param data The data to be loaded.
+ * @param callback An optional callback made on the main thread once the range has been loaded and may be used for rendering.
+ * @param context An optional context passed to the callback. Also used to cancel the request. See renderer_uploads_cancel.
+ * @returns True if the request was queued; otherwise false.
+ */
+KAPI b8 renderer_renderbuffer_load_range_async(struct renderer_system_state* state, krenderbuffer buffer, u64 offset, u64 size, const void* data, PFN_renderer_upload_complete callback, void* context);
+
+/**
+ * @brief Cancels all asynchronous uploads requested with the given context. Callbacks are not
+ * made for cancelled uploads. Those already in progress are not waited on; renderbuffer ranges
+ * freed afterward are held until they are done, so the ranges may be freed right after.
+ * Must be called from the main thread.
+ *
+ * @param state A pointer to the renderer state.
+ * @param context The context the uploads were requested with. Must not be 0.
+ */
+KAPI void renderer_uploads_cancel(struct renderer_system_state* state, void* context);
+
 /**
  * @brief Copies data in the specified rage fron the source to the destination buffer.
  *
@@ -821,6 +864,37 @@ KAPI b8 renderer_renderbuffer_copy_range(struct renderer_system_state* state, kr
  */
 KAPI b8 renderer_renderbuffer_draw(struct renderer_system_state* state, krenderbuffer buffer, u64 offset, u32 element_count, u32 binding_index, b8 bind_only);
 
+/**
+ * @brief Attempts to draw several instances of the contents of the provided buffer
+ * at the given offset and element count. Only meant to be used with vertex and index
+ * buffers. Shaders can tell instances apart by their instance index, which counts up
+ * from first_instance.
+ *
+ * @param state A pointer to the renderer state.
+ * @param buffer A handle to the buffer to be drawn.
+ * @param offset The offset in bytes from the beginning of the buffer.
+ * @param element_count The number of elements to be drawn.
+ * @param instance_count The number of instances to be drawn.
+ * @param first_instance The instance index of the first instance drawn.
+ * @param binding_index The index of which to bind the buffer. Unless using multiple buffers of the same time, pass 0 here.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 renderer_renderbuffer_draw_instanced(struct renderer_system_state* state, krenderbuffer buffer, u64 offset, u32 element_count, u32 instance_count, u32 first_instance, u32 binding_index);
+
+/**
+ * @brief Attempts to issue the indexed draw commands held in the provided indirect
+ * buffer, all with a single call where the device supports it. The vertex and index
+ * buffers the commands refer to must already be bound, typically at offset 0, since
+ * commands locate their data relative to the bound buffers.
+ *
+ * @param state A pointer to the renderer state.
+ * @param buffer A handle to an indirect buffer holding renderer_indexed_indirect_commands.
+ * @param offset The offset in bytes of the first command from the beginning of the buffer.
+ * @param draw_count The number of consecutive commands to be drawn.
+ * @return True on success; otherwise false.
+ */
+KAPI b8 renderer_renderbuffer_draw_indirect(struct renderer_system_state* state, krenderbuffer buffer, u64 offset, u32 draw_count);
+
 /**
  * @brief Attempts retrieve the renderer's internal buffer of the given name.
  * @param state A pointer to the renderer state.
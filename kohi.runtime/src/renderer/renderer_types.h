@@ -153,9 +153,28 @@ typedef enum renderbuffer_type {
 	/** @brief Buffer is used for reading purposes (i.e copy to from device local, then read) */
 	RENDERBUFFER_TYPE_READ,
 	/** @brief Buffer is used for data storage. */
-	RENDERBUFFER_TYPE_STORAGE
+	RENDERBUFFER_TYPE_STORAGE,
+	/** @brief Buffer holds draw commands for indirect drawing. @see renderer_indexed_indirect_command */
+	RENDERBUFFER_TYPE_INDIRECT
 } renderbuffer_type;
 
+/**
+ * @brief A single indexed draw, as read from an indirect buffer by indirect draws.
+ * Laid out to match what the GPU expects (i.e. VkDrawIndexedIndirectCommand). 20 bytes.
+ */
+typedef struct renderer_indexed_indirect_command {
+	/** @brief The number of indices to draw. */
+	u32 index_count;
+	/** @brief The number of instances to draw. */
+	u32 instance_count;
+	/** @brief The first index to draw, in indices from the start of the bound index buffer. */
+	u32 first_index;
+	/** @brief Added to each index before fetching vertices, in vertices from the start of the bound vertex buffer. */
+	i32 vertex_offset;
+	/** @brief The instance index of the first instance drawn. */
+	u32 first_instance;
+} renderer_indexed_indirect_command;
+
 typedef enum renderbuffer_track_type {
 	RENDERBUFFER_TRACK_TYPE_NONE = 0,
 	RENDERBUFFER_TRACK_TYPE_FREELIST = 1,
@@ -252,6 +271,42 @@ typedef struct kwindow_renderer_state {
 typedef u16 ksampler_backend;
 #define KSAMPLER_BACKEND_INVALID INVALID_ID_U16
 
+/**
+ * @brief A callback made once an asynchronous upload has completed and its
+ * destination may be used for rendering.
+ *
+ * @param context The context passed along with the upload request.
+ */
+typedef void (*PFN_renderer_upload_complete)(void* context);
+
+/** @brief The type of destination of an upload. */
+typedef enum renderer_upload_type {
+	/** @brief The upload writes texture data. */
+	RENDERER_UPLOAD_TYPE_TEXTURE,
+	/** @brief The upload writes a range of a renderbuffer. */
+	RENDERER_UPLOAD_TYPE_RENDERBUFFER
+} renderer_upload_type;
+
+/**
+ * @brief An upload passed to the renderer backend to be performed asynchronously.
+ */
+typedef struct renderer_upload {
+	/** @brief The id of the upload. Ids increase with each upload, and uploads complete in id order. */
+	u64 id;
+	/** @brief The type of destination. */
+	renderer_upload_type type;
+	/** @brief The texture to write to. Used for RENDERER_UPLOAD_TYPE_TEXTURE. */
+	ktexture texture;
+	/** @brief The renderbuffer to write to. Used for RENDERER_UPLOAD_TYPE_RENDERBUFFER. */
+	krenderbuffer buffer;
+	/** @brief The offset in bytes from the beginning of the destination. */
+	u64 offset;
+	/** @brief The size of the data in bytes. */
+	u64 size;
+	/** @brief The data to be uploaded. */
+	const void* data;
+} renderer_upload;
+
 /**
  * @brief A generic "interface" for the renderer backend. The renderer backend
  * is what is responsible for making calls to the graphics API such as
@@ -841,6 +896,58 @@ typedef struct renderer_backend_interface {
 	 */
 	b8 (*renderbuffer_draw)(struct renderer_backend_interface* backend, krenderbuffer buffer, u64 offset, u32 element_count, u32 binding_index, b8 bind_only);
 
+	/**
+	 * @brief Attempts to draw several instances of the contents of the provided buffer
+	 * at the given offset and element count. Only meant for use with vertex and index buffers.
+	 *
+	 * @param backend A pointer to the renderer backend interface.
+	 * @param buffer A handle to the buffer to be drawn.
+	 * @param offset The offset in bytes from the beginning of the buffer.
+	 * @param element_count The number of elements to be drawn.
+	 * @param instance_count The number of instances to be drawn.
+	 * @param first_instance The instance index of the first instance drawn.
+	 * @param binding_index The index of which to bind the buffer. Unless using multiple buffers of the same time, pass 0 here.
+	 * @return True on success; otherwise false.
+	 */
+	b8 (*renderbuffer_draw_instanced)(struct renderer_backend_interface* backend, krenderbuffer buffer, u64 offset, u32 element_count, u32 instance_count, u32 first_instance, u32 binding_index);
+
+	/**
+	 * @brief Attempts to issue the indexed draw commands held in the provided indirect
+	 * buffer, using the currently bound vertex and index buffers. Devices without
+	 * multi-draw-indirect support instead have each command read back and drawn directly,
+	 * which requires the buffer's memory to be mapped.
+	 *
+	 * @param backend A pointer to the renderer backend interface.
+	 * @param buffer A handle to the indirect buffer holding the commands.
+	 * @param offset The offset in bytes of the first command from the beginning of the buffer.
+	 * @param draw_count The number of consecutive commands to be drawn.
+	 * @return True on success; otherwise false.
+	 */
+	b8 (*renderbuffer_draw_indirect)(struct renderer_backend_interface* backend, krenderbuffer buffer, u64 offset, u32 draw_count);
+
+	/**
+	 * @brief Submits the given uploads to be performed without waiting on them. The data is copied
+	 * before returning. The destinations must not be in use by the GPU, and must not be used for
+	 * rendering until the uploads have completed.
+	 *
+	 * @param backend A pointer to the renderer backend interface.
+	 * @param upload_count The number of uploads.
+	 * @param uploads An array of uploads, in increasing id order.
+	 * @param out_results An array of upload_count elements to hold whether each upload was submitted. Those which were not will never complete.
+	 * @return True if every upload was submitted; otherwise false.
+	 */
+	b8 (*uploads_submit)(struct renderer_backend_interface* backend, u32 upload_count, const renderer_upload* uploads, b8* out_results);
+
+	/**
+	 * @brief Makes the destinations of all completed uploads ready for use in rendering.
+	 * Must be called before the work which uses them is recorded.
+	 *
+	 * @param backend A pointer to the renderer backend interface.
+	 * @param out_completed_id A pointer to hold the id of the last completed upload. All earlier uploads have also completed.
+	 * @return True on success; otherwise false.
+	 */
+	b8 (*uploads_acquire)(struct renderer_backend_interface* backend, u64* out_completed_id);
+
 	/**
 	 * Waits for the renderer backend to be completely idle of work before returning.
 	 * NOTE: This incurs a lot of overhead/waits, and should be used sparingly.
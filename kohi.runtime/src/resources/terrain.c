@@ -21,6 +21,7 @@ static void terrain_chunk_destroy(terrain* t, terrain_chunk* chunk);
 static void terrain_chunk_calculate_geometry(terrain* t, terrain_chunk* chunk, u32 chunk_offset_x, u32 chunk_offset_z);
 static void generate_and_load_geometry(terrain* t);
 static void kasset_heightmap_result(void* listener_inst, struct kasset_heightmap_terrain* asset);
+static void terrain_chunk_upload_complete(void* context);
 
 typedef enum terrain_skirt_side {
 	TSS_LEFT = 0,
@@ -162,8 +163,8 @@ b8 terrain_chunk_load(terrain* t, terrain_chunk* chunk) {
 		return false;
 	}
 
-	// TODO: Passing false here produces a queue wait and should be offloaded to another queue.
-	if (!renderer_renderbuffer_load_range(renderer_system, vertex_buffer, chunk->vertex_buffer_offset, total_vertex_size, chunk->vertices, false)) {
+	// Data is loaded asynchronously. Uploads complete in order, so the chunk becomes valid to render once the last one does.
+	if (!renderer_renderbuffer_load_range_async(renderer_system, vertex_buffer, chunk->vertex_buffer_offset, total_vertex_size, chunk->vertices, t->lod_count ? 0 : terrain_chunk_upload_complete, chunk)) {
 		KERROR("Failed to upload vertex data for terrain chunk.");
 		return false;
 	}
@@ -178,13 +179,16 @@ b8 terrain_chunk_load(terrain* t, terrain_chunk* chunk) {
 			return false;
 		}
 
-		// TODO: Passing false here produces a queue wait and should be offloaded to another queue.
-		if (!renderer_renderbuffer_load_range(renderer_system, index_buffer, lod->index_buffer_offset, total_size, lod->indices, false)) {
+		b8 is_last = i + 1 == t->lod_count;
+		if (!renderer_renderbuffer_load_range_async(renderer_system, index_buffer, lod->index_buffer_offset, total_size, lod->indices, is_last ? terrain_chunk_upload_complete : 0, chunk)) {
 			KERROR("Failed to upload index data for terrain chunk lod.");
+			renderer_uploads_cancel(renderer_system, chunk);
 			return false;
 		}
 	}
 
+	chunk->upload_pending = true;
+
 	// Create a terrain material by copying the properties of these materials to a new terrain material.
 	// FIXME: Need layered materials for this. This is just using the default standard material for now if nothing exists.
 	kmaterial_system_acquire(engine_systems_get()->material_system, t->material_name ? t->material_name : kname_create(KMATERIAL_STANDARD_NAME_DEFAULT), &chunk->material);
@@ -193,12 +197,16 @@ b8 terrain_chunk_load(terrain* t, terrain_chunk* chunk) {
 		chunk->material = kmaterial_system_get_default_blended(engine_systems_get()->material_system);
 	}
 
-	// Update the generation, making this valid to render.
-	chunk->generation++;
-
 	return true;
 }
 
+// Updates the generation once the chunk's data has been uploaded, making it valid to render.
+static void terrain_chunk_upload_complete(void* context) {
+	terrain_chunk* chunk = (terrain_chunk*)context;
+	chunk->upload_pending = false;
+	chunk->generation++;
+}
+
 b8 terrain_unload(terrain* t) {
 	if (!t) {
 		KERROR("terrain_unload requires a valid pointer to a terrain.");
@@ -241,6 +249,12 @@ b8 terrain_chunk_unload(terrain* t, terrain_chunk* chunk) {
 
 	struct renderer_system_state* renderer_system = engine_systems_get()->renderer_system;
 
+	// Stop any uploads still in progress. Their ranges are held until they are done.
+	if (chunk->upload_pending) {
+		renderer_uploads_cancel(renderer_system, chunk);
+		chunk->upload_pending = false;
+	}
+
 	if (chunk->vertices) {
 		// FIXME: Use extended buffer for terrain extended properties.
 		// NOTE: since geometry is not used here, need to release vertex and index data manually.
@@ -278,8 +292,8 @@ static void terrain_chunk_destroy(terrain* t, terrain_chunk* chunk) {
 		return;
 	}
 
-	// If it is still loaded, unload it first.
-	if (chunk->generation != INVALID_ID_U16) {
+	// If it is still loaded or loading, unload it first.
+	if (chunk->generation != INVALID_ID_U16 || chunk->upload_pending) {
 		if (!terrain_chunk_unload(t, chunk)) {
 			// Log, but continue since there's nothing to be done.
 			KERROR("Failed to unload terrain chunk before destroying it. See logs for details.");
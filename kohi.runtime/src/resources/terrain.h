@@ -51,8 +51,10 @@ typedef struct terrain_chunk_lod {
 } terrain_chunk_lod;
 
 typedef struct terrain_chunk {
-	/** @brief The chunk generation. Incremented every time the geometry changes. */
+	/** @brief The chunk generation. Incremented every time the geometry changes. INVALID_ID_U16 until its data has been uploaded. */
 	u16 generation;
+	/** @brief Set while the chunk's data is being uploaded. */
+	b8 upload_pending;
 	u32 surface_vertex_count;
 	u32 total_vertex_count;
 	terrain_vertex* vertices;
@@ -1,5 +1,6 @@
 #include "job_system.h"
 
+#include "containers/mpsc_queue.h"
 #include "containers/ring_queue.h"
 #include "core/frame_data.h"
 #include "debug/kassert.h"
@@ -7,33 +8,102 @@
 #include "logger.h"
 #include "memory/kmemory.h"
 #include "platform/platform.h"
+#include "threads/katomic.h"
 #include "threads/kmutex.h"
 #include "threads/ksemaphore.h"
 #include "threads/kthread.h"
 
+// The number of job priority levels, and thus the number of queues each job thread owns.
+#define JOB_PRIORITY_COUNT 3
+
+// The max number of jobs each job thread can hold in each of its priority queues.
+#define JOB_THREAD_QUEUE_CAPACITY 1024
+
+// The size of the ring of memory each job thread copies result payloads into.
+#define JOB_RESULT_ARENA_SIZE KIBIBYTES(64)
+
+// Result payloads larger than this are allocated individually instead of being taken from the arena.
+#define JOB_RESULT_ARENA_MAX_PAYLOAD (JOB_RESULT_ARENA_SIZE / 4)
+
 typedef struct job_thread {
 	u8 index;
 	kthread thread;
-	job_info info;
-	// A mutex to guard access to this thread's info.
-	kmutex info_mutex;
+
+	// The types of jobs this thread can handle.
+	u32 type_mask;
+
+	// Jobs owned by this thread, one queue per priority (indexed by job_priority).
+	// The owning thread pulls its next job from these, and idle peers may steal from them.
+	ring_queue queues[JOB_PRIORITY_COUNT];
+
+	// A mutex to guard access to this thread's queues and status flags below.
+	kmutex queue_mutex;
+
+	// The total number of jobs currently held across all of this thread's queues.
+	u32 queued_count;
+
+	// Indicates if this thread is currently executing a job.
+	b8 is_busy;
+
+	// Indicates that this thread found no work and is (or is about to be) blocked on its semaphore.
+	b8 is_sleeping;
 
 	// Used to cause a thread to block until work is available.
 	ksemaphore semaphore;
 
-	// The types of jobs this thread can handle.
-	u32 type_mask;
+	// Result payloads produced by this thread are copied into this ring of memory. Since the main
+	// thread processes results in the order they were produced, it is released in the same order.
+	u8* result_arena;
+	// The total number of bytes ever reserved from the arena. Only touched by this thread.
+	u64 result_arena_head;
+	// The total number of bytes ever released back to the arena. Only written by the main thread.
+	volatile u64 result_arena_tail;
 } job_thread;
 
+// The max number of parallel-for counters which can have unclaimed batches at once.
+#define MAX_PARALLEL_FOR_COUNTERS 32
+
 typedef struct job_result_entry {
-	u16 id;
 	pfn_job_on_complete callback;
-	u32 param_size;
 	void* params;
+	u32 param_size;
+	// The index of the job thread whose arena holds params, or INVALID_ID_U8 if params was allocated on its own.
+	u8 thread_index;
+	// The arena position which may be released once the callback has run.
+	u64 arena_release_position;
 } job_result_entry;
 
-// The max number of job results that can be stored at once.
-#define MAX_JOB_RESULTS 512
+// The max number of job results that can be waiting for the main thread at once. Must be a power of 2.
+#define JOB_RESULT_QUEUE_CAPACITY 4096
+
+// The max number of jobs that can be waiting on dependencies at once.
+#define MAX_WAITING_JOBS 1024
+
+// The max number of outstanding (unsatisfied) dependency links across all waiting jobs.
+#define MAX_DEPENDENCY_LINKS 4096
+
+/**
+ * A job which has been submitted, but has at least one dependency which
+ * has not yet completed. It is dispatched as soon as the last one does.
+ */
+typedef struct job_waiting_entry {
+	job_info info;
+	// The number of dependencies that have yet to complete.
+	u16 pending_count;
+	// The index of the next free entry when this one is not in use.
+	u16 next_free;
+} job_waiting_entry;
+
+/**
+ * Links a waiting job to one of the jobs it depends on. Each job identifier
+ * owns a singly-linked list of these, walked when that job completes.
+ */
+typedef struct job_dependency_link {
+	// The index of the waiting entry to be notified.
+	u16 waiting_index;
+	// The index of the next link for the same parent job, or INVALID_ID for the end of the list.
+	u32 next;
+} job_dependency_link;
 
 typedef struct job_system_state {
 	b8 running;
@@ -43,149 +113,516 @@ typedef struct job_system_state {
 	u16 current_job_id;
 	// TODO: This is a massive waste of memory - combine 8 at a time into each bool.
 	b8* job_statuses;
+	// Guards job statuses as well as the dependency graph below.
 	kmutex job_status_mutex;
 
-	ring_queue low_priority_queue;
-	ring_queue normal_priority_queue;
-	ring_queue high_priority_queue;
+	// Per job identifier, the index of the first link to a job waiting on it (INVALID_ID if none).
+	u32* first_dependent_links;
+
+	// Jobs parked until their dependencies complete.
+	job_waiting_entry waiting_jobs[MAX_WAITING_JOBS];
+	u16 first_free_waiting;
 
-	// Mutexes for each queue, since a job could be kicked off from another job (thread).
-	kmutex low_pri_queue_mutex;
-	kmutex normal_pri_queue_mutex;
-	kmutex high_pri_queue_mutex;
+	// Continuations from a parent job to the waiting jobs that depend on it.
+	job_dependency_link dependency_links[MAX_DEPENDENCY_LINKS];
+	u32 first_free_link;
 
-	job_result_entry pending_results[MAX_JOB_RESULTS];
-	kmutex result_mutex;
-	// A mutex for the result array
+	// Parallel-for counters which still have batches waiting to be claimed.
+	job_counter* parallel_for_counters[MAX_PARALLEL_FOR_COUNTERS];
+	u32 parallel_for_counter_count;
+	kmutex parallel_for_mutex;
+
+	// Results waiting to have their callbacks run on the main thread. Written by
+	// any job thread, read only by the main thread.
+	mpsc_queue results;
 } job_system_state;
 
 static job_system_state* state_ptr;
 
-static void store_result(pfn_job_on_complete callback, u32 param_size, void* params) {
+/**
+ * Reserves space for a result payload from the given thread's arena. Must only be called from that thread.
+ * @returns A pointer to the reserved space, or 0 if it is too large or the arena is currently full.
+ */
+static void* result_arena_allocate(job_thread* thread, u32 size, u64* out_release_position) {
+	u64 aligned_size = get_aligned(size, 16);
+	if (aligned_size > JOB_RESULT_ARENA_MAX_PAYLOAD) {
+		return 0;
+	}
+
+	u64 head = thread->result_arena_head;
+	u64 offset = head % JOB_RESULT_ARENA_SIZE;
+	// Allocations never wrap around the end of the ring, the remainder is skipped instead.
+	u64 skip = (offset + aligned_size > JOB_RESULT_ARENA_SIZE) ? JOB_RESULT_ARENA_SIZE - offset : 0;
+	u64 new_head = head + skip + aligned_size;
+	if (new_head - katomic_load_u64(&thread->result_arena_tail) > JOB_RESULT_ARENA_SIZE) {
+		// The main thread has not caught up yet.
+		return 0;
+	}
+
+	thread->result_arena_head = new_head;
+	*out_release_position = new_head;
+	return thread->result_arena + ((head + skip) % JOB_RESULT_ARENA_SIZE);
+}
+
+static void result_release(job_result_entry* entry) {
+	if (!entry->params) {
+		return;
+	}
+	if (entry->thread_index == INVALID_ID_U8) {
+		kfree(entry->params, entry->param_size, MEMORY_TAG_JOB);
+	} else {
+		katomic_store_u64(&state_ptr->job_threads[entry->thread_index].result_arena_tail, entry->arena_release_position);
+	}
+}
+
+static void store_result(job_thread* thread, pfn_job_on_complete callback, u32 param_size, void* params) {
 	// Create the new entry.
-	job_result_entry entry;
-	entry.id = INVALID_ID_U16;
+	job_result_entry entry = {0};
 	entry.param_size = param_size;
 	entry.callback = callback;
+	entry.thread_index = INVALID_ID_U8;
 	if (entry.param_size > 0) {
-		// Take a copy, as the job is destroyed after this.
-		entry.params = kallocate(param_size, MEMORY_TAG_JOB);
+		// Take a copy, as the job is destroyed after this. This normally comes from the
+		// thread's arena, falling back to a separate allocation if it does not fit.
+		entry.params = result_arena_allocate(thread, param_size, &entry.arena_release_position);
+		if (entry.params) {
+			entry.thread_index = thread->index;
+		} else {
+			entry.params = kallocate(param_size, MEMORY_TAG_JOB);
+		}
 		kcopy_memory(entry.params, params, param_size);
-	} else {
-		entry.params = 0;
 	}
 
-	// Lock, find a free space, store, unlock.
-	if (!kmutex_lock(&state_ptr->result_mutex)) {
-		KERROR("Failed to obtain mutex lock for storing a result! Result storage may be corrupted.");
+	// Results are never dropped. If the queue is full, wait for the main thread to drain it.
+	b8 warned = false;
+	while (!mpsc_queue_enqueue(&state_ptr->results, &entry)) {
+		if (!state_ptr->running) {
+			result_release(&entry);
+			return;
+		}
+		if (!warned) {
+			KWARN("Job result queue is full, thread %u is waiting for results to be processed.", thread->index);
+			warned = true;
+		}
+		platform_sleep(1);
 	}
-	for (u16 i = 0; i < MAX_JOB_RESULTS; ++i) {
-		if (state_ptr->pending_results[i].id == INVALID_ID_U16) {
-			state_ptr->pending_results[i] = entry;
-			state_ptr->pending_results[i].id = i;
-			break;
+}
+
+static void job_thread_set_sleeping(job_thread* thread, b8 is_sleeping) {
+	if (!kmutex_lock(&thread->queue_mutex)) {
+		KERROR("Failed to obtain lock on job thread mutex!");
+	}
+	thread->is_sleeping = is_sleeping;
+	if (!kmutex_unlock(&thread->queue_mutex)) {
+		KERROR("Failed to release lock on job thread mutex!");
+	}
+}
+
+/**
+ * Attempts to take the oldest job at the given priority from the given thread's queues which is
+ * supported by the taker's type mask. Used both by the owning thread and by thieves.
+ */
+static b8 job_thread_take(job_thread* victim, job_thread* taker, u32 priority, job_info* out_info) {
+	b8 taken = false;
+	if (!kmutex_lock(&victim->queue_mutex)) {
+		KERROR("Failed to obtain lock on job thread mutex!");
+	}
+	ring_queue* queue = &victim->queues[priority];
+	u32 head = (u32)queue->head;
+	for (u32 i = 0; i < queue->length; ++i) {
+		// NOTE: Jobs are taken in submission order regardless of which thread ends up executing them.
+		// A thief only takes a job it is able to run, so skips past any it cannot.
+		u8* candidate = (u8*)queue->block + (((head + i) % queue->capacity) * queue->stride);
+		if ((((job_info*)candidate)->type & taker->type_mask) == 0) {
+			continue;
 		}
+		kcopy_memory(out_info, candidate, sizeof(job_info));
+
+		// Close the gap by moving the skipped jobs up one slot, which keeps them in order.
+		for (u32 j = i; j > 0; --j) {
+			u8* to = (u8*)queue->block + (((head + j) % queue->capacity) * queue->stride);
+			u8* from = (u8*)queue->block + (((head + j - 1) % queue->capacity) * queue->stride);
+			kcopy_memory(to, from, queue->stride);
+		}
+		queue->head = (i32)((head + 1) % queue->capacity);
+		queue->length--;
+		victim->queued_count--;
+		taken = true;
+		break;
 	}
-	if (!kmutex_unlock(&state_ptr->result_mutex)) {
-		KERROR("Failed to release mutex lock for result storage, storage may be corrupted.");
+	if (!kmutex_unlock(&victim->queue_mutex)) {
+		KERROR("Failed to release lock on job thread mutex!");
 	}
+	return taken;
 }
 
-static u32 job_thread_run(void* params) {
-	u32 index = *(u32*)params;
-	job_thread* thread = &state_ptr->job_threads[index];
-	KTRACE("Starting job thread #%i (id=%#x, type=%#x).", thread->index, thread->thread.thread_id, thread->type_mask);
+static void job_thread_set_busy(job_thread* thread, b8 is_busy) {
+	if (!kmutex_lock(&thread->queue_mutex)) {
+		KERROR("Failed to obtain lock on job thread mutex!");
+	}
+	thread->is_busy = is_busy;
+	if (!kmutex_unlock(&thread->queue_mutex)) {
+		KERROR("Failed to release lock on job thread mutex!");
+	}
+}
 
-	// A mutex to lock info for this thread.
-	if (!kmutex_create(&thread->info_mutex)) {
-		KERROR("Failed to create job thread mutex! Aborting thread.");
-		return 0;
+/**
+ * Wakes the given thread if it is sleeping. The flag is cleared here so that
+ * a sleeping thread is only ever signaled once, no matter how many jobs arrive
+ * before it actually wakes.
+ */
+static b8 job_thread_wake(job_thread* thread) {
+	if (!kmutex_lock(&thread->queue_mutex)) {
+		KERROR("Failed to obtain lock on job thread mutex!");
+	}
+	b8 was_sleeping = thread->is_sleeping;
+	thread->is_sleeping = false;
+	if (!kmutex_unlock(&thread->queue_mutex)) {
+		KERROR("Failed to release lock on job thread mutex!");
+	}
+	if (was_sleeping) {
+		ksemaphore_signal(&thread->semaphore);
 	}
+	return was_sleeping;
+}
 
-	// Create a semaphore for the thread which will block until there is work to do.
-	if (!ksemaphore_create(&thread->semaphore, 1, 1)) {
-		KERROR("Failed to create job thread semaphore! Aborting thread.");
-		return 0;
+/**
+ * Gets the next job for the given thread. Each priority level is checked across all queues, the
+ * thread's own first and then its peers', before dropping to the next level down. This way a
+ * peer's high priority job is never left waiting behind a lower priority one.
+ */
+static b8 job_thread_next(job_thread* thread, job_info* out_info) {
+	u8 thread_count = state_ptr->thread_count;
+	for (i32 p = JOB_PRIORITY_COUNT - 1; p >= 0; --p) {
+		// Starting with our own queue, then stealing from peers starting with the next thread over.
+		for (u8 i = 0; i < thread_count; ++i) {
+			job_thread* victim = &state_ptr->job_threads[(thread->index + i) % thread_count];
+			if (job_thread_take(victim, thread, (u32)p, out_info)) {
+				if (victim != thread) {
+					KTRACE("Job thread %u stole job %u from thread %u.", thread->index, out_info->id, victim->index);
+				}
+				job_thread_set_busy(thread, true);
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+static void dispatch_job(job_info* info);
+
+/**
+ * Marks the given job as complete and walks the list of jobs waiting on it. Any job for which
+ * this was the last outstanding dependency is dispatched immediately, from the calling thread.
+ */
+static void job_complete(u16 job_id) {
+	if (!kmutex_lock(&state_ptr->job_status_mutex)) {
+		KERROR("Failed to lock job status mutex!");
+	}
+	state_ptr->job_statuses[job_id] = true;
+
+	u32 link_index = state_ptr->first_dependent_links[job_id];
+	state_ptr->first_dependent_links[job_id] = INVALID_ID;
+	while (link_index != INVALID_ID) {
+		job_dependency_link* link = &state_ptr->dependency_links[link_index];
+		u32 next = link->next;
+
+		job_waiting_entry* waiting = &state_ptr->waiting_jobs[link->waiting_index];
+		waiting->pending_count--;
+		if (waiting->pending_count == 0) {
+			KTRACE("Job %u released by completion of job %u.", waiting->info.id, job_id);
+			job_info released = waiting->info;
+			waiting->next_free = state_ptr->first_free_waiting;
+			state_ptr->first_free_waiting = link->waiting_index;
+			dispatch_job(&released);
+		}
+
+		// Return the link to the free list.
+		link->next = state_ptr->first_free_link;
+		state_ptr->first_free_link = link_index;
+		link_index = next;
 	}
 
+	if (!kmutex_unlock(&state_ptr->job_status_mutex)) {
+		KERROR("Failed to unlock job status mutex!");
+	}
+}
+
+/**
+ * Adds a continuation from the given parent job to the waiting entry at the given index,
+ * if the parent has not already completed. Must be called with the job status mutex held.
+ * @returns True if a dependency was registered (i.e. the parent is still outstanding); otherwise false.
+ */
+static b8 register_dependency(u16 waiting_index, u16 parent_id) {
+	if (state_ptr->job_statuses[parent_id]) {
+		return false;
+	}
+	if (state_ptr->first_free_link == INVALID_ID) {
+		KERROR("Job system ran out of dependency links (max=%u). Job %u will not wait on job %u.", MAX_DEPENDENCY_LINKS, state_ptr->waiting_jobs[waiting_index].info.id, parent_id);
+		return false;
+	}
+
+	u32 link_index = state_ptr->first_free_link;
+	job_dependency_link* link = &state_ptr->dependency_links[link_index];
+	state_ptr->first_free_link = link->next;
+
+	link->waiting_index = waiting_index;
+	link->next = state_ptr->first_dependent_links[parent_id];
+	state_ptr->first_dependent_links[parent_id] = link_index;
+	return true;
+}
+
+/**
+ * Submits a job along with any additional parent jobs (on top of the job's own dependency_ids). If
+ * any of these have not yet completed, the job is parked until the last one does; otherwise it is
+ * dispatched right away. Must be called with the job status mutex held.
+ */
+static b8 submit_with_parents(job_info* info, u32 extra_parent_count, const u16* extra_parent_ids) {
+	if (!info->dependency_count && !extra_parent_count) {
+		dispatch_job(info);
+		return true;
+	}
+
+	if (state_ptr->first_free_waiting == INVALID_ID_U16) {
+		KERROR("Job system has too many jobs waiting on dependencies (max=%u). Job %u will not be run.", MAX_WAITING_JOBS, info->id);
+		return false;
+	}
+
+	u16 waiting_index = state_ptr->first_free_waiting;
+	job_waiting_entry* waiting = &state_ptr->waiting_jobs[waiting_index];
+	state_ptr->first_free_waiting = waiting->next_free;
+	waiting->info = *info;
+	waiting->pending_count = 0;
+
+	for (u32 i = 0; i < info->dependency_count; ++i) {
+		if (register_dependency(waiting_index, info->dependency_ids[i])) {
+			waiting->pending_count++;
+		}
+	}
+	for (u32 i = 0; i < extra_parent_count; ++i) {
+		if (register_dependency(waiting_index, extra_parent_ids[i])) {
+			waiting->pending_count++;
+		}
+	}
+
+	if (waiting->pending_count == 0) {
+		// Everything it depends on is already done, so no need to wait.
+		waiting->next_free = state_ptr->first_free_waiting;
+		state_ptr->first_free_waiting = waiting_index;
+		dispatch_job(info);
+	} else {
+		KTRACE("Job %u waiting on %u dependencies.", info->id, waiting->pending_count);
+	}
+	return true;
+}
+
+static void job_execute(job_thread* thread, job_info* info) {
+	b8 result = info->entry_point(info->param_data, info->result_data);
+
+	// Store the result to be executed on the main thread later.
+	// Note that store_result takes a copy of the result_data
+	// so it does not have to be held onto by this thread any longer.
+	if (result && info->on_success) {
+		store_result(thread, info->on_success, info->result_data_size, info->result_data);
+	} else if (!result && info->on_fail) {
+		store_result(thread, info->on_fail, info->result_data_size, info->result_data);
+	}
+
+	// Clear the param data and result data.
+	if (info->param_data) {
+		kfree(info->param_data, info->param_data_size, MEMORY_TAG_JOB);
+	}
+	if (info->result_data) {
+		kfree(info->result_data, info->result_data_size, MEMORY_TAG_JOB);
+	}
+	if (info->dependency_ids) {
+		kfree(info->dependency_ids, sizeof(u16) * info->dependency_count, MEMORY_TAG_ARRAY);
+	}
+
+	// Update the job status for this job, releasing any jobs for which this was the last dependency.
+	job_complete(info->id);
+
+	job_thread_set_busy(thread, false);
+}
+
+/**
+ * Claims the next unclaimed batch of a parallel-for. If a counter is provided, only that counter
+ * is considered, otherwise any active counter may be used. A counter is removed from the active
+ * list once its last batch is claimed, so that it is never touched again after it completes.
+ */
+static b8 parallel_for_claim(job_counter* only, job_counter** out_counter, u32* out_batch) {
+	b8 claimed = false;
+	if (!kmutex_lock(&state_ptr->parallel_for_mutex)) {
+		KERROR("Failed to obtain lock on parallel-for mutex!");
+	}
+	for (u32 i = 0; i < state_ptr->parallel_for_counter_count; ++i) {
+		job_counter* counter = state_ptr->parallel_for_counters[i];
+		if (only && counter != only) {
+			continue;
+		}
+
+		*out_counter = counter;
+		*out_batch = counter->next_batch;
+		counter->next_batch++;
+		if (counter->next_batch == counter->batch_count) {
+			// Fully claimed, swap-remove from the active list.
+			state_ptr->parallel_for_counter_count--;
+			state_ptr->parallel_for_counters[i] = state_ptr->parallel_for_counters[state_ptr->parallel_for_counter_count];
+		}
+		claimed = true;
+		break;
+	}
+	if (!kmutex_unlock(&state_ptr->parallel_for_mutex)) {
+		KERROR("Failed to release lock on parallel-for mutex!");
+	}
+	return claimed;
+}
+
+static void parallel_for_run_batch(job_counter* counter, u32 batch) {
+	u32 start = batch * counter->batch_size;
+	u32 end = KMIN(start + counter->batch_size, counter->count);
+	counter->fn(start, end, counter->context);
+
+	// NOTE: This must be the last access to the counter, as its owner may return as soon as it hits 0.
+	katomic_fetch_sub_u32(&counter->remaining, 1);
+}
+
+/**
+ * Runs one batch of any active parallel-for on the given job thread, if it is able to.
+ * @returns True if a batch was run; otherwise false.
+ */
+static b8 job_thread_help_parallel_for(job_thread* thread) {
+	if ((thread->type_mask & JOB_TYPE_GENERAL) == 0) {
+		return false;
+	}
+	job_counter* counter = 0;
+	u32 batch = 0;
+	if (!parallel_for_claim(0, &counter, &batch)) {
+		return false;
+	}
+	parallel_for_run_batch(counter, batch);
+	return true;
+}
+
+static u32 job_thread_run(void* params) {
+	u8 index = *(u8*)params;
+	job_thread* thread = &state_ptr->job_threads[index];
+	KTRACE("Starting job thread #%i (id=%#x, type=%#x).", thread->index, thread->thread.thread_id, thread->type_mask);
+
 	// Run forever, waiting for jobs.
 	while (true) {
 		if (!state_ptr || !state_ptr->running || !thread) {
 			break;
 		}
 
+		// Parallel-for batches come first, since someone is always waiting on them.
+		if (job_thread_help_parallel_for(thread)) {
+			continue;
+		}
+
+		job_info info;
+		if (job_thread_next(thread, &info)) {
+			job_execute(thread, &info);
+			continue;
+		}
+
+		// Out of work. Flag as sleeping before checking one last time, so that any job submitted
+		// after this point is guaranteed to wake this thread.
+		job_thread_set_sleeping(thread, true);
+		if (job_thread_help_parallel_for(thread)) {
+			job_thread_set_sleeping(thread, false);
+			continue;
+		}
+		if (job_thread_next(thread, &info)) {
+			job_thread_set_sleeping(thread, false);
+			job_execute(thread, &info);
+			continue;
+		}
+
 		// Wait for the semaphore to be signaled.
 		ksemaphore_wait(&thread->semaphore, 0xFFFFFFFF);
+	}
+
+	// Hand back any small blocks this thread was holding on to.
+	kmemory_thread_cache_flush();
 
-		// Lock and grab a copy of the info
-		if (!kmutex_lock(&thread->info_mutex)) {
+	return 1;
+}
+
+/**
+ * Hands the given job to the least-loaded thread able to run it, waking that
+ * thread (or, if it is busy, an idle peer that can steal it).
+ */
+static void dispatch_job(job_info* info) {
+	u8 thread_count = state_ptr->thread_count;
+	// Start the search at a different thread for each job so equally-loaded threads share the work.
+	u8 start = info->id % thread_count;
+
+	job_thread* target = 0;
+	u32 target_load = INVALID_ID;
+	for (u8 i = 0; i < thread_count; ++i) {
+		job_thread* thread = &state_ptr->job_threads[(start + i) % thread_count];
+		if ((thread->type_mask & info->type) == 0) {
+			continue;
+		}
+		if (!kmutex_lock(&thread->queue_mutex)) {
 			KERROR("Failed to obtain lock on job thread mutex!");
 		}
-		job_info info = thread->info;
-		if (!kmutex_unlock(&thread->info_mutex)) {
+		u32 load = thread->queued_count + (thread->is_busy ? 1 : 0);
+		if (!kmutex_unlock(&thread->queue_mutex)) {
 			KERROR("Failed to release lock on job thread mutex!");
 		}
+		if (load < target_load) {
+			target = thread;
+			target_load = load;
+			if (load == 0) {
+				break;
+			}
+		}
+	}
 
-		if (info.entry_point) {
-			b8 result = info.entry_point(info.param_data, info.result_data);
+	if (!target) {
+		KERROR("No job thread exists which can handle job type %#x. Job will not be run.", info->type);
+		return;
+	}
 
-			// Store the result to be executed on the main thread later.
-			// Note that store_result takes a copy of the result_data
-			// so it does not have to be held onto by this thread any longer.
-			if (result && info.on_success) {
-				store_result(info.on_success, info.result_data_size, info.result_data);
-			} else if (!result && info.on_fail) {
-				store_result(info.on_fail, info.result_data_size, info.result_data);
-			}
+	if (!kmutex_lock(&target->queue_mutex)) {
+		KERROR("Failed to obtain lock on job thread mutex!");
+	}
+	b8 enqueued = ring_queue_enqueue(&target->queues[info->priority], info);
+	if (enqueued) {
+		target->queued_count++;
+	}
+	b8 target_busy = target->is_busy;
+	if (!kmutex_unlock(&target->queue_mutex)) {
+		KERROR("Failed to release lock on job thread mutex!");
+	}
 
-			// Clear the param data and result data.
-			if (info.param_data) {
-				kfree(info.param_data, info.param_data_size, MEMORY_TAG_JOB);
-			}
-			if (info.result_data) {
-				kfree(info.result_data, info.result_data_size, MEMORY_TAG_JOB);
-			}
+	if (!enqueued) {
+		KERROR("Job thread %u queue is full. Job %u will not be run.", target->index, info->id);
+		return;
+	}
 
-			// Update the job status for this job.
-			if (!kmutex_lock(&state_ptr->job_status_mutex)) {
-				KERROR("Failed to lock job status mutex!");
-			}
-			state_ptr->job_statuses[thread->info.id] = true;
-			if (!kmutex_unlock(&state_ptr->job_status_mutex)) {
-				KERROR("Failed to unlock job status mutex!");
-			}
+	KTRACE("Job %u queued on thread %u.", info->id, target->index);
+	job_thread_wake(target);
 
-			// Lock and reset the thread's info object
-			if (!kmutex_lock(&thread->info_mutex)) {
-				KERROR("Failed to obtain lock on job thread mutex!");
-			}
-			if (thread->info.dependency_ids) {
-				kfree(thread->info.dependency_ids, sizeof(u16) * thread->info.dependency_count, MEMORY_TAG_ARRAY);
-			}
-			kzero_memory(&thread->info, sizeof(job_info));
-			if (!kmutex_unlock(&thread->info_mutex)) {
-				KERROR("Failed to release lock on job thread mutex!");
+	// If the target is busy, also wake one sleeping peer that can handle the job so it can steal it.
+	if (target_busy) {
+		for (u8 i = 0; i < thread_count; ++i) {
+			job_thread* thread = &state_ptr->job_threads[i];
+			if (thread != target && (thread->type_mask & info->type) && job_thread_wake(thread)) {
+				break;
 			}
 		}
-
-		// If no longer running, shut down the thread.
-		if (!state_ptr->running) {
-			break;
-		}
 	}
-
-	// Destroy the mutex for this thread.
-	kmutex_destroy(&thread->info_mutex);
-
-	// Destroy the semaphore.
-	ksemaphore_destroy(&thread->semaphore);
-
-	return 1;
 }
 
 b8 job_system_initialize(u64* job_system_memory_requirement, void* state, void* config) {
 	job_system_config* typed_config = (job_system_config*)config;
-	*job_system_memory_requirement = sizeof(job_system_state) + (sizeof(u8) * (INVALID_ID_U16 - 1));
+	// Statuses and dependency list heads are both indexed by job identifier, so are stored after the state.
+	u64 statuses_size = get_aligned(sizeof(b8) * INVALID_ID_U16, 16);
+	*job_system_memory_requirement = sizeof(job_system_state) + statuses_size + (sizeof(u32) * INVALID_ID_U16);
 	if (state == 0) {
 		return true;
 	}
@@ -195,51 +632,69 @@ b8 job_system_initialize(u64* job_system_memory_requirement, void* state, void*
 	state_ptr = state;
 	state_ptr->running = true;
 	state_ptr->job_statuses = (void*)((u64)state_ptr + sizeof(job_system_state));
+	state_ptr->first_dependent_links = (void*)((u64)state_ptr->job_statuses + statuses_size);
+	for (u32 i = 0; i < INVALID_ID_U16; ++i) {
+		state_ptr->first_dependent_links[i] = INVALID_ID;
+	}
+
+	// Chain up the free lists for waiting jobs and dependency links.
+	for (u16 i = 0; i < MAX_WAITING_JOBS; ++i) {
+		state_ptr->waiting_jobs[i].next_free = (i + 1 < MAX_WAITING_JOBS) ? (u16)(i + 1) : INVALID_ID_U16;
+	}
+	state_ptr->first_free_waiting = 0;
+	for (u32 i = 0; i < MAX_DEPENDENCY_LINKS; ++i) {
+		state_ptr->dependency_links[i].next = (i + 1 < MAX_DEPENDENCY_LINKS) ? i + 1 : INVALID_ID;
+	}
+	state_ptr->first_free_link = 0;
 
-	ring_queue_create(sizeof(job_info), 1024, 0, &state_ptr->low_priority_queue);
-	ring_queue_create(sizeof(job_info), 1024, 0, &state_ptr->normal_priority_queue);
-	ring_queue_create(sizeof(job_info), 1024, 0, &state_ptr->high_priority_queue);
 	state_ptr->thread_count = typed_config->max_job_thread_count;
 
-	// Invalidate all result slots
-	for (u16 i = 0; i < MAX_JOB_RESULTS; ++i) {
-		state_ptr->pending_results[i].id = INVALID_ID_U16;
+	if (!mpsc_queue_create(sizeof(job_result_entry), JOB_RESULT_QUEUE_CAPACITY, 0, &state_ptr->results)) {
+		KERROR("Failed to create job result queue!");
+		return false;
+	}
+
+	// Create needed mutexes
+	if (!kmutex_create(&state_ptr->job_status_mutex)) {
+		KERROR("Failed to create job status mutex!");
+		return false;
+	}
+	if (!kmutex_create(&state_ptr->parallel_for_mutex)) {
+		KERROR("Failed to create parallel-for mutex!");
+		return false;
 	}
 
 	KDEBUG("Main thread id is: %#x", platform_current_thread_id());
 
 	KDEBUG("Spawning %i job threads.", state_ptr->thread_count);
 
+	// Setup all thread queues and sync objects before any thread is started, since
+	// threads steal from one another as soon as they are running.
 	for (u8 i = 0; i < state_ptr->thread_count; ++i) {
-		state_ptr->job_threads[i].index = i;
-		state_ptr->job_threads[i].type_mask = typed_config->type_masks[i];
-		if (!kthread_create(job_thread_run, &state_ptr->job_threads[i].index, false, &state_ptr->job_threads[i].thread)) {
-			KFATAL("OS Error in creating job thread. Application cannot continue.");
+		job_thread* thread = &state_ptr->job_threads[i];
+		thread->index = i;
+		thread->type_mask = typed_config->type_masks[i];
+		for (u32 p = 0; p < JOB_PRIORITY_COUNT; ++p) {
+			ring_queue_create(sizeof(job_info), JOB_THREAD_QUEUE_CAPACITY, 0, &thread->queues[p]);
+		}
+		if (!kmutex_create(&thread->queue_mutex)) {
+			KERROR("Failed to create job thread mutex!");
+			return false;
+		}
+		if (!ksemaphore_create(&thread->semaphore, JOB_THREAD_QUEUE_CAPACITY * JOB_PRIORITY_COUNT, 0)) {
+			KERROR("Failed to create job thread semaphore!");
 			return false;
 		}
-		kzero_memory(&state_ptr->job_threads[i].info, sizeof(job_info));
+		thread->result_arena = kallocate(JOB_RESULT_ARENA_SIZE, MEMORY_TAG_JOB);
+		thread->result_arena_head = 0;
+		thread->result_arena_tail = 0;
 	}
 
-	// Create needed mutexes
-	if (!kmutex_create(&state_ptr->result_mutex)) {
-		KERROR("Failed to create result mutex!");
-		return false;
-	}
-	if (!kmutex_create(&state_ptr->low_pri_queue_mutex)) {
-		KERROR("Failed to create low priority queue mutex!");
-		return false;
-	}
-	if (!kmutex_create(&state_ptr->normal_pri_queue_mutex)) {
-		KERROR("Failed to create normal priority queue mutex!");
-		return false;
-	}
-	if (!kmutex_create(&state_ptr->high_pri_queue_mutex)) {
-		KERROR("Failed to create high priority queue mutex!");
-		return false;
-	}
-	if (!kmutex_create(&state_ptr->job_status_mutex)) {
-		KERROR("Failed to create job status mutex!");
-		return false;
+	for (u8 i = 0; i < state_ptr->thread_count; ++i) {
+		if (!kthread_create(job_thread_run, &state_ptr->job_threads[i].index, false, &state_ptr->job_threads[i].thread)) {
+			KFATAL("OS Error in creating job thread. Application cannot continue.");
+			return false;
+		}
 	}
 
 	return true;
@@ -251,193 +706,231 @@ void job_system_shutdown(void* state) {
 
 		u64 thread_count = state_ptr->thread_count;
 
-		// Check for a free thread first.
+		// Wake every thread so it can observe the shutdown.
 		for (u8 i = 0; i < thread_count; ++i) {
 			ksemaphore_signal(&state_ptr->job_threads[i].semaphore);
-			kthread_destroy(&state_ptr->job_threads[i].thread);
-			// Give it a bit.
-			/* kthread_sleep(&state_ptr->job_threads[i].thread, 100); */
 		}
 
-		// Wait for the threads to finish.
-		platform_sleep(100);
-		ring_queue_destroy(&state_ptr->low_priority_queue);
-		ring_queue_destroy(&state_ptr->normal_priority_queue);
-		ring_queue_destroy(&state_ptr->high_priority_queue);
+		// Wait for each thread to exit, so that it finishes its current job and flushes its memory cache.
+		for (u8 i = 0; i < thread_count; ++i) {
+			kthread* thread = &state_ptr->job_threads[i].thread;
+			if (!kthread_wait(thread)) {
+				KWARN("Failed to wait for job thread #%u to exit.", i);
+			}
+			kthread_destroy(thread);
+		}
+
+		for (u8 i = 0; i < thread_count; ++i) {
+			job_thread* thread = &state_ptr->job_threads[i];
+			for (u32 p = 0; p < JOB_PRIORITY_COUNT; ++p) {
+				ring_queue_destroy(&thread->queues[p]);
+			}
+			kmutex_destroy(&thread->queue_mutex);
+			ksemaphore_destroy(&thread->semaphore);
+		}
+
+		// Discard any results which were never processed, then the arenas holding them.
+		job_result_entry entry;
+		while (mpsc_queue_dequeue(&state_ptr->results, &entry)) {
+			result_release(&entry);
+		}
+		mpsc_queue_destroy(&state_ptr->results);
+		for (u8 i = 0; i < thread_count; ++i) {
+			kfree(state_ptr->job_threads[i].result_arena, JOB_RESULT_ARENA_SIZE, MEMORY_TAG_JOB);
+			state_ptr->job_threads[i].result_arena = 0;
+		}
 
 		// Destroy mutexes
-		kmutex_destroy(&state_ptr->result_mutex);
-		kmutex_destroy(&state_ptr->low_pri_queue_mutex);
-		kmutex_destroy(&state_ptr->normal_pri_queue_mutex);
-		kmutex_destroy(&state_ptr->high_pri_queue_mutex);
 		kmutex_destroy(&state_ptr->job_status_mutex);
+		kmutex_destroy(&state_ptr->parallel_for_mutex);
 
 		state_ptr = 0;
 	}
 }
 
-static void process_queue(ring_queue* queue, kmutex* queue_mutex) {
-	u64 thread_count = state_ptr->thread_count;
+b8 job_system_update(void* state, struct frame_data* p_frame_data) {
+	if (!state_ptr || !state_ptr->running) {
+		return false;
+	}
 
-	// Check for a free thread first.
-	while (queue->length > 0) {
-		job_info info;
-		if (!ring_queue_peek(queue, &info)) {
+	// Process pending results, in the order they were produced. This is capped at one queue's worth,
+	// so that callbacks which kick off short jobs cannot keep this going indefinitely.
+	job_result_entry entry;
+	for (u32 i = 0; i < JOB_RESULT_QUEUE_CAPACITY; ++i) {
+		if (!mpsc_queue_dequeue(&state_ptr->results, &entry)) {
 			break;
 		}
 
-		// Verify dependencies are complete.
-		b8 awaiting_dependency = false;
-		if (info.dependency_count) {
-			for (u32 i = 0; i < info.dependency_count; ++i) {
-				if (!job_system_query_job_complete(info.dependency_ids[i])) {
-					KTRACE("Note: Not starting job id %u because it's dependency (job id=%u) is still running.", info.id, info.dependency_ids[i]);
-					awaiting_dependency = true;
-					break;
-				}
-			}
-		}
+		// Execute the callback, then hand its payload back.
+		entry.callback(entry.params);
+		result_release(&entry);
+	}
 
-		if (awaiting_dependency) {
-			continue;
+	return true;
+}
+
+void job_system_submit(job_info info) {
+	// NOTE: Locking here since dependencies may complete on a job thread while they are being registered.
+	if (!kmutex_lock(&state_ptr->job_status_mutex)) {
+		KERROR("Failed to lock job status mutex!");
+	}
+	// Jobs with outstanding dependencies are parked until the last one completes. Otherwise
+	// the job is queued on a worker directly. Workers pull their own work (and steal from one
+	// another), so this does not need to wait for the next update.
+	submit_with_parents(&info, 0, 0);
+	if (!kmutex_unlock(&state_ptr->job_status_mutex)) {
+		KERROR("Failed to unlock job status mutex!");
+	}
+}
+
+b8 job_system_submit_graph(u32 job_count, job_info* jobs, u32 edge_count, const job_graph_edge* edges) {
+	if (!job_count || !jobs) {
+		KERROR("job_system_submit_graph requires at least one job.");
+		return false;
+	}
+	for (u32 e = 0; e < edge_count; ++e) {
+		if (edges[e].parent_index >= job_count || edges[e].child_index >= job_count || edges[e].parent_index == edges[e].child_index) {
+			KERROR("job_system_submit_graph - edge %u (%u -> %u) is invalid for a graph of %u jobs.", e, edges[e].parent_index, edges[e].child_index, job_count);
+			return false;
 		}
+	}
 
-		b8 thread_found = false;
-		for (u8 i = 0; i < thread_count; ++i) {
-			job_thread* thread = &state_ptr->job_threads[i];
-			if ((thread->type_mask & info.type) == 0) {
-				continue;
-			}
+	// Hold the lock for the entire graph so that no parent can complete and miss
+	// a child which has not been registered yet.
+	if (!kmutex_lock(&state_ptr->job_status_mutex)) {
+		KERROR("Failed to lock job status mutex!");
+	}
 
-			// Check that the job thread can handle the job type.
-			if (!kmutex_lock(&thread->info_mutex)) {
-				KERROR("Failed to obtain lock on job thread mutex!");
-			}
-			if (!thread->info.entry_point) {
-				// Make sure to remove the entry from the queue.
-				if (!kmutex_lock(queue_mutex)) {
-					KERROR("Failed to obtain lock on queue mutex!");
-				}
-				ring_queue_dequeue(queue, &info);
-				if (!kmutex_unlock(queue_mutex)) {
-					KERROR("Failed to release lock on queue mutex!");
-				}
-				thread->info = info;
-				KTRACE("Assigning job to thread: %u", thread->index);
-				thread_found = true;
-				// Signal the thread's semaphore since there is work to be done.
-				ksemaphore_signal(&thread->semaphore);
-			}
-			if (!kmutex_unlock(&thread->info_mutex)) {
-				KERROR("Failed to release lock on job thread mutex!");
+	b8 success = true;
+	for (u32 i = 0; i < job_count; ++i) {
+		// Gather the parents declared by graph edges for this job.
+		u16 parent_ids[64];
+		u32 parent_count = 0;
+		for (u32 e = 0; e < edge_count; ++e) {
+			if (edges[e].child_index != i) {
+				continue;
 			}
-
-			// Break after unlocking if an available thread was found.
-			if (thread_found) {
+			if (parent_count == 64) {
+				KERROR("job_system_submit_graph - job %u has more than 64 parents in the graph. Extra edges are ignored.", i);
 				break;
 			}
+			parent_ids[parent_count++] = jobs[edges[e].parent_index].id;
 		}
 
-		// This means all of the threads are currently handling a job,
-		// So wait until the next update and try again.
-		if (!thread_found) {
-			break;
+		if (!submit_with_parents(&jobs[i], parent_count, parent_ids)) {
+			success = false;
 		}
 	}
+
+	if (!kmutex_unlock(&state_ptr->job_status_mutex)) {
+		KERROR("Failed to unlock job status mutex!");
+	}
+	return success;
 }
 
-b8 job_system_update(void* state, struct frame_data* p_frame_data) {
-	if (!state_ptr || !state_ptr->running) {
-		return false;
+void job_system_parallel_for_begin(job_counter* counter, u32 count, u32 batch_size, pfn_job_parallel_for fn, void* context) {
+	KASSERT_DEBUG(counter);
+	KASSERT_DEBUG(fn);
+
+	u32 thread_count = state_ptr ? state_ptr->thread_count : 0;
+	if (batch_size == 0) {
+		// Aim for a few batches per thread (including the caller), so uneven batches balance out.
+		batch_size = KMAX(1, count / ((thread_count + 1) * 4));
 	}
 
-	process_queue(&state_ptr->high_priority_queue, &state_ptr->high_pri_queue_mutex);
-	process_queue(&state_ptr->normal_priority_queue, &state_ptr->normal_pri_queue_mutex);
-	process_queue(&state_ptr->low_priority_queue, &state_ptr->low_pri_queue_mutex);
+	counter->fn = fn;
+	counter->context = context;
+	counter->count = count;
+	counter->batch_size = batch_size;
+	counter->batch_count = count ? ((count + batch_size - 1) / batch_size) : 0;
+	counter->next_batch = 0;
+	katomic_store_u32(&counter->remaining, counter->batch_count);
 
-	// Process pending results.
-	for (u16 i = 0; i < MAX_JOB_RESULTS; ++i) {
-		// Lock and take a copy, unlock.
-		if (!kmutex_lock(&state_ptr->result_mutex)) {
-			KERROR("Failed to obtain lock on result mutex!");
-		}
-		job_result_entry entry = state_ptr->pending_results[i];
-		if (!kmutex_unlock(&state_ptr->result_mutex)) {
-			KERROR("Failed to release lock on result mutex!");
-		}
+	if (counter->batch_count == 0) {
+		return;
+	}
 
-		if (entry.id != INVALID_ID_U16) {
-			// Execute the callback.
-			entry.callback(entry.params);
+	// Small ranges (or no job threads) are just run on the calling thread when waited on.
+	if (counter->batch_count == 1 || thread_count == 0) {
+		return;
+	}
 
-			if (entry.params) {
-				kfree(entry.params, entry.param_size, MEMORY_TAG_JOB);
-			}
+	if (!kmutex_lock(&state_ptr->parallel_for_mutex)) {
+		KERROR("Failed to obtain lock on parallel-for mutex!");
+	}
+	b8 registered = false;
+	if (state_ptr->parallel_for_counter_count < MAX_PARALLEL_FOR_COUNTERS) {
+		state_ptr->parallel_for_counters[state_ptr->parallel_for_counter_count] = counter;
+		state_ptr->parallel_for_counter_count++;
+		registered = true;
+	}
+	if (!kmutex_unlock(&state_ptr->parallel_for_mutex)) {
+		KERROR("Failed to release lock on parallel-for mutex!");
+	}
 
-			// Lock actual entry, invalidate and clear it
-			if (!kmutex_lock(&state_ptr->result_mutex)) {
-				KERROR("Failed to obtain lock on result mutex!");
-			}
-			kzero_memory(&state_ptr->pending_results[i], sizeof(job_result_entry));
-			state_ptr->pending_results[i].id = INVALID_ID_U16;
-			if (!kmutex_unlock(&state_ptr->result_mutex)) {
-				KERROR("Failed to release lock on result mutex!");
-			}
-		}
+	if (!registered) {
+		KTRACE("Too many parallel-for counters active (max=%u). Batches will run on the waiting thread.", MAX_PARALLEL_FOR_COUNTERS);
+		return;
 	}
 
-	return true;
+	// Wake enough idle general-purpose threads to take the batches that the caller will not.
+	u32 to_wake = counter->batch_count - 1;
+	for (u8 i = 0; i < thread_count && to_wake; ++i) {
+		job_thread* thread = &state_ptr->job_threads[i];
+		if ((thread->type_mask & JOB_TYPE_GENERAL) && job_thread_wake(thread)) {
+			to_wake--;
+		}
+	}
 }
 
-void job_system_submit(job_info info) {
-	u64 thread_count = state_ptr->thread_count;
-	ring_queue* queue = &state_ptr->normal_priority_queue;
-	kmutex* queue_mutex = &state_ptr->normal_pri_queue_mutex;
-
-	// If the job is high priority, try to kick it off immediately.
-	if (info.priority == JOB_PRIORITY_HIGH) {
-		queue = &state_ptr->high_priority_queue;
-		queue_mutex = &state_ptr->high_pri_queue_mutex;
+void job_system_counter_wait(job_counter* counter) {
+	KASSERT_DEBUG(counter);
 
-		// Check for a free thread that supports the job type first.
-		for (u8 i = 0; i < thread_count; ++i) {
-			job_thread* thread = &state_ptr->job_threads[i];
-			if (state_ptr->job_threads[i].type_mask & info.type) {
-				b8 found = false;
-				if (!kmutex_lock(&thread->info_mutex)) {
-					KERROR("Failed to obtain lock on job thread mutex!");
-				}
-				if (!state_ptr->job_threads[i].info.entry_point) {
-					KTRACE("Job immediately submitted on thread %i", state_ptr->job_threads[i].index);
-					state_ptr->job_threads[i].info = info;
-					found = true;
-				}
-				if (!kmutex_unlock(&thread->info_mutex)) {
-					KERROR("Failed to release lock on job thread mutex!");
-				}
-				if (found) {
-					return;
-				}
-			}
+	if (counter->batch_count == 1 || !state_ptr || state_ptr->thread_count == 0) {
+		// Never registered, so just run everything here.
+		for (u32 b = counter->next_batch; b < counter->batch_count; ++b) {
+			parallel_for_run_batch(counter, b);
 		}
+		counter->next_batch = counter->batch_count;
+		return;
 	}
 
-	// If this point is reached, all threads are busy (if high) or it can wait a frame.
-	// Add to the queue and try again next cycle.
-	if (info.priority == JOB_PRIORITY_LOW) {
-		queue = &state_ptr->low_priority_queue;
-		queue_mutex = &state_ptr->low_pri_queue_mutex;
+	// Help out with this counter's batches rather than just blocking.
+	job_counter* claimed_counter = 0;
+	u32 batch = 0;
+	while (parallel_for_claim(counter, &claimed_counter, &batch)) {
+		parallel_for_run_batch(claimed_counter, batch);
 	}
 
-	// NOTE: Locking here in case the job is submitted from another job/thread.
-	if (!kmutex_lock(queue_mutex)) {
-		KERROR("Failed to obtain lock on queue mutex!");
+	// If registration failed, nothing else will ever claim the remaining batches.
+	if (!kmutex_lock(&state_ptr->parallel_for_mutex)) {
+		KERROR("Failed to obtain lock on parallel-for mutex!");
 	}
-	ring_queue_enqueue(queue, &info);
-	if (!kmutex_unlock(queue_mutex)) {
-		KERROR("Failed to release lock on queue mutex!");
+	u32 first_unclaimed = counter->next_batch;
+	counter->next_batch = counter->batch_count;
+	if (!kmutex_unlock(&state_ptr->parallel_for_mutex)) {
+		KERROR("Failed to release lock on parallel-for mutex!");
 	}
-	KTRACE("Job queued.");
+	for (u32 b = first_unclaimed; b < counter->batch_count; ++b) {
+		parallel_for_run_batch(counter, b);
+	}
+
+	// Everything has been claimed, so just wait for other threads to finish their batches.
+	// Yield every so often in case a thread running a batch has been preempted.
+	u32 spin_count = 0;
+	while (katomic_load_u32(&counter->remaining) > 0) {
+		if (++spin_count % 1024 == 0) {
+			platform_sleep(0);
+		} else {
+			katomic_pause();
+		}
+	}
+}
+
+void job_system_parallel_for(u32 count, u32 batch_size, pfn_job_parallel_for fn, void* context) {
+	job_counter counter;
+	job_system_parallel_for_begin(&counter, count, batch_size, fn, context);
+	job_system_counter_wait(&counter);
 }
 
 job_info job_create(pfn_job_start entry_point, pfn_job_on_complete on_success, pfn_job_on_complete on_fail, void* param_data, u32 param_data_size, u32 result_data_size) {
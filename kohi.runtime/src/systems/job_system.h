@@ -87,6 +87,46 @@ typedef struct job_info {
 	u16* dependency_ids;
 } job_info;
 
+/**
+ * @brief Describes a parent->child relationship between two jobs in a graph
+ * submitted via job_system_submit_graph. The child job does not start until
+ * the parent job has completed.
+ */
+typedef struct job_graph_edge {
+	/** @brief The index of the parent job within the submitted jobs array. */
+	u32 parent_index;
+	/** @brief The index of the child job within the submitted jobs array. */
+	u32 child_index;
+} job_graph_edge;
+
+/**
+ * @brief A function pointer definition for a batch of a parallel-for. Invoked with
+ * the half-open range of indices [start, end) to be processed by this batch.
+ */
+typedef void (*pfn_job_parallel_for)(u32 start, u32 end, void* context);
+
+/**
+ * @brief Tracks the progress of a parallel-for. Typically lives on the stack of the
+ * caller, which must wait on it via job_system_counter_wait before it goes out of scope.
+ * The fields are internal to the job system and should not be modified.
+ */
+typedef struct job_counter {
+	/** @brief The function invoked for each batch. */
+	pfn_job_parallel_for fn;
+	/** @brief The context passed to each invocation of fn. */
+	void* context;
+	/** @brief The total number of indices being processed. */
+	u32 count;
+	/** @brief The number of indices handed to each invocation of fn. */
+	u32 batch_size;
+	/** @brief The total number of batches. */
+	u32 batch_count;
+	/** @brief The index of the next batch to be claimed by a thread. */
+	u32 next_batch;
+	/** @brief The number of batches which have not yet finished. Complete when 0. */
+	volatile u32 remaining;
+} job_counter;
+
 typedef struct job_system_config {
 	/**
 	 * @param max_job_thread_count The maximum number of job threads to be spun up.
@@ -118,11 +158,57 @@ void job_system_shutdown(void* state);
 b8 job_system_update(void* state, struct frame_data* p_frame_data);
 
 /**
- * @brief Submits the provided job to be queued for execution.
+ * @brief Submits the provided job to be queued for execution. If the job has dependencies
+ * which are not yet complete, it is held back and released as soon as the last of them completes.
  * @param info The description of the job to be executed.
  */
 KAPI void job_system_submit(job_info info);
 
+/**
+ * @brief Submits a graph of jobs at once. Each edge makes its child job wait on its parent
+ * job, in addition to any dependency_ids the jobs were created with. Children are released
+ * onto the job threads the moment their last parent completes (whether it succeeded or failed),
+ * so chains of dependent jobs run back-to-back without waiting on the main thread.
+ * NOTE: The graph must not contain cycles, otherwise the jobs in the cycle will never run.
+ * @param job_count The number of jobs in the jobs array.
+ * @param jobs An array of jobs, each created via one of the job_create functions.
+ * @param edge_count The number of edges in the edges array. Pass 0 if not used.
+ * @param edges An array of parent->child relationships, by index into the jobs array. Optional.
+ * @returns True if every job in the graph was submitted; otherwise false.
+ */
+KAPI b8 job_system_submit_graph(u32 job_count, job_info* jobs, u32 edge_count, const job_graph_edge* edges);
+
+/**
+ * @brief Splits the range [0, count) into batches and starts processing them across the general
+ * job threads. Returns immediately; call job_system_counter_wait on the counter to wait for (and
+ * help with) completion. Batches may run on any thread, including the one that waits, so fn must
+ * only touch data which is independent between indices.
+ * @param counter A pointer to a counter to track progress. Must remain valid until waited on.
+ * @param count The number of indices to be processed.
+ * @param batch_size The number of indices per batch. Pass 0 to pick one based on the thread count.
+ * @param fn The function to be invoked for each batch. Required.
+ * @param context A context passed along to each invocation of fn. Optional.
+ */
+KAPI void job_system_parallel_for_begin(job_counter* counter, u32 count, u32 batch_size, pfn_job_parallel_for fn, void* context);
+
+/**
+ * @brief Waits for all batches of the parallel-for tracked by the given counter to complete.
+ * Rather than just blocking, the calling thread processes unclaimed batches itself.
+ * @param counter A pointer to the counter to wait on.
+ */
+KAPI void job_system_counter_wait(job_counter* counter);
+
+/**
+ * @brief Processes the range [0, count) in batches across the general job threads and the calling
+ * thread, returning once every batch has completed. Ranges that fit in a single batch are run
+ * directly on the calling thread.
+ * @param count The number of indices to be processed.
+ * @param batch_size The number of indices per batch. Pass 0 to pick one based on the thread count.
+ * @param fn The function to be invoked for each batch. Required.
+ * @param context A context passed along to each invocation of fn. Optional.
+ */
+KAPI void job_system_parallel_for(u32 count, u32 batch_size, pfn_job_parallel_for fn, void* context);
+
 /**
  * @brief Creates a new job with default type (Generic) and priority (Normal).
  * @param entry_point A pointer to a function to be invoked when the job starts. Required.
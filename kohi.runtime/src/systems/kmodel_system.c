@@ -17,6 +17,7 @@
 #include "renderer/renderer_types.h"
 #include "strings/kname.h"
 #include "systems/asset_system.h"
+#include "systems/job_system.h"
 #include "systems/kmaterial_system.h"
 
 static void animator_update(kmodel_system_state* state, kmodel_animator* animator, f32 delta_time);
@@ -27,6 +28,15 @@ static u16 get_new_instance_id(struct kmodel_system_state* state, u16 base_id);
 static void acquire_material_instances(struct kmodel_system_state* state, u16 base_id, u16 instance_id);
 
 static void animator_set_animation(kmodel_system_state* state, kmodel_animator* animator, kname name);
+static void animator_setup(kmodel_system_state* state, kmodel_base* base, kmodel_animator* animator);
+static void animator_buffers_create(kmodel_base* base, kmodel_animator* animator);
+static kmodel_animator* instance_animator_get(kmodel_system_state* state, kmodel_instance instance, u8 layer);
+static void animator_buffers_destroy(kmodel_animator* animator);
+static u32 base_find_node_index(kmodel_base* base, kname name);
+static void base_lookups_create(kmodel_base* base);
+static void base_lookups_destroy(kmodel_base* base);
+static void submesh_upload_complete(void* context);
+static void base_load_complete(kmodel_system_state* state, u16 base_id);
 
 b8 kmodel_system_initialize(u64* memory_requirement, kmodel_system_state* memory, const kmodel_system_config* config) {
 	*memory_requirement = sizeof(kmodel_system_state);
@@ -55,12 +65,14 @@ b8 kmodel_system_initialize(u64* memory_requirement, kmodel_system_state* memory
 	state->shader_data = (kmodel_animation_shader_data*)state->shader_data_pool.memory;
 
 	state->instance_queue = darray_create(kmodel_instance_queue_entry);
+	state->update_list = darray_create(kmodel_animator*);
 
 	return true;
 }
 
 void kmodel_system_shutdown(kmodel_system_state* state) {
 	darray_destroy(state->instance_queue);
+	darray_destroy(state->update_list);
 	for (u32 b = 0; b < state->max_mesh_count; ++b) {
 		u32 instance_count = state->models[b].instance_count;
 
@@ -77,22 +89,60 @@ void kmodel_system_shutdown(kmodel_system_state* state) {
 	}
 }
 
+typedef struct animator_update_batch_context {
+	kmodel_system_state* state;
+	f32 delta_time;
+} animator_update_batch_context;
+
+static void animator_update_batch(u32 start, u32 end, void* context) {
+	animator_update_batch_context* typed_context = context;
+	for (u32 i = start; i < end; ++i) {
+		animator_update(typed_context->state, typed_context->state->update_list[i], typed_context->delta_time);
+	}
+}
+
 void kmodel_system_update(kmodel_system_state* state, f32 delta_time, frame_data* p_frame_data) {
-	// Iterate all mesh instances and update thier final_bone_matrices.
+	// Gather up all playing animators. Each one only writes to its own state and final_bone_matrices,
+	// so they can be updated across job threads.
+	darray_clear(state->update_list);
 	for (u32 b = 0; b < state->max_mesh_count; ++b) {
 		u32 instance_count = state->models[b].instance_count;
 
 		for (u32 i = 0; i < instance_count; ++i) {
-			animator_update(state, &state->models[b].instances[i].animator, delta_time);
+			kmodel_animator* animator = &state->models[b].instances[i].animator;
+			if (animator->current_animation != INVALID_ID_U16 && animator->state == KMODEL_ANIMATOR_STATE_PLAYING) {
+				darray_push(state->update_list, animator);
+			}
+		}
+	}
+
+	u32 update_count = darray_length(state->update_list);
+	animator_update_batch_context context = {.state = state, .delta_time = delta_time};
+	job_system_parallel_for(update_count, 4, animator_update_batch, &context);
+
+	// Fire completion events from here, as the above may have run on other threads.
+	for (u32 i = 0; i < update_count; ++i) {
+		kmodel_animator* animator = state->update_list[i];
+		if (animator->completion_pending) {
+			animator->completion_pending = false;
+			kmodel_animation* current = &state->models[animator->base].animations[animator->current_animation];
+			KTRACE("Animation complete: %k", current->name);
+			event_context ctx = {
+				.data.u64[0] = current->name};
+			event_fire(EVENT_CODE_ANIMATION_COMPLETE, animator, ctx);
 		}
 	}
 }
 
 void kmodel_system_frame_prepare(kmodel_system_state* state, frame_data* p_frame_data) {
-	// Upload all of the mesh instance final_bone_matrices to the SSBO.
+	// Upload all of the mesh instance final_bone_matrices to the SSBO. Palettes are handed out
+	// lowest index first, so those in use are packed at the start.
+	if (!state->shader_data_used_count) {
+		return;
+	}
 	void* memory = renderer_renderbuffer_get_mapped_memory(engine_systems_get()->renderer_system, state->global_animation_ssbo);
 
-	kcopy_memory(memory, state->shader_data, sizeof(kmodel_animation_shader_data) * state->max_instance_count);
+	kcopy_memory(memory, state->shader_data, sizeof(kmodel_animation_shader_data) * state->shader_data_used_count);
 }
 
 void kmodel_system_time_scale(kmodel_system_state* state, f32 time_scale) {
@@ -109,6 +159,20 @@ typedef struct animated_mesh_asset_request_listener {
 	u16 base_id;
 } animated_mesh_asset_request_listener;
 
+// Made once all of a submesh's data has been uploaded. The base finishes loading along with its last submesh.
+static void submesh_upload_complete(void* context) {
+	animated_mesh_asset_request_listener* listener = (animated_mesh_asset_request_listener*)context;
+	kmodel_system_state* state = listener->state;
+	kmodel_base* base = &state->models[listener->base_id];
+
+	base->pending_upload_count--;
+	if (!base->pending_upload_count) {
+		base->upload_context = KNULL;
+		base_load_complete(state, listener->base_id);
+		KFREE_TYPE(listener, animated_mesh_asset_request_listener, MEMORY_TAG_ASSET);
+	}
+}
+
 static void kasset_model_loaded(void* listener, kasset_model* asset) {
 	animated_mesh_asset_request_listener* typed_listener = (animated_mesh_asset_request_listener*)listener;
 	KDEBUG("%s - model loaded", __FUNCTION__);
@@ -171,6 +235,7 @@ static void kasset_model_loaded(void* listener, kasset_model* asset) {
 			target->ticks_per_second = source->ticks_per_second;
 			target->duration = source->duration;
 			target->channel_count = source->channel_count;
+			base->max_channel_count = KMAX(base->max_channel_count, target->channel_count);
 			if (target->channel_count) {
 				target->channels = KALLOC_TYPE_CARRAY(kmodel_channel, target->channel_count);
 
@@ -208,6 +273,9 @@ static void kasset_model_loaded(void* listener, kasset_model* asset) {
 		}
 	}
 
+	// Resolve node hierarchy, channel and bone lookups once rather than on every update.
+	base_lookups_create(base);
+
 	struct renderer_system_state* renderer_system = engine_systems_get()->renderer_system;
 	krenderbuffer standard_vertex_buffer = renderer_renderbuffer_get(renderer_system, kname_create(KRENDERBUFFER_NAME_VERTEX_STANDARD));
 	krenderbuffer index_buffer = renderer_renderbuffer_get(renderer_system, kname_create(KRENDERBUFFER_NAME_INDEX_STANDARD));
@@ -268,8 +336,9 @@ static void kasset_model_loaded(void* listener, kasset_model* asset) {
 				KERROR("Model system failed to allocate from the renderer's vertex buffer! Submesh geometry won't be uploaded (skipped)");
 				continue;
 			}
-			// TODO: Passing false here produces a queue wait and should be offloaded to another queue.
-			if (!renderer_renderbuffer_load_range(renderer_system, standard_vertex_buffer, target->geo.vertex_buffer_offset + standard_vertex_offset, standard_vertex_size, target->geo.vertices + standard_vertex_offset, false)) {
+			// Loaded asynchronously. The geometry becomes valid to render once the last of the base's uploads completes.
+			u64 index_size = (u64)(sizeof(u32) * source->index_count);
+			if (!renderer_renderbuffer_load_range_async(renderer_system, standard_vertex_buffer, target->geo.vertex_buffer_offset + standard_vertex_offset, standard_vertex_size, target->geo.vertices + standard_vertex_offset, index_size ? 0 : submesh_upload_complete, listener)) {
 				KERROR("Model system failed to upload to the standard vertex buffer!");
 				if (!renderer_renderbuffer_free(renderer_system, standard_vertex_buffer, standard_vertex_size, target->geo.vertex_buffer_offset)) {
 					KERROR("Failed to recover from vertex write failure while freeing standard vertex buffer range.");
@@ -278,7 +347,6 @@ static void kasset_model_loaded(void* listener, kasset_model* asset) {
 			}
 
 			// Index data, if applicable
-			u64 index_size = (u64)(sizeof(u32) * source->index_count);
 			u64 index_offset = 0;
 			if (index_size) {
 				// Allocate space in the buffer.
@@ -291,11 +359,10 @@ static void kasset_model_loaded(void* listener, kasset_model* asset) {
 					continue;
 				}
 
-				// Load the data.
-				// TODO: Passing false here produces a queue wait and should be offloaded to another queue.
-				if (!renderer_renderbuffer_load_range(renderer_system, index_buffer, target->geo.index_buffer_offset + index_offset, index_size, target->geo.indices + index_offset, false)) {
+				// Load the data. Uploads complete in order, so this completing means the vertex data has too.
+				if (!renderer_renderbuffer_load_range_async(renderer_system, index_buffer, target->geo.index_buffer_offset + index_offset, index_size, target->geo.indices + index_offset, submesh_upload_complete, listener)) {
 					KERROR("Model system failed to upload to the renderer index buffer!");
-					// Free vertex data
+					// Free vertex data. The vertex upload has no callback, and the range is held until it is done.
 					if (!renderer_renderbuffer_free(renderer_system, standard_vertex_buffer, standard_vertex_size, target->geo.vertex_buffer_offset)) {
 						KERROR("Failed to recover from index write failure while freeing vertex buffer range.");
 					}
@@ -307,7 +374,33 @@ static void kasset_model_loaded(void* listener, kasset_model* asset) {
 				}
 			}
 
-			target->geo.generation++;
+			target->upload_pending = true;
+			base->pending_upload_count++;
+		}
+	}
+
+	// After copying over all properties, release the asset.
+	asset_system_release_model(engine_systems_get()->asset_state, asset);
+
+	if (base->pending_upload_count) {
+		// Stays loading until the uploads complete. The listener identifies them until then.
+		base->upload_context = listener;
+	} else {
+		// Nothing to wait on.
+		base_load_complete(state, base_id);
+		KFREE_TYPE(listener, animated_mesh_asset_request_listener, MEMORY_TAG_ASSET);
+	}
+}
+
+// Makes the base's uploaded geometry valid to render, then sets up the instances waiting on it.
+static void base_load_complete(kmodel_system_state* state, u16 base_id) {
+	kmodel_base* base = &state->models[base_id];
+
+	for (u32 i = 0; i < base->submesh_count; ++i) {
+		kmodel_submesh* mesh = &base->meshes[i];
+		if (mesh->upload_pending) {
+			mesh->upload_pending = false;
+			mesh->geo.generation++;
 		}
 	}
 
@@ -316,7 +409,7 @@ static void kasset_model_loaded(void* listener, kasset_model* asset) {
 	// Setup queued instances.
 	for (u16 i = 0; i < darray_length(state->instance_queue);) {
 		kmodel_instance_queue_entry* entry = &state->instance_queue[i];
-		if (entry->base_mesh_id == typed_listener->base_id) {
+		if (entry->base_mesh_id == base_id) {
 
 			u16 instance_id = entry->instance_id;
 
@@ -327,41 +420,23 @@ static void kasset_model_loaded(void* listener, kasset_model* asset) {
 
 			// For animated models, alloc shader data from the animation SSBO.
 			if (base->type == KMODEL_TYPE_ANIMATED) {
-				kmodel_animator* animator = &instance->animator;
-				animator->shader_data = pool_allocator_allocate(&state->shader_data_pool, &animator->shader_data_index);
-				animator->time_scale = 1.0f; // Always default time scale to 1.0f
-				animator->max_bones = base->bone_count;
-				animator->time_in_ticks = 0.0f;
-
-				// Auto-set the first animation and simulate a frame being updated so it shows up
-				// properly.
-				animator->current_animation = 0;
-				animator->current_animation_name = base->animations[0].name;
-
-				kmodel_animator_state prev_state = animator->state;
-				animator->state = KMODEL_ANIMATOR_STATE_PLAYING;
-				animator_update(state, animator, 0.0f);
-				animator->state = prev_state;
+				animator_setup(state, base, &instance->animator);
 			}
 
-			if (entry->callback) {
+			// Copied out first, as the callback may acquire more instances and grow the queue.
+			kmodel_instance_queue_entry ready = *entry;
+			darray_pop_at(state->instance_queue, i, 0);
+
+			if (ready.callback) {
 				kmodel_instance inst = {
-					.instance = entry->instance_id,
-					.base_mesh = typed_listener->base_id};
-				entry->callback(inst, entry->context);
+					.instance = ready.instance_id,
+					.base_mesh = base_id};
+				ready.callback(inst, ready.context);
 			}
-
-			darray_pop_at(state->instance_queue, i, 0);
 		} else {
 			++i;
 		}
 	}
-
-	// After copying over all properties, release the asset.
-	asset_system_release_model(engine_systems_get()->asset_state, asset);
-
-	// Cleanup the listener.
-	KFREE_TYPE(listener, animated_mesh_asset_request_listener, MEMORY_TAG_ASSET);
 }
 
 static void acquire_material_instances(struct kmodel_system_state* state, u16 base_id, u16 instance_id) {
@@ -405,6 +480,7 @@ kmodel_instance kmodel_instance_acquire_from_package(struct kmodel_system_state*
 		animated_mesh_asset_request_listener* listener = KALLOC_TYPE(animated_mesh_asset_request_listener, MEMORY_TAG_ASSET);
 		listener->state = state;
 		listener->base_id = base_id;
+		state->states[base_id] = KMODEL_STATE_LOADING;
 
 		// Queue this so that we can make the callback when it loads.
 		kmodel_instance_queue_entry new_entry = {
@@ -424,32 +500,18 @@ kmodel_instance kmodel_instance_acquire_from_package(struct kmodel_system_state*
 		KASSERT_DEBUG(asset);
 	} else {
 		KTRACE("Base mesh for '%k' already exists (%u). Getting new instance.", asset_name, base_id);
-		// Base mesh already exists, just need to get material instances.
-		kmodel_base* base = &state->models[base_id];
-		kmodel_instance_data* instance = &state->models[base_id].instances[instance_id];
-
-		acquire_material_instances(state, base_id, instance_id);
-
-		// For animated models, alloc shader data from the animation SSBO.
-		if (base->type == KMODEL_TYPE_ANIMATED) {
-			kmodel_animator* animator = &instance->animator;
-			animator->shader_data = pool_allocator_allocate(&state->shader_data_pool, &animator->shader_data_index);
-			animator->time_scale = 1.0f; // Always default time scale to 1.0f
-			animator->max_bones = base->bone_count;
-			animator->time_in_ticks = 0.0f;
+		if (state->states[base_id] == KMODEL_STATE_LOADED) {
+			// Base mesh already exists, just need to get material instances.
+			kmodel_base* base = &state->models[base_id];
+			kmodel_instance_data* instance = &state->models[base_id].instances[instance_id];
 
-			// Auto-set the first animation and simulate a frame being updated so it shows up
-			// properly.
-			animator->current_animation = 0;
-			animator->current_animation_name = base->animations[0].name;
+			acquire_material_instances(state, base_id, instance_id);
 
-			kmodel_animator_state prev_state = animator->state;
-			animator->state = KMODEL_ANIMATOR_STATE_PLAYING;
-			animator_update(state, animator, 0.0f);
-			animator->state = prev_state;
-		}
+			// For animated models, alloc shader data from the animation SSBO.
+			if (base->type == KMODEL_TYPE_ANIMATED) {
+				animator_setup(state, base, &instance->animator);
+			}
 
-		if (state->states[base_id] == KMODEL_STATE_LOADED) {
 			// Make the callback immediately if loaded.
 			if (callback) {
 				callback((kmodel_instance){.base_mesh = base_id, .instance = instance_id}, context);
@@ -504,6 +566,7 @@ void kmodel_instance_release(struct kmodel_system_state* state, kmodel_instance*
 		pool_allocator_free(&state->shader_data_pool, animator->shader_data);
 		animator->shader_data = KNULL;
 	}
+	animator_buffers_destroy(animator);
 
 	kzero_memory(animator, sizeof(kmodel_animator));
 	animator->base = INVALID_ID_U16;
@@ -532,6 +595,14 @@ void kmodel_instance_release(struct kmodel_system_state* state, kmodel_instance*
 		krenderbuffer standard_vertex_buffer = renderer_renderbuffer_get(renderer_system, kname_create(KRENDERBUFFER_NAME_VERTEX_STANDARD));
 		krenderbuffer index_buffer = renderer_renderbuffer_get(renderer_system, kname_create(KRENDERBUFFER_NAME_INDEX_STANDARD));
 
+		// Stop any uploads still in progress. Their ranges are held until they are done.
+		if (base->upload_context) {
+			renderer_uploads_cancel(renderer_system, base->upload_context);
+			KFREE_TYPE(base->upload_context, animated_mesh_asset_request_listener, MEMORY_TAG_ASSET);
+			base->upload_context = KNULL;
+			base->pending_upload_count = 0;
+		}
+
 		// Unload submeshes from GPU.
 		if (base->meshes && base->submesh_count) {
 			for (u32 i = 0; i < base->submesh_count; ++i) {
@@ -556,6 +627,8 @@ void kmodel_instance_release(struct kmodel_system_state* state, kmodel_instance*
 			base->submesh_count = 0;
 		}
 
+		base_lookups_destroy(base);
+
 		// Cleanup animations.
 		if (base->animation_count && base->animations) {
 			for (u32 i = 0; i < base->animation_count; ++i) {
@@ -585,6 +658,7 @@ void kmodel_instance_release(struct kmodel_system_state* state, kmodel_instance*
 			KFREE_TYPE_CARRAY(base->animations, kmodel_animation, base->animation_count);
 			base->animations = KNULL;
 			base->animation_count = 0;
+			base->max_channel_count = 0;
 		}
 
 		if (base->node_count && base->nodes) {
@@ -604,7 +678,7 @@ void kmodel_instance_release(struct kmodel_system_state* state, kmodel_instance*
 		if (base->bone_count && base->bones) {
 			KFREE_TYPE_CARRAY(base->bones, kmodel_bone, base->bone_count);
 			base->bones = KNULL;
-			base->node_count = 0;
+			base->bone_count = 0;
 		}
 	} else {
 		KDEBUG("Released instance, but there are %u remaining active instances of model '%s' active.", active_count, kname_string_get(state->models[instance->base_mesh].asset_name));
@@ -705,6 +779,174 @@ void kmodel_instance_animation_set(struct kmodel_system_state* state, kmodel_ins
 	}
 }
 
+void kmodel_instance_animation_crossfade(struct kmodel_system_state* state, kmodel_instance instance, kname animation_name, f32 duration) {
+	kmodel_base* base = &state->models[instance.base_mesh];
+	kmodel_animator* animator = &base->instances[instance.instance].animator;
+	if (duration <= 0.0f || animator->current_animation == INVALID_ID_U16 || !animator->fade_cursors) {
+		kmodel_instance_animation_set(state, instance, animation_name);
+		return;
+	}
+	if (animator->current_animation_name == animation_name) {
+		return;
+	}
+
+	for (u16 i = 0; i < base->animation_count; ++i) {
+		if (base->animations[i].name == animation_name) {
+			// The current animation keeps playing, along with its cursors, as it fades out.
+			animator->fade_animation = animator->current_animation;
+			animator->fade_time_in_ticks = animator->time_in_ticks;
+			animator->fade_loop = animator->loop;
+			animator->fade_duration = duration;
+			animator->fade_elapsed = 0.0f;
+			kmodel_channel_cursor* fade_cursors = animator->fade_cursors;
+			animator->fade_cursors = animator->cursors;
+			animator->cursors = fade_cursors;
+			kzero_memory(animator->cursors, sizeof(kmodel_channel_cursor) * animator->cursor_count);
+
+			animator->current_animation = i;
+			animator->current_animation_name = animation_name;
+			animator->time_in_ticks = 0.0f;
+			return;
+		}
+	}
+
+	KWARN("Animation '%k' not found on base mesh '%k'. Nothing to crossfade to.", animation_name, base->asset_name);
+}
+
+b8 kmodel_instance_layer_set(struct kmodel_system_state* state, kmodel_instance instance, u8 layer, kname animation_name, kmodel_animation_blend_mode mode, f32 weight, b8 loop) {
+	kmodel_animator* animator = instance_animator_get(state, instance, layer);
+	if (!animator) {
+		return false;
+	}
+
+	kmodel_base* base = &state->models[instance.base_mesh];
+	for (u16 i = 0; i < base->animation_count; ++i) {
+		if (base->animations[i].name == animation_name) {
+			kmodel_animation_layer* l = &animator->layers[layer];
+			if (!l->cursors && animator->cursor_count) {
+				l->cursors = KALLOC_TYPE_CARRAY(kmodel_channel_cursor, animator->cursor_count);
+			} else if (l->cursors) {
+				kzero_memory(l->cursors, sizeof(kmodel_channel_cursor) * animator->cursor_count);
+			}
+			l->active = true;
+			l->animation = i;
+			l->time_in_ticks = 0.0f;
+			l->loop = loop;
+			l->mode = mode;
+			l->weight = weight;
+			l->target_weight = weight;
+			l->weight_rate = 0.0f;
+			return true;
+		}
+	}
+
+	KERROR("%s - Animation '%k' not found on base mesh '%k'.", __FUNCTION__, animation_name, base->asset_name);
+	return false;
+}
+
+void kmodel_instance_layer_weight_set(struct kmodel_system_state* state, kmodel_instance instance, u8 layer, f32 weight, f32 duration) {
+	kmodel_animator* animator = instance_animator_get(state, instance, layer);
+	if (!animator) {
+		return;
+	}
+
+	kmodel_animation_layer* l = &animator->layers[layer];
+	l->target_weight = weight;
+	if (duration > 0.0f) {
+		l->weight_rate = kabs(weight - l->weight) / duration;
+	} else {
+		l->weight = weight;
+		l->weight_rate = 0.0f;
+	}
+}
+
+b8 kmodel_instance_layer_mask_set(struct kmodel_system_state* state, kmodel_instance instance, u8 layer, kname root_node_name) {
+	kmodel_animator* animator = instance_animator_get(state, instance, layer);
+	if (!animator) {
+		return false;
+	}
+
+	kmodel_base* base = &state->models[instance.base_mesh];
+	kmodel_animation_layer* l = &animator->layers[layer];
+	if (root_node_name == INVALID_KNAME) {
+		if (l->node_mask) {
+			KFREE_TYPE_CARRAY(l->node_mask, f32, animator->node_count);
+			l->node_mask = KNULL;
+		}
+		return true;
+	}
+
+	u32 root_index = base_find_node_index(base, root_node_name);
+	if (root_index == INVALID_ID || !animator->node_count) {
+		KERROR("%s - Node '%k' not found on base mesh '%k'.", __FUNCTION__, root_node_name, base->asset_name);
+		return false;
+	}
+
+	if (!l->node_mask) {
+		l->node_mask = KALLOC_TYPE_CARRAY(f32, animator->node_count);
+	}
+
+	// Nodes come after their parents in node_order, so a single pass reaches the whole subtree.
+	kzero_memory(l->node_mask, sizeof(f32) * animator->node_count);
+	l->node_mask[root_index] = 1.0f;
+	for (u32 o = 0; o < base->node_order_count; ++o) {
+		u16 node_index = base->node_order[o];
+		u16 parent_index = base->nodes[node_index].parent_index;
+		if (parent_index != INVALID_ID_U16 && l->node_mask[parent_index] > 0.0f) {
+			l->node_mask[node_index] = 1.0f;
+		}
+	}
+	return true;
+}
+
+void kmodel_instance_layer_clear(struct kmodel_system_state* state, kmodel_instance instance, u8 layer) {
+	kmodel_animator* animator = instance_animator_get(state, instance, layer);
+	if (animator) {
+		animator->layers[layer].active = false;
+	}
+}
+
+// Obtains the animator of an instance of an animated model, or 0 if the instance is not (yet) one.
+// Used by the LOD setters, which the scene calls on every model instance.
+static kmodel_animator* instance_lod_animator_get(kmodel_system_state* state, kmodel_instance instance) {
+	if (instance.base_mesh >= state->max_mesh_count) {
+		return 0;
+	}
+	kmodel_base* base = &state->models[instance.base_mesh];
+	if (instance.instance >= base->instance_count) {
+		return 0;
+	}
+	kmodel_animator* animator = &base->instances[instance.instance].animator;
+	return animator->shader_data ? animator : 0;
+}
+
+void kmodel_instance_lod_set(struct kmodel_system_state* state, kmodel_instance instance, u8 update_interval, b8 skip_leaf_bones) {
+	kmodel_animator* animator = instance_lod_animator_get(state, instance);
+	if (!animator) {
+		return;
+	}
+	if (animator->lod_update_interval != update_interval) {
+		animator->lod_update_interval = update_interval;
+		// Stagger instances sharing an interval across updates, rather than evaluating them all on the same one.
+		animator->lod_countdown = update_interval > 1 ? (u8)(animator->shader_data_index % update_interval) : 0;
+		animator->lod_previous_valid = false;
+	}
+	animator->lod_skip_leaf_bones = skip_leaf_bones;
+}
+
+void kmodel_instance_visibility_set(struct kmodel_system_state* state, kmodel_instance instance, b8 visible) {
+	kmodel_animator* animator = instance_lod_animator_get(state, instance);
+	if (!animator) {
+		return;
+	}
+	// Evaluate straight away on coming back into view, as the palette is out of date.
+	if (animator->lod_culled && visible) {
+		animator->lod_countdown = 0;
+		animator->lod_previous_valid = false;
+	}
+	animator->lod_culled = !visible;
+}
+
 u32 kmodel_instance_animation_id_get(struct kmodel_system_state* state, kmodel_instance instance) {
 	kmodel_base* base = &state->models[instance.base_mesh];
 	kmodel_instance_data* inst = &base->instances[instance.instance];
@@ -764,6 +1006,8 @@ void kmodel_instance_seek(struct kmodel_system_state* state, kmodel_instance ins
 
 	// Wrap around.
 	f32 duration = current->duration;
+	animator->lod_countdown = 0;
+	animator->lod_previous_valid = false;
 	if (duration > 0.0f) {
 		animator->time_in_ticks = ticks_per_second * kmod(time, duration);
 		if (animator->time_in_ticks < 0.0f) {
@@ -812,7 +1056,50 @@ static u32 base_find_bone_index(kmodel_base* base, kname name) {
 	return INVALID_ID;
 }
 
-static vec3 interpolate_position(const kmodel_channel* channel, f32 time) {
+// The number of keys stepped forward from a cursor before switching to a binary search.
+#define KEY_CURSOR_MAX_STEPS 4
+
+// Obtains the index of the last key at or after index lo whose time is at or before time,
+// given that key lo qualifies (or lo is 0). times points at the time of the first key, with
+// the times of subsequent keys each stride floats apart.
+static u32 key_search(const f32* times, u32 stride, u32 count, u32 lo, f32 time) {
+	u32 first = lo + 1;
+	u32 last = count;
+	while (first < last) {
+		u32 mid = first + ((last - first) / 2);
+		if (time >= times[mid * stride]) {
+			first = mid + 1;
+		} else {
+			last = mid;
+		}
+	}
+	return first - 1;
+}
+
+// Obtains the index of the key to interpolate from at the given time, being the last key
+// at or before that time (or the first key, if time precedes the second). During normal
+// playback this is found by stepping forward from the cursor. A binary search is used if
+// time has moved back (after a loop or seek) or too far forward.
+static u32 key_find(const f32* times, u32 stride, u32 count, f32 time, u32* cursor) {
+	u32 idx = *cursor;
+	if (idx >= count || (idx > 0 && time < times[idx * stride])) {
+		idx = key_search(times, stride, count, 0, time);
+	} else {
+		u32 steps = 0;
+		while (idx + 1 < count && time >= times[(idx + 1) * stride]) {
+			if (++steps > KEY_CURSOR_MAX_STEPS) {
+				idx = key_search(times, stride, count, idx + 1, time);
+				break;
+			}
+			idx++;
+		}
+	}
+
+	*cursor = idx;
+	return idx;
+}
+
+static vec3 interpolate_position(const kmodel_channel* channel, f32 time, u32* cursor) {
 	if (!channel->pos_count) {
 		return vec3_zero();
 	}
@@ -820,10 +1107,7 @@ static vec3 interpolate_position(const kmodel_channel* channel, f32 time) {
 		return channel->positions[0].value;
 	}
 
-	u32 idx = 0;
-	while (idx + 1 < channel->pos_count && time >= channel->positions[idx + 1].time) {
-		idx++;
-	}
+	u32 idx = key_find(&channel->positions[0].time, sizeof(anim_key_vec3) / sizeof(f32), channel->pos_count, time, cursor);
 	if (idx + 1 == channel->pos_count) {
 		return channel->positions[channel->pos_count - 1].value;
 	}
@@ -834,7 +1118,7 @@ static vec3 interpolate_position(const kmodel_channel* channel, f32 time) {
 	return vec3_lerp(channel->positions[idx].value, channel->positions[idx + 1].value, factor);
 }
 
-static quat interpolate_rotation(const kmodel_channel* channel, f32 time) {
+static quat interpolate_rotation(const kmodel_channel* channel, f32 time, u32* cursor) {
 	if (!channel->rot_count) {
 		return quat_identity();
 	}
@@ -842,10 +1126,7 @@ static quat interpolate_rotation(const kmodel_channel* channel, f32 time) {
 		return channel->rotations[0].value;
 	}
 
-	u32 idx = 0;
-	while (idx + 1 < channel->rot_count && time >= channel->rotations[idx + 1].time) {
-		idx++;
-	}
+	u32 idx = key_find(&channel->rotations[0].time, sizeof(anim_key_quat) / sizeof(f32), channel->rot_count, time, cursor);
 	if (idx + 1 == channel->rot_count) {
 		return channel->rotations[channel->rot_count - 1].value;
 	}
@@ -856,7 +1137,7 @@ static quat interpolate_rotation(const kmodel_channel* channel, f32 time) {
 	return quat_slerp(channel->rotations[idx].value, channel->rotations[idx + 1].value, factor);
 }
 
-static vec3 interpolate_scale(const kmodel_channel* channel, f32 time) {
+static vec3 interpolate_scale(const kmodel_channel* channel, f32 time, u32* cursor) {
 	if (!channel->scale_count) {
 		return vec3_zero();
 	}
@@ -864,10 +1145,7 @@ static vec3 interpolate_scale(const kmodel_channel* channel, f32 time) {
 		return channel->scales[0].value;
 	}
 
-	u32 idx = 0;
-	while (idx + 1 < channel->scale_count && time >= channel->scales[idx + 1].time) {
-		idx++;
-	}
+	u32 idx = key_find(&channel->scales[0].time, sizeof(anim_key_vec3) / sizeof(f32), channel->scale_count, time, cursor);
 	if (idx + 1 == channel->scale_count) {
 		return channel->scales[channel->scale_count - 1].value;
 	}
@@ -878,39 +1156,374 @@ static vec3 interpolate_scale(const kmodel_channel* channel, f32 time) {
 	return vec3_lerp(channel->scales[idx].value, channel->scales[idx + 1].value, factor);
 }
 
-static void process_animator(
-	kmodel_system_state* state,
-	kmodel_animator* animator,
-	kmodel_animation* animation,
-	u32 node_index,
-	const mat4 parent_transform) {
+static void pose_create(kmodel_pose* pose, u32 node_count) {
+	pose->translations = KALLOC_TYPE_CARRAY(vec3, node_count);
+	pose->rotations = KALLOC_TYPE_CARRAY(quat, node_count);
+	pose->scales = KALLOC_TYPE_CARRAY(vec3, node_count);
+}
 
-	kmodel_base* asset = &state->models[animator->base];
-	kmodel_node* node = &asset->nodes[node_index];
-	mat4 node_transform = node->local_transform;
+static void pose_destroy(kmodel_pose* pose, u32 node_count) {
+	if (pose->translations) {
+		KFREE_TYPE_CARRAY(pose->translations, vec3, node_count);
+		KFREE_TYPE_CARRAY(pose->rotations, quat, node_count);
+		KFREE_TYPE_CARRAY(pose->scales, vec3, node_count);
+	}
+	kzero_memory(pose, sizeof(kmodel_pose));
+}
+
+static void pose_copy(kmodel_pose* dest, const kmodel_pose* source, u32 node_count) {
+	KCOPY_TYPE_CARRAY(dest->translations, source->translations, vec3, node_count);
+	KCOPY_TYPE_CARRAY(dest->rotations, source->rotations, quat, node_count);
+	KCOPY_TYPE_CARRAY(dest->scales, source->scales, vec3, node_count);
+}
+
+// Splits a transform built by mat4_from_translation_rotation_scale back into its parts.
+// Shear and mirroring are not represented.
+static void transform_decompose(mat4 m, vec3* out_translation, quat* out_rotation, vec3* out_scale) {
+	const f32* d = m.data;
+	*out_translation = (vec3){d[12], d[13], d[14]};
+
+	vec3 s = {
+		ksqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]),
+		ksqrt(d[4] * d[4] + d[5] * d[5] + d[6] * d[6]),
+		ksqrt(d[8] * d[8] + d[9] * d[9] + d[10] * d[10])};
+	*out_scale = s;
+
+	f32 ix = s.x > K_FLOAT_EPSILON ? 1.0f / s.x : 0.0f;
+	f32 iy = s.y > K_FLOAT_EPSILON ? 1.0f / s.y : 0.0f;
+	f32 iz = s.z > K_FLOAT_EPSILON ? 1.0f / s.z : 0.0f;
+	f32 r0 = d[0] * ix, r1 = d[1] * ix, r2 = d[2] * ix;
+	f32 r4 = d[4] * iy, r5 = d[5] * iy, r6 = d[6] * iy;
+	f32 r8 = d[8] * iz, r9 = d[9] * iz, r10 = d[10] * iz;
+
+	// Solve from the largest of w, x, y and z, which keeps the division well conditioned.
+	quat q;
+	f32 trace = r0 + r5 + r10;
+	if (trace > 0.0f) {
+		f32 f = ksqrt(1.0f + trace) * 2.0f;
+		q = (quat){(r6 - r9) / f, (r8 - r2) / f, (r1 - r4) / f, 0.25f * f};
+	} else if (r0 > r5 && r0 > r10) {
+		f32 f = ksqrt(1.0f + r0 - r5 - r10) * 2.0f;
+		q = (quat){0.25f * f, (r1 + r4) / f, (r2 + r8) / f, (r6 - r9) / f};
+	} else if (r5 > r10) {
+		f32 f = ksqrt(1.0f + r5 - r0 - r10) * 2.0f;
+		q = (quat){(r1 + r4) / f, 0.25f * f, (r6 + r9) / f, (r8 - r2) / f};
+	} else {
+		f32 f = ksqrt(1.0f + r10 - r0 - r5) * 2.0f;
+		q = (quat){(r2 + r8) / f, (r6 + r9) / f, 0.25f * f, (r1 - r4) / f};
+	}
+	*out_rotation = quat_normalize(q);
+}
+
+static void base_lookups_create(kmodel_base* base) {
+	if (!base->node_count) {
+		return;
+	}
+
+	// Order the nodes breadth-first from each root, which puts every node after its parent.
+	// The order array itself serves as the queue.
+	base->node_order = KALLOC_TYPE_CARRAY(u16, base->node_count);
+	u32 order_count = 0;
+	for (u32 i = 0; i < base->node_count; ++i) {
+		if (base->nodes[i].parent_index == INVALID_ID_U16) {
+			base->node_order[order_count++] = (u16)i;
+		}
+	}
+	for (u32 head = 0; head < order_count; ++head) {
+		kmodel_node* node = &base->nodes[base->node_order[head]];
+		for (u32 c = 0; c < node->child_count && order_count < base->node_count; ++c) {
+			base->node_order[order_count++] = node->children[c];
+		}
+	}
+	base->node_order_count = order_count;
+
+	pose_create(&base->bind_pose, base->node_count);
+	for (u32 i = 0; i < base->node_count; ++i) {
+		transform_decompose(base->nodes[i].local_transform, &base->bind_pose.translations[i], &base->bind_pose.rotations[i], &base->bind_pose.scales[i]);
+	}
+
+	base->node_bone_indices = KALLOC_TYPE_CARRAY(u16, base->node_count);
+	for (u32 i = 0; i < base->node_count; ++i) {
+		u32 bone_index = base_find_bone_index(base, base->nodes[i].name);
+		base->node_bone_indices[i] = bone_index == INVALID_ID ? INVALID_ID_U16 : (u16)bone_index;
+	}
+
+	if (base->bone_count) {
+		base->bone_offsets = KALLOC_TYPE_CARRAY(mat4, base->bone_count);
+		base->bone_node_indices = KALLOC_TYPE_CARRAY(u16, base->bone_count);
+		for (u32 i = 0; i < base->bone_count; ++i) {
+			base->bone_offsets[i] = base->bones[i].offset;
+			base->bone_node_indices[i] = INVALID_ID_U16;
+		}
+		// Only nodes reachable from a root have their world transforms built.
+		for (u32 o = 0; o < base->node_order_count; ++o) {
+			u16 node_index = base->node_order[o];
+			u16 bone_index = base->node_bone_indices[node_index];
+			if (bone_index < base->bone_count) {
+				base->bone_node_indices[bone_index] = node_index;
+			}
+		}
+	}
+
+	for (u32 a = 0; a < base->animation_count; ++a) {
+		kmodel_animation* animation = &base->animations[a];
+		animation->node_channel_indices = KALLOC_TYPE_CARRAY(u16, base->node_count);
+		for (u32 i = 0; i < base->node_count; ++i) {
+			kmodel_channel* channel = kanimation_find_channel(animation, base->nodes[i].name);
+			animation->node_channel_indices[i] = channel ? (u16)(channel - animation->channels) : INVALID_ID_U16;
+		}
+	}
+}
+
+static void base_lookups_destroy(kmodel_base* base) {
+	if (base->node_order) {
+		KFREE_TYPE_CARRAY(base->node_order, u16, base->node_count);
+		base->node_order = KNULL;
+		base->node_order_count = 0;
+	}
+	if (base->node_bone_indices) {
+		KFREE_TYPE_CARRAY(base->node_bone_indices, u16, base->node_count);
+		base->node_bone_indices = KNULL;
+	}
+	if (base->bone_offsets) {
+		KFREE_TYPE_CARRAY(base->bone_offsets, mat4, base->bone_count);
+		base->bone_offsets = KNULL;
+	}
+	if (base->bone_node_indices) {
+		KFREE_TYPE_CARRAY(base->bone_node_indices, u16, base->bone_count);
+		base->bone_node_indices = KNULL;
+	}
+	pose_destroy(&base->bind_pose, base->node_count);
+	for (u32 a = 0; a < base->animation_count; ++a) {
+		kmodel_animation* animation = &base->animations[a];
+		if (animation->node_channel_indices) {
+			KFREE_TYPE_CARRAY(animation->node_channel_indices, u16, base->node_count);
+			animation->node_channel_indices = KNULL;
+		}
+	}
+}
+
+static void animator_setup(kmodel_system_state* state, kmodel_base* base, kmodel_animator* animator) {
+	animator->shader_data = pool_allocator_allocate(&state->shader_data_pool, &animator->shader_data_index);
+	state->shader_data_used_count = KMAX(state->shader_data_used_count, animator->shader_data_index + 1);
+	animator->time_scale = 1.0f; // Always default time scale to 1.0f
+	animator->max_bones = base->bone_count;
+	animator->time_in_ticks = 0.0f;
+	animator_buffers_create(base, animator);
+
+	// Auto-set the first animation and simulate a frame being updated so it shows up
+	// properly.
+	animator->current_animation = 0;
+	animator->current_animation_name = base->animations[0].name;
+
+	kmodel_animator_state prev_state = animator->state;
+	animator->state = KMODEL_ANIMATOR_STATE_PLAYING;
+	animator_update(state, animator, 0.0f);
+	animator->state = prev_state;
+}
+
+static void animator_buffers_create(kmodel_base* base, kmodel_animator* animator) {
+	animator->cursor_count = base->max_channel_count;
+	animator->cursors = animator->cursor_count ? KALLOC_TYPE_CARRAY(kmodel_channel_cursor, animator->cursor_count) : KNULL;
+	animator->fade_cursors = animator->cursor_count ? KALLOC_TYPE_CARRAY(kmodel_channel_cursor, animator->cursor_count) : KNULL;
+	animator->node_count = base->node_count;
+	if (animator->node_count) {
+		pose_create(&animator->pose, animator->node_count);
+		pose_create(&animator->blend_pose, animator->node_count);
+		pose_create(&animator->lod_previous_pose, animator->node_count);
+		animator->node_transforms = KALLOC_TYPE_CARRAY(mat4, animator->node_count);
+	}
+}
+
+static void animator_buffers_destroy(kmodel_animator* animator) {
+	for (u32 i = 0; i < KMODEL_ANIMATOR_MAX_LAYERS; ++i) {
+		kmodel_animation_layer* layer = &animator->layers[i];
+		if (layer->cursors) {
+			KFREE_TYPE_CARRAY(layer->cursors, kmodel_channel_cursor, animator->cursor_count);
+		}
+		if (layer->node_mask) {
+			KFREE_TYPE_CARRAY(layer->node_mask, f32, animator->node_count);
+		}
+		kzero_memory(layer, sizeof(kmodel_animation_layer));
+	}
+	if (animator->cursors) {
+		KFREE_TYPE_CARRAY(animator->cursors, kmodel_channel_cursor, animator->cursor_count);
+		animator->cursors = KNULL;
+	}
+	if (animator->fade_cursors) {
+		KFREE_TYPE_CARRAY(animator->fade_cursors, kmodel_channel_cursor, animator->cursor_count);
+		animator->fade_cursors = KNULL;
+	}
+	animator->fade_duration = 0.0f;
+	if (animator->node_count) {
+		pose_destroy(&animator->pose, animator->node_count);
+		pose_destroy(&animator->blend_pose, animator->node_count);
+		pose_destroy(&animator->lod_previous_pose, animator->node_count);
+		animator->lod_previous_valid = false;
+		KFREE_TYPE_CARRAY(animator->node_transforms, mat4, animator->node_count);
+		animator->node_transforms = KNULL;
+		animator->node_count = 0;
+	}
+}
+
+// Obtains the animator of an instance for use with the given layer. Returns 0 after logging why if
+// the handle or layer is out of range, or the model is not animated. Callers must check for this.
+static kmodel_animator* instance_animator_get(kmodel_system_state* state, kmodel_instance instance, u8 layer) {
+	if (layer >= KMODEL_ANIMATOR_MAX_LAYERS) {
+		KERROR("Animation layer %u is out of range. Must be less than %u.", layer, KMODEL_ANIMATOR_MAX_LAYERS);
+		return 0;
+	}
+	if (instance.base_mesh >= state->max_mesh_count || instance.instance >= state->models[instance.base_mesh].instance_count) {
+		KERROR("Model instance (base=%u, instance=%u) is out of range.", instance.base_mesh, instance.instance);
+		return 0;
+	}
+	kmodel_animator* animator = &state->models[instance.base_mesh].instances[instance.instance].animator;
+	if (!animator->shader_data) {
+		KERROR("Animation layers can only be used on instances of animated models.");
+		return 0;
+	}
+	return animator;
+}
+
+// Samples each node animated by the given animation into out_pose, leaving other nodes untouched.
+// Leaf nodes are also left untouched if skip_leaves is set.
+static void pose_sample(const kmodel_base* base, const kmodel_animation* animation, f32 time, kmodel_channel_cursor* cursors, u32 cursor_count, b8 skip_leaves, kmodel_pose* out_pose) {
+	for (u32 i = 0; i < base->node_count; ++i) {
+		u16 channel_index = animation->node_channel_indices[i];
+		if (channel_index == INVALID_ID_U16 || (skip_leaves && !base->nodes[i].child_count)) {
+			continue;
+		}
+
+		const kmodel_channel* channel = &animation->channels[channel_index];
+		kmodel_channel_cursor fallback_cursor = {0};
+		kmodel_channel_cursor* cursor = channel_index < cursor_count ? &cursors[channel_index] : &fallback_cursor;
+		out_pose->translations[i] = interpolate_position(channel, time, &cursor->position);
+		out_pose->rotations[i] = interpolate_rotation(channel, time, &cursor->rotation);
+		out_pose->scales[i] = interpolate_scale(channel, time, &cursor->scale);
+	}
+}
 
-	kmodel_channel* channel = kanimation_find_channel(animation, node->name);
-	if (channel) {
-		vec3 translation = interpolate_position(channel, animator->time_in_ticks);
-		quat rotation = interpolate_rotation(channel, animator->time_in_ticks);
-		vec3 scale = interpolate_scale(channel, animator->time_in_ticks);
-		node_transform = mat4_from_translation_rotation_scale(translation, rotation, scale);
+// Normalized lerp along the shorter arc. Close enough to slerp for blending poses, and much cheaper.
+static quat quat_nlerp(quat a, quat b, f32 t) {
+	if (quat_dot(a, b) < 0.0f) {
+		b = (quat){-b.x, -b.y, -b.z, -b.w};
 	}
+	return quat_normalize((quat){a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t});
+}
+
+// Blends pose toward other by weight, for every node.
+static void pose_blend(kmodel_pose* pose, const kmodel_pose* other, f32 weight, u32 node_count) {
+	for (u32 i = 0; i < node_count; ++i) {
+		pose->translations[i] = vec3_lerp(pose->translations[i], other->translations[i], weight);
+		pose->rotations[i] = quat_nlerp(pose->rotations[i], other->rotations[i], weight);
+		pose->scales[i] = vec3_lerp(pose->scales[i], other->scales[i], weight);
+	}
+}
 
-	mat4 world_transform = mat4_mul(node_transform, parent_transform);
+// Blends a layer's samples into pose, for the nodes the layer's animation animates.
+static void pose_blend_layer(const kmodel_base* base, kmodel_pose* pose, const kmodel_pose* layer_pose, const kmodel_animation_layer* layer) {
+	const kmodel_animation* animation = &base->animations[layer->animation];
+	for (u32 i = 0; i < base->node_count; ++i) {
+		u16 channel_index = animation->node_channel_indices[i];
+		f32 weight = layer->node_mask ? layer->weight * layer->node_mask[i] : layer->weight;
+		if (channel_index == INVALID_ID_U16 || weight <= 0.0f) {
+			continue;
+		}
+
+		if (layer->mode == KMODEL_ANIMATION_BLEND_MODE_OVERRIDE) {
+			pose->translations[i] = vec3_lerp(pose->translations[i], layer_pose->translations[i], weight);
+			pose->rotations[i] = quat_nlerp(pose->rotations[i], layer_pose->rotations[i], weight);
+			pose->scales[i] = vec3_lerp(pose->scales[i], layer_pose->scales[i], weight);
+			continue;
+		}
 
-	u32 bone_index = base_find_bone_index(asset, node->name);
-	mat4 final_matrix = world_transform;
-	if (bone_index < animator->max_bones) {
-		final_matrix = mat4_mul(asset->bones[bone_index].offset, final_matrix);
-		animator->shader_data->final_bone_matrices[bone_index] = final_matrix;
+		// Additive: apply the change from each track's first key, in the node's local space.
+		const kmodel_channel* channel = &animation->channels[channel_index];
+		if (channel->pos_count) {
+			vec3 delta = vec3_sub(layer_pose->translations[i], channel->positions[0].value);
+			pose->translations[i] = vec3_add(pose->translations[i], vec3_mul_scalar(delta, weight));
+		}
+		if (channel->rot_count) {
+			quat delta = quat_mul(quat_inverse(channel->rotations[0].value), layer_pose->rotations[i]);
+			pose->rotations[i] = quat_normalize(quat_mul(pose->rotations[i], quat_nlerp(quat_identity(), delta, weight)));
+		}
+		if (channel->scale_count) {
+			vec3 reference = channel->scales[0].value;
+			vec3 ratio = {
+				kabs(reference.x) > K_FLOAT_EPSILON ? layer_pose->scales[i].x / reference.x : 1.0f,
+				kabs(reference.y) > K_FLOAT_EPSILON ? layer_pose->scales[i].y / reference.y : 1.0f,
+				kabs(reference.z) > K_FLOAT_EPSILON ? layer_pose->scales[i].z / reference.z : 1.0f};
+			pose->scales[i] = vec3_mul(pose->scales[i], vec3_lerp(vec3_one(), ratio, weight));
+		}
 	}
+}
 
-	// Recurse children.
-	for (u32 i = 0; i < node->child_count; ++i) {
-		u32 ci = node->children[i];
-		process_animator(state, animator, animation, ci, world_transform);
+static b8 layer_contributes(const kmodel_animation_layer* layer) {
+	return layer->active && (layer->weight > 0.0f || layer->target_weight > 0.0f);
+}
+
+// Indicates if any animation being played this update animates the given node.
+static b8 node_is_animated(const kmodel_base* base, const kmodel_animator* animator, u16 node_index) {
+	if (base->animations[animator->current_animation].node_channel_indices[node_index] != INVALID_ID_U16) {
+		return true;
+	}
+	if (animator->fade_duration > 0.0f && base->animations[animator->fade_animation].node_channel_indices[node_index] != INVALID_ID_U16) {
+		return true;
 	}
+	for (u32 l = 0; l < KMODEL_ANIMATOR_MAX_LAYERS; ++l) {
+		const kmodel_animation_layer* layer = &animator->layers[l];
+		if (layer_contributes(layer) && base->animations[layer->animation].node_channel_indices[node_index] != INVALID_ID_U16) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Builds world transforms from the given local pose (or the local transform of nodes which are not
+// animated) and writes the skinning palette.
+static void animator_pose_apply(kmodel_base* base, kmodel_animator* animator, const kmodel_pose* pose, b8 blended) {
+	const kmodel_animation* current = &base->animations[animator->current_animation];
+	mat4* palette = animator->shader_data->final_bone_matrices;
+
+	// Parents are always processed before their children, so their world transforms are ready.
+	for (u32 o = 0; o < base->node_order_count; ++o) {
+		u16 node_index = base->node_order[o];
+		kmodel_node* node = &base->nodes[node_index];
+
+		b8 animated = blended ? node_is_animated(base, animator, node_index) : current->node_channel_indices[node_index] != INVALID_ID_U16;
+		animated &= !(animator->lod_skip_leaf_bones && !node->child_count);
+		mat4 node_transform = animated
+								  ? mat4_from_translation_rotation_scale(pose->translations[node_index], pose->rotations[node_index], pose->scales[node_index])
+								  : node->local_transform;
+
+		mat4 parent_transform = node->parent_index == INVALID_ID_U16 ? base->global_inverse_transform : animator->node_transforms[node->parent_index];
+		animator->node_transforms[node_index] = mat4_mul(node_transform, parent_transform);
+	}
+
+	// Gather each bone's world transform into its palette entry, then apply the offsets in place as one batch.
+	// Bones without a node keep the identity.
+	u32 bone_count = base->bone_offsets ? KMIN(base->bone_count, animator->max_bones) : 0;
+	for (u32 b = 0; b < bone_count; ++b) {
+		u16 node_index = base->bone_node_indices[b];
+		palette[b] = node_index == INVALID_ID_U16 ? mat4_identity() : animator->node_transforms[node_index];
+	}
+	mat4_mul_batch(base->bone_offsets, palette, palette, bone_count);
+	for (u32 b = 0; b < bone_count; ++b) {
+		if (base->bone_node_indices[b] == INVALID_ID_U16) {
+			palette[b] = mat4_identity();
+		}
+	}
+}
+
+// Blends from the previously evaluated pose toward the latest one by how far through the LOD
+// interval this update is, then applies the result. The evaluating update lands 1/interval of the
+// way along, and the last update before the next evaluation lands on the latest pose.
+static void animator_lod_pose_apply(kmodel_base* base, kmodel_animator* animator, b8 blended) {
+	u8 interval = animator->lod_update_interval;
+	f32 phase = (f32)(interval - animator->lod_countdown) / (f32)interval;
+	pose_copy(&animator->blend_pose, &animator->lod_previous_pose, base->node_count);
+	pose_blend(&animator->blend_pose, &animator->pose, phase, base->node_count);
+	animator_pose_apply(base, animator, &animator->blend_pose, blended);
 }
 
 static void animator_create(kmodel_base* asset, kmodel_animator* out_animator) {
@@ -934,12 +1547,40 @@ static void animator_set_animation(kmodel_system_state* state, kmodel_animator*
 				animator->current_animation_name = name;
 				animator->current_animation = i;
 				animator->time_in_ticks = 0.0f;
+				animator->fade_duration = 0.0f;
+				animator->lod_countdown = 0;
+				animator->lod_previous_valid = false;
+				// Cursors index into the previous animation's keys.
+				if (animator->cursors) {
+					kzero_memory(animator->cursors, sizeof(kmodel_channel_cursor) * animator->cursor_count);
+				}
 				break;
 			}
 		}
 	}
 }
 
+// Advances the time of a clip by delta_ticks. Returns true if a non-looping clip reached its end.
+static b8 clip_time_advance(const kmodel_animation* animation, f32* time_in_ticks, b8 loop, f32 delta_ticks) {
+	f32 prev_time = *time_in_ticks;
+	*time_in_ticks += delta_ticks;
+
+	f32 duration = animation->duration;
+	if (duration > 0.0f) {
+		// Wrap around.
+		if (loop) {
+			*time_in_ticks = kmod(*time_in_ticks, duration);
+			if (*time_in_ticks < 0.0f) {
+				*time_in_ticks += duration;
+			}
+		} else if (*time_in_ticks > duration) {
+			*time_in_ticks = duration;
+			return !kfloat_compare(prev_time, duration);
+		}
+	}
+	return false;
+}
+
 static void animator_update(kmodel_system_state* state, kmodel_animator* animator, f32 delta_time) {
 	if (animator->current_animation == INVALID_ID_U16) {
 		return;
@@ -950,42 +1591,97 @@ static void animator_update(kmodel_system_state* state, kmodel_animator* animato
 	}
 	kmodel_base* base = &state->models[animator->base];
 	kmodel_animation* current = &base->animations[animator->current_animation];
-	f32 ticks_per_second = current->ticks_per_second;
 	f32 time_scale = state->global_time_scale * animator->time_scale;
-	f32 delta_ticks = delta_time * time_scale * ticks_per_second;
-	f32 prev_time = animator->time_in_ticks;
-	animator->time_in_ticks += delta_ticks;
+	f32 scaled_delta = delta_time * time_scale;
 
-	f32 duration = current->duration;
-	if (duration > 0.0f) {
-		// Wrap around.
-		if (animator->loop) {
-			animator->time_in_ticks = kmod(animator->time_in_ticks, duration);
-			if (animator->time_in_ticks < 0.0f) {
-				animator->time_in_ticks += duration;
-			}
+	// If just hitting the end of the animation, flag it's completion to be signaled.
+	if (clip_time_advance(current, &animator->time_in_ticks, animator->loop, scaled_delta * current->ticks_per_second)) {
+		animator->completion_pending = true;
+	}
+
+	// Crossfade and layer progress.
+	if (animator->fade_duration > 0.0f) {
+		animator->fade_elapsed += scaled_delta;
+		if (animator->fade_elapsed >= animator->fade_duration) {
+			animator->fade_duration = 0.0f;
 		} else {
-			if (animator->time_in_ticks > duration) {
-				animator->time_in_ticks = duration;
-
-				// If just hitting the end of the animation, signal it's completion.
-				if (!kfloat_compare(prev_time, duration)) {
-					KTRACE("Animation complete: %k", current->name);
-					event_context ctx = {
-						.data.u64[0] = current->name};
-					event_fire(EVENT_CODE_ANIMATION_COMPLETE, animator, ctx);
-				}
+			kmodel_animation* fading = &base->animations[animator->fade_animation];
+			clip_time_advance(fading, &animator->fade_time_in_ticks, animator->fade_loop, scaled_delta * fading->ticks_per_second);
+		}
+	}
+	b8 blended = animator->fade_duration > 0.0f;
+	for (u32 l = 0; l < KMODEL_ANIMATOR_MAX_LAYERS; ++l) {
+		kmodel_animation_layer* layer = &animator->layers[l];
+		if (!layer->active) {
+			continue;
+		}
+		if (layer->weight != layer->target_weight) {
+			f32 step = layer->weight_rate * scaled_delta;
+			if (layer->weight_rate <= 0.0f || kabs(layer->target_weight - layer->weight) <= step) {
+				layer->weight = layer->target_weight;
+			} else {
+				layer->weight += layer->target_weight > layer->weight ? step : -step;
 			}
 		}
+		kmodel_animation* animation = &base->animations[layer->animation];
+		clip_time_advance(animation, &layer->time_in_ticks, layer->loop, scaled_delta * animation->ticks_per_second);
+		blended |= layer_contributes(layer);
 	}
 
-	// Process the hierarchy starting at the root.
-	kmodel_base* asset = &state->models[animator->base];
-	for (u32 i = 0; i < base->node_count; ++i) {
-		if (base->nodes[i].parent_index == INVALID_ID_U16) {
-			process_animator(state, animator, current, i, asset->global_inverse_transform);
+	// Animation LOD. Time was advanced above regardless, so whenever the pose is evaluated it is
+	// evaluated at the right point of each clip. The updates in between blend the last two
+	// evaluations, which keeps motion smooth at the cost of trailing the clips by up to an interval.
+	if (animator->lod_culled) {
+		return;
+	}
+	b8 interpolated = animator->lod_update_interval > 1;
+	if (animator->lod_countdown) {
+		animator->lod_countdown--;
+		if (interpolated && animator->lod_previous_valid) {
+			animator_lod_pose_apply(base, animator, blended);
 		}
+		return;
+	}
+	animator->lod_countdown = interpolated ? animator->lod_update_interval - 1 : 0;
+	b8 skip_leaves = animator->lod_skip_leaf_bones;
+	if (interpolated && animator->lod_previous_valid) {
+		pose_copy(&animator->lod_previous_pose, &animator->pose, base->node_count);
+	}
+
+	// Sample everything into the local pose first. A single animation only needs its own
+	// nodes sampled. When blending, nodes an animation leaves alone hold their bind pose.
+	// The same goes for interpolation, so every node of the previous pose holds a valid value.
+	if (blended || interpolated) {
+		pose_copy(&animator->pose, &base->bind_pose, base->node_count);
+	}
+	pose_sample(base, current, animator->time_in_ticks, animator->cursors, animator->cursor_count, skip_leaves, &animator->pose);
+
+	if (animator->fade_duration > 0.0f) {
+		pose_copy(&animator->blend_pose, &base->bind_pose, base->node_count);
+		pose_sample(base, &base->animations[animator->fade_animation], animator->fade_time_in_ticks, animator->fade_cursors, animator->cursor_count, skip_leaves, &animator->blend_pose);
+		// The pose holds the incoming animation, so blend toward the outgoing one by what remains of the fade.
+		pose_blend(&animator->pose, &animator->blend_pose, 1.0f - (animator->fade_elapsed / animator->fade_duration), base->node_count);
+	}
+
+	for (u32 l = 0; l < KMODEL_ANIMATOR_MAX_LAYERS; ++l) {
+		kmodel_animation_layer* layer = &animator->layers[l];
+		if (layer->active && layer->weight > 0.0f) {
+			pose_sample(base, &base->animations[layer->animation], layer->time_in_ticks, layer->cursors, layer->cursors ? animator->cursor_count : 0, skip_leaves, &animator->blend_pose);
+			pose_blend_layer(base, &animator->pose, &animator->blend_pose, layer);
+		}
+	}
+
+	if (!interpolated) {
+		animator_pose_apply(base, animator, &animator->pose, blended);
+		return;
+	}
+
+	// With nothing to blend from yet, start from the latest pose.
+	if (!animator->lod_previous_valid) {
+		pose_copy(&animator->lod_previous_pose, &animator->pose, base->node_count);
+		animator->lod_previous_valid = true;
 	}
+	animator_lod_pose_apply(base, animator, blended);
 }
 
 static void animator_get_bone_transforms(kmodel_system_state* state, kmodel_animator* animator, u32 count, mat4* out_transforms) {
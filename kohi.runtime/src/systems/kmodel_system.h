@@ -11,6 +11,8 @@
 #include <strings/kname.h>
 
 #define KANIMATION_MAX_BONES 64
+// The number of animation layers which may be played over an animator's main animation.
+#define KMODEL_ANIMATOR_MAX_LAYERS 4
 #define KRENDERBUFFER_NAME_ANIMATIONS_GLOBAL "Kohi.StorageBuffer.AnimationsGlobal"
 
 typedef enum kmodel_type {
@@ -39,6 +41,22 @@ typedef struct kmodel_channel {
 	anim_key_quat* rotations;
 } kmodel_channel;
 
+// The keys last sampled from each of a channel's key arrays. Normal playback only moves
+// these forward by a key or so per update, so sampling rarely needs to search.
+typedef struct kmodel_channel_cursor {
+	u32 position;
+	u32 rotation;
+	u32 scale;
+} kmodel_channel_cursor;
+
+// A local-space pose, held as one array per component so each can be processed in
+// bulk. Each array aligns with the base's nodes.
+typedef struct kmodel_pose {
+	vec3* translations;
+	quat* rotations;
+	vec3* scales;
+} kmodel_pose;
+
 // Animation that contains channels.
 typedef struct kmodel_animation {
 	kname name;
@@ -46,6 +64,8 @@ typedef struct kmodel_animation {
 	f32 ticks_per_second;
 	u32 channel_count;
 	kmodel_channel* channels;
+	// The index of the channel animating each node, or INVALID_ID_U16 if none. Aligns with the base's nodes.
+	u16* node_channel_indices;
 } kmodel_animation;
 
 // Bone data
@@ -69,6 +89,8 @@ typedef struct kmodel_submesh {
 	kname name;
 	kgeometry geo;
 	kname material_name;
+	// Set while the geometry is being uploaded. It becomes valid once all of the base's uploads complete.
+	b8 upload_pending;
 } kmodel_submesh;
 
 typedef enum kmodel_state {
@@ -97,6 +119,32 @@ typedef enum kmodel_animator_state {
 	KMODEL_ANIMATOR_STATE_PAUSED
 } kmodel_animator_state;
 
+typedef enum kmodel_animation_blend_mode {
+	// Blends from the pose beneath toward the layer's pose by the layer's weight.
+	KMODEL_ANIMATION_BLEND_MODE_OVERRIDE,
+	// Adds the layer's change from the first key of each of its channels onto the pose beneath,
+	// scaled by the layer's weight.
+	KMODEL_ANIMATION_BLEND_MODE_ADDITIVE
+} kmodel_animation_blend_mode;
+
+// An animation played over an animator's main animation, affecting only the nodes it animates.
+typedef struct kmodel_animation_layer {
+	b8 active;
+	// Index into the base's animation array.
+	u16 animation;
+	f32 time_in_ticks;
+	b8 loop;
+	kmodel_animation_blend_mode mode;
+	f32 weight;
+	// The weight being faded toward, and the change in weight per second to get there.
+	f32 target_weight;
+	f32 weight_rate;
+	// Optional per-node weights limiting the layer to part of the hierarchy. Aligns with the base's nodes.
+	f32* node_mask;
+	// Sized to the animator's cursor_count.
+	kmodel_channel_cursor* cursors;
+} kmodel_animation_layer;
+
 // One animator = one animated mesh instance state
 typedef struct kmodel_animator {
 	kname name;
@@ -113,6 +161,45 @@ typedef struct kmodel_animator {
 	u32 shader_data_index;
 	kmodel_animation_shader_data* shader_data;
 	u32 max_bones;
+	// Set when a non-looping animation reaches its end during an update. Since updates
+	// run on job threads, the completion event is fired afterward from the main thread.
+	b8 completion_pending;
+	// One cursor per channel of the current animation. Sized to the base's max_channel_count.
+	u32 cursor_count;
+	kmodel_channel_cursor* cursors;
+	// The number of nodes held by each of the per-node buffers below.
+	u32 node_count;
+	// The sampled local pose of each node animated by the current animation.
+	kmodel_pose pose;
+	// The world transform of each node as of the last update.
+	mat4* node_transforms;
+
+	// The animation fading out while current_animation fades in. Only valid while fade_duration is nonzero.
+	u16 fade_animation;
+	f32 fade_time_in_ticks;
+	b8 fade_loop;
+	// The length and progress of the crossfade, in seconds.
+	f32 fade_duration;
+	f32 fade_elapsed;
+	// Sized to cursor_count.
+	kmodel_channel_cursor* fade_cursors;
+
+	kmodel_animation_layer layers[KMODEL_ANIMATOR_MAX_LAYERS];
+	// Holds the samples of the fading animation or a layer before they are blended into pose.
+	kmodel_pose blend_pose;
+
+	// Animation LOD. Time advances on every update, but the pose is only evaluated on every
+	// lod_update_interval'th one (0 or 1 = every update), counted down by lod_countdown.
+	// The updates in between blend from the previous evaluation toward the latest one.
+	u8 lod_update_interval;
+	u8 lod_countdown;
+	// The pose evaluated before pose. Only valid while lod_previous_valid is set.
+	kmodel_pose lod_previous_pose;
+	b8 lod_previous_valid;
+	// Leaf nodes are left at their local transform rather than sampled.
+	b8 lod_skip_leaf_bones;
+	// Set while the instance is outside of every view. Time advances, but the pose is not evaluated.
+	b8 lod_culled;
 } kmodel_animator;
 
 typedef struct kmodel_instance_data {
@@ -131,14 +218,32 @@ typedef struct kmodel_base {
 
 	u32 animation_count;
 	kmodel_animation* animations;
+	// The most channels held by any one animation.
+	u32 max_channel_count;
 	u32 bone_count;
 	kmodel_bone* bones;
 	u32 node_count;
 	kmodel_node* nodes;
+	// Indices of the nodes reachable from a root, ordered so each node comes after its parent.
+	u32 node_order_count;
+	u16* node_order;
+	// The index of the bone for each node, or INVALID_ID_U16 if none. Aligns with nodes.
+	u16* node_bone_indices;
+	// The index of the node for each bone, or INVALID_ID_U16 if none is reachable. Aligns with bones.
+	u16* bone_node_indices;
+	// Each bone's offset, held contiguously so the skinning palette can be built as a batch. Aligns with bones.
+	mat4* bone_offsets;
+	// Each node's local transform, decomposed. Nodes which one blended animation animates but
+	// another does not blend against this.
+	kmodel_pose bind_pose;
 	mat4 global_inverse_transform;
 
 	u32 submesh_count;
 	kmodel_submesh* meshes;
+	// The number of submeshes still being uploaded. The base stays loading until this reaches 0.
+	u32 pending_upload_count;
+	// Identifies the base's uploads so they may be cancelled. Only set while they are pending.
+	void* upload_context;
 
 	u32 instance_count;
 	// The instances of this model.
@@ -184,7 +289,13 @@ typedef struct kmodel_system_state {
 
 	// Element count = max_instance_count
 	pool_allocator shader_data_pool;
+	// All skinning palettes, contiguous so that they are uploaded together.
 	kmodel_animation_shader_data* shader_data;
+	// One past the highest shader data index handed out. Only this many are uploaded.
+	u32 shader_data_used_count;
+
+	// darray of animators to be updated this frame. Rebuilt every update and processed in parallel.
+	kmodel_animator** update_list;
 } kmodel_system_state;
 
 b8 kmodel_system_initialize(u64* memory_requirement, kmodel_system_state* memory, const kmodel_system_config* config);
@@ -209,6 +320,19 @@ KAPI const kmaterial_instance* kmodel_submesh_material_instance_get_at(struct km
 KAPI kname* kmodel_query_animations(struct kmodel_system_state* state, u16 base_mesh, u32* out_count);
 
 KAPI void kmodel_instance_animation_set(struct kmodel_system_state* state, kmodel_instance instance, kname animation_name);
+// Switches to the named animation, fading in over duration seconds. A crossfade already underway is cut short.
+KAPI void kmodel_instance_animation_crossfade(struct kmodel_system_state* state, kmodel_instance instance, kname animation_name, f32 duration);
+// Plays the named animation on the given layer (0 to KMODEL_ANIMATOR_MAX_LAYERS - 1). Layers blend in order over the main animation.
+KAPI b8 kmodel_instance_layer_set(struct kmodel_system_state* state, kmodel_instance instance, u8 layer, kname animation_name, kmodel_animation_blend_mode mode, f32 weight, b8 loop);
+// Fades the layer's weight to the given weight over duration seconds, or immediately if duration is 0.
+KAPI void kmodel_instance_layer_weight_set(struct kmodel_system_state* state, kmodel_instance instance, u8 layer, f32 weight, f32 duration);
+// Limits the layer to the named node and its descendants (e.g. the spine, for an upper body layer). INVALID_KNAME removes the limit.
+KAPI b8 kmodel_instance_layer_mask_set(struct kmodel_system_state* state, kmodel_instance instance, u8 layer, kname root_node_name);
+KAPI void kmodel_instance_layer_clear(struct kmodel_system_state* state, kmodel_instance instance, u8 layer);
+// Reduces how often the instance's pose is evaluated, to every update_interval'th update (0 or 1 = every update), optionally also leaving leaf bones unanimated.
+KAPI void kmodel_instance_lod_set(struct kmodel_system_state* state, kmodel_instance instance, u8 update_interval, b8 skip_leaf_bones);
+// Pauses pose evaluation while the instance cannot be seen. Playback time still advances, so it resumes in step.
+KAPI void kmodel_instance_visibility_set(struct kmodel_system_state* state, kmodel_instance instance, b8 visible);
 KAPI u32 kmodel_instance_animation_id_get(struct kmodel_system_state* state, kmodel_instance instance);
 
 KAPI void kmodel_instance_time_scale_set(kmodel_system_state* state, kmodel_instance instance, f32 time_scale); // 1.0 - normal
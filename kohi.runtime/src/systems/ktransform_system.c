@@ -15,7 +15,7 @@
 #include "renderer/renderer_frontend.h"
 #include "renderer/renderer_types.h"
 #include "strings/kstring.h"
-#include "utils/ksort.h"
+#include "systems/job_system.h"
 
 typedef enum ktransform_flags {
 	KTRANSFORM_FLAG_NONE = 0,
@@ -24,6 +24,12 @@ typedef enum ktransform_flags {
 
 typedef u32 ktransform_flag_bits;
 
+// The number of copies of the global transform renderbuffer (i.e. it is triple-buffered).
+#define KTRANSFORM_SSBO_COPY_COUNT 3
+
+// The number of world matrices the global transform renderbuffer initially has room for.
+#define KTRANSFORM_SSBO_INITIAL_MATRIX_COUNT 16384
+
 // Going with a SOA here so that like data is grouped together.
 typedef struct ktransform_system_state {
 	/** @brief The cached local matrices in the world, indexed by handle. */
@@ -53,10 +59,25 @@ typedef struct ktransform_system_state {
 	/** @brief The depth of the transform in the hierarchy. Used for efficient recalculation of transforms. */
 	u8* depths;
 
+	/** @brief The first child of each transform, indexed by handle. KTRANSFORM_INVALID means no children. */
+	ktransform* first_children;
+
+	/** @brief The next sibling (i.e. the next child of the same parent), indexed by handle. KTRANSFORM_INVALID means none. */
+	ktransform* next_siblings;
+
+	/** @brief The previous sibling, indexed by handle. KTRANSFORM_INVALID means this is the first child. */
+	ktransform* prev_siblings;
+
 	/** @brief A list of handle ids that represent dirty local ktransforms. */
 	ktransform* local_dirty_handles;
 	u32 local_dirty_count;
 
+	/** @brief One bit per handle, set while that handle is in the dirty list. */
+	u64* dirty_bits;
+
+	/** @brief Scratch space the size of the dirty list, used when ordering it by depth. */
+	ktransform* dirty_sort_scratch;
+
 	/** The number of slots available (capacity) (NOT the allocated space in bytes!) */
 	u32 capacity;
 
@@ -65,6 +86,18 @@ typedef struct ktransform_system_state {
 
 	/** globally-accessible renderbuffer that holds transforms. */
 	krenderbuffer transform_global_ssbo;
+
+	/** The number of world matrices the global renderbuffer can hold. Grows along with capacity. */
+	u32 ssbo_matrix_capacity;
+
+	/**
+	 * The mapped memory of each copy of the global renderbuffer, as seen so far. Since the buffer
+	 * is triple-buffered, a changed world matrix must be written to each copy in turn.
+	 */
+	void* ssbo_copy_memory[KTRANSFORM_SSBO_COPY_COUNT];
+
+	/** One bit per handle for each copy of the global renderbuffer, set while its world matrix needs writing there. */
+	u64* ssbo_copy_pending_bits[KTRANSFORM_SSBO_COPY_COUNT];
 } ktransform_system_state;
 
 /**
@@ -75,12 +108,36 @@ typedef struct ktransform_system_state {
  */
 static void ensure_allocated(ktransform_system_state* state, u32 slot_count);
 static void dirty_list_reset(ktransform_system_state* state);
-static void dirty_list_add_r(ktransform_system_state* state, ktransform t);
+static void dirty_list_add(ktransform_system_state* state, ktransform t);
+static u32 dirty_list_sort_by_depth(ktransform_system_state* state, u32* out_level_ends);
+static void child_link(ktransform_system_state* state, ktransform t, ktransform parent);
+static void child_unlink(ktransform_system_state* state, ktransform t);
+static void depths_refresh(ktransform_system_state* state, ktransform t);
+static void ssbo_pending_mark(ktransform_system_state* state, ktransform t);
+static b8 ssbo_upload(ktransform_system_state* state);
 static ktransform handle_create(ktransform_system_state* state);
 static void handle_destroy(ktransform_system_state* state, ktransform* t);
 // Validates the handle itself, as well as compares it against the ktransform at the handle's index position.
 static b8 validate_handle(ktransform_system_state* state, ktransform handle);
-static void recalculate_world_r(ktransform t);
+
+// The number of dirty transforms handled by each parallel batch when recalculating local matrices.
+#define KTRANSFORM_LOCAL_BATCH_SIZE 256
+
+// The number of dirty transforms handled by each parallel batch when recalculating world matrices within a depth level.
+#define KTRANSFORM_WORLD_BATCH_SIZE 256
+
+// The number of child transforms gathered together, along with their parents' world matrices, for each mat4_mul_batch call.
+#define KTRANSFORM_WORLD_GATHER_COUNT 64
+
+// Below this many dirty transforms, world matrices are recalculated on the calling thread, since waiting
+// on job threads between every depth level would cost more than it saves.
+#define KTRANSFORM_WORLD_PARALLEL_THRESHOLD 2048
+
+// The number of distinct hierarchy depths, as limited by the size of a depth value.
+#define KTRANSFORM_DEPTH_COUNT 256
+
+// The number of words needed to hold a dirty bit for each of the given number of slots.
+#define DIRTY_BIT_WORD_COUNT(slot_count) (((slot_count) + 63) / 64)
 
 static void on_transform_dump(console_command_context context) {
 	ktransform_system_state* state = context.listener;
@@ -114,8 +171,9 @@ b8 ktransform_system_initialize(u64* memory_requirement, void* state, void* conf
 
 	dirty_list_reset(state);
 
-	// Global transform storage buffer
-	u64 buffer_size = sizeof(mat4) * 16384; // TODO: configurable?
+	// Global transform storage buffer. Grows as needed.
+	typed_state->ssbo_matrix_capacity = KMAX(KTRANSFORM_SSBO_INITIAL_MATRIX_COUNT, typed_state->capacity);
+	u64 buffer_size = sizeof(mat4) * typed_state->ssbo_matrix_capacity;
 	typed_state->transform_global_ssbo = renderer_renderbuffer_create(engine_systems_get()->renderer_system, kname_create(KRENDERBUFFER_NAME_TRANSFORMS_GLOBAL), RENDERBUFFER_TYPE_STORAGE, buffer_size, RENDERBUFFER_TRACK_TYPE_NONE, RENDERBUFFER_FLAG_AUTO_MAP_MEMORY_BIT | RENDERBUFFER_FLAG_TRIPLE_BUFFERED_BIT);
 	KASSERT(typed_state->transform_global_ssbo != KRENDERBUFFER_INVALID);
 	KDEBUG("Created transforms global storage buffer.");
@@ -159,54 +217,128 @@ void ktransform_system_shutdown(void* state) {
 			kfree_aligned(typed_state->user, sizeof(u64) * typed_state->capacity, 16, MEMORY_TAG_TRANSFORM);
 			typed_state->user = 0;
 		}
+		if (typed_state->parents) {
+			kfree_aligned(typed_state->parents, sizeof(ktransform) * typed_state->capacity, 16, MEMORY_TAG_TRANSFORM);
+			typed_state->parents = 0;
+		}
+		if (typed_state->depths) {
+			kfree_aligned(typed_state->depths, sizeof(u8) * typed_state->capacity, 16, MEMORY_TAG_TRANSFORM);
+			typed_state->depths = 0;
+		}
+		if (typed_state->first_children) {
+			kfree_aligned(typed_state->first_children, sizeof(ktransform) * typed_state->capacity, 16, MEMORY_TAG_TRANSFORM);
+			typed_state->first_children = 0;
+		}
+		if (typed_state->next_siblings) {
+			kfree_aligned(typed_state->next_siblings, sizeof(ktransform) * typed_state->capacity, 16, MEMORY_TAG_TRANSFORM);
+			typed_state->next_siblings = 0;
+		}
+		if (typed_state->prev_siblings) {
+			kfree_aligned(typed_state->prev_siblings, sizeof(ktransform) * typed_state->capacity, 16, MEMORY_TAG_TRANSFORM);
+			typed_state->prev_siblings = 0;
+		}
 		if (typed_state->local_dirty_handles) {
 			kfree_aligned(typed_state->local_dirty_handles, sizeof(ktransform) * typed_state->capacity, 16, MEMORY_TAG_TRANSFORM);
 			typed_state->local_dirty_handles = 0;
 		}
+		if (typed_state->dirty_bits) {
+			kfree_aligned(typed_state->dirty_bits, sizeof(u64) * DIRTY_BIT_WORD_COUNT(typed_state->capacity), 16, MEMORY_TAG_TRANSFORM);
+			typed_state->dirty_bits = 0;
+		}
+		if (typed_state->dirty_sort_scratch) {
+			kfree_aligned(typed_state->dirty_sort_scratch, sizeof(ktransform) * typed_state->capacity, 16, MEMORY_TAG_TRANSFORM);
+			typed_state->dirty_sort_scratch = 0;
+		}
+		for (u32 c = 0; c < KTRANSFORM_SSBO_COPY_COUNT; ++c) {
+			if (typed_state->ssbo_copy_pending_bits[c]) {
+				kfree_aligned(typed_state->ssbo_copy_pending_bits[c], sizeof(u64) * DIRTY_BIT_WORD_COUNT(typed_state->capacity), 16, MEMORY_TAG_TRANSFORM);
+				typed_state->ssbo_copy_pending_bits[c] = 0;
+			}
+		}
 	}
 }
 
-static i32 transform_depth_kquicksort_compare_internal(void* a, void* b, i32 mod) {
-	ktransform* a_typed = a;
-	ktransform* b_typed = b;
-
-	ktransform_system_state* state = engine_systems_get()->ktransform_system;
-	u8 da = state->depths[*a_typed];
-	u8 db = state->depths[*b_typed];
-	if (da > db) {
-		return -mod;
-	} else if (da < db) {
-		return mod;
+// Recalculates the local matrices for a range of the dirty list. These are independent of one another.
+static void calculate_local_batch(u32 start, u32 end, void* context) {
+	ktransform_system_state* state = context;
+	for (u32 i = start; i < end; ++i) {
+		ktransform_calculate_local(state->local_dirty_handles[i]);
 	}
-	return 0;
 }
 
-static i32 transform_depth_kquicksort_compare(void* a, void* b) {
-	return transform_depth_kquicksort_compare_internal(a, b, 1);
+// Recalculates the world matrices for a range of the dirty list, which must lie within a single depth
+// level. These are independent of one another, since a transform's parent is always at the level above.
+static void calculate_world_batch(u32 start, u32 end, void* context) {
+	ktransform_system_state* state = context;
+	// Children are gathered alongside their parents' world matrices so they can be multiplied as a batch.
+	ktransform handles[KTRANSFORM_WORLD_GATHER_COUNT];
+	mat4 locals[KTRANSFORM_WORLD_GATHER_COUNT];
+	mat4 parent_worlds[KTRANSFORM_WORLD_GATHER_COUNT];
+	u32 gathered = 0;
+	for (u32 i = start; i < end; ++i) {
+		ktransform t = state->local_dirty_handles[i];
+		ktransform parent = state->parents[t];
+		if (parent == KTRANSFORM_INVALID) {
+			state->world_matrices[t] = state->local_matrices[t];
+		} else {
+			handles[gathered] = t;
+			locals[gathered] = state->local_matrices[t];
+			parent_worlds[gathered] = state->world_matrices[parent];
+			gathered++;
+		}
+
+		if (gathered == KTRANSFORM_WORLD_GATHER_COUNT || (gathered && i + 1 == end)) {
+			mat4_mul_batch(locals, parent_worlds, locals, gathered);
+			for (u32 g = 0; g < gathered; ++g) {
+				state->world_matrices[handles[g]] = locals[g];
+			}
+			gathered = 0;
+		}
+	}
 }
-static i32 transform_depth_kquicksort_compare_desc(void* a, void* b) {
-	return transform_depth_kquicksort_compare_internal(a, b, -1);
+
+typedef struct world_level_context {
+	ktransform_system_state* state;
+	// The index in the dirty list at which the level starts.
+	u32 level_start;
+} world_level_context;
+
+static void calculate_world_level_batch(u32 start, u32 end, void* context) {
+	world_level_context* level = context;
+	calculate_world_batch(level->level_start + start, level->level_start + end, level->state);
 }
 
 b8 ktransform_system_update(ktransform_system_state* state, struct frame_data* p_frame_data) {
-	// Sort the dirty list by depth.
-	kquick_sort(sizeof(ktransform), state->local_dirty_handles, 0, state->local_dirty_count - 1, transform_depth_kquicksort_compare);
+	// Order the dirty list by depth, so that parents come before their children.
+	u32 level_ends[KTRANSFORM_DEPTH_COUNT];
+	u32 level_count = dirty_list_sort_by_depth(state, level_ends);
+
+	// Local matrices only depend on the transform's own data, so can be done across job threads.
+	job_system_parallel_for(state->local_dirty_count, KTRANSFORM_LOCAL_BATCH_SIZE, calculate_local_batch, state);
+
+	// Update dirty world matrices top-down according to depth. Since the list is sorted by depth, any dirty
+	// parent has already been updated by this point, and a clean parent's world matrix is still valid.
+	// Each level is finished before the next begins. Large updates spread each level across job threads.
+	b8 parallel = state->local_dirty_count >= KTRANSFORM_WORLD_PARALLEL_THRESHOLD;
+	u32 level_start = 0;
+	for (u32 d = 0; d < level_count; ++d) {
+		if (parallel) {
+			world_level_context level = {state, level_start};
+			job_system_parallel_for(level_ends[d] - level_start, KTRANSFORM_WORLD_BATCH_SIZE, calculate_world_level_batch, &level);
+		} else {
+			calculate_world_batch(level_start, level_ends[d], state);
+		}
+		level_start = level_ends[d];
+	}
 
-	// Update dirty transforms top-down according to depth.
+	// Queue the new world matrices for upload, then clear the dirty list.
 	for (u32 i = 0; i < state->local_dirty_count; ++i) {
-		recalculate_world_r(state->local_dirty_handles[i]);
+		ssbo_pending_mark(state, state->local_dirty_handles[i]);
 	}
-
-	// Clear the dirty list.
 	dirty_list_reset(state);
 
-	// Update the data in the SSBO.
-	void* mapped_memory = renderer_renderbuffer_get_mapped_memory(engine_systems_get()->renderer_system, state->transform_global_ssbo);
-	mat4* mapped_transforms = (mat4*)mapped_memory;
-
-	kcopy_memory(mapped_transforms, state->world_matrices, sizeof(mat4) * state->capacity);
-
-	return true;
+	// Update the changed data in the SSBO.
+	return ssbo_upload(state);
 }
 
 ktransform ktransform_create(u64 user) {
@@ -241,9 +373,12 @@ ktransform ktransform_clone(ktransform original, u64 user) {
 		state->local_matrices[handle] = state->local_matrices[original];
 		state->world_matrices[handle] = state->world_matrices[original];
 		state->user[handle] = user;
-		state->parents[handle] = state->parents[original];
+		if (state->parents[original] != KTRANSFORM_INVALID) {
+			child_link(state, handle, state->parents[original]);
+		}
 		state->depths[handle] = state->depths[original];
-		// NOTE: This is not added to the dirty list because the defualts form an identity matrix.
+		// Add to the dirty list, since the original's world matrix may be out of date if it is.
+		dirty_list_add(state, handle);
 	} else {
 		KERROR("Attempted to clone a transform before the system was initialized.");
 		handle = KTRANSFORM_INVALID;
@@ -256,7 +391,7 @@ void ktransform_mark_dirty(ktransform transform) {
 	if (!validate_handle(state, transform)) {
 		KWARN("Invalid handle passed, nothing was done.");
 	} else {
-		dirty_list_add_r(state, transform);
+		dirty_list_add(state, transform);
 	}
 }
 
@@ -274,7 +409,7 @@ ktransform ktransform_from_position(vec3 position, u64 user) {
 		state->parents[handle] = KTRANSFORM_INVALID;
 		state->depths[handle] = 0;
 		// Add to the dirty list.
-		dirty_list_add_r(state, handle);
+		dirty_list_add(state, handle);
 	} else {
 		KERROR("Attempted to create a transform before the system was initialized.");
 		handle = KTRANSFORM_INVALID;
@@ -296,7 +431,7 @@ ktransform ktransform_from_rotation(quat rotation, u64 user) {
 		state->parents[handle] = KTRANSFORM_INVALID;
 		state->depths[handle] = 0;
 		// Add to the dirty list.
-		dirty_list_add_r(state, handle);
+		dirty_list_add(state, handle);
 	} else {
 		KERROR("Attempted to create a transform before the system was initialized.");
 		handle = KTRANSFORM_INVALID;
@@ -318,7 +453,7 @@ ktransform ktransform_from_position_rotation(vec3 position, quat rotation, u64 u
 		state->parents[handle] = KTRANSFORM_INVALID;
 		state->depths[handle] = 0;
 		// Add to the dirty list.
-		dirty_list_add_r(state, handle);
+		dirty_list_add(state, handle);
 	} else {
 		KERROR("Attempted to create a transform before the system was initialized.");
 		handle = KTRANSFORM_INVALID;
@@ -340,7 +475,7 @@ ktransform ktransform_from_position_rotation_scale(vec3 position, quat rotation,
 		state->parents[handle] = KTRANSFORM_INVALID;
 		state->depths[handle] = 0;
 		// Add to the dirty list.
-		dirty_list_add_r(state, handle);
+		dirty_list_add(state, handle);
 	} else {
 		KERROR("Attempted to create a transform before the system was initialized.");
 		handle = KTRANSFORM_INVALID;
@@ -383,15 +518,20 @@ b8 ktransform_parent_set(ktransform t, ktransform parent) {
 	}
 
 	// Ensure no circular references.
-	if (parent != KTRANSFORM_INVALID) {
-		KASSERT(state->parents[parent] != t);
+	for (ktransform ancestor = parent; ancestor != KTRANSFORM_INVALID; ancestor = state->parents[ancestor]) {
+		KASSERT(ancestor != t);
 	}
 
-	state->parents[t] = parent;
-	// Update the depth too.
-	state->depths[t] = parent == KTRANSFORM_INVALID ? 0 : state->depths[parent] + 1;
+	if (state->parents[t] != parent) {
+		child_unlink(state, t);
+		if (parent != KTRANSFORM_INVALID) {
+			child_link(state, t, parent);
+		}
+	}
+	// Update the depth too, along with those of all descendants.
+	depths_refresh(state, t);
 
-	dirty_list_add_r(state, t);
+	dirty_list_add(state, t);
 
 	return true;
 }
@@ -429,7 +569,7 @@ void ktransform_position_set(ktransform t, vec3 position) {
 		KWARN("Invalid handle passed, nothing was done.");
 	} else {
 		state->positions[t] = position;
-		dirty_list_add_r(state, t);
+		dirty_list_add(state, t);
 	}
 }
 
@@ -439,7 +579,7 @@ void ktransform_translate(ktransform t, vec3 translation) {
 		KWARN("Invalid handle passed, nothing was done.");
 	} else {
 		state->positions[t] = vec3_add(state->positions[t], translation);
-		dirty_list_add_r(state, t);
+		dirty_list_add(state, t);
 	}
 }
 
@@ -488,7 +628,7 @@ void ktransform_rotation_set(ktransform t, quat rotation) {
 		KWARN("Invalid handle passed, nothing was done.");
 	} else {
 		state->rotations[t] = rotation;
-		dirty_list_add_r(state, t);
+		dirty_list_add(state, t);
 	}
 }
 
@@ -499,7 +639,7 @@ void ktransform_rotate(ktransform t, quat rotation) {
 		KWARN("Invalid handle passed, nothing was done.");
 	} else {
 		state->rotations[t] = quat_normalize(quat_mul(state->rotations[t], rotation));
-		dirty_list_add_r(state, t);
+		dirty_list_add(state, t);
 	}
 }
 
@@ -545,7 +685,7 @@ void ktransform_scale_set(ktransform t, vec3 scale) {
 		KWARN("Invalid handle passed, nothing was done.");
 	} else {
 		state->scales[t] = scale;
-		dirty_list_add_r(state, t);
+		dirty_list_add(state, t);
 	}
 }
 
@@ -555,7 +695,7 @@ void ktransform_scale(ktransform t, vec3 scale) {
 		KWARN("Invalid handle passed, nothing was done.");
 	} else {
 		state->scales[t] = vec3_mul(state->scales[t], scale);
-		dirty_list_add_r(state, t);
+		dirty_list_add(state, t);
 	}
 }
 
@@ -566,7 +706,7 @@ void ktransform_position_rotation_set(ktransform t, vec3 position, quat rotation
 	} else {
 		state->positions[t] = position;
 		state->rotations[t] = rotation;
-		dirty_list_add_r(state, t);
+		dirty_list_add(state, t);
 	}
 }
 
@@ -578,7 +718,7 @@ void ktransform_position_rotation_scale_set(ktransform t, vec3 position, quat ro
 		state->positions[t] = position;
 		state->rotations[t] = rotation;
 		state->scales[t] = scale;
-		dirty_list_add_r(state, t);
+		dirty_list_add(state, t);
 	}
 }
 
@@ -589,7 +729,7 @@ void ktransform_translate_rotate(ktransform t, vec3 translation, quat rotation)
 	} else {
 		state->positions[t] = vec3_add(state->positions[t], translation);
 		state->rotations[t] = quat_mul(state->rotations[t], rotation);
-		dirty_list_add_r(state, t);
+		dirty_list_add(state, t);
 	}
 }
 
@@ -736,7 +876,7 @@ b8 ktransform_from_string(const char* str, u64 user, ktransform* out_ktransform)
 		state->world_matrices[handle] = mat4_identity();
 		state->user[handle] = user;
 		// Add to the dirty list.
-		dirty_list_add_r(state, handle);
+		dirty_list_add(state, handle);
 	} else {
 		KERROR("Attempted to create a ktransform before the system was initialized.");
 		*out_ktransform = KTRANSFORM_INVALID;
@@ -830,6 +970,21 @@ static void ensure_allocated(ktransform_system_state* state, u32 slot_count) {
 		}
 		state->depths = new_depth;
 
+		// Hierarchy links
+		ktransform** link_arrays[3] = {&state->first_children, &state->next_siblings, &state->prev_siblings};
+		for (u32 a = 0; a < 3; ++a) {
+			ktransform* new_links = kallocate_aligned(sizeof(ktransform) * slot_count, 16, MEMORY_TAG_TRANSFORM);
+			if (*link_arrays[a]) {
+				kcopy_memory(new_links, *link_arrays[a], sizeof(ktransform) * state->capacity);
+				kfree_aligned(*link_arrays[a], sizeof(ktransform) * state->capacity, 16, MEMORY_TAG_TRANSFORM);
+			}
+			// Invalidate new links.
+			for (u32 i = state->capacity; i < slot_count; ++i) {
+				new_links[i] = KTRANSFORM_INVALID;
+			}
+			*link_arrays[a] = new_links;
+		}
+
 		// Dirty handle list doesn't *need* to be aligned, but do it anyways since everything else is.
 		u32* new_dirty_handles = kallocate_aligned(sizeof(ktransform) * slot_count, 16, MEMORY_TAG_TRANSFORM);
 		if (state->local_dirty_handles) {
@@ -838,6 +993,32 @@ static void ensure_allocated(ktransform_system_state* state, u32 slot_count) {
 		}
 		state->local_dirty_handles = new_dirty_handles;
 
+		// Pending SSBO writes per buffer copy. New bits start out clear, and are set once a handle is put to use.
+		for (u32 c = 0; c < KTRANSFORM_SSBO_COPY_COUNT; ++c) {
+			u64* new_pending_bits = kallocate_aligned(sizeof(u64) * DIRTY_BIT_WORD_COUNT(slot_count), 16, MEMORY_TAG_TRANSFORM);
+			kzero_memory(new_pending_bits, sizeof(u64) * DIRTY_BIT_WORD_COUNT(slot_count));
+			if (state->ssbo_copy_pending_bits[c]) {
+				kcopy_memory(new_pending_bits, state->ssbo_copy_pending_bits[c], sizeof(u64) * DIRTY_BIT_WORD_COUNT(state->capacity));
+				kfree_aligned(state->ssbo_copy_pending_bits[c], sizeof(u64) * DIRTY_BIT_WORD_COUNT(state->capacity), 16, MEMORY_TAG_TRANSFORM);
+			}
+			state->ssbo_copy_pending_bits[c] = new_pending_bits;
+		}
+
+		// The sort scratch space holds nothing between updates, so doesn't need copying.
+		if (state->dirty_sort_scratch) {
+			kfree_aligned(state->dirty_sort_scratch, sizeof(ktransform) * state->capacity, 16, MEMORY_TAG_TRANSFORM);
+		}
+		state->dirty_sort_scratch = kallocate_aligned(sizeof(ktransform) * slot_count, 16, MEMORY_TAG_TRANSFORM);
+
+		// Dirty bits. New bits start out clear.
+		u64* new_dirty_bits = kallocate_aligned(sizeof(u64) * DIRTY_BIT_WORD_COUNT(slot_count), 16, MEMORY_TAG_TRANSFORM);
+		kzero_memory(new_dirty_bits, sizeof(u64) * DIRTY_BIT_WORD_COUNT(slot_count));
+		if (state->dirty_bits) {
+			kcopy_memory(new_dirty_bits, state->dirty_bits, sizeof(u64) * DIRTY_BIT_WORD_COUNT(state->capacity));
+			kfree_aligned(state->dirty_bits, sizeof(u64) * DIRTY_BIT_WORD_COUNT(state->capacity), 16, MEMORY_TAG_TRANSFORM);
+		}
+		state->dirty_bits = new_dirty_bits;
+
 		// Make sure the allocated count is up to date.
 		state->capacity = slot_count;
 	}
@@ -845,34 +1026,202 @@ static void ensure_allocated(ktransform_system_state* state, u32 slot_count) {
 
 static void dirty_list_reset(ktransform_system_state* state) {
 	for (u32 i = 0; i < state->local_dirty_count; ++i) {
+		ktransform t = state->local_dirty_handles[i];
+		state->dirty_bits[t / 64] &= ~(1ull << (t % 64));
 		state->local_dirty_handles[i] = INVALID_ID;
 	}
 	state->local_dirty_count = 0;
 }
 
-static void dirty_list_add_r(ktransform_system_state* state, ktransform t) {
-	b8 do_add = true;
+// Obtains the transform following node in a depth-first (parent before child) walk of the
+// hierarchy below root, or KTRANSFORM_INVALID once the walk is complete. If descend is false,
+// the children of node are skipped.
+static ktransform subtree_next(const ktransform_system_state* state, ktransform root, ktransform node, b8 descend) {
+	if (descend && state->first_children[node] != KTRANSFORM_INVALID) {
+		return state->first_children[node];
+	}
+	// Move on to the next sibling, climbing back up as each level is exhausted.
+	while (node != root && state->next_siblings[node] == KTRANSFORM_INVALID) {
+		node = state->parents[node];
+	}
+	return node == root ? KTRANSFORM_INVALID : state->next_siblings[node];
+}
+
+static void dirty_list_add(ktransform_system_state* state, ktransform t) {
+	if (!state->local_dirty_handles) {
+		return;
+	}
+
+	// Add the transform and all of its descendants. Anything already in the list had all of its
+	// descendants added along with it (and anything parented since is added when parented), so
+	// already-dirty subtrees can be skipped entirely.
+	ktransform node = t;
+	while (node != KTRANSFORM_INVALID) {
+		u64 bit = 1ull << (node % 64);
+		b8 is_dirty = (state->dirty_bits[node / 64] & bit) != 0;
+		if (!is_dirty) {
+			state->dirty_bits[node / 64] |= bit;
+			state->local_dirty_handles[state->local_dirty_count] = node;
+			state->local_dirty_count++;
+		}
+		node = subtree_next(state, t, node, !is_dirty);
+	}
+}
+
+// Orders the dirty list by depth. out_level_ends receives the index one past the last entry at each
+// depth (KTRANSFORM_DEPTH_COUNT of them). Returns the number of depth levels in use.
+static u32 dirty_list_sort_by_depth(ktransform_system_state* state, u32* out_level_ends) {
+	// Counting sort, since depths are small integers. Stable, and linear in the number of dirty transforms.
+	u32 level_count = 0;
+	kzero_memory(out_level_ends, sizeof(u32) * KTRANSFORM_DEPTH_COUNT);
 	for (u32 i = 0; i < state->local_dirty_count; ++i) {
-		if (state->local_dirty_handles[i] == t) {
-			// Already there, do nothing.
-			do_add = false;
-			break;
+		u8 depth = state->depths[state->local_dirty_handles[i]];
+		out_level_ends[depth]++;
+		level_count = KMAX(level_count, (u32)depth + 1);
+	}
+	u32 total = 0;
+	for (u32 d = 0; d < level_count; ++d) {
+		u32 count = out_level_ends[d];
+		out_level_ends[d] = total;
+		total += count;
+	}
+	// Each level's start offset is advanced as it is filled, leaving it at the level's end.
+	for (u32 i = 0; i < state->local_dirty_count; ++i) {
+		ktransform t = state->local_dirty_handles[i];
+		state->dirty_sort_scratch[out_level_ends[state->depths[t]]++] = t;
+	}
+
+	// The scratch space now holds the ordered list, so just swap the two.
+	ktransform* ordered = state->dirty_sort_scratch;
+	state->dirty_sort_scratch = state->local_dirty_handles;
+	state->local_dirty_handles = ordered;
+
+	return level_count;
+}
+
+static void ssbo_pending_mark(ktransform_system_state* state, ktransform t) {
+	u64 bit = 1ull << (t % 64);
+	for (u32 c = 0; c < KTRANSFORM_SSBO_COPY_COUNT; ++c) {
+		state->ssbo_copy_pending_bits[c][t / 64] |= bit;
+	}
+}
+
+// Marks every handle as needing to be written to the given copy of the SSBO.
+static void ssbo_pending_mark_all(ktransform_system_state* state, u32 copy_index) {
+	kset_memory(state->ssbo_copy_pending_bits[copy_index], 0xFF, sizeof(u64) * DIRTY_BIT_WORD_COUNT(state->capacity));
+}
+
+static b8 ssbo_upload(ktransform_system_state* state) {
+	struct renderer_system_state* renderer = engine_systems_get()->renderer_system;
+
+	// Grow the buffer if the transforms have outgrown it. Its copies are then new memory, and are filled from scratch.
+	if (state->capacity > state->ssbo_matrix_capacity) {
+		u32 new_matrix_capacity = KMAX(state->ssbo_matrix_capacity * 2, state->capacity);
+		if (!renderer_renderbuffer_resize(renderer, state->transform_global_ssbo, sizeof(mat4) * new_matrix_capacity)) {
+			KERROR("Failed to resize the global transform storage buffer. World matrices will not be updated.");
+			return false;
 		}
+		state->ssbo_matrix_capacity = new_matrix_capacity;
+		kzero_memory(state->ssbo_copy_memory, sizeof(void*) * KTRANSFORM_SSBO_COPY_COUNT);
 	}
 
-	if (state->local_dirty_handles) {
-		if (do_add) {
-			state->local_dirty_handles[state->local_dirty_count] = t;
-			state->local_dirty_count++;
+	// Find which copy of the buffer is mapped this frame. The first time each one is seen, all of it needs writing.
+	mat4* mapped_transforms = renderer_renderbuffer_get_mapped_memory(renderer, state->transform_global_ssbo);
+	u32 copy_index = INVALID_ID;
+	for (u32 c = 0; c < KTRANSFORM_SSBO_COPY_COUNT; ++c) {
+		if (state->ssbo_copy_memory[c] == mapped_transforms) {
+			copy_index = c;
+			break;
+		}
+		if (!state->ssbo_copy_memory[c]) {
+			state->ssbo_copy_memory[c] = mapped_transforms;
+			ssbo_pending_mark_all(state, c);
+			copy_index = c;
+			break;
 		}
+	}
+	if (copy_index == INVALID_ID) {
+		// More copies than expected. Fall back to writing everything to each, starting over.
+		KWARN("Unexpected copy of the global transform storage buffer encountered. Rewriting all transforms.");
+		kzero_memory(state->ssbo_copy_memory, sizeof(void*) * KTRANSFORM_SSBO_COPY_COUNT);
+		state->ssbo_copy_memory[0] = mapped_transforms;
+		ssbo_pending_mark_all(state, 0);
+		copy_index = 0;
+	}
 
-		// Need to recurse all children and add them to the list as well.
-		for (u32 i = 0; i < state->capacity; ++i) {
-			if (state->parents[i] == t) {
-				dirty_list_add_r(state, i);
+	// Write pending matrices, coalescing runs of consecutive handles into single copies.
+	u64* pending_bits = state->ssbo_copy_pending_bits[copy_index];
+	u32 word_count = DIRTY_BIT_WORD_COUNT(state->capacity);
+	u32 span_start = 0;
+	u32 span_count = 0;
+	for (u32 w = 0; w < word_count; ++w) {
+		u64 word = pending_bits[w];
+		if (!word) {
+			continue;
+		}
+		pending_bits[w] = 0;
+		while (word) {
+			u32 index = (w * 64) + (u32)__builtin_ctzll(word);
+			if (index >= state->capacity) {
+				break;
 			}
+			if (span_count && index == span_start + span_count) {
+				span_count++;
+			} else {
+				if (span_count) {
+					kcopy_memory(mapped_transforms + span_start, state->world_matrices + span_start, sizeof(mat4) * span_count);
+				}
+				span_start = index;
+				span_count = 1;
+			}
+			// Clear the lowest set bit.
+			word &= word - 1;
+		}
+	}
+	if (span_count) {
+		kcopy_memory(mapped_transforms + span_start, state->world_matrices + span_start, sizeof(mat4) * span_count);
+	}
+
+	return true;
+}
+
+static void child_link(ktransform_system_state* state, ktransform t, ktransform parent) {
+	ktransform first = state->first_children[parent];
+	state->parents[t] = parent;
+	state->prev_siblings[t] = KTRANSFORM_INVALID;
+	state->next_siblings[t] = first;
+	if (first != KTRANSFORM_INVALID) {
+		state->prev_siblings[first] = t;
+	}
+	state->first_children[parent] = t;
+}
+
+static void child_unlink(ktransform_system_state* state, ktransform t) {
+	ktransform parent = state->parents[t];
+	if (parent != KTRANSFORM_INVALID) {
+		ktransform prev = state->prev_siblings[t];
+		ktransform next = state->next_siblings[t];
+		if (prev != KTRANSFORM_INVALID) {
+			state->next_siblings[prev] = next;
+		} else {
+			state->first_children[parent] = next;
+		}
+		if (next != KTRANSFORM_INVALID) {
+			state->prev_siblings[next] = prev;
 		}
 	}
+	state->parents[t] = KTRANSFORM_INVALID;
+	state->prev_siblings[t] = KTRANSFORM_INVALID;
+	state->next_siblings[t] = KTRANSFORM_INVALID;
+}
+
+static void depths_refresh(ktransform_system_state* state, ktransform t) {
+	for (ktransform node = t; node != KTRANSFORM_INVALID; node = subtree_next(state, t, node, true)) {
+		ktransform parent = state->parents[node];
+		u32 depth = parent == KTRANSFORM_INVALID ? 0 : state->depths[parent] + 1;
+		KASSERT_MSG(depth < KTRANSFORM_DEPTH_COUNT, "Transform hierarchy is too deep.");
+		state->depths[node] = (u8)depth;
+	}
 }
 
 static ktransform handle_create(ktransform_system_state* state) {
@@ -884,9 +1233,14 @@ static ktransform handle_create(ktransform_system_state* state) {
 		if (FLAG_GET(state->flags[i], KTRANSFORM_FLAG_FREE)) {
 			// Found an entry.
 			state->flags[i] = FLAG_SET(state->flags[i], KTRANSFORM_FLAG_FREE, false);
-			// Ensure the parent is invalid.
+			// Ensure the parent is invalid, and there are no children.
 			state->parents[i] = KTRANSFORM_INVALID;
+			state->first_children[i] = KTRANSFORM_INVALID;
+			state->next_siblings[i] = KTRANSFORM_INVALID;
+			state->prev_siblings[i] = KTRANSFORM_INVALID;
 			state->depths[i] = 0;
+			// The world matrix is set by the caller, and needs writing to the SSBO whether or not it's marked dirty.
+			ssbo_pending_mark(state, i);
 			state->allocated++;
 			return i;
 		}
@@ -899,6 +1253,8 @@ static ktransform handle_create(ktransform_system_state* state) {
 	// Ensure the parent is invalid.
 	state->parents[handle] = KTRANSFORM_INVALID;
 	state->depths[handle] = 0;
+	// The world matrix is set by the caller, and needs writing to the SSBO whether or not it's marked dirty.
+	ssbo_pending_mark(state, handle);
 	state->allocated++;
 	return handle;
 }
@@ -912,9 +1268,20 @@ static void handle_destroy(ktransform_system_state* state, ktransform* t) {
 			state->flags[*t] = 0;
 			FLAG_SET(state->flags[*t], KTRANSFORM_FLAG_FREE, true);
 		}
-		// Ensure the parent is invalid.
-		if(state->parents) {
-			state->parents[*t] = KTRANSFORM_INVALID;
+		// Remove from the parent, and make any children roots.
+		if (state->parents) {
+			child_unlink(state, *t);
+			ktransform child = state->first_children[*t];
+			while (child != KTRANSFORM_INVALID) {
+				ktransform next = state->next_siblings[child];
+				state->parents[child] = KTRANSFORM_INVALID;
+				state->prev_siblings[child] = KTRANSFORM_INVALID;
+				state->next_siblings[child] = KTRANSFORM_INVALID;
+				depths_refresh(state, child);
+				dirty_list_add(state, child);
+				child = next;
+			}
+			state->first_children[*t] = KTRANSFORM_INVALID;
 		}
 		state->allocated--;
 		*t = KTRANSFORM_INVALID;
@@ -935,22 +1302,3 @@ static b8 validate_handle(ktransform_system_state* state, ktransform handle) {
 	// Check for a match.
 	return true;
 }
-
-static void recalculate_world_r(ktransform t) {
-	ktransform_system_state* state = engine_systems_get()->ktransform_system;
-	if (t != KTRANSFORM_INVALID) {
-		mat4 child_world;
-		ktransform_calculate_local(t);
-		mat4 child_local = state->local_matrices[t];
-
-		ktransform parent = state->parents[t];
-		if (parent != KTRANSFORM_INVALID) {
-			recalculate_world_r(parent);
-			mat4 parent_world = state->world_matrices[parent];
-			child_world = mat4_mul(child_local, parent_world);
-		} else {
-			child_world = child_local;
-		}
-		state->world_matrices[t] = child_world;
-	}
-}
@@ -33,8 +33,9 @@ KAPI ktransform ktransform_create(u64 user);
 
 /**
  * @brief Creates and returns a new ktransform, using the position,
- * rotation and scale of the provided original transform.
- * Not marked dirty by default.
+ * rotation and scale of the provided original transform, and sharing
+ * its parent. Marked dirty, so the world matrix is brought up to date
+ * on the next update.
  *
  * @param original The transform to be cloned.
  * @param user User data, typically a handle or pointer to something for reverse lookups.
@@ -1,6 +1,6 @@
 #include "texture_system.h"
 
-#include <containers/u64_bst.h>
+#include <containers/hashmap.h>
 #include <core/engine.h>
 #include <core_render_types.h>
 #include <debug/kassert.h>
@@ -46,9 +46,11 @@ typedef struct texture_system_state {
 	b8* auto_releases;
 	kname* names;
 	texture_state* states;
+	/** @brief Listener contexts of textures whose pixel data is still being uploaded. Used to cancel the upload if the texture is released first. */
+	void** upload_contexts;
 
-	// For quick lookups by name.
-	bt_node* texture_name_lookup;
+	// For quick lookups by name. Maps names to ktexture handles.
+	hashmap texture_name_lookup;
 
 	ktexture default_texture;
 	ktexture default_base_colour_texture;
@@ -90,7 +92,8 @@ static b8 texture_resources_acquire(ktexture t, kname name);
 static void texture_cleanup(ktexture t, b8 clear_references);
 static b8 get_image_asset_names_from_options(const ktexture_load_options* options, u16* out_count, kname** image_asset_names, kname** package_names);
 static void combine_asset_pixel_data(kasset_image** assets, u32 count, u32 expected_width, u32 expected_height, b8 release_assets, u32* out_size, void** out_pixels);
-static b8 texture_apply_asset_data(ktexture t, kname name, const ktexture_load_options* options, kasset_image** assets);
+static b8 texture_apply_asset_data(ktexture t, kname name, const ktexture_load_options* options, kasset_image** assets, texture_asset_load_listener_context* context);
+static void texture_upload_complete(void* context);
 
 static void on_texture_system_dump(console_command_context context) {
 	texture_system_state* state = engine_systems_get()->texture_system;
@@ -135,6 +138,12 @@ b8 texture_system_initialize(u64* memory_requirement, void* state, void* config)
 	state_ptr->auto_releases = KALLOC_TYPE_CARRAY(b8, typed_config->max_texture_count);
 	state_ptr->states = KALLOC_TYPE_CARRAY(texture_state, typed_config->max_texture_count);
 	state_ptr->names = KALLOC_TYPE_CARRAY(kname, typed_config->max_texture_count);
+	state_ptr->upload_contexts = KALLOC_TYPE_CARRAY(void*, typed_config->max_texture_count);
+
+	if (!hashmap_create(sizeof(ktexture), typed_config->max_texture_count, &state_ptr->texture_name_lookup)) {
+		KERROR("Failed to create texture name lookup.");
+		return false;
+	}
 
 	// Keep a pointer to the renderer system state.
 	state_ptr->renderer = engine_systems_get()->renderer_system;
@@ -159,6 +168,11 @@ void texture_system_shutdown(void* state) {
 
 		// Ensure all textures are released.
 		for (u16 i = 0; i < typed_config->max_texture_count; ++i) {
+			if (state_ptr->upload_contexts[i]) {
+				renderer_uploads_cancel(state_ptr->renderer, state_ptr->upload_contexts[i]);
+				KFREE_TYPE(state_ptr->upload_contexts[i], texture_asset_load_listener_context, MEMORY_TAG_TEXTURE);
+				state_ptr->upload_contexts[i] = 0;
+			}
 			if (state_ptr->states[i] != TEXTURE_STATE_UNINITIALIZED) {
 				renderer_texture_resources_release(state_ptr->renderer, i);
 			}
@@ -175,6 +189,9 @@ void texture_system_shutdown(void* state) {
 		KFREE_TYPE_CARRAY(state_ptr->auto_releases, b8, typed_config->max_texture_count);
 		KFREE_TYPE_CARRAY(state_ptr->states, texture_state, typed_config->max_texture_count);
 		KFREE_TYPE_CARRAY(state_ptr->names, kname, typed_config->max_texture_count);
+		KFREE_TYPE_CARRAY(state_ptr->upload_contexts, void*, typed_config->max_texture_count);
+
+		hashmap_destroy(&state_ptr->texture_name_lookup);
 
 		state_ptr->renderer = 0;
 		state_ptr = 0;
@@ -999,43 +1016,48 @@ static void texture_kasset_image_loaded(void* listener, kasset_image* asset) {
 			}
 		}
 
-		// Handle the GPU upload of pixel data.
-		if (texture_apply_asset_data(t, context->name, &context->options, context->assets)) {
+		// Queue the GPU upload of pixel data. The texture is marked as loaded once it completes.
+		u16 array_size = state_ptr->array_sizes[t];
+		if (texture_apply_asset_data(t, context->name, &context->options, context->assets, context)) {
 			success = true;
 		}
 
-		state_ptr->states[t] = TEXTURE_STATE_LOADED;
-
 		if (context->assets) {
-			KFREE_TYPE_CARRAY(context->assets, kasset_image*, state_ptr->array_sizes[t]);
+			KFREE_TYPE_CARRAY(context->assets, kasset_image*, array_size);
+			context->assets = 0;
 		}
-		KFREE_TYPE_CARRAY(context->image_asset_names, kname, state_ptr->array_sizes[t]);
-		KFREE_TYPE_CARRAY(context->package_names, kname, state_ptr->array_sizes[t]);
+		KFREE_TYPE_CARRAY(context->image_asset_names, kname, array_size);
+		KFREE_TYPE_CARRAY(context->package_names, kname, array_size);
+		context->image_asset_names = 0;
+		context->package_names = 0;
 
+		// On success, the context is kept until the upload completes. See texture_upload_complete.
 		if (!success) {
-			if (t != INVALID_KTEXTURE) {
-				texture_cleanup(t, true);
-			}
-
-			t = INVALID_KTEXTURE;
+			KFREE_TYPE(context, texture_asset_load_listener_context, MEMORY_TAG_TEXTURE);
 		}
+	}
+}
 
-		if (t != INVALID_KTEXTURE && context->user_callback) {
-			context->user_callback(t, context->user_listener);
-		}
+static void texture_upload_complete(void* context) {
+	texture_asset_load_listener_context* listener = (texture_asset_load_listener_context*)context;
+	ktexture t = listener->texture;
 
-		KFREE_TYPE(context, texture_asset_load_listener_context, MEMORY_TAG_TEXTURE);
+	state_ptr->upload_contexts[t] = 0;
+	state_ptr->states[t] = TEXTURE_STATE_LOADED;
+
+	if (listener->user_callback) {
+		listener->user_callback(t, listener->user_listener);
 	}
+
+	KFREE_TYPE(listener, texture_asset_load_listener_context, MEMORY_TAG_TEXTURE);
 }
 
 static ktexture texture_get_if_exists(kname name) {
 	ktexture t = INVALID_KTEXTURE;
 
 	// Check first if an entry with the name exists. If it does, return it.
-	const bt_node* node = u64_bst_find(state_ptr->texture_name_lookup, name);
-	if (node) {
+	if (hashmap_kname_get(&state_ptr->texture_name_lookup, name, &t)) {
 		// Already exists, just return it.
-		t = node->value.u16;
 		if (state_ptr->names[t] == INVALID_KNAME) {
 			KERROR("%s - lookup for name '%s' exists, but texture is invalid. This likely means a release wasn't done properly.", __FUNCTION__, kname_string_get(name));
 			return INVALID_KTEXTURE;
@@ -1054,12 +1076,9 @@ static ktexture texture_get_new(kname name) {
 			// Found one, use it.
 			state_ptr->states[i] = TEXTURE_STATE_LOADING;
 
-			// Insert into the lookup tree.
-			bt_node_value val = {.u16 = i};
-			bt_node* new_node = u64_bst_insert(state_ptr->texture_name_lookup, name, val);
-			if (!state_ptr->texture_name_lookup) {
-				state_ptr->texture_name_lookup = new_node;
-			}
+			// Insert into the lookup.
+			ktexture t = i;
+			hashmap_kname_set(&state_ptr->texture_name_lookup, name, &t);
 
 			// Start reference count at 1.
 			state_ptr->texture_reference_counts[i] = 1;
@@ -1088,6 +1107,13 @@ static b8 texture_resources_acquire(ktexture t, kname name) {
 
 static void texture_cleanup(ktexture t, b8 clear_references) {
 	if (t != INVALID_KTEXTURE) {
+		// If the pixel data is still being uploaded, make sure its callback is never made.
+		if (state_ptr->upload_contexts[t]) {
+			renderer_uploads_cancel(state_ptr->renderer, state_ptr->upload_contexts[t]);
+			KFREE_TYPE(state_ptr->upload_contexts[t], texture_asset_load_listener_context, MEMORY_TAG_TEXTURE);
+			state_ptr->upload_contexts[t] = 0;
+		}
+
 		renderer_texture_resources_release(state_ptr->renderer, t);
 
 		if (clear_references) {
@@ -1096,7 +1122,7 @@ static void texture_cleanup(ktexture t, b8 clear_references) {
 		}
 
 		// remove name from the lookup.
-		u64_bst_delete(state_ptr->texture_name_lookup, state_ptr->names[t]);
+		hashmap_kname_remove(&state_ptr->texture_name_lookup, state_ptr->names[t]);
 
 		state_ptr->types[t] = 0;
 		state_ptr->widths[t] = 0;
@@ -1244,7 +1270,7 @@ static void combine_asset_pixel_data(kasset_image** assets, u32 count, u32 expec
 	}
 }
 
-static b8 texture_apply_asset_data(ktexture t, kname name, const ktexture_load_options* options, kasset_image** assets) {
+static b8 texture_apply_asset_data(ktexture t, kname name, const ktexture_load_options* options, kasset_image** assets, texture_asset_load_listener_context* context) {
 	b8 success = false;
 
 	// Calculate mip levels if needed.
@@ -1277,19 +1303,22 @@ static b8 texture_apply_asset_data(ktexture t, kname name, const ktexture_load_o
 	b8 has_transparency = pixel_data_has_transparency(all_pixels, all_pixel_count, state_ptr->formats[t]);
 	state_ptr->flags[t] = FLAG_SET(state_ptr->flags[t], KTEXTURE_FLAG_HAS_TRANSPARENCY, has_transparency);
 
-	// Write the image asset data to the texture.
+	// Queue the image asset data to be written to the texture. The data is copied, so it can be freed below.
+	// Registered first, so releasing the texture before the upload completes cancels it.
+	state_ptr->upload_contexts[t] = context;
 	u32 texture_data_offset = 0; // NOTE: The only time this potentially could be nonzero is when explicitly loading a layer of texture data.
-	b8 write_result = renderer_texture_write_data(
+	b8 write_result = renderer_texture_write_data_async(
 		state_ptr->renderer,
 		t,
-		texture_data_offset, all_pixel_size, all_pixels);
+		texture_data_offset, all_pixel_size, all_pixels,
+		texture_upload_complete, context);
 
 	if (!write_result) {
-		KERROR("%s - Failed to write texture data resource '%s'.", __FUNCTION__, kname_string_get(name));
+		KERROR("%s - Failed to queue texture data upload for resource '%s'.", __FUNCTION__, kname_string_get(name));
+		state_ptr->upload_contexts[t] = 0;
 		goto texture_apply_asset_data_cleanup;
 	}
 
-	state_ptr->states[t] = TEXTURE_STATE_LOADED;
 	success = true;
 texture_apply_asset_data_cleanup:
 
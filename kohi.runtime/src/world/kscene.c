@@ -29,6 +29,7 @@
 #include <strings/kstring_id.h>
 #include <systems/kcamera_system.h>
 #include <systems/kmaterial_system.h>
+#include <systems/job_system.h>
 #include <systems/kmodel_system.h>
 #include <systems/ktransform_system.h>
 #include <systems/light_system.h>
@@ -49,6 +50,16 @@
 #define ENTITY_MODEL_ANIMATED_DEBUG_COLOUR \
 	(colour4){0, 1, 1, 1}
 
+// Animated models have their pose evaluated one frame less often for each multiple of this
+// distance from the camera, down to every KSCENE_ANIMATION_LOD_MAX_INTERVAL'th frame.
+#define KSCENE_ANIMATION_LOD_DISTANCE 25.0f
+#define KSCENE_ANIMATION_LOD_MAX_INTERVAL 4
+// From this interval onward, leaf bones (fingers, toes and the like) are no longer animated.
+#define KSCENE_ANIMATION_LOD_SKIP_LEAF_BONES_INTERVAL 3
+
+// The number of entities whose world bounds are transformed together by aabb_transform_batch.
+#define KSCENE_BOUNDS_BATCH_SIZE 64
+
 /**
  * A base entity with no type. Used for grouping other entities together, for example
  */
@@ -68,6 +79,8 @@ typedef struct base_entity {
 
 	// The extents for the entity.
 	extents_3d extents;
+	// The world-space bounds of the entity, as of the last transform update.
+	aabb world_bounds;
 
 	bvh_id bvh_id;
 
@@ -77,12 +90,28 @@ typedef struct base_entity {
 #endif
 } base_entity;
 
+/**
+ * The point lights bound to the geometries of an entity. These are chosen by the light
+ * assignment stage during update, and kept until the entity or a light near it moves.
+ */
+typedef struct kscene_light_binding {
+	// The world-space bounds of the entity when the lights were chosen.
+	aabb bounds;
+	// Cleared when the lights need to be chosen again.
+	b8 valid;
+	// The number of bound lights.
+	u8 count;
+	// The bound lights, ordered from most to least influential.
+	klight lights[KMATERIAL_MAX_BOUND_POINT_LIGHTS];
+} kscene_light_binding;
+
 /**
  * A model specialized entity.
  */
 typedef struct model_entity {
 	base_entity base;
 	kmodel_instance model;
+	kscene_light_binding light_binding;
 
 	// Metadata for serialization later
 	kname asset_name;
@@ -104,6 +133,12 @@ typedef struct point_light_entity {
 
 	// A handle into the light system, that contains the data.
 	klight handle;
+
+	// The world position and radius the light had when last accounted for in light assignment.
+	vec3 assigned_position;
+	f32 assigned_radius;
+	// Indicates the light has been accounted for in light assignment.
+	b8 assigned;
 } point_light_entity;
 
 typedef struct spawn_point_entity {
@@ -150,6 +185,7 @@ typedef struct water_plane_entity {
 	kgeometry_ref ref;
 	u32 size;
 	kgeometry geo;
+	kscene_light_binding light_binding;
 } water_plane_entity;
 
 typedef enum audio_emitter_entity_flag_bits {
@@ -359,6 +395,13 @@ static void map_model_submesh_geometries(kscene* scene, kentity entity, u16 subm
 static void map_model_entity_geometries(kscene* scene, kentity entity);
 static void unmap_model_entity_geometries(kscene* scene, kentity entity);
 
+// Builds per-model frustum visibility masks, and gathers model render data using them.
+static u8* model_visibility_build(struct kscene* scene, frame_allocator_int* frame_allocator, const kfrustum* frusta, u8 frustum_count);
+static kmaterial_render_data* kscene_get_model_render_data(struct kscene* scene, struct frame_data* p_frame_data, const u8* visibility, kscene_render_data_flag_bits flags, b8 is_animated, u16* out_material_count);
+// Combines visibility masks, and uses the result to drive the animation LOD of model instances.
+static void model_visibility_accumulate(struct kscene* scene, u8* dest, const u8* src);
+static void model_animation_lod_update(struct kscene* scene, const u8* visibility, vec3 view_position);
+
 // Handles notifications that an inital load entity type that has async asset load started.
 static void notify_initial_load_entity_started(kscene* scene, kentity entity);
 // Handles notifications of initial asset load completion and updates counts.
@@ -637,19 +680,136 @@ void kscene_destroy(struct kscene* scene) {
 	KFREE_TYPE(scene, kscene, MEMORY_TAG_SCENE);
 }
 
-static void recalculate_transforms(kscene* scene, base_entity* parent, kentity child_handle) {
+// Entities gathered by recalculate_transforms() to have their world bounds transformed together.
+typedef struct bounds_batch {
+	u32 count;
+	base_entity* entities[KSCENE_BOUNDS_BATCH_SIZE];
+	aabb bounds[KSCENE_BOUNDS_BATCH_SIZE];
+	mat4 world_matrices[KSCENE_BOUNDS_BATCH_SIZE];
+} bounds_batch;
+
+static void bounds_batch_flush(kscene* scene, bounds_batch* batch) {
+	aabb_transform_batch(batch->bounds, batch->world_matrices, batch->bounds, batch->count);
+	for (u32 i = 0; i < batch->count; ++i) {
+		base_entity* entity = batch->entities[i];
+		entity->world_bounds = batch->bounds[i];
+		bvh_update(&scene->bvh_tree, entity->bvh_id, batch->bounds[i]);
+	}
+	batch->count = 0;
+}
+
+// World matrices are already up to date at this point, so the order entities are gathered in does not
+// matter. The caller flushes whatever remains in the batch afterward.
+static void recalculate_transforms(kscene* scene, bounds_batch* batch, kentity child_handle) {
 	KASSERT(child_handle != KENTITY_INVALID);
 	base_entity* child = get_entity_base(scene, child_handle);
-	mat4 bvh_extents_transform = ktransform_world_get(child->transform); // child_world;
-
-	aabb box = aabb_from_mat4_extents(child->extents.min, child->extents.max, bvh_extents_transform);
 
-	bvh_update(&scene->bvh_tree, child->bvh_id, box);
+	batch->entities[batch->count] = child;
+	batch->bounds[batch->count] = child->extents;
+	batch->world_matrices[batch->count] = ktransform_world_get(child->transform);
+	batch->count++;
+	if (batch->count == KSCENE_BOUNDS_BATCH_SIZE) {
+		bounds_batch_flush(scene, batch);
+	}
 
 	u16 count = child->children ? darray_length(child->children) : 0;
 	for (u16 i = 0; i < count; ++i) {
-		recalculate_transforms(scene, child, child->children[i]);
+		recalculate_transforms(scene, batch, child->children[i]);
+	}
+}
+
+static aabb point_light_influence_bounds(vec3 position, f32 radius) {
+	vec3 r = (vec3){radius, radius, radius};
+	return aabb_create(vec3_sub(position, r), vec3_add(position, r));
+}
+
+static u32 on_light_binding_invalidate_hit(bvh_userdata user, bvh_id id, void* usr) {
+	kscene* scene = usr;
+	kentity entity = (kentity)user;
+	u16 type_index = kentity_unpack_type_index(entity);
+	switch (kentity_unpack_type(entity)) {
+	case KENTITY_TYPE_MODEL:
+		scene->models[type_index].light_binding.valid = false;
+		return 1;
+	case KENTITY_TYPE_WATER_PLANE:
+		scene->water_planes[type_index].light_binding.valid = false;
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+// Flags the lights of every entity overlapping the given bounds to be chosen again.
+static void light_bindings_invalidate(kscene* scene, aabb bounds) {
+	bvh_query_overlaps(&scene->bvh_tree, bounds, on_light_binding_invalidate_hit, scene);
+}
+
+typedef struct light_binding_query_context {
+	kscene* scene;
+	aabb bounds;
+	u8 count;
+	klight lights[KMATERIAL_MAX_BOUND_POINT_LIGHTS];
+	f32 influences[KMATERIAL_MAX_BOUND_POINT_LIGHTS];
+} light_binding_query_context;
+
+static u32 on_light_binding_query_hit(bvh_userdata user, bvh_id id, void* usr) {
+	light_binding_query_context* ctx = usr;
+	kentity entity = (kentity)user;
+	if (kentity_unpack_type(entity) != KENTITY_TYPE_POINT_LIGHT) {
+		return 0;
+	}
+	point_light_entity* light = &ctx->scene->point_lights[kentity_unpack_type_index(entity)];
+
+	// Distance from the light to the closest point of the bounds (0 if within them).
+	vec3 p = light->assigned_position;
+	aabb b = ctx->bounds;
+	vec3 closest = (vec3){KCLAMP(p.x, b.min.x, b.max.x), KCLAMP(p.y, b.min.y, b.max.y), KCLAMP(p.z, b.min.z, b.max.z)};
+	f32 dist = vec3_distance(p, closest);
+	if (dist > light->assigned_radius) {
+		return 0;
+	}
+
+	// Rank by perceived brightness at the closest point, attenuated the same way as in the shaders.
+	colour3 c = light->colour;
+	f32 luminance = (c.r * 0.2126f) + (c.g * 0.7152f) + (c.b * 0.0722f);
+	f32 influence = luminance / (1.0f + (light->linear * dist) + (light->quadratic * dist * dist));
+
+	// Insert, keeping the list sorted from most to least influential. When full, the least influential drops off.
+	u8 slot = ctx->count;
+	if (slot == KMATERIAL_MAX_BOUND_POINT_LIGHTS) {
+		if (influence <= ctx->influences[slot - 1]) {
+			return 0;
+		}
+		slot--;
+	} else {
+		ctx->count++;
+	}
+	while (slot > 0 && ctx->influences[slot - 1] < influence) {
+		ctx->lights[slot] = ctx->lights[slot - 1];
+		ctx->influences[slot] = ctx->influences[slot - 1];
+		slot--;
 	}
+	ctx->lights[slot] = light->handle;
+	ctx->influences[slot] = influence;
+	return 1;
+}
+
+// Chooses the most influential point lights for an entity with the given world bounds. Does
+// nothing if the previous choice is still valid and the entity hasn't moved since it was made.
+static void light_binding_update(kscene* scene, kscene_light_binding* binding, aabb bounds) {
+	if (binding->valid &&
+		vec3_compare(binding->bounds.min, bounds.min, K_FLOAT_EPSILON) &&
+		vec3_compare(binding->bounds.max, bounds.max, K_FLOAT_EPSILON)) {
+		return;
+	}
+
+	light_binding_query_context context = {.scene = scene, .bounds = bounds};
+	bvh_query_overlaps(&scene->bvh_tree, bounds, on_light_binding_query_hit, &context);
+
+	binding->count = context.count;
+	kcopy_memory(binding->lights, context.lights, sizeof(klight) * context.count);
+	binding->bounds = bounds;
+	binding->valid = true;
 }
 
 #if KOHI_DEBUG
@@ -805,10 +965,13 @@ b8 kscene_update(struct kscene* scene, struct frame_data* p_frame_data) {
 		if (scene->state == KSCENE_STATE_LOADED) {
 
 			// Update all transforms from the top (roots) down.
+			bounds_batch batch;
+			batch.count = 0;
 			u16 root_count = darray_length(scene->root_entities);
 			for (u16 i = 0; i < root_count; ++i) {
-				recalculate_transforms(scene, 0, scene->root_entities[i]);
+				recalculate_transforms(scene, &batch, scene->root_entities[i]);
 			}
+			bounds_batch_flush(scene, &batch);
 
 #if KOHI_DEBUG
 			recalculate_debug_transforms(scene);
@@ -828,11 +991,44 @@ b8 kscene_update(struct kscene* scene, struct frame_data* p_frame_data) {
 			u16 point_light_count = darray_length(scene->point_lights);
 			for (u16 i = 0; i < point_light_count; ++i) {
 				point_light_entity* light_entity = &scene->point_lights[i];
+				if (FLAG_GET(light_entity->base.flags, KENTITY_FLAG_FREE_BIT)) {
+					continue;
+				}
 
 				vec3 pos = ktransform_world_position_get(light_entity->base.transform);
 
 				point_light_set_position(engine_systems_get()->light_system, light_entity->handle, pos);
 				// TODO: sync other properties (colour, etc.)
+
+				// If the light has moved or changed reach, entities it used to reach and those it now
+				// reaches need their lights chosen again.
+				f32 radius = point_light_radius_get(engine_systems_get()->light_system, light_entity->handle);
+				if (!light_entity->assigned || radius != light_entity->assigned_radius || !vec3_compare(pos, light_entity->assigned_position, K_FLOAT_EPSILON)) {
+					if (light_entity->assigned) {
+						light_bindings_invalidate(scene, point_light_influence_bounds(light_entity->assigned_position, light_entity->assigned_radius));
+					}
+					light_bindings_invalidate(scene, point_light_influence_bounds(pos, radius));
+					light_entity->assigned_position = pos;
+					light_entity->assigned_radius = radius;
+					light_entity->assigned = true;
+				}
+			}
+
+			// Light assignment. Only entities which have moved or been reached by a changed light
+			// since their lights were last chosen do any work here.
+			u16 model_count = darray_length(scene->models);
+			for (u16 i = 0; i < model_count; ++i) {
+				model_entity* m = &scene->models[i];
+				if (!FLAG_GET(m->base.flags, KENTITY_FLAG_FREE_BIT)) {
+					light_binding_update(scene, &m->light_binding, m->base.world_bounds);
+				}
+			}
+			u16 water_plane_count = darray_length(scene->water_planes);
+			for (u16 i = 0; i < water_plane_count; ++i) {
+				water_plane_entity* wp = &scene->water_planes[i];
+				if (!FLAG_GET(wp->base.flags, KENTITY_FLAG_FREE_BIT)) {
+					light_binding_update(scene, &wp->light_binding, wp->base.world_bounds);
+				}
 			}
 
 			// Check all hit shapes against all volumes.
@@ -914,6 +1110,12 @@ b8 kscene_frame_prepare(struct kscene* scene, struct frame_data* p_frame_data, u
 		vec3 view_euler = kcamera_get_euler_rotation(current_camera);
 		rect_2di vp_rect = kcamera_get_vp_rect(current_camera);
 		f32 fov = kcamera_get_fov(current_camera);
+		kfrustum view_frustum = kfrustum_from_view_projection(mat4_mul(view, projection));
+
+		// Whether each model is seen by any of the passes below. Animation is paused for the rest.
+		u32 model_count = scene->models ? darray_length(scene->models) : 0;
+		u8* animation_visibility = frame_allocator->allocate(KMAX(model_count, 1));
+		kzero_memory(animation_visibility, KMAX(model_count, 1));
 
 		f32 near = kcamera_get_near_clip(current_camera);
 		f32 far = scene->shadow_dist + scene->shadow_fade_dist;
@@ -1049,26 +1251,35 @@ b8 kscene_frame_prepare(struct kscene* scene, struct frame_data* p_frame_data, u
 				last_split_dist = split_dist;
 			}
 
+			// Cull against each cascade. The cascade volumes are already extended toward the light, so
+			// casters outside the view which throw shadows into it are kept. Geometries are gathered into
+			// one list, each marked with the cascades it falls within so it is only drawn to those.
+			kfrustum cascade_frusta[KMATERIAL_MAX_SHADOW_CASCADES];
+			for (u32 c = 0; c < render_data->shadow_data.cascade_count; c++) {
+				cascade_frusta[c] = kfrustum_from_view_projection(shadow_camera_view_projections[c]);
+			}
+			u8* shadow_visibility = model_visibility_build(scene, frame_allocator, cascade_frusta, (u8)render_data->shadow_data.cascade_count);
+			model_visibility_accumulate(scene, animation_visibility, shadow_visibility);
+
 			// Gather the geometries to be rendered.
-			// Note that this only needs to happen once, since all geometries visible by the furthest-out cascase
-			// must also be drawn on the nearest cascade to ensure objects outside the view cast shadows into the
-			// view properly.
 			//
 			// Meshes with opaque materials first.
 			u16 opaque_material_count = 0;
-			kmaterial_render_data* opaque_material_render_data = kscene_get_static_model_render_data(
+			kmaterial_render_data* opaque_material_render_data = kscene_get_model_render_data(
 				scene,
 				p_frame_data,
-				0, // FIXME: frustum culling disabled for now.
+				shadow_visibility,
 				KSCENE_RENDER_DATA_FLAG_NONE,
+				false,
 				&opaque_material_count);
 
 			u16 animated_opaque_material_count = 0;
-			kmaterial_render_data* animated_opaque_material_render_data = kscene_get_animated_model_render_data(
+			kmaterial_render_data* animated_opaque_material_render_data = kscene_get_model_render_data(
 				scene,
 				p_frame_data,
-				0, // FIXME: frustum culling disabled for now.
+				shadow_visibility,
 				KSCENE_RENDER_DATA_FLAG_NONE,
+				true,
 				&animated_opaque_material_count);
 
 			u32 animated_count = darray_length(animated_opaque_material_render_data);
@@ -1091,11 +1302,12 @@ b8 kscene_frame_prepare(struct kscene* scene, struct frame_data* p_frame_data, u
 			p_frame_data->drawn_shadow_mesh_count = render_data->shadow_data.opaque_geometry_count;
 
 			// Meshes with transparent materials next. Can just use these as they come organized from the scene.
-			render_data->shadow_data.transparent_geometries_by_material = kscene_get_static_model_render_data(
+			render_data->shadow_data.transparent_geometries_by_material = kscene_get_model_render_data(
 				scene,
 				p_frame_data,
-				0, // FIXME: frustum culling disabled for now.
+				shadow_visibility,
 				KSCENE_RENDER_DATA_FLAG_TRANSPARENT_BIT,
+				false,
 				&render_data->shadow_data.transparent_geometries_by_material_count);
 			// Get a count of all the geometries
 			for (u16 i = 0; i < render_data->shadow_data.transparent_geometries_by_material_count; ++i) {
@@ -1106,11 +1318,12 @@ b8 kscene_frame_prepare(struct kscene* scene, struct frame_data* p_frame_data, u
 			// FIXME: animated and static model data should be combined into a single call from the scene since the
 			// shaders are no longer separate. When this is done, this code won't be required.
 			u16 animated_transparent_count = 0;
-			kmaterial_render_data* animated_transparent_geometries_by_material = kscene_get_animated_model_render_data(
+			kmaterial_render_data* animated_transparent_geometries_by_material = kscene_get_model_render_data(
 				scene,
 				p_frame_data,
-				0, // FIXME: frustum culling disabled for now.
+				shadow_visibility,
 				KSCENE_RENDER_DATA_FLAG_TRANSPARENT_BIT,
+				true,
 				&animated_transparent_count);
 			// Get a count of all the geometries
 			for (u16 i = 0; i < animated_transparent_count; ++i) {
@@ -1122,11 +1335,12 @@ b8 kscene_frame_prepare(struct kscene* scene, struct frame_data* p_frame_data, u
 			{
 				// Meshes with opaque materials first.
 				u16 animated_opaque_material_count = 0;
-				kmaterial_render_data* animated_opaque_material_render_data = kscene_get_animated_model_render_data(
+				kmaterial_render_data* animated_opaque_material_render_data = kscene_get_model_render_data(
 					scene,
 					p_frame_data,
-					0, // FIXME: frustum culling disabled for now.
+					shadow_visibility,
 					KSCENE_RENDER_DATA_FLAG_NONE,
+					true,
 					&animated_opaque_material_count);
 
 				// Opaque-material geometries can be grouped together for the shadow pass.
@@ -1143,11 +1357,12 @@ b8 kscene_frame_prepare(struct kscene* scene, struct frame_data* p_frame_data, u
 				p_frame_data->drawn_shadow_mesh_count = render_data->shadow_data.animated_opaque_geometry_count;
 
 				// Meshes with transparent materials next. Can just use these as they come organized from the scene.
-				render_data->shadow_data.animated_transparent_geometries_by_material = kscene_get_static_model_render_data(
+				render_data->shadow_data.animated_transparent_geometries_by_material = kscene_get_model_render_data(
 					scene,
 					p_frame_data,
-					0, // FIXME: frustum culling disabled for now.
+					shadow_visibility,
 					KSCENE_RENDER_DATA_FLAG_TRANSPARENT_BIT,
+					false,
 					&render_data->shadow_data.animated_transparent_geometries_by_material_count);
 				// Get a count of all the geometries
 				for (u16 i = 0; i < render_data->shadow_data.animated_transparent_geometries_by_material_count; ++i) {
@@ -1159,7 +1374,7 @@ b8 kscene_frame_prepare(struct kscene* scene, struct frame_data* p_frame_data, u
 			render_data->shadow_data.terrains = kscene_get_hm_terrain_render_data(
 				scene,
 				p_frame_data,
-				0, // FIXME: frustum culling disabled for now.
+				0, // NOTE: Terrain spans all cascades, so is not culled per cascade.
 				0,
 				&render_data->shadow_data.terrain_count);
 			// Get terrain geometry count (i.e. number of chunks)
@@ -1205,12 +1420,17 @@ b8 kscene_frame_prepare(struct kscene* scene, struct frame_data* p_frame_data, u
 			render_data->forward_data.standard_pass.view_position = view_position;
 			render_data->forward_data.standard_pass.view_matrix = render_data->forward_data.view_matrix;
 
+			// Cull against the camera's view.
+			u8* view_visibility = model_visibility_build(scene, frame_allocator, &view_frustum, 1);
+			model_visibility_accumulate(scene, animation_visibility, view_visibility);
+
 			// Meshes with opaque materials first.
-			render_data->forward_data.standard_pass.opaque_meshes_by_material = kscene_get_static_model_render_data(
+			render_data->forward_data.standard_pass.opaque_meshes_by_material = kscene_get_model_render_data(
 				scene,
 				p_frame_data,
-				0, // FIXME: frustum culling disabled for now.
+				view_visibility,
 				KSCENE_RENDER_DATA_FLAG_NONE,
+				false,
 				&render_data->forward_data.standard_pass.opaque_meshes_by_material_count);
 
 			// Get geometry count.
@@ -1219,11 +1439,12 @@ b8 kscene_frame_prepare(struct kscene* scene, struct frame_data* p_frame_data, u
 			}
 
 			// Animated meshes with opaque materials.
-			render_data->forward_data.standard_pass.animated_opaque_meshes_by_material = kscene_get_animated_model_render_data(
+			render_data->forward_data.standard_pass.animated_opaque_meshes_by_material = kscene_get_model_render_data(
 				scene,
 				p_frame_data,
-				0, // FIXME: frustum culling disabled for now.
+				view_visibility,
 				KSCENE_RENDER_DATA_FLAG_NONE,
+				true,
 				&render_data->forward_data.standard_pass.animated_opaque_meshes_by_material_count);
 
 			// Get geometry count.
@@ -1232,11 +1453,12 @@ b8 kscene_frame_prepare(struct kscene* scene, struct frame_data* p_frame_data, u
 			}
 
 			// Meshes with transparent materials next. Can just use these as they come organized from the scene.
-			render_data->forward_data.standard_pass.transparent_meshes_by_material = kscene_get_static_model_render_data(
+			render_data->forward_data.standard_pass.transparent_meshes_by_material = kscene_get_model_render_data(
 				scene,
 				p_frame_data,
-				0, // FIXME: frustum culling disabled for now.
+				view_visibility,
 				KSCENE_RENDER_DATA_FLAG_TRANSPARENT_BIT,
+				false,
 				&render_data->forward_data.standard_pass.transparent_meshes_by_material_count);
 			// Get a count of all the geometries
 			for (u16 i = 0; i < render_data->forward_data.standard_pass.transparent_meshes_by_material_count; ++i) {
@@ -1244,11 +1466,12 @@ b8 kscene_frame_prepare(struct kscene* scene, struct frame_data* p_frame_data, u
 			}
 
 			// Animated meshes with transparent materials next. Can just use these as they come organized from the scene.
-			render_data->forward_data.standard_pass.animated_transparent_meshes_by_material = kscene_get_animated_model_render_data(
+			render_data->forward_data.standard_pass.animated_transparent_meshes_by_material = kscene_get_model_render_data(
 				scene,
 				p_frame_data,
-				0, // FIXME: frustum culling disabled for now.
+				view_visibility,
 				KSCENE_RENDER_DATA_FLAG_TRANSPARENT_BIT,
+				true,
 				&render_data->forward_data.standard_pass.animated_transparent_meshes_by_material_count);
 			// Get a count of all the geometries
 			for (u16 i = 0; i < render_data->forward_data.standard_pass.animated_transparent_meshes_by_material_count; ++i) {
@@ -1259,7 +1482,7 @@ b8 kscene_frame_prepare(struct kscene* scene, struct frame_data* p_frame_data, u
 			render_data->forward_data.standard_pass.terrains = kscene_get_hm_terrain_render_data(
 				scene,
 				p_frame_data,
-				0, // FIXME: frustum culling disabled for now.
+				&view_frustum,
 				0,
 				&render_data->forward_data.standard_pass.terrain_count);
 
@@ -1273,7 +1496,7 @@ b8 kscene_frame_prepare(struct kscene* scene, struct frame_data* p_frame_data, u
 			kwater_plane_render_data* water_planes = kscene_get_water_plane_render_data(
 				scene,
 				p_frame_data,
-				0, // FIXME: frustum culling disabled for now.
+				&view_frustum,
 				0,
 				&render_data->forward_data.water_plane_count);
 
@@ -1322,43 +1545,52 @@ b8 kscene_frame_prepare(struct kscene* scene, struct frame_data* p_frame_data, u
 						wp_data->reflection_pass.view_position = inv_cam_pos;
 						wp_data->reflection_pass.view_matrix = kcamera_get_view(scene->world_inv_camera);
 
+						// Cull against the reflection camera's view.
+						kfrustum reflection_frustum = kfrustum_from_view_projection(mat4_mul(wp_data->reflection_pass.view_matrix, projection));
+						u8* reflection_visibility = model_visibility_build(scene, frame_allocator, &reflection_frustum, 1);
+						model_visibility_accumulate(scene, animation_visibility, reflection_visibility);
+
 						// Get a list of opaque geometries from the "reflection" camera perspective.
-						wp_data->reflection_pass.opaque_meshes_by_material = kscene_get_static_model_render_data(
+						wp_data->reflection_pass.opaque_meshes_by_material = kscene_get_model_render_data(
 							scene,
 							p_frame_data,
-							0, // FIXME: frustum culling disabled for now.
+							reflection_visibility,
 							KSCENE_RENDER_DATA_FLAG_NONE,
+							false,
 							&wp_data->reflection_pass.opaque_meshes_by_material_count);
 
 						// Get a list of animated opaque geometries from the "reflection" camera perspective.
-						wp_data->reflection_pass.animated_opaque_meshes_by_material = kscene_get_animated_model_render_data(
+						wp_data->reflection_pass.animated_opaque_meshes_by_material = kscene_get_model_render_data(
 							scene,
 							p_frame_data,
-							0, // FIXME: frustum culling disabled for now.
+							reflection_visibility,
 							KSCENE_RENDER_DATA_FLAG_NONE,
+							true,
 							&wp_data->reflection_pass.animated_opaque_meshes_by_material_count);
 
 						// Get a list of transparent geometries from the "reflection" camera perspective.
-						wp_data->reflection_pass.transparent_meshes_by_material = kscene_get_static_model_render_data(
+						wp_data->reflection_pass.transparent_meshes_by_material = kscene_get_model_render_data(
 							scene,
 							p_frame_data,
-							0, // FIXME: frustum culling disabled for now.
+							reflection_visibility,
 							KSCENE_RENDER_DATA_FLAG_TRANSPARENT_BIT,
+							false,
 							&wp_data->reflection_pass.transparent_meshes_by_material_count);
 
 						// Get a list of animated transparent geometries from the "reflection" camera perspective.
-						wp_data->reflection_pass.animated_transparent_meshes_by_material = kscene_get_animated_model_render_data(
+						wp_data->reflection_pass.animated_transparent_meshes_by_material = kscene_get_model_render_data(
 							scene,
 							p_frame_data,
-							0, // FIXME: frustum culling disabled for now.
+							reflection_visibility,
 							KSCENE_RENDER_DATA_FLAG_TRANSPARENT_BIT,
+							true,
 							&wp_data->reflection_pass.animated_transparent_meshes_by_material_count);
 
 						// Get terrains/chunk data
 						wp_data->reflection_pass.terrains = kscene_get_hm_terrain_render_data(
 							scene,
 							p_frame_data,
-							0, // FIXME: frustum culling disabled for now.
+							&reflection_frustum,
 							0,
 							&wp_data->reflection_pass.terrain_count);
 					}
@@ -1379,7 +1611,7 @@ b8 kscene_frame_prepare(struct kscene* scene, struct frame_data* p_frame_data, u
 			render_data->world_debug_data.geometries = kscene_get_debug_render_data(
 				scene,
 				p_frame_data,
-				0, // FIXME: frustum culling disabled for now.
+				&view_frustum,
 				0,
 				&render_data->world_debug_data.geometry_count);
 
@@ -1452,6 +1684,9 @@ b8 kscene_frame_prepare(struct kscene* scene, struct frame_data* p_frame_data, u
 			KERROR("Failed to update scene BVH debug data.");
 		}
 #endif
+
+		// Takes effect from the next update, as animation for this frame has already been updated.
+		model_animation_lod_update(scene, animation_visibility, view_position);
 	}
 	return true;
 }
@@ -2100,6 +2335,7 @@ static void model_entity_destroy(kscene* scene, model_entity* typed_entity, kent
 
 	typed_entity->asset_name = INVALID_KNAME;
 	typed_entity->package_name = INVALID_KNAME;
+	typed_entity->light_binding = (kscene_light_binding){0};
 
 	base_entity_destroy(scene, &typed_entity->base, entity_handle);
 }
@@ -2143,6 +2379,12 @@ kentity kscene_add_point_light(struct kscene* scene, kname name, ktransform tran
 }
 
 static void point_light_entity_destroy(kscene* scene, point_light_entity* typed_entity, kentity entity_handle) {
+	// Entities the light reached need their lights chosen again. Not needed if cleaning up the entire scene.
+	if (entity_handle != KENTITY_INVALID && typed_entity->assigned) {
+		light_bindings_invalidate(scene, point_light_influence_bounds(typed_entity->assigned_position, typed_entity->assigned_radius));
+	}
+	typed_entity->assigned = false;
+
 	light_destroy(engine_systems_get()->light_system, typed_entity->handle);
 
 	typed_entity->linear = 0;
@@ -2451,6 +2693,8 @@ static void water_plane_entity_destroy(kscene* scene, water_plane_entity* typed_
 	kzero_memory(extents, sizeof(extents_3d));
 	FLAG_SET(geo_data->flags, KGEOMETRY_DATA_FLAG_FREE_BIT, true);
 
+	typed_entity->light_binding = (kscene_light_binding){0};
+
 	base_entity_destroy(scene, &typed_entity->base, entity_handle);
 }
 
@@ -2569,40 +2813,26 @@ kskybox_render_data kscene_get_skybox_render_data(struct kscene* scene) {
 	return out_data;
 }
 
-// Gets model render data, organized by material.
-static kmaterial_render_data* kscene_get_model_render_data(
-	struct kscene* scene,
-	struct frame_data* p_frame_data,
-	kfrustum* frustum,
-	kscene_render_data_flag_bits flags,
-	b8 is_animated,
-	u16* out_material_count) {
-
-	KASSERT_DEBUG(scene);
-	KASSERT_DEBUG(p_frame_data);
-	KASSERT_DEBUG(out_material_count);
-
-	frame_allocator_int* frame_allocator = &p_frame_data->allocator;
-
-	kmaterial_to_geometry_map* map = 0;
-	if (FLAG_GET(flags, KSCENE_RENDER_DATA_FLAG_TRANSPARENT_BIT)) {
-		// Only get transparent geometries
-		map = is_animated ? &scene->transparent_animated_model_material_map : &scene->transparent_static_model_material_map;
-	} else {
-		// Only get opaque geometries
-		map = is_animated ? &scene->opaque_animated_model_material_map : &scene->opaque_static_model_material_map;
-	}
-
-	// Extract geometry to be rendered from the appropriate map.
-	kmaterial_render_data* mats = darray_create_with_allocator(kmaterial_render_data, frame_allocator);
-
-	for (u16 i = 0; i < map->count; ++i) {
-		kmaterial_geometry_list* list = &map->lists[i];
-
-		kmaterial_render_data mat_render_data = {0};
+typedef struct model_render_data_gather_context {
+	struct kscene* scene;
+	kmaterial_to_geometry_map* map;
+	// A mask per model entity of the frusta it is visible within (see model_visibility_build()). 0 means no culling.
+	const u8* visibility;
+	b8 is_animated;
+	// One entry per material list in the map. Geometry arrays are reserved up front so that
+	// gathering never allocates, and can thus happen across job threads.
+	kmaterial_render_data* per_material;
+} model_render_data_gather_context;
+
+// Gathers render data for a range of the material lists in a material-to-geometry map.
+static void gather_model_render_data_batch(u32 start, u32 end, void* context) {
+	model_render_data_gather_context* ctx = context;
+	struct kscene* scene = ctx->scene;
+	kmodel_system_state* model_state = engine_systems_get()->model_system;
 
-		mat_render_data.base_material = list->base_material;
-		mat_render_data.geometries = darray_create_with_allocator(kgeometry_render_data, frame_allocator);
+	for (u32 i = start; i < end; ++i) {
+		kmaterial_geometry_list* list = &ctx->map->lists[i];
+		kmaterial_render_data* mat_render_data = &ctx->per_material[i];
 
 		// Each geometry in the material.
 		for (u16 g = 0; g < list->count; ++g) {
@@ -2614,14 +2844,12 @@ static kmaterial_render_data* kscene_get_model_render_data(
 
 			// TODO: check entity visibility
 
-			/* mat4 world_model = ktransform_world_get(entity->base.transform); */
-
-			if (frustum) {
-				// TODO: frustum cull check, continue to next if fails.
+			// Skip entities outside of every frustum being gathered for.
+			u8 visibility_mask = ctx->visibility ? ctx->visibility[entity_index] : 0xFF;
+			if (!visibility_mask) {
+				continue;
 			}
 
-			kmodel_system_state* model_state = engine_systems_get()->model_system;
-
 			// If it passes all tests, create/push the render data.
 			kgeometry_render_data rd = {
 				.vertex_count = geo->vertex_count,
@@ -2631,30 +2859,144 @@ static kmaterial_render_data* kscene_get_model_render_data(
 				.material_instance_id = geo->material_instance_id,
 				.transform = entity->base.transform,
 				.animation_id = INVALID_ID_U16,
+				.cascade_mask = visibility_mask,
 			};
-			if (is_animated) {
+			if (ctx->is_animated) {
 				rd.animation_id = kmodel_instance_animation_id_get(model_state, entity->model);
 			}
 
-			// FIXME: Pick the closest lights that actually interact with this geometry and add them
-			// to the list. For now this is just adding the closest 8.
-			rd.bound_point_light_count = KMIN(darray_length(scene->point_lights), KMATERIAL_MAX_BOUND_POINT_LIGHTS);
+			// Lights are chosen per entity during update.
+			rd.bound_point_light_count = entity->light_binding.count;
 			for (u8 l = 0; l < rd.bound_point_light_count; ++l) {
-				// TODO: distance check.
-				rd.bound_point_light_indices[l] = scene->point_lights[l].handle;
+				rd.bound_point_light_indices[l] = entity->light_binding.lights[l];
 			}
 
 			// Flags - note that these aren't a straight copy, as the flag values between these two sets vary.
 			rd.flags = FLAG_SET(rd.flags, KGEOMETRY_RENDER_DATA_FLAG_WINDING_INVERTED_BIT, FLAG_GET(geo->flags, KGEOMETRY_DATA_FLAG_WINDING_INVERTED_BIT));
 
-			// This is building the render data array, so just pushing here is fine.
-			darray_push(mat_render_data.geometries, rd);
-			mat_render_data.geometry_count++;
+			// Capacity was reserved for every geometry in the list, so this push never reallocates.
+			darray_push(mat_render_data->geometries, rd);
+			mat_render_data->geometry_count++;
 		}
+	}
+}
 
-		// If there are actually things to render, push the mat_render_data to the list.
-		if (mat_render_data.geometry_count) {
-			darray_push(mats, mat_render_data);
+typedef struct model_visibility_query_context {
+	u8* masks;
+	u8 bit;
+} model_visibility_query_context;
+
+static u32 on_model_visibility_query_hit(bvh_userdata user, bvh_id id, void* usr) {
+	model_visibility_query_context* ctx = usr;
+	kentity entity = (kentity)user;
+	if (kentity_unpack_type(entity) != KENTITY_TYPE_MODEL) {
+		return 0;
+	}
+	ctx->masks[kentity_unpack_type_index(entity)] |= ctx->bit;
+	return 1;
+}
+
+// Builds a mask per model entity, with bit n set if the entity's bounds fall within frusta[n].
+// Allocated from the frame allocator. Returns 0 if no frusta are given, which means no culling.
+static u8* model_visibility_build(struct kscene* scene, frame_allocator_int* frame_allocator, const kfrustum* frusta, u8 frustum_count) {
+	if (!frusta || !frustum_count) {
+		return 0;
+	}
+	KASSERT_DEBUG(frustum_count <= 8);
+
+	u32 model_count = scene->models ? darray_length(scene->models) : 0;
+	u8* masks = frame_allocator->allocate(KMAX(model_count, 1));
+	kzero_memory(masks, KMAX(model_count, 1));
+
+	model_visibility_query_context context = {.masks = masks};
+	for (u8 i = 0; i < frustum_count; ++i) {
+		context.bit = (u8)(1 << i);
+		bvh_query_frustum(&scene->bvh_tree, &frusta[i], on_model_visibility_query_hit, &context);
+	}
+
+	return masks;
+}
+
+static void model_visibility_accumulate(struct kscene* scene, u8* dest, const u8* src) {
+	u32 model_count = scene->models ? darray_length(scene->models) : 0;
+	for (u32 i = 0; i < model_count; ++i) {
+		dest[i] |= src[i];
+	}
+}
+
+static void model_animation_lod_update(struct kscene* scene, const u8* visibility, vec3 view_position) {
+	kmodel_system_state* model_state = engine_systems_get()->model_system;
+	u32 model_count = scene->models ? darray_length(scene->models) : 0;
+	for (u32 i = 0; i < model_count; ++i) {
+		model_entity* entity = &scene->models[i];
+		if (FLAG_GET(entity->base.flags, KENTITY_FLAG_FREE_BIT)) {
+			continue;
+		}
+
+		// Static models and instances still loading are ignored by the model system.
+		b8 visible = visibility[i] != 0;
+		kmodel_instance_visibility_set(model_state, entity->model, visible);
+		if (visible) {
+			f32 distance = vec3_distance(view_position, extents_3d_center(entity->base.world_bounds));
+			u8 interval = (u8)KMIN(1 + (u32)(distance / KSCENE_ANIMATION_LOD_DISTANCE), KSCENE_ANIMATION_LOD_MAX_INTERVAL);
+			kmodel_instance_lod_set(model_state, entity->model, interval, interval >= KSCENE_ANIMATION_LOD_SKIP_LEAF_BONES_INTERVAL);
+		}
+	}
+}
+
+// Gets model render data, organized by material. Only entities with a nonzero visibility mask are included.
+static kmaterial_render_data* kscene_get_model_render_data(
+	struct kscene* scene,
+	struct frame_data* p_frame_data,
+	const u8* visibility,
+	kscene_render_data_flag_bits flags,
+	b8 is_animated,
+	u16* out_material_count) {
+
+	KASSERT_DEBUG(scene);
+	KASSERT_DEBUG(p_frame_data);
+	KASSERT_DEBUG(out_material_count);
+
+	frame_allocator_int* frame_allocator = &p_frame_data->allocator;
+
+	kmaterial_to_geometry_map* map = 0;
+	if (FLAG_GET(flags, KSCENE_RENDER_DATA_FLAG_TRANSPARENT_BIT)) {
+		// Only get transparent geometries
+		map = is_animated ? &scene->transparent_animated_model_material_map : &scene->transparent_static_model_material_map;
+	} else {
+		// Only get opaque geometries
+		map = is_animated ? &scene->opaque_animated_model_material_map : &scene->opaque_static_model_material_map;
+	}
+
+	// Extract geometry to be rendered from the appropriate map.
+	kmaterial_render_data* mats = darray_create_with_allocator(kmaterial_render_data, frame_allocator);
+	if (!map->count) {
+		*out_material_count = 0;
+		return mats;
+	}
+
+	// Setup the per-material render data up front on this thread, since the frame allocator is not thread-safe.
+	model_render_data_gather_context context = {
+		.scene = scene,
+		.map = map,
+		.visibility = visibility,
+		.is_animated = is_animated,
+		.per_material = frame_allocator->allocate(sizeof(kmaterial_render_data) * map->count)};
+	for (u16 i = 0; i < map->count; ++i) {
+		kmaterial_geometry_list* list = &map->lists[i];
+		kmaterial_render_data* mat_render_data = &context.per_material[i];
+		mat_render_data->base_material = list->base_material;
+		mat_render_data->geometry_count = 0;
+		mat_render_data->geometries = darray_reserve_with_allocator(kgeometry_render_data, KMAX(list->count, 1), frame_allocator);
+	}
+
+	// Each material's geometry list is independent, so gather them across job threads.
+	job_system_parallel_for(map->count, 8, gather_model_render_data_batch, &context);
+
+	// If there are actually things to render, push the mat_render_data to the list.
+	for (u16 i = 0; i < map->count; ++i) {
+		if (context.per_material[i].geometry_count) {
+			darray_push(mats, context.per_material[i]);
 		}
 	}
 
@@ -2671,7 +3013,8 @@ kmaterial_render_data* kscene_get_static_model_render_data(
 	kscene_render_data_flag_bits flags,
 	u16* out_material_count) {
 
-	return kscene_get_model_render_data(scene, p_frame_data, frustum, flags, false, out_material_count);
+	u8* visibility = model_visibility_build(scene, &p_frame_data->allocator, frustum, frustum ? 1 : 0);
+	return kscene_get_model_render_data(scene, p_frame_data, visibility, flags, false, out_material_count);
 }
 
 // Gets animated model render data, organized by material.
@@ -2682,7 +3025,8 @@ kmaterial_render_data* kscene_get_animated_model_render_data(
 	kscene_render_data_flag_bits flags,
 	u16* out_material_count) {
 
-	return kscene_get_model_render_data(scene, p_frame_data, frustum, flags, true, out_material_count);
+	u8* visibility = model_visibility_build(scene, &p_frame_data->allocator, frustum, frustum ? 1 : 0);
+	return kscene_get_model_render_data(scene, p_frame_data, visibility, flags, true, out_material_count);
 }
 
 // Gets terrain chunk render data.
@@ -2693,7 +3037,8 @@ hm_terrain_render_data* kscene_get_hm_terrain_render_data(
 	u32 flags,
 	u16* out_terrain_count) {
 
-	// FIXME: implement this
+	// FIXME: implement this. Chunks are uploaded asynchronously, so any whose generation is still
+	// INVALID_ID_U16 must be skipped.
 
 	return 0;
 }
@@ -2804,12 +3149,10 @@ kwater_plane_render_data* kscene_get_water_plane_render_data(
 		p->index_buffer_offset = g->index_offset;
 		p->vertex_buffer_offset = g->vertex_offset;
 
-		// FIXME: Pick the closest lights that actually interact with this geometry and add them
-		// to the list. For now this is just adding the closest 8.
-		p->bound_point_light_count = KMIN(darray_length(scene->point_lights), KMATERIAL_MAX_BOUND_POINT_LIGHTS);
+		// Lights are chosen per entity during update.
+		p->bound_point_light_count = wp->light_binding.count;
 		for (u8 l = 0; l < p->bound_point_light_count; ++l) {
-			// TODO: distance check.
-			p->bound_point_light_indices[l] = scene->point_lights[l].handle;
+			p->bound_point_light_indices[l] = wp->light_binding.lights[l];
 		}
 	}
 
@@ -3097,6 +3440,11 @@ static void map_model_entity_geometries(kscene* scene, kentity entity) {
 		// Take all the extents and combine them to get the outer extents for the entire thing.
 		base->extents = extents_combine(base->extents, geo->extents);
 
+		// Geometry which failed to upload is never valid to render.
+		if (geo->generation == INVALID_ID_U16) {
+			continue;
+		}
+
 		// Material instance for this submesh.
 		const kmaterial_instance* mat_inst = kmodel_submesh_material_instance_get_at(model_state, typed_entity->model, g);
 
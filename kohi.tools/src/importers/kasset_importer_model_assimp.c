@@ -38,8 +38,9 @@ static b8 materials_from_assimp(const struct aiScene* scene, kname package_name,
 static const struct aiScene* assimp_open_file(const char* source_path);
 static b8 anim_asset_from_assimp(const struct aiScene* scene, kname package_name, kasset_model* out_asset);
 static void anim_asset_destroy(kasset_model* asset);
+static void animations_compress(kasset_model* asset, f32 key_tolerance);
 
-b8 kasset_model_assimp_import(const char* source_path, const char* target_path, const char* material_target_dir, const char* package_name) {
+b8 kasset_model_assimp_import(const char* source_path, const char* target_path, const char* material_target_dir, const char* package_name, b8 compress_animations, f32 key_tolerance) {
 	kasset_model new_asset = {0};
 
 	const struct aiScene* scene = assimp_open_file(source_path);
@@ -52,6 +53,10 @@ b8 kasset_model_assimp_import(const char* source_path, const char* target_path,
 		return false;
 	}
 
+	if (compress_animations) {
+		animations_compress(&new_asset, key_tolerance);
+	}
+
 	b8 success = false;
 
 	// Serialize animation asset.
@@ -709,3 +714,113 @@ static void anim_asset_destroy(kasset_model* asset) {
 	}
 	KFREE_TYPE_CARRAY(asset->nodes, kasset_model_node, asset->node_count);
 }
+
+// Removes keys which linear interpolation between the keys kept either side of them reproduces to within
+// tolerance, compacting the remainder in place. Returns the number of keys kept.
+static u32 keys_reduce_vec3(kasset_model_key_vec3* keys, u32 count, f32 tolerance) {
+	if (count < 2) {
+		return count;
+	}
+
+	// The first key is always kept, and becomes the anchor for the keys after it.
+	u32 kept = 1;
+	for (u32 i = 1; i + 1 < count; ++i) {
+		// Key i can go if the segment from the anchor to the key after it passes close enough to it and every
+		// key dropped since the anchor. Only slots up to kept are written, which are never read again.
+		const kasset_model_key_vec3* anchor = &keys[kept - 1];
+		const kasset_model_key_vec3* next = &keys[i + 1];
+		f32 span = next->time - anchor->time;
+		b8 droppable = span > 0.0f;
+		for (u32 j = i; droppable && j > 0 && keys[j].time > anchor->time; --j) {
+			vec3 estimate = vec3_lerp(anchor->value, next->value, (keys[j].time - anchor->time) / span);
+			droppable = vec3_distance(estimate, keys[j].value) <= tolerance;
+		}
+		if (!droppable) {
+			keys[kept++] = keys[i];
+		}
+	}
+	keys[kept++] = keys[count - 1];
+
+	// A track which holds still needs only one key.
+	if (kept == 2 && vec3_distance(keys[0].value, keys[1].value) <= tolerance) {
+		kept = 1;
+	}
+	return kept;
+}
+
+// The angle between two rotations, in radians.
+static f32 quat_angle_between(quat a, quat b) {
+	f32 dot = KMIN(kabs(quat_dot(quat_normalize(a), quat_normalize(b))), 1.0f);
+	return 2.0f * kacos(dot);
+}
+
+// As keys_reduce_vec3(), interpolating as the runtime does. Tolerance is in radians.
+static u32 keys_reduce_quat(kasset_model_key_quat* keys, u32 count, f32 tolerance) {
+	if (count < 2) {
+		return count;
+	}
+
+	u32 kept = 1;
+	for (u32 i = 1; i + 1 < count; ++i) {
+		const kasset_model_key_quat* anchor = &keys[kept - 1];
+		const kasset_model_key_quat* next = &keys[i + 1];
+		f32 span = next->time - anchor->time;
+		b8 droppable = span > 0.0f;
+		for (u32 j = i; droppable && j > 0 && keys[j].time > anchor->time; --j) {
+			quat estimate = quat_slerp(anchor->value, next->value, (keys[j].time - anchor->time) / span);
+			droppable = quat_angle_between(estimate, keys[j].value) <= tolerance;
+		}
+		if (!droppable) {
+			keys[kept++] = keys[i];
+		}
+	}
+	keys[kept++] = keys[count - 1];
+
+	if (kept == 2 && quat_angle_between(keys[0].value, keys[1].value) <= tolerance) {
+		kept = 1;
+	}
+	return kept;
+}
+
+// Moves the first new_count keys into an array of that size, so it is freed with the size it was allocated at.
+static void* keys_shrink(void* keys, u64 key_size, u32 old_count, u32 new_count) {
+	if (new_count == old_count) {
+		return keys;
+	}
+	void* shrunk = kallocate(key_size * new_count, MEMORY_TAG_ARRAY);
+	kcopy_memory(shrunk, keys, key_size * new_count);
+	kfree(keys, key_size * old_count, MEMORY_TAG_ARRAY);
+	return shrunk;
+}
+
+// Reduces the keys of every animation, and marks them to be quantized when serialized.
+static void animations_compress(kasset_model* asset, f32 key_tolerance) {
+	u64 total_before = 0;
+	u64 total_after = 0;
+	for (u16 a = 0; a < asset->animation_count; ++a) {
+		kasset_model_animation* anim = &asset->animations[a];
+		anim->key_encoding = KASSET_MODEL_KEY_ENCODING_QUANTIZED;
+		for (u16 c = 0; c < anim->channel_count; ++c) {
+			kasset_model_channel* ch = &anim->channels[c];
+			total_before += ch->pos_count + ch->rot_count + ch->scale_count;
+
+			if (key_tolerance > 0.0f) {
+				u32 count = keys_reduce_vec3(ch->positions, ch->pos_count, key_tolerance);
+				ch->positions = keys_shrink(ch->positions, sizeof(kasset_model_key_vec3), ch->pos_count, count);
+				ch->pos_count = count;
+
+				count = keys_reduce_quat(ch->rotations, ch->rot_count, key_tolerance);
+				ch->rotations = keys_shrink(ch->rotations, sizeof(kasset_model_key_quat), ch->rot_count, count);
+				ch->rot_count = count;
+
+				count = keys_reduce_vec3(ch->scales, ch->scale_count, key_tolerance);
+				ch->scales = keys_shrink(ch->scales, sizeof(kasset_model_key_vec3), ch->scale_count, count);
+				ch->scale_count = count;
+			}
+
+			total_after += ch->pos_count + ch->rot_count + ch->scale_count;
+		}
+	}
+
+	KINFO("Animation keys reduced from %llu to %llu (tolerance=%f).", total_before, total_after, key_tolerance);
+}
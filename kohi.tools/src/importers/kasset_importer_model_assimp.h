@@ -5,4 +5,10 @@
 #define KASSET_EXPORTER_TYPE_KOHI_IMPORTER 0x00000001
 #define KASSET_EXPORTER_TYPE_KOHI_IMPORTER_VERSION 0x01
 
-b8 kasset_model_assimp_import(const char* source_path, const char* target_path, const char* material_target_dir, const char* package_name);
+// The default error tolerance of animation keyframe reduction, used when animations are compressed without one being given.
+#define KASSET_IMPORTER_MODEL_DEFAULT_KEY_TOLERANCE 0.0005f
+
+// If compress_animations is set, keys which can be rebuilt by interpolating their neighbours to within
+// key_tolerance (in model units for translations and scales, radians for rotations) are removed, and the
+// remainder are quantized when written.
+b8 kasset_model_assimp_import(const char* source_path, const char* target_path, const char* material_target_dir, const char* package_name, b8 compress_animations, f32 key_tolerance);
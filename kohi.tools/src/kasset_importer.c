@@ -22,6 +22,7 @@ NOTE: Need to add required/optional options (lul) to import processes. Can vary
 kohi.tools -t "./assets/models/Tree.ksm" -s "./assets/models/source/Tree.obj" -mtl_target_path="./assets/materials/" -package_name="Testbed"
 kohi.tools -t "./assets/models/Tree.ksm" -s "./assets/models/source/Tree.gltf" -mtl_target_path="./assets/materials/" -package_name="Testbed"
 kohi.tools -t "./assets/images/orange_lines_512.kbi" -s "./assets/images/source/orange_lines_512.png" -flip_y=no
+kohi.tools -t "./assets/models/Soldier.ksm" -s "./assets/models/source/Soldier.fbx" -mtl_target_path="./assets/materials/" -package_name="Testbed" -compress_animations=yes -animation_key_tolerance=0.001
 */
 
 // Returns the index of the option. -1 if not found.
@@ -46,9 +47,9 @@ b8 fnt_2_kbf(const char* source_path, const char* target_path) {
 	return kasset_bitmap_font_fnt_import(source_path, target_path);
 }
 
-b8 assimp_2_k3d(const char* source_path, const char* target_path, const char* material_target_dir, const char* package_name) {
-	KDEBUG("Executing %s...", __FUNCTION__);
-	return kasset_model_assimp_import(source_path, target_path, material_target_dir, package_name);
+b8 assimp_2_k3d(const char* source_path, const char* target_path, const char* material_target_dir, const char* package_name, b8 compress_animations, f32 key_tolerance) {
+	KDEBUG("Executing %s... (compress_animations=%s)", __FUNCTION__, compress_animations ? "yes" : "no");
+	return kasset_model_assimp_import(source_path, target_path, material_target_dir, package_name, compress_animations, key_tolerance);
 }
 
 b8 import_from_path(const char* source_path, const char* target_path, u8 option_count, const import_option* options) {
@@ -109,7 +110,20 @@ b8 import_from_path(const char* source_path, const char* target_path, u8 option_
 		// TODO: required?
 		const char* package_name = get_option_value("package_name", option_count, options);
 
-		if (!assimp_2_k3d(source_path, target_path, mtl_target_dir, package_name)) {
+		// Extract optional properties.
+		b8 compress_animations = false;
+		const char* compress_animations_str = get_option_value("compress_animations", option_count, options);
+		if (compress_animations_str) {
+			string_to_bool(compress_animations_str, &compress_animations);
+		}
+
+		f32 key_tolerance = KASSET_IMPORTER_MODEL_DEFAULT_KEY_TOLERANCE;
+		const char* key_tolerance_str = get_option_value("animation_key_tolerance", option_count, options);
+		if (key_tolerance_str) {
+			string_to_f32(key_tolerance_str, &key_tolerance);
+		}
+
+		if (!assimp_2_k3d(source_path, target_path, mtl_target_dir, package_name, compress_animations, key_tolerance)) {
 			goto import_from_path_cleanup;
 		}
 
@@ -185,7 +199,8 @@ b8 import_all_from_manifest(const char* manifest_path, kimport_flag_bits flags)
 				const char* mtl_target_dir = string_format("%s/%s", manifest.path, "assets/materials/");
 				const char* package_name = kname_string_get(manifest.name);
 
-				if (!assimp_2_k3d(asset->source_path, asset->path, mtl_target_dir, package_name)) {
+				// NOTE: Manifests have no per-asset import options, so animations are kept at full precision.
+				if (!assimp_2_k3d(asset->source_path, asset->path, mtl_target_dir, package_name, false, KASSET_IMPORTER_MODEL_DEFAULT_KEY_TOLERANCE)) {
 					goto import_all_from_manifest_cleanup;
 				}
 			} else if (extension_is_audio(source_extension)) {